@@ -59,16 +59,6 @@ cbuffer BufferFrame : register(b0)
 cbuffer BufferUber : register(b1)
 {
 	matrix g_transform;
-    
-	float4 materialAlbedoColor;	
-
-	float2 materialTiling;
-	float2 materialOffset;
-
-    float materialRoughness;
-    float materialMetallic;
-    float materialNormalStrength;
-	float materialHeight;
 
 	float4 g_color;
 	
@@ -85,7 +75,26 @@ cbuffer BufferObject : register(b2)
 	matrix g_object_transform;
 	matrix g_object_wvp_current;
 	matrix g_object_wvp_previous;
+	uint g_object_instance_offset;
+	float3 g_object_padding;
+
+	// Per draw material properties
+	float4 materialAlbedoColor;
+	float2 materialTiling;
+	float2 materialOffset;
+	float materialRoughness;
+	float materialMetallic;
+	float materialNormalStrength;
+	float materialHeight;
+};
+
+// Per instance - Instanced draws read g_instances[g_object_instance_offset + SV_InstanceID]
+struct Instance
+{
+	matrix transform; // world matrix, or world view projection matrix for the depth passes
+	matrix wvp_previous;
 };
+StructuredBuffer<Instance> g_instances : register(t31);
 
 // Updates as many times as there are lights
 cbuffer LightBuffer : register(b3)
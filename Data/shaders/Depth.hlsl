@@ -23,12 +23,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Common.hlsl"
 //====================
 
-Pixel_PosUv mainVS(Vertex_PosUv input)
+Pixel_PosUv mainVS(Vertex_PosUv input, uint instance_id : SV_InstanceID)
 {
 	Pixel_PosUv output;
+	Instance instance = g_instances[g_object_instance_offset + instance_id];
 
 	input.position.w 	= 1.0f;	
-    output.position 	= mul(input.position, g_object_transform);
+    output.position 	= mul(input.position, instance.transform);
     output.uv 			= input.uv;
 
 	return output;
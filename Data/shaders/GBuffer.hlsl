@@ -42,17 +42,18 @@ struct PixelOutputType
 	float2 velocity	: SV_Target3;
 };
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+PixelInputType mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID)
 {
     PixelInputType output;
+    Instance instance = g_instances[g_object_instance_offset + instance_id];
     
     input.position.w 			= 1.0f;		
-	output.position_ss_previous = mul(input.position, g_object_wvp_previous);
-    output.position 			= mul(input.position, g_object_transform);
+	output.position_ss_previous = mul(input.position, instance.wvp_previous);
+    output.position 			= mul(input.position, instance.transform);
     output.position   		    = mul(output.position, g_viewProjection);
     output.position_ss_current 	= output.position;
-	output.normal 				= normalize(mul(input.normal, (float3x3)g_object_transform)).xyz;	
-	output.tangent 				= normalize(mul(input.tangent, (float3x3)g_object_transform)).xyz;
+	output.normal 				= normalize(mul(input.normal, (float3x3)instance.transform)).xyz;	
+	output.tangent 				= normalize(mul(input.tangent, (float3x3)instance.transform)).xyz;
     output.uv 					= input.uv;
 	
 	return output;
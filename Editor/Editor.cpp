@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Editor.h"
 #include "Core/Engine.h"
 #include "Core/Settings.h"
+#include "Profiling/Benchmark.h"
 #include "Rendering/Model.h"
 #include "ImGui_Extension.h"
 #include "ImGui/Implementation/ImGui_RHI.h"
@@ -109,6 +110,13 @@ void Editor::OnWindowMessage(WindowData& window_data)
 
             // Create all ImGui widgets
             Widgets_Create();
+
+            // A benchmark requested on the command line, e.g. -benchmark scene_query
+            m_benchmark = make_unique<Benchmark>(m_context);
+            if (!m_benchmark->Start(m_command_line))
+            {
+                m_benchmark = nullptr;
+            }
         }
         else
         {
@@ -143,6 +151,16 @@ void Editor::OnTick()
 	// Engine
 	m_engine->Tick();
 
+    // Benchmark
+    if (m_benchmark)
+    {
+        m_benchmark->Tick();
+        if (!m_benchmark->IsRunning())
+        {
+            m_benchmark = nullptr;
+        }
+    }
+
     // Editor
     m_profiler->TimeBlockStart("Editor", TimeBlock_Cpu);
     {
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include <vector>
 #include <memory>
+#include <string>
 #include "RHI/RHI_Definition.h"
 #include "Widgets/Widget.h"
 //=============================
@@ -35,6 +36,7 @@ namespace Spartan
 	class Engine;
 	class Renderer;
     class Profiler;
+    class Benchmark;
     struct WindowData;
 }
 //========================
@@ -42,7 +44,7 @@ namespace Spartan
 class Editor
 {
 public:
-    Editor() = default;
+    Editor(const std::string& command_line) : m_command_line(command_line) {}
 	~Editor();
 
     void OnWindowMessage(Spartan::WindowData& window_data);
@@ -59,6 +61,7 @@ private:
 	std::vector<std::unique_ptr<Widget>> m_widgets;
 	bool m_initializing = false;
     bool m_editor_begun = false;
+    std::string m_command_line;
 
 	// Engine
 	std::unique_ptr<Spartan::Engine> m_engine;
@@ -66,4 +69,5 @@ private:
 	Spartan::Context* m_context	    = nullptr;
 	Spartan::Renderer* m_renderer	= nullptr;
     Spartan::Profiler* m_profiler   = nullptr;
+    std::unique_ptr<Spartan::Benchmark> m_benchmark;
 };
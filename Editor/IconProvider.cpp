@@ -172,7 +172,7 @@ const Thumbnail& IconProvider::Thumbnail_Load(const string& file_path, Icon_Type
 		texture->SetHeight(size);
 
 		// Load it asynchronously
-		m_context->GetSubsystem<Threading>()->AddTask([texture, file_path]()
+		m_context->GetSubsystem<Threading>()->AddTaskBackground([texture, file_path]()
 		{
 			texture->LoadFromFile(file_path);
 		});
@@ -61,7 +61,7 @@ public:
 		auto resource_cache = g_resource_cache;
 
 		// Load the model asynchronously
-		g_threading->AddTask([resource_cache, file_path]()
+		g_threading->AddTaskBackground([resource_cache, file_path]()
 		{
 			resource_cache->Load<Spartan::Model>(file_path);
 		});
@@ -72,7 +72,7 @@ public:
 		auto world = g_world;
 
 		// Load the scene asynchronously
-		g_threading->AddTask([world, file_path]()
+		g_threading->AddTaskBackground([world, file_path]()
 		{
 			world->LoadFromFile(file_path);
 		});
@@ -83,7 +83,7 @@ public:
 		auto world = g_world;
 
 		// Save the scene asynchronously
-		g_threading->AddTask([world, file_path]()
+		g_threading->AddTaskBackground([world, file_path]()
 		{
 			world->SaveToFile(file_path);
 		});
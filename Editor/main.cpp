@@ -27,7 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
     // Create editor
-    Editor editor;
+    Editor editor(lpCmdLine);
 
 	// Create window
 	Window::Create(hInstance, "Spartan " + std::string(engine_version));	
@@ -34,12 +34,14 @@ namespace Spartan
 	{
 	public:
 		Spartan_Object() { m_id = GenerateId(); }
-
-		const uint32_t GetId()          const { return m_id; }
-		void SetId(const uint32_t id)	      { m_id = id; }
-        static uint32_t GenerateId()          { return ++g_id; }
-        const uint64_t GetSizeCpu()     const { return m_size_cpu; }
-        const std::string& GetName()    const { return m_name; }
+		virtual ~Spartan_Object() = default;
+
+		const uint32_t GetId()                const { return m_id; }
+		// Virtual, so that objects which are indexed by their id (e.g. entities) can keep their index up to date
+		virtual void SetId(const uint32_t id)       { m_id = id; }
+        static uint32_t GenerateId()                { return ++g_id; }
+        const uint64_t GetSizeCpu()           const { return m_size_cpu; }
+        const std::string& GetName()          const { return m_name; }
 
 	protected:
         std::string m_name;
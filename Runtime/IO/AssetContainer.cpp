@@ -0,0 +1,290 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "AssetContainer.h"
+#include <cstdio>
+#include <fstream>
+#include "../Logging/Log.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+//============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    AssetContainer::~AssetContainer()
+    {
+        Close();
+    }
+
+    bool AssetContainer::Open(const string& path)
+    {
+        Close();
+
+        #ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(Header)))
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file      = file;
+        m_mapping   = mapping;
+        m_data      = static_cast<const std::byte*>(view);
+        m_size      = static_cast<uint64_t>(size.QuadPart);
+        #else
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file == -1)
+            return false;
+
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header)))
+        {
+            close(file);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file); // the mapping keeps its own reference to the file
+        if (view == MAP_FAILED)
+            return false;
+
+        m_data = static_cast<const std::byte*>(view);
+        m_size = static_cast<uint64_t>(info.st_size);
+        #endif
+
+        // Validate the header and the table of contents before handing out any pointer into the file
+        const Header* header = reinterpret_cast<const Header*>(m_data);
+        if (header->magic != magic)
+        {
+            Close();
+            return false;
+        }
+
+        if (header->version != version)
+        {
+            LOG_WARNING("\"%s\" was written with container version %d, expected %d", path.c_str(), header->version, version);
+            Close();
+            return false;
+        }
+
+        const uint64_t toc_size = static_cast<uint64_t>(header->chunk_count) * sizeof(Chunk);
+        if (header->file_size != m_size || header->toc_offset > m_size || toc_size > m_size - header->toc_offset)
+        {
+            LOG_ERROR("\"%s\" is truncated or corrupt", path.c_str());
+            Close();
+            return false;
+        }
+
+        m_chunks        = reinterpret_cast<const Chunk*>(m_data + header->toc_offset);
+        m_chunk_count   = header->chunk_count;
+
+        for (uint32_t i = 0; i < m_chunk_count; i++)
+        {
+            if (m_chunks[i].offset > m_size || m_chunks[i].size > m_size - m_chunks[i].offset)
+            {
+                LOG_ERROR("\"%s\" has a chunk outside of the file", path.c_str());
+                Close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void AssetContainer::Close()
+    {
+        #ifdef _WIN32
+        if (m_data)     UnmapViewOfFile(m_data);
+        if (m_mapping)  CloseHandle(static_cast<HANDLE>(m_mapping));
+        if (m_file)     CloseHandle(static_cast<HANDLE>(m_file));
+        m_mapping   = nullptr;
+        m_file      = nullptr;
+        #else
+        if (m_data) munmap(const_cast<std::byte*>(m_data), static_cast<size_t>(m_size));
+        #endif
+
+        m_data          = nullptr;
+        m_size          = 0;
+        m_chunks        = nullptr;
+        m_chunk_count   = 0;
+    }
+
+    bool AssetContainer::IsContainer(const string& path)
+    {
+        ifstream in(path, ios::binary);
+        uint32_t file_magic = 0;
+        in.read(reinterpret_cast<char*>(&file_magic), sizeof(file_magic));
+        return in.good() && file_magic == magic;
+    }
+
+    const std::byte* AssetContainer::GetChunk(const uint32_t type, const uint32_t index, uint64_t* size) const
+    {
+        // Assets have a handful of chunks, a linear scan over the mapped table of contents is all that's needed
+        for (uint32_t i = 0; i < m_chunk_count; i++)
+        {
+            const Chunk& chunk = m_chunks[i];
+            if (chunk.type == type && chunk.index == index)
+            {
+                if (size) *size = chunk.size;
+                return m_data + chunk.offset;
+            }
+        }
+
+        if (size) *size = 0;
+        return nullptr;
+    }
+
+    uint32_t AssetContainer::GetChunkCount(const uint32_t type) const
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < m_chunk_count; i++)
+        {
+            count += m_chunks[i].type == type ? 1 : 0;
+        }
+        return count;
+    }
+
+    string AssetContainer::GetChunkString(const uint32_t type, const uint32_t index) const
+    {
+        uint64_t size       = 0;
+        const char* data    = GetChunk<char>(type, index, &size);
+        return data ? string(data, static_cast<size_t>(size)) : string();
+    }
+
+    void AssetContainerWriter::AddChunk(const uint32_t type, const uint32_t index, const void* data, const uint64_t size)
+    {
+        m_chunks.push_back({ type, index, data, size, string() });
+    }
+
+    void AssetContainerWriter::AddChunk(const uint32_t type, const uint32_t index, const string& value)
+    {
+        m_chunks.push_back({ type, index, nullptr, value.size(), value });
+    }
+
+    bool AssetContainerWriter::Save(const string& path)
+    {
+        const string path_temp = path + ".tmp";
+        {
+            ofstream out(path_temp, ios::binary | ios::trunc);
+            if (out.fail())
+            {
+                LOG_ERROR("Failed to open \"%s\" for writing", path_temp.c_str());
+                return false;
+            }
+
+            static const char padding[AssetContainer::alignment] = {};
+            uint64_t offset = 0;
+            const auto write = [&out, &offset](const void* data, const uint64_t size)
+            {
+                out.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+                offset += size;
+            };
+            const auto align = [&write, &offset]()
+            {
+                const uint64_t remainder = offset % AssetContainer::alignment;
+                if (remainder != 0)
+                {
+                    write(padding, AssetContainer::alignment - remainder);
+                }
+            };
+
+            // The header is patched at the end, once the offsets are known
+            AssetContainer::Header header   = {};
+            header.magic                    = AssetContainer::magic;
+            header.version                  = AssetContainer::version;
+            header.chunk_count              = static_cast<uint32_t>(m_chunks.size());
+            write(&header, sizeof(header));
+
+            vector<AssetContainer::Chunk> toc;
+            toc.reserve(m_chunks.size());
+            for (const PendingChunk& chunk : m_chunks)
+            {
+                align();
+                toc.push_back({ chunk.type, chunk.index, offset, chunk.size });
+                write(chunk.data ? chunk.data : chunk.owned.data(), chunk.size);
+            }
+
+            align();
+            header.toc_offset = offset;
+            write(toc.data(), toc.size() * sizeof(AssetContainer::Chunk));
+            header.file_size = offset;
+
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.flush();
+            if (out.fail())
+            {
+                LOG_ERROR("Failed to write \"%s\"", path_temp.c_str());
+                out.close();
+                std::remove(path_temp.c_str());
+                return false;
+            }
+        }
+
+        // Replace the file in one step, so that it's either the old or the new one if the process dies meanwhile
+        #ifdef _WIN32
+        const bool replaced = MoveFileExA(path_temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        #else
+        const bool replaced = std::rename(path_temp.c_str(), path.c_str()) == 0;
+        #endif
+        if (!replaced)
+        {
+            LOG_ERROR("Failed to move \"%s\" to \"%s\"", path_temp.c_str(), path.c_str());
+            std::remove(path_temp.c_str());
+            return false;
+        }
+
+        m_chunks.clear();
+        return true;
+    }
+}
@@ -0,0 +1,135 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+    constexpr uint32_t asset_chunk_type(const char a, const char b, const char c, const char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    // A read-only view of an asset file made of typed chunks. The file is memory mapped, a table of contents at the end
+    // of the file locates each chunk, and every chunk starts on an aligned offset, so any chunk can be handed to the GPU
+    // upload path (or cast to a POD header) without being read or copied first. Pointers stay valid while the container lives.
+    class SPARTAN_CLASS AssetContainer
+    {
+    public:
+        static constexpr uint32_t magic         = asset_chunk_type('S', 'P', 'A', 'C');
+        static constexpr uint32_t version       = 1;
+        static constexpr uint64_t alignment     = 64;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t chunk_count;
+            uint32_t reserved;
+            uint64_t toc_offset;
+            uint64_t file_size;
+        };
+
+        struct Chunk
+        {
+            uint32_t type;
+            uint32_t index;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        AssetContainer() = default;
+        ~AssetContainer();
+
+        AssetContainer(const AssetContainer&) = delete;
+        AssetContainer& operator=(const AssetContainer&) = delete;
+
+        // Returns false if the file doesn't exist, isn't a container, or was written by an incompatible version
+        bool Open(const std::string& path);
+        void Close();
+        bool IsOpen() const { return m_data != nullptr; }
+
+        // Cheap check that only reads the header, used to pick between the container and a legacy loader
+        static bool IsContainer(const std::string& path);
+
+        const std::byte* GetChunk(uint32_t type, uint32_t index = 0, uint64_t* size = nullptr) const;
+        uint32_t GetChunkCount(uint32_t type) const;
+
+        template<typename T>
+        const T* GetChunk(const uint32_t type, const uint32_t index = 0, uint64_t* count = nullptr) const
+        {
+            uint64_t size       = 0;
+            const std::byte* p  = GetChunk(type, index, &size);
+            if (count) *count   = size / sizeof(T);
+            return reinterpret_cast<const T*>(p);
+        }
+
+        std::string GetChunkString(uint32_t type, uint32_t index = 0) const;
+
+    private:
+        const std::byte* m_data = nullptr;
+        uint64_t m_size         = 0;
+        const Chunk* m_chunks   = nullptr;
+        uint32_t m_chunk_count  = 0;
+
+        #ifdef _WIN32
+        void* m_file            = nullptr;
+        void* m_mapping         = nullptr;
+        #endif
+    };
+
+    // Builds an AssetContainer file. Chunks only reference the caller's memory until Save() returns,
+    // so large payloads (mips, vertices) are written straight from where they already live.
+    class SPARTAN_CLASS AssetContainerWriter
+    {
+    public:
+        void AddChunk(uint32_t type, uint32_t index, const void* data, uint64_t size);
+        void AddChunk(uint32_t type, uint32_t index, const std::string& value);
+
+        template<typename T>
+        void AddChunk(const uint32_t type, const uint32_t index, const std::vector<T>& values)
+        {
+            AddChunk(type, index, values.data(), values.size() * sizeof(T));
+        }
+
+        // Writes to a temporary file which then replaces the target, so a failed save never leaves a truncated asset behind
+        bool Save(const std::string& path);
+
+    private:
+        struct PendingChunk
+        {
+            uint32_t type;
+            uint32_t index;
+            const void* data;
+            uint64_t size;
+            std::string owned; // small chunks (strings) are copied, so callers can pass temporaries
+        };
+
+        std::vector<PendingChunk> m_chunks;
+    };
+}
@@ -0,0 +1,222 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========
+#include "Compression.h"
+#include <vector>
+#include <cstring>
+//=====================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Compression
+{
+    namespace
+    {
+        constexpr uint32_t hash_log         = 14;
+        constexpr size_t match_min          = 4;
+        constexpr size_t offset_max         = 65535;
+        constexpr size_t last_literals      = 5;    // the format requires the last 5 bytes to be literals
+        constexpr size_t match_start_limit  = 12;   // and the last match to start at least 12 bytes before the end
+
+        inline uint32_t read32(const uint8_t* p)
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(const uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - hash_log);
+        }
+
+        inline uint8_t* write_length(uint8_t* op, size_t length)
+        {
+            while (length >= 255)
+            {
+                *op++ = 255;
+                length -= 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        inline uint8_t* write_sequence(uint8_t* op, const uint8_t* literals, const size_t literal_length, const size_t offset, const size_t match_length)
+        {
+            const size_t match_code = match_length - match_min;
+
+            uint8_t* token = op++;
+            *token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+            if (literal_length >= 15)
+            {
+                op = write_length(op, literal_length - 15);
+            }
+
+            if (literal_length != 0)
+            {
+                memcpy(op, literals, literal_length);
+                op += literal_length;
+            }
+
+            // The last sequence only carries literals
+            if (match_length == 0)
+                return op;
+
+            *op++ = static_cast<uint8_t>(offset & 0xFF);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            *token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+            if (match_code >= 15)
+            {
+                op = write_length(op, match_code - 15);
+            }
+
+            return op;
+        }
+    }
+
+    size_t Compress(const byte* src, const size_t src_size, byte* dst, const size_t dst_capacity)
+    {
+        if (dst_capacity < CompressBound(src_size))
+            return 0;
+
+        const uint8_t* const begin  = reinterpret_cast<const uint8_t*>(src);
+        const uint8_t* const end    = begin + src_size;
+        const uint8_t* ip           = begin;
+        const uint8_t* anchor       = begin;
+        uint8_t* op                 = reinterpret_cast<uint8_t*>(dst);
+
+        if (src_size > match_start_limit)
+        {
+            // Positions of recently seen 4 byte sequences, relative to begin
+            vector<uint32_t> table(size_t(1) << hash_log, 0);
+
+            const uint8_t* const match_start_end    = end - match_start_limit;
+            const uint8_t* const match_end_limit    = end - last_literals;
+
+            ip++; // the first byte can't be a match
+            while (ip < match_start_end)
+            {
+                const uint32_t sequence = read32(ip);
+                uint32_t& entry         = table[hash(sequence)];
+                const uint8_t* ref      = begin + entry;
+                entry                   = static_cast<uint32_t>(ip - begin);
+
+                if (ref >= ip || static_cast<size_t>(ip - ref) > offset_max || read32(ref) != sequence)
+                {
+                    ip++;
+                    continue;
+                }
+
+                size_t match_length = match_min;
+                while (ip + match_length < match_end_limit && ip[match_length] == ref[match_length])
+                {
+                    match_length++;
+                }
+
+                op      = write_sequence(op, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref), match_length);
+                ip      += match_length;
+                anchor  = ip;
+            }
+        }
+
+        op = write_sequence(op, anchor, static_cast<size_t>(end - anchor), 0, 0);
+
+        return static_cast<size_t>(op - reinterpret_cast<uint8_t*>(dst));
+    }
+
+    bool Decompress(const byte* src, const size_t src_size, byte* dst, const size_t dst_size)
+    {
+        const uint8_t* ip           = reinterpret_cast<const uint8_t*>(src);
+        const uint8_t* const iend   = ip + src_size;
+        uint8_t* const begin        = reinterpret_cast<uint8_t*>(dst);
+        uint8_t* op                 = begin;
+        uint8_t* const oend         = begin + dst_size;
+
+        const auto read_length = [&ip, iend](size_t& length)
+        {
+            uint8_t value = 255;
+            while (value == 255)
+            {
+                if (ip >= iend)
+                    return false;
+
+                value   = *ip++;
+                length  += value;
+            }
+            return true;
+        };
+
+        while (ip < iend)
+        {
+            const uint8_t token = *ip++;
+
+            // Literals
+            size_t literal_length = token >> 4;
+            if (literal_length == 15 && !read_length(literal_length))
+                return false;
+
+            if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op))
+                return false;
+
+            if (literal_length != 0)
+            {
+                memcpy(op, ip, literal_length);
+                ip += literal_length;
+                op += literal_length;
+            }
+
+            // The last sequence ends after its literals
+            if (ip == iend)
+                break;
+
+            // Match
+            if (iend - ip < 2)
+                return false;
+
+            const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - begin))
+                return false;
+
+            size_t match_length = token & 15;
+            if (match_length == 15 && !read_length(match_length))
+                return false;
+            match_length += match_min;
+
+            if (match_length > static_cast<size_t>(oend - op))
+                return false;
+
+            // Matches can overlap the bytes they produce, so copy forwards one byte at a time
+            const uint8_t* match = op - offset;
+            for (size_t i = 0; i < match_length; i++)
+            {
+                op[i] = match[i];
+            }
+            op += match_length;
+        }
+
+        return op == oend;
+    }
+}
@@ -0,0 +1,41 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <cstddef>
+#include "../Core/EngineDefs.h"
+//=============================
+
+// A small, dependency free LZ77 codec which reads and writes the LZ4 block format.
+// Every call is independent (no dictionary, no shared state), so blocks can be compressed and decompressed on any thread.
+namespace Spartan::Compression
+{
+    // The size a destination buffer needs to hold the compressed form of any input of src_size bytes
+    constexpr size_t CompressBound(const size_t src_size) { return src_size + src_size / 255 + 16; }
+
+    // Returns the compressed size, or 0 if dst_capacity is smaller than CompressBound(src_size)
+    SPARTAN_CLASS size_t Compress(const std::byte* src, size_t src_size, std::byte* dst, size_t dst_capacity);
+
+    // Returns false if the block is malformed or doesn't decompress to exactly dst_size bytes
+    SPARTAN_CLASS bool Decompress(const std::byte* src, size_t src_size, std::byte* dst, size_t dst_size);
+}
@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==============
 #include "FileStream.h"
+#include "Compression.h"
 #include "../Logging/Log.h"
 //=========================
 
@@ -30,6 +31,13 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace
+    {
+        // Compressed streams start with this, followed by chunks of { uncompressed size, stored size, bytes }.
+        // A chunk whose stored size equals its uncompressed size didn't compress and is stored as is.
+        constexpr uint32_t compressed_magic = 'S' | ('P' << 8) | ('Z' << 16) | ('1' << 24);
+    }
+
 	FileStream::FileStream(const string& path, uint32_t flags)
 	{
 		m_is_open	= false;
@@ -48,6 +56,12 @@ namespace Spartan
 				LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
 				return;
 			}
+
+            m_compressed = m_flags & FileStream_Compressed;
+            if (m_compressed)
+            {
+                out.write(reinterpret_cast<const char*>(&compressed_magic), sizeof(compressed_magic));
+            }
 		}
 		else if (m_flags & FileStream_Read)
 		{
@@ -57,11 +71,38 @@ namespace Spartan
 				LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
 				return;
 			}
+
+            // Compression is detected, so plain files written before it was enabled still load
+            if (m_flags & FileStream_Compressed)
+            {
+                uint32_t magic = 0;
+                in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+                m_compressed = in.gcount() == sizeof(magic) && magic == compressed_magic;
+                if (!m_compressed)
+                {
+                    in.clear();
+                    in.seekg(0);
+                }
+            }
 		}
 
+        m_buffer.resize(buffer_size);
 		m_is_open = true;
 	}
 
+    FileStream::FileStream(vector<std::byte>* memory, uint32_t flags)
+    {
+        // No buffer, the slow paths go straight to memory
+        m_flags     = flags;
+        m_memory    = memory;
+        m_is_open   = memory != nullptr;
+
+        if (m_memory && (m_flags & FileStream_Write) && !(m_flags & FileStream_Append))
+        {
+            m_memory->clear();
+        }
+    }
+
 	FileStream::~FileStream()
 	{
 		Close();
@@ -69,8 +110,15 @@ namespace Spartan
 
 	void FileStream::Close()
 	{
+        if (m_memory)
+        {
+            m_memory_position = 0;
+            return;
+        }
+
 		if (m_flags & FileStream_Write)
 		{
+            BufferFlush();
 			out.flush();
 			out.close();
 		}
@@ -79,14 +127,16 @@ namespace Spartan
 			in.clear();
 			in.close();
 		}
+
+        m_buffer_position   = 0;
+        m_buffer_size       = 0;
 	}
 
 	void FileStream::Write(const string& value)
 	{
 		const auto length = static_cast<uint32_t>(value.length());
 		Write(length);
-
-		out.write(const_cast<char*>(value.c_str()), length);
+        WriteBytes(value.data(), length);
 	}
 
 	void FileStream::Write(const vector<string>& value)
@@ -100,44 +150,34 @@ namespace Spartan
 		}
 	}
 
-	void FileStream::Write(const vector<RHI_Vertex_PosTexNorTan>& value)
-	{
-		const auto length = static_cast<uint32_t>(value.size());
-		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(RHI_Vertex_PosTexNorTan) * length);
-	}
-
-	void FileStream::Write(const vector<uint32_t>& value)
-	{
-		const auto length = static_cast<uint32_t>(value.size());
-		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
-	}
-
-	void FileStream::Write(const vector<unsigned char>& value)
-	{
-		const auto size = static_cast<uint32_t>(value.size());
-		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(unsigned char) * size);
-	}
-
-	void FileStream::Write(const vector<std::byte>& value)
-	{
-		const auto size = static_cast<uint32_t>(value.size());
-		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
-	}
-
 	void FileStream::Skip(uint32_t n)
 	{
-		// Set the seek cursor to offset n from the current position
 		if (m_flags & FileStream_Write)
 		{
-			out.seekp(n, ios::cur);
+            // Skipped bytes are written as zeros, a compressed stream can't seek
+            static const char zeros[256] = {};
+            while (n != 0)
+            {
+                const uint32_t count = n < sizeof(zeros) ? n : static_cast<uint32_t>(sizeof(zeros));
+                WriteBytes(zeros, count);
+                n -= count;
+            }
+		}
+		else if (m_memory)
+		{
+            m_memory_position = Math::Min(m_memory_position + n, m_memory->size());
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.ignore(n, ios::cur);
+            while (n != 0)
+            {
+                if (m_buffer_position == m_buffer_size && !BufferFill())
+                    return;
+
+                const size_t count = Math::Min(static_cast<size_t>(n), m_buffer_size - m_buffer_position);
+                m_buffer_position += count;
+                n -= static_cast<uint32_t>(count);
+            }
 		}
 	}
 
@@ -147,7 +187,7 @@ namespace Spartan
 		Read(&length);
 
 		value->resize(length);
-		in.read(const_cast<char*>(value->c_str()), length);
+        ReadBytes(value->data(), length);
 	}
 
 	void FileStream::Read(vector<string>* vec)
@@ -169,67 +209,163 @@ namespace Spartan
 		}
 	}
 
-	void FileStream::Read(vector<RHI_Vertex_PosTexNorTan>* vec)
-	{
-		if (!vec)
-			return;
-
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
-	}
-
-	void FileStream::Read(vector<uint32_t>* vec)
-	{
-		if (!vec)
-			return;
-
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
-	}
-
-	void FileStream::Read(vector<unsigned char>* vec)
-	{
-		if (!vec)
-			return;
-
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
-	}
-
-	void FileStream::Read(vector<std::byte>* vec)
-	{
-		if (!vec)
-			return;
-
-		vec->clear();
-		vec->shrink_to_fit();
-
-		const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
-	}
+    void FileStream::WriteBytesSlow(const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+
+        if (m_memory)
+        {
+            const std::byte* memory_bytes = reinterpret_cast<const std::byte*>(bytes);
+            m_memory->insert(m_memory->end(), memory_bytes, memory_bytes + size);
+            return;
+        }
+
+        while (size != 0)
+        {
+            if (m_buffer_position == m_buffer.size())
+            {
+                BufferFlush();
+            }
+
+            // Large plain writes skip the buffer
+            if (!m_compressed && m_buffer_position == 0 && size >= m_buffer.size())
+            {
+                out.write(bytes, static_cast<streamsize>(size));
+                return;
+            }
+
+            const size_t count = Math::Min(size, m_buffer.size() - m_buffer_position);
+            memcpy(m_buffer.data() + m_buffer_position, bytes, count);
+            m_buffer_position   += count;
+            bytes               += count;
+            size                -= count;
+        }
+    }
+
+    void FileStream::ReadBytesSlow(void* data, size_t size)
+    {
+        char* bytes = static_cast<char*>(data);
+
+        if (m_memory)
+        {
+            const size_t count = Math::Min(size, m_memory->size() - m_memory_position);
+            memcpy(bytes, m_memory->data() + m_memory_position, count);
+            m_memory_position += count;
+
+            if (count != size)
+            {
+                LOG_ERROR("Attempted to read past the end of the memory");
+                memset(bytes + count, 0, size - count);
+            }
+            return;
+        }
+
+        while (size != 0)
+        {
+            const size_t available = m_buffer_size - m_buffer_position;
+            if (available == 0)
+            {
+                // Large plain reads skip the buffer
+                if (!m_compressed && size >= m_buffer.size())
+                {
+                    in.read(bytes, static_cast<streamsize>(size));
+                    return;
+                }
+
+                if (!BufferFill())
+                {
+                    LOG_ERROR("Attempted to read past the end of the file");
+                    memset(bytes, 0, size);
+                    return;
+                }
+                continue;
+            }
+
+            const size_t count = Math::Min(size, available);
+            memcpy(bytes, m_buffer.data() + m_buffer_position, count);
+            m_buffer_position   += count;
+            bytes               += count;
+            size                -= count;
+        }
+    }
+
+    void FileStream::BufferFlush()
+    {
+        if (m_buffer_position == 0)
+            return;
+
+        if (m_compressed)
+        {
+            m_buffer_compressed.resize(Compression::CompressBound(m_buffer_position));
+            const uint32_t size             = static_cast<uint32_t>(m_buffer_position);
+            const uint32_t size_compressed  = static_cast<uint32_t>(Compression::Compress
+            (
+                reinterpret_cast<const std::byte*>(m_buffer.data()),
+                m_buffer_position,
+                reinterpret_cast<std::byte*>(m_buffer_compressed.data()),
+                m_buffer_compressed.size()
+            ));
+
+            // Store the chunk as is if it didn't compress
+            const bool stored           = size_compressed == 0 || size_compressed >= size;
+            const uint32_t size_stored  = stored ? size : size_compressed;
+            out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            out.write(reinterpret_cast<const char*>(&size_stored), sizeof(size_stored));
+            out.write(stored ? m_buffer.data() : m_buffer_compressed.data(), size_stored);
+        }
+        else
+        {
+            out.write(m_buffer.data(), static_cast<streamsize>(m_buffer_position));
+        }
+
+        m_buffer_position = 0;
+    }
+
+    bool FileStream::BufferFill()
+    {
+        m_buffer_position   = 0;
+        m_buffer_size       = 0;
+
+        if (!m_compressed)
+        {
+            in.read(m_buffer.data(), static_cast<streamsize>(m_buffer.size()));
+            m_buffer_size = static_cast<size_t>(in.gcount());
+            return m_buffer_size != 0;
+        }
+
+        uint32_t size           = 0;
+        uint32_t size_stored    = 0;
+        in.read(reinterpret_cast<char*>(&size), sizeof(size));
+        in.read(reinterpret_cast<char*>(&size_stored), sizeof(size_stored));
+        if (in.gcount() != sizeof(size_stored) || size == 0 || size > m_buffer.size() || size_stored > size)
+            return false;
+
+        if (size_stored == size)
+        {
+            in.read(m_buffer.data(), size);
+            m_buffer_size = static_cast<size_t>(in.gcount()) == size ? size : 0;
+        }
+        else
+        {
+            m_buffer_compressed.resize(size_stored);
+            in.read(m_buffer_compressed.data(), size_stored);
+            if (static_cast<size_t>(in.gcount()) == size_stored && Compression::Decompress
+            (
+                reinterpret_cast<const std::byte*>(m_buffer_compressed.data()),
+                size_stored,
+                reinterpret_cast<std::byte*>(m_buffer.data()),
+                size
+            ))
+            {
+                m_buffer_size = size;
+            }
+        }
+
+        if (m_buffer_size == 0)
+        {
+            LOG_ERROR("Corrupt compressed chunk");
+        }
+
+        return m_buffer_size != 0;
+    }
 }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===================
 #include <vector>
 #include <fstream>
+#include <cstring>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
@@ -37,112 +38,114 @@ namespace Spartan
 
 	enum FileStream_Mode : uint32_t
 	{
-		FileStream_Read		= 1 << 0,
-		FileStream_Write	= 1 << 1,
-		FileStream_Append	= 1 << 2,
+		FileStream_Read		    = 1 << 0,
+		FileStream_Write	    = 1 << 1,
+		FileStream_Append	    = 1 << 2,
+        FileStream_Compressed   = 1 << 3  // Writes independently decodable compressed chunks. Reading accepts both compressed and plain files.
 	};
 
+    // Types which are written and read as their raw bytes
+    template <class T>
+    struct is_stream_pod : std::integral_constant<bool,
+        std::is_same<T, bool>::value				||
+        std::is_same<T, unsigned char>::value		||
+        std::is_same<T, int>::value					||
+        std::is_same<T, long>::value				||
+        std::is_same<T, long long>::value			||
+        std::is_same<T, uint8_t>::value			    ||
+        std::is_same<T, uint16_t>::value			||
+        std::is_same<T, uint32_t>::value			||
+        std::is_same<T, uint64_t>::value			||
+        std::is_same<T, unsigned long>::value		||
+        std::is_same<T, unsigned long long>::value	||
+        std::is_same<T, float>::value				||
+        std::is_same<T, double>::value				||
+        std::is_same<T, long double>::value			||
+        std::is_same<T, std::byte>::value			||
+        std::is_same<T, Math::Vector2>::value		||
+        std::is_same<T, Math::Vector3>::value		||
+        std::is_same<T, Math::Vector4>::value		||
+        std::is_same<T, Math::Quaternion>::value	||
+        std::is_same<T, Math::BoundingBox>::value   ||
+        std::is_same<T, RHI_Vertex_PosTexNorTan>::value
+    > {};
+
+    // All reads and writes go through an internal buffer, so the many small values entities
+    // serialize turn into a few large file operations. In compressed mode every buffer is
+    // compressed on its own, which is what makes the chunks independently decodable.
+    // A stream can also target a byte vector instead of a file, that's never compressed.
 	class SPARTAN_CLASS FileStream
 	{
 	public:
+        static constexpr size_t buffer_size = 1024 * 1024; // also the uncompressed size of a chunk
+
 		FileStream(const std::string& path, uint32_t flags);
+        FileStream(std::vector<std::byte>* memory, uint32_t flags);
 		~FileStream();
 
 		auto IsOpen() const { return m_is_open; }
 		void Close();
 
+        // Bytes written to or read from a memory stream so far
+        size_t GetMemoryPosition() const { return m_memory ? (m_flags & FileStream_Write ? m_memory->size() : m_memory_position) : 0; }
+
 		//= WRITING ==================================================
-		template <class T, class = typename std::enable_if<
-			std::is_same<T, bool>::value				||
-			std::is_same<T, unsigned char>::value		||		
-			std::is_same<T, int>::value					||
-			std::is_same<T, long>::value				||
-			std::is_same<T, long long>::value			||
-			std::is_same<T, uint8_t>::value			    ||
-            std::is_same<T, uint16_t>::value			||
-            std::is_same<T, uint32_t>::value			||
-            std::is_same<T, uint64_t>::value			||
-			std::is_same<T, unsigned long>::value		||
-			std::is_same<T, unsigned long long>::value	||
-			std::is_same<T, float>::value				||
-			std::is_same<T, double>::value				||
-			std::is_same<T, long double>::value			||
-			std::is_same<T, std::byte>::value			||
-			std::is_same<T, Math::Vector2>::value		||
-			std::is_same<T, Math::Vector3>::value		||
-			std::is_same<T, Math::Vector4>::value		||
-			std::is_same<T, Math::Quaternion>::value	||
-			std::is_same<T, Math::BoundingBox>::value
-		>::type>
+		template <class T, class = typename std::enable_if<is_stream_pod<T>::value>::type>
 		void Write(T value)
 		{
-			out.write(reinterpret_cast<char*>(&value), sizeof(value));
+            WriteBytes(&value, sizeof(value));
 		}
 
+        // Contiguous values, without a count
+        template <class T, class = typename std::enable_if<is_stream_pod<T>::value>::type>
+        void Write(const T* values, const size_t count)
+        {
+            WriteBytes(values, sizeof(T) * count);
+        }
+
+        // A count followed by the values
+        template <class T, class = typename std::enable_if<is_stream_pod<T>::value && !std::is_same<T, bool>::value>::type>
+        void Write(const std::vector<T>& values)
+        {
+            Write(static_cast<uint32_t>(values.size()));
+            Write(values.data(), values.size());
+        }
+
 		void Write(const std::string& value);
 		void Write(const std::vector<std::string>& value);
-		void Write(const std::vector<RHI_Vertex_PosTexNorTan>& value);
-		void Write(const std::vector<uint32_t>& value);
-		void Write(const std::vector<unsigned char>& value);
-		void Write(const std::vector<std::byte>& value);
 		void Skip(uint32_t n);
 		//===========================================================
 		
 		//= READING ===========================================
-		template <class T, class = typename std::enable_if
-		<
-			std::is_same<T, bool>::value				||
-			std::is_same<T, unsigned char>::value		||
-			std::is_same<T, int>::value					||
-			std::is_same<T, long>::value				||
-			std::is_same<T, long long>::value			||
-            std::is_same<T, uint8_t>::value			    ||
-            std::is_same<T, uint16_t>::value			||
-            std::is_same<T, uint32_t>::value			||
-			std::is_same<T, uint64_t>::value			||
-			std::is_same<T, unsigned long>::value		||
-			std::is_same<T, unsigned long long>::value	||
-			std::is_same<T, float>::value				||
-			std::is_same<T, double>::value				||
-			std::is_same<T, long double>::value			||
-			std::is_same<T, std::byte>::value			||
-			std::is_same<T, Math::Vector2>::value		||
-			std::is_same<T, Math::Vector3>::value		||
-			std::is_same<T, Math::Vector4>::value		||
-			std::is_same<T, Math::Quaternion>::value	||
-			std::is_same<T, Math::BoundingBox>::value
-		>::type>
+		template <class T, class = typename std::enable_if<is_stream_pod<T>::value>::type>
 		void Read(T* value)
 		{
-			in.read(reinterpret_cast<char*>(value), sizeof(T));
+            ReadBytes(value, sizeof(T));
 		}
+
+        template <class T, class = typename std::enable_if<is_stream_pod<T>::value>::type>
+        void Read(T* values, const size_t count)
+        {
+            ReadBytes(values, sizeof(T) * count);
+        }
+
+        template <class T, class = typename std::enable_if<is_stream_pod<T>::value && !std::is_same<T, bool>::value>::type>
+        void Read(std::vector<T>* vec)
+        {
+            if (!vec)
+                return;
+
+            vec->clear();
+            vec->shrink_to_fit();
+            vec->resize(ReadAs<uint32_t>());
+            Read(vec->data(), vec->size());
+        }
+
 		void Read(std::string* value);
 		void Read(std::vector<std::string>* vec);
-		void Read(std::vector<RHI_Vertex_PosTexNorTan>* vec);
-		void Read(std::vector<uint32_t>* vec);
-		void Read(std::vector<unsigned char>* vec);
-		void Read(std::vector<std::byte>* vec);
 
 		// Reading with explicit type definition
-		template <class T, class = typename std::enable_if
-		<
-			std::is_same<T, bool>::value				||
-			std::is_same<T, unsigned char>::value		||		
-			std::is_same<T, int>::value					||
-			std::is_same<T, long>::value				||
-			std::is_same<T, long long>::value			||
-			std::is_same<T, uint8_t>::value			    ||
-            std::is_same<T, uint16_t>::value			||
-            std::is_same<T, uint32_t>::value			||
-            std::is_same<T, uint64_t>::value			||
-			std::is_same<T, unsigned long>::value		||
-			std::is_same<T, unsigned long long>::value	||
-			std::is_same<T, float>::value				||
-			std::is_same<T, double>::value				||
-			std::is_same<T, long double>::value			||
-			std::is_same<T, std::byte>::value			||
-			std::is_same<T, std::string>::value
-		>::type> 
+		template <class T, class = typename std::enable_if<is_stream_pod<T>::value || std::is_same<T, std::string>::value>::type>
 		T ReadAs()
 		{
 			T value;
@@ -152,9 +155,45 @@ namespace Spartan
 		//=====================================================
 
 	private:
+        void WriteBytes(const void* data, const size_t size)
+        {
+            if (size <= m_buffer.size() - m_buffer_position)
+            {
+                memcpy(m_buffer.data() + m_buffer_position, data, size);
+                m_buffer_position += size;
+                return;
+            }
+
+            WriteBytesSlow(data, size);
+        }
+
+        void ReadBytes(void* data, const size_t size)
+        {
+            if (size <= m_buffer_size - m_buffer_position)
+            {
+                memcpy(data, m_buffer.data() + m_buffer_position, size);
+                m_buffer_position += size;
+                return;
+            }
+
+            ReadBytesSlow(data, size);
+        }
+
+        void WriteBytesSlow(const void* data, size_t size);
+        void ReadBytesSlow(void* data, size_t size);
+        void BufferFlush();
+        bool BufferFill();
+
 		std::ofstream out;
 		std::ifstream in;
 		uint32_t m_flags;
 		bool m_is_open;
+        bool m_compressed           = false;
+        std::vector<char> m_buffer;
+        size_t m_buffer_position    = 0; // next byte to write or read
+        size_t m_buffer_size        = 0; // bytes available for reading
+        std::vector<char> m_buffer_compressed;
+        std::vector<std::byte>* m_memory    = nullptr;
+        size_t m_memory_position            = 0;
 	};
 }
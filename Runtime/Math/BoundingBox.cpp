@@ -58,13 +58,20 @@ namespace Spartan::Math
         }
     }
 
-	BoundingBox::BoundingBox(const std::vector<RHI_Vertex_PosTexNorTan>& vertices)
+	BoundingBox::BoundingBox(const std::vector<RHI_Vertex_PosTexNorTan>& vertices) : BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()))
+	{
+
+	}
+
+	BoundingBox::BoundingBox(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count)
 	{
 		m_min = Vector3::Infinity;
 		m_max = Vector3::InfinityNeg;
 
-		for (const auto& vertex : vertices)
+		for (uint32_t i = 0; i < vertex_count; i++)
 		{
+			const RHI_Vertex_PosTexNorTan& vertex = vertices[i];
+
 			m_max.x = Max(m_max.x, vertex.pos[0]);
 			m_max.y = Max(m_max.y, vertex.pos[1]);
 			m_max.z = Max(m_max.z, vertex.pos[2]);
@@ -130,7 +137,7 @@ namespace Spartan::Math
         m_min.y = Min(m_min.y, box.m_min.y);
         m_min.z = Min(m_min.z, box.m_min.z);
         m_max.x = Max(m_max.x, box.m_max.x);
-        m_max.y = Max(m_max.x, box.m_max.x);
-        m_max.z = Max(m_max.x, box.m_max.x);
+        m_max.y = Max(m_max.y, box.m_max.y);
+        m_max.z = Max(m_max.z, box.m_max.z);
     }
 }
@@ -50,6 +50,7 @@ namespace Spartan
 
 			// Construct from vertices
 			BoundingBox(const std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+			BoundingBox(const RHI_Vertex_PosTexNorTan* vertices, uint32_t vertex_count);
 
             ~BoundingBox() = default;
 
@@ -72,6 +73,13 @@ namespace Spartan
 			// Test if a bounding box is inside
 			Intersection IsInside (const BoundingBox& box) const;
 
+			// Squared distance to a point, zero if the point is inside
+			float DistanceSquared(const Vector3& point) const
+			{
+				const Vector3 closest = Vector3(Clamp(point.x, m_min.x, m_max.x), Clamp(point.y, m_min.y, m_max.y), Clamp(point.z, m_min.z, m_max.z));
+				return Vector3::DistanceSquared(point, closest);
+			}
+
 			// Returns a transformed bounding box
 			BoundingBox Transform(const Matrix& transform) const;
 
@@ -0,0 +1,322 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =====================
+#include "BoundingVolumeHierarchy.h"
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Math
+{
+    namespace
+    {
+        BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box = a;
+            box.Merge(b);
+            return box;
+        }
+
+        BoundingBox fattened(const BoundingBox& box, const float margin_ratio, const float margin_min)
+        {
+            const Vector3 size      = box.GetSize();
+            const Vector3 margin    = Vector3(Max(size.x * margin_ratio, margin_min), Max(size.y * margin_ratio, margin_min), Max(size.z * margin_ratio, margin_min));
+            return BoundingBox(box.GetMin() - margin, box.GetMax() + margin);
+        }
+
+        float surface_area(const BoundingBox& box)
+        {
+            const Vector3 size = box.GetSize();
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::Insert(const BoundingBox& box, void* user_data)
+    {
+        const uint32_t proxy = NodeAllocate();
+
+        Node& node      = m_nodes[proxy];
+        node.box        = fattened(box, fat_margin, fat_margin_min);
+        node.user_data  = user_data;
+        node.height     = 0;
+
+        LeafInsert(proxy);
+        m_proxy_count++;
+
+        return proxy;
+    }
+
+    void BoundingVolumeHierarchy::Remove(const uint32_t proxy)
+    {
+        SPARTAN_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+        LeafRemove(proxy);
+        NodeFree(proxy);
+        m_proxy_count--;
+    }
+
+    bool BoundingVolumeHierarchy::Move(const uint32_t proxy, const BoundingBox& box)
+    {
+        SPARTAN_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+        if (m_nodes[proxy].box.IsInside(box) == Inside)
+            return false;
+
+        LeafRemove(proxy);
+
+        m_nodes[proxy].box = fattened(box, fat_margin, fat_margin_min);
+
+        LeafInsert(proxy);
+
+        return true;
+    }
+
+    void BoundingVolumeHierarchy::Clear()
+    {
+        m_nodes.clear();
+        m_nodes_free.clear();
+        m_root          = null_proxy;
+        m_proxy_count   = 0;
+    }
+
+    void BoundingVolumeHierarchy::QueryFrustumSplit(const Frustum& frustum, const bool ignore_near_plane, const uint32_t count, vector<FrustumSubtree>* subtrees) const
+    {
+        subtrees->clear();
+        if (m_root == null_proxy)
+            return;
+
+        const Intersection result = frustum.CheckBox(m_nodes[m_root].box, ignore_near_plane);
+        if (result == Outside)
+            return;
+
+        subtrees->push_back({ m_root, result == Inside });
+
+        // Replace intersecting nodes with their overlapping children until there are enough, subtrees which are
+        // entirely inside and leaves can't be split any further
+        for (uint32_t i = 0; i < static_cast<uint32_t>(subtrees->size()) && static_cast<uint32_t>(subtrees->size()) < count;)
+        {
+            const FrustumSubtree subtree = (*subtrees)[i];
+            const Node& node = m_nodes[subtree.node];
+            if (subtree.inside || node.IsLeaf())
+            {
+                i++;
+                continue;
+            }
+
+            subtrees->erase(subtrees->begin() + i);
+            for (const uint32_t child : { node.child_left, node.child_right })
+            {
+                const Intersection result_child = frustum.CheckBox(m_nodes[child].box, ignore_near_plane);
+                if (result_child != Outside)
+                {
+                    subtrees->push_back({ child, result_child == Inside });
+                }
+            }
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::NodeAllocate()
+    {
+        if (!m_nodes_free.empty())
+        {
+            const uint32_t index = m_nodes_free.back();
+            m_nodes_free.pop_back();
+            m_nodes[index] = Node();
+            return index;
+        }
+
+        m_nodes.emplace_back();
+        return static_cast<uint32_t>(m_nodes.size()) - 1;
+    }
+
+    void BoundingVolumeHierarchy::NodeFree(const uint32_t index)
+    {
+        m_nodes[index].height = -1;
+        m_nodes_free.emplace_back(index);
+    }
+
+    void BoundingVolumeHierarchy::LeafInsert(const uint32_t leaf)
+    {
+        if (m_root == null_proxy)
+        {
+            m_root                  = leaf;
+            m_nodes[leaf].parent    = null_proxy;
+            return;
+        }
+
+        // Find the best sibling, descend towards the child which grows the surface area of the tree the least (surface area heuristic)
+        const BoundingBox box_leaf  = m_nodes[leaf].box;
+        uint32_t index              = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const Node& node = m_nodes[index];
+
+            const float area            = surface_area(node.box);
+            const float area_combined   = surface_area(merged(node.box, box_leaf));
+
+            // Cost of making a new parent for this node and the leaf
+            const float cost = 2.0f * area_combined;
+
+            // Minimum cost of pushing the leaf further down the tree
+            const float cost_inheritance = 2.0f * (area_combined - area);
+
+            const auto cost_descend = [this, &box_leaf, cost_inheritance](const uint32_t child)
+            {
+                const BoundingBox& box_child = m_nodes[child].box;
+                const float area_new         = surface_area(merged(box_leaf, box_child));
+                return (m_nodes[child].IsLeaf() ? area_new : area_new - surface_area(box_child)) + cost_inheritance;
+            };
+            const float cost_left   = cost_descend(node.child_left);
+            const float cost_right  = cost_descend(node.child_right);
+
+            if (cost < cost_left && cost < cost_right)
+                break;
+
+            index = cost_left < cost_right ? node.child_left : node.child_right;
+        }
+        const uint32_t sibling = index;
+
+        // Create a new parent for the sibling and the leaf (the allocation can move the nodes, so no references are held across it)
+        const uint32_t parent_old   = m_nodes[sibling].parent;
+        const uint32_t parent_new   = NodeAllocate();
+        Node& parent                = m_nodes[parent_new];
+        parent.parent               = parent_old;
+        parent.box                  = merged(box_leaf, m_nodes[sibling].box);
+        parent.height               = m_nodes[sibling].height + 1;
+        parent.child_left           = sibling;
+        parent.child_right          = leaf;
+        m_nodes[sibling].parent     = parent_new;
+        m_nodes[leaf].parent        = parent_new;
+
+        ChildReplace(parent_old, sibling, parent_new);
+
+        // Walk back up, fixing heights and boxes
+        Refit(m_nodes[leaf].parent);
+    }
+
+    void BoundingVolumeHierarchy::LeafRemove(const uint32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = null_proxy;
+            return;
+        }
+
+        // The sibling takes the place of the parent
+        const uint32_t parent       = m_nodes[leaf].parent;
+        const uint32_t grandparent  = m_nodes[parent].parent;
+        const uint32_t sibling      = m_nodes[parent].child_left == leaf ? m_nodes[parent].child_right : m_nodes[parent].child_left;
+
+        m_nodes[sibling].parent = grandparent;
+        ChildReplace(grandparent, parent, sibling);
+        NodeFree(parent);
+
+        Refit(grandparent);
+    }
+
+    void BoundingVolumeHierarchy::ChildReplace(const uint32_t parent, const uint32_t child_old, const uint32_t child_new)
+    {
+        if (parent == null_proxy)
+        {
+            m_root = child_new;
+            return;
+        }
+
+        Node& node = m_nodes[parent];
+        if (node.child_left == child_old)
+        {
+            node.child_left = child_new;
+        }
+        else
+        {
+            SPARTAN_ASSERT(node.child_right == child_old);
+            node.child_right = child_new;
+        }
+    }
+
+    void BoundingVolumeHierarchy::Refit(uint32_t index)
+    {
+        while (index != null_proxy)
+        {
+            index = Balance(index);
+
+            Node& node  = m_nodes[index];
+            node.height = 1 + Max(m_nodes[node.child_left].height, m_nodes[node.child_right].height);
+            node.box    = merged(m_nodes[node.child_left].box, m_nodes[node.child_right].box);
+
+            index = node.parent;
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::Balance(const uint32_t index_a)
+    {
+        // If the subtrees of a differ in height by more than one, the taller child (b or c) is rotated up to take a's place.
+        // Of the taller child's children (f and g), the taller stays with it and the shorter moves under a.
+        Node& a = m_nodes[index_a];
+        if (a.IsLeaf() || a.height < 2)
+            return index_a;
+
+        const uint32_t index_b  = a.child_left;
+        const uint32_t index_c  = a.child_right;
+        const int32_t balance   = m_nodes[index_c].height - m_nodes[index_b].height;
+        if (balance >= -1 && balance <= 1)
+            return index_a;
+
+        const bool rotate_right         = balance > 1; // c goes up
+        const uint32_t index_up         = rotate_right ? index_c : index_b;
+        const uint32_t index_stay       = rotate_right ? index_b : index_c;
+        Node& up                        = m_nodes[index_up];
+        const uint32_t index_f          = up.child_left;
+        const uint32_t index_g          = up.child_right;
+        const bool f_is_taller          = m_nodes[index_f].height > m_nodes[index_g].height;
+        const uint32_t index_up_keeps   = f_is_taller ? index_f : index_g;
+        const uint32_t index_a_takes    = f_is_taller ? index_g : index_f;
+
+        // Swap a and the child that goes up
+        up.child_left   = index_a;
+        up.parent       = a.parent;
+        a.parent        = index_up;
+
+        ChildReplace(up.parent, index_a, index_up);
+
+        // Rotate, a keeps its other child on the side it was on
+        up.child_right = index_up_keeps;
+        if (rotate_right)
+        {
+            a.child_right = index_a_takes;
+        }
+        else
+        {
+            a.child_left = index_a_takes;
+        }
+        m_nodes[index_a_takes].parent = index_a;
+
+        a.box       = merged(m_nodes[index_stay].box, m_nodes[index_a_takes].box);
+        a.height    = 1 + Max(m_nodes[index_stay].height, m_nodes[index_a_takes].height);
+        up.box      = merged(a.box, m_nodes[index_up_keeps].box);
+        up.height   = 1 + Max(a.height, m_nodes[index_up_keeps].height);
+
+        return index_up;
+    }
+}
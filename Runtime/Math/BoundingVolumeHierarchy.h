@@ -0,0 +1,316 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <limits>
+#include "../Core/EngineDefs.h"
+#include "BoundingBox.h"
+#include "Frustum.h"
+//=============================
+
+namespace Spartan::Math
+{
+    // A dynamic bounding volume hierarchy (AABB tree). Leaves store a fattened box, so small movements don't
+    // touch the tree at all, and the tree is kept balanced with rotations as leaves are inserted and removed.
+    // A proxy is the index of a leaf and stays the same until the leaf is removed.
+    // Queries only read the tree, so any number of them can run in parallel as long as nothing modifies it.
+    class SPARTAN_CLASS BoundingVolumeHierarchy
+    {
+    public:
+        static constexpr uint32_t null_proxy = std::numeric_limits<uint32_t>::max();
+
+        // A node that overlaps a frustum, inside means that the whole subtree is in it
+        struct FrustumSubtree
+        {
+            uint32_t node   = null_proxy;
+            bool inside     = false;
+        };
+
+        BoundingVolumeHierarchy() = default;
+        ~BoundingVolumeHierarchy() = default;
+
+        // Returns the proxy of the new leaf
+        uint32_t Insert(const BoundingBox& box, void* user_data);
+        void Remove(uint32_t proxy);
+
+        // Returns true if the leaf had to be re-inserted, false if the box still fits in the leaf's fattened box
+        bool Move(uint32_t proxy, const BoundingBox& box);
+
+        void Clear();
+
+        void* GetUserData(const uint32_t proxy)         const { return m_nodes[proxy].user_data; }
+        const BoundingBox& GetBox(const uint32_t proxy) const { return m_nodes[proxy].box; }
+        uint32_t GetProxyCount()                        const { return m_proxy_count; }
+        uint32_t GetHeight()                            const { return m_root == null_proxy ? 0 : static_cast<uint32_t>(m_nodes[m_root].height); }
+
+        // Proxies are always smaller than this, so it can size lookup tables indexed by proxy
+        uint32_t GetCapacity() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+        // The queries below invoke callback(proxy) for every leaf whose fattened box passes the test, callers that need
+        // exact results test their own bounds in the callback. Returning false from the callback ends the query.
+        template <typename Callback>
+        void QueryBox(const BoundingBox& box, Callback&& callback) const
+        {
+            Query([&box](const BoundingBox& node_box) { return box.IsInside(node_box); }, callback);
+        }
+
+        template <typename Callback>
+        void QuerySphere(const Vector3& center, const float radius, Callback&& callback) const
+        {
+            Query([&center, radius](const BoundingBox& node_box) { return node_box.DistanceSquared(center) <= radius * radius ? Intersects : Outside; }, callback);
+        }
+
+        template <typename Callback>
+        void QueryFrustum(const Frustum& frustum, const bool ignore_near_plane, Callback&& callback) const
+        {
+            Query([&frustum, ignore_near_plane](const BoundingBox& node_box) { return frustum.CheckBox(node_box, ignore_near_plane); }, callback);
+        }
+
+        // Splits the part of the tree that overlaps the frustum into (up to) count disjoint subtrees, breadth first,
+        // so that a single frustum query can be spread over several threads with QueryFrustumSubtree()
+        void QueryFrustumSplit(const Frustum& frustum, bool ignore_near_plane, uint32_t count, std::vector<FrustumSubtree>* subtrees) const;
+
+        // Invokes callback(proxy, inside) for every leaf of the subtree whose fattened box passes the test. Inside means the
+        // fattened box (and so the leaf's own bounds) is entirely in the frustum, so the leaf needs no further tests.
+        template <typename Callback>
+        void QueryFrustumSubtree(const Frustum& frustum, const bool ignore_near_plane, const FrustumSubtree& subtree, Callback&& callback) const
+        {
+            if (subtree.inside)
+            {
+                QueryAll(subtree.node, [&callback](const uint32_t proxy) { return callback(proxy, true); });
+                return;
+            }
+
+            uint32_t stack[stack_size];
+            uint32_t stack_count = 0;
+            stack[stack_count++] = subtree.node;
+
+            while (stack_count > 0)
+            {
+                const uint32_t index    = stack[--stack_count];
+                const Node& node        = m_nodes[index];
+
+                const Intersection result = frustum.CheckBox(node.box, ignore_near_plane);
+                if (result == Outside)
+                    continue;
+
+                if (result == Inside)
+                {
+                    if (!QueryAll(index, [&callback](const uint32_t proxy) { return callback(proxy, true); }))
+                        return;
+                }
+                else if (node.IsLeaf())
+                {
+                    if (!callback(index, false))
+                        return;
+                }
+                else
+                {
+                    SPARTAN_ASSERT(stack_count + 2 <= stack_size);
+                    stack[stack_count++] = node.child_right;
+                    stack[stack_count++] = node.child_left;
+                }
+            }
+        }
+
+        // Walks the leaves the ray enters within max_distance, nearest subtree first. The callback returns the distance
+        // the query continues up to, so returning a hit distance prunes everything behind it (nearest hit) while
+        // returning max_distance keeps collecting, a negative value ends the query.
+        template <typename Callback>
+        void QueryRay(const Vector3& origin, const Vector3& direction, float max_distance, Callback&& callback) const
+        {
+            if (m_root == null_proxy)
+                return;
+
+            const Vector3 direction_inverse = Vector3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+            struct StackEntry
+            {
+                uint32_t node;
+                float distance;
+            };
+            StackEntry stack[stack_size];
+            uint32_t stack_count = 0;
+
+            const float distance_root = RayDistance(m_nodes[m_root].box, origin, direction_inverse);
+            if (distance_root <= max_distance)
+            {
+                stack[stack_count++] = { m_root, distance_root };
+            }
+
+            while (stack_count > 0)
+            {
+                const StackEntry entry = stack[--stack_count];
+
+                // The distance might have shrunk since the node was pushed
+                if (entry.distance > max_distance)
+                    continue;
+
+                const Node& node = m_nodes[entry.node];
+                if (node.IsLeaf())
+                {
+                    max_distance = callback(entry.node);
+                    if (max_distance < 0.0f)
+                        return;
+
+                    continue;
+                }
+
+                const float distance_left   = RayDistance(m_nodes[node.child_left].box, origin, direction_inverse);
+                const float distance_right  = RayDistance(m_nodes[node.child_right].box, origin, direction_inverse);
+                const bool left_first       = distance_left <= distance_right;
+
+                // Push the farther child first, so that the nearer one is visited first
+                SPARTAN_ASSERT(stack_count + 2 <= stack_size);
+                const StackEntry entry_near = left_first ? StackEntry{ node.child_left, distance_left } : StackEntry{ node.child_right, distance_right };
+                const StackEntry entry_far  = left_first ? StackEntry{ node.child_right, distance_right } : StackEntry{ node.child_left, distance_left };
+                if (entry_far.distance <= max_distance)
+                {
+                    stack[stack_count++] = entry_far;
+                }
+                if (entry_near.distance <= max_distance)
+                {
+                    stack[stack_count++] = entry_near;
+                }
+            }
+        }
+
+    private:
+        struct Node
+        {
+            bool IsLeaf() const { return child_left == null_proxy; }
+
+            BoundingBox box;
+            void* user_data         = nullptr;
+            uint32_t parent         = null_proxy;
+            uint32_t child_left     = null_proxy;
+            uint32_t child_right    = null_proxy;
+            int32_t height          = 0; // leaves are 0
+        };
+
+        // Leaf boxes grow by this fraction of their size (and at least by fat_margin_min) in every direction
+        static constexpr float fat_margin       = 0.1f;
+        static constexpr float fat_margin_min   = 0.05f;
+
+        // Enough for any tree the balancing produces (its height grows with the logarithm of the leaf count)
+        static constexpr uint32_t stack_size = 256;
+
+        // Walks the tree, overlap(box) decides whether a node is skipped (Outside), descended into (Intersects)
+        // or reported as a whole without testing any of its descendants (Inside)
+        template <typename Overlap, typename Callback>
+        void Query(Overlap&& overlap, Callback& callback) const
+        {
+            if (m_root == null_proxy)
+                return;
+
+            uint32_t stack[stack_size];
+            uint32_t stack_count = 0;
+            stack[stack_count++] = m_root;
+
+            while (stack_count > 0)
+            {
+                const uint32_t index    = stack[--stack_count];
+                const Node& node        = m_nodes[index];
+
+                const Intersection result = overlap(node.box);
+                if (result == Outside)
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    if (!callback(index))
+                        return;
+                }
+                else if (result == Inside)
+                {
+                    if (!QueryAll(index, callback))
+                        return;
+                }
+                else
+                {
+                    SPARTAN_ASSERT(stack_count + 2 <= stack_size);
+                    stack[stack_count++] = node.child_right;
+                    stack[stack_count++] = node.child_left;
+                }
+            }
+        }
+
+        // Reports every leaf under node, returns false if the callback ended the query
+        template <typename Callback>
+        bool QueryAll(const uint32_t node, Callback&& callback) const
+        {
+            uint32_t stack[stack_size];
+            uint32_t stack_count = 0;
+            stack[stack_count++] = node;
+
+            while (stack_count > 0)
+            {
+                const uint32_t index    = stack[--stack_count];
+                const Node& current     = m_nodes[index];
+                if (current.IsLeaf())
+                {
+                    if (!callback(index))
+                        return false;
+                }
+                else
+                {
+                    SPARTAN_ASSERT(stack_count + 2 <= stack_size);
+                    stack[stack_count++] = current.child_right;
+                    stack[stack_count++] = current.child_left;
+                }
+            }
+
+            return true;
+        }
+
+        // Distance along the ray to where it enters the box (0 if it starts inside), or infinity if it misses it
+        static float RayDistance(const BoundingBox& box, const Vector3& origin, const Vector3& direction_inverse)
+        {
+            const float x1 = (box.GetMin().x - origin.x) * direction_inverse.x;
+            const float x2 = (box.GetMax().x - origin.x) * direction_inverse.x;
+            const float y1 = (box.GetMin().y - origin.y) * direction_inverse.y;
+            const float y2 = (box.GetMax().y - origin.y) * direction_inverse.y;
+            const float z1 = (box.GetMin().z - origin.z) * direction_inverse.z;
+            const float z2 = (box.GetMax().z - origin.z) * direction_inverse.z;
+
+            const float distance_enter  = Max(Max(Min(x1, x2), Min(y1, y2)), Max(Min(z1, z2), 0.0f));
+            const float distance_exit   = Min(Min(Max(x1, x2), Max(y1, y2)), Max(z1, z2));
+
+            return distance_enter <= distance_exit ? distance_enter : std::numeric_limits<float>::infinity();
+        }
+
+        uint32_t NodeAllocate();
+        void NodeFree(uint32_t index);
+        void LeafInsert(uint32_t leaf);
+        void LeafRemove(uint32_t leaf);
+        void ChildReplace(uint32_t parent, uint32_t child_old, uint32_t child_new);
+        uint32_t Balance(uint32_t index);
+        void Refit(uint32_t index);
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_nodes_free;
+        uint32_t m_root         = null_proxy;
+        uint32_t m_proxy_count  = 0;
+    };
+}
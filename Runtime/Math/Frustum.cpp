@@ -22,9 +22,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =======
 #include "Frustum.h"
 #include "Plane.h"
+#include "BoundingBox.h"
 #include <limits>
 //==================
 
+#if defined(_M_X64) || defined(__SSE2__)
+    #define FRUSTUM_CULL_SSE
+    #include <xmmintrin.h>
+#endif
+
 //= NAMESPACES =====
 using namespace std;
 //==================
@@ -159,4 +165,108 @@ namespace Spartan::Math
 		// otherwise we are fully in view
 		return Inside;
 	}
+
+    Intersection Frustum::CheckBox(const BoundingBox& box, const bool ignore_near_plane /*= false*/) const
+    {
+        const Vector3 center = box.GetCenter();
+        const Vector3 extent = box.GetExtents();
+
+        // The near and far planes are the first two
+        const uint32_t plane_first = ignore_near_plane ? 2 : 0;
+
+        // Compare the distance of the center to each plane against the extent projected onto the plane normal
+        Intersection result = Inside;
+        for (uint32_t p = plane_first; p < 6; p++)
+        {
+            const Plane& plane  = m_planes[p];
+            const float d       = Vector3::Dot(plane.normal, center) + plane.d;
+            const float r       = Abs(plane.normal.x) * extent.x + Abs(plane.normal.y) * extent.y + Abs(plane.normal.z) * extent.z;
+
+            if (d + r < 0.0f)
+                return Outside;
+
+            if (d - r < 0.0f)
+            {
+                result = Intersects;
+            }
+        }
+
+        return result;
+    }
+
+    void Frustum::Cull(const BoundingBoxSoA& boxes, const uint32_t* indices, const uint32_t index_count, vector<uint32_t>& visible, const bool ignore_near_plane /*= false*/) const
+    {
+        // The near and far planes are the first two
+        const uint32_t plane_first = ignore_near_plane ? 2 : 0;
+
+        // A box is outside if, for any plane, the distance of its center plus its extent projected onto the plane normal is negative
+        uint32_t i = 0;
+
+#if defined(FRUSTUM_CULL_SSE)
+        __m128 normal_x[6], normal_y[6], normal_z[6], normal_abs_x[6], normal_abs_y[6], normal_abs_z[6], distance[6];
+        for (uint32_t p = plane_first; p < 6; p++)
+        {
+            normal_x[p]     = _mm_set1_ps(m_planes[p].normal.x);
+            normal_y[p]     = _mm_set1_ps(m_planes[p].normal.y);
+            normal_z[p]     = _mm_set1_ps(m_planes[p].normal.z);
+            normal_abs_x[p] = _mm_set1_ps(Abs(m_planes[p].normal.x));
+            normal_abs_y[p] = _mm_set1_ps(Abs(m_planes[p].normal.y));
+            normal_abs_z[p] = _mm_set1_ps(Abs(m_planes[p].normal.z));
+            distance[p]     = _mm_set1_ps(m_planes[p].d);
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= index_count; i += 4)
+        {
+            const uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2], i3 = indices[i + 3];
+            const __m128 center_x = _mm_set_ps(boxes.center_x[i3], boxes.center_x[i2], boxes.center_x[i1], boxes.center_x[i0]);
+            const __m128 center_y = _mm_set_ps(boxes.center_y[i3], boxes.center_y[i2], boxes.center_y[i1], boxes.center_y[i0]);
+            const __m128 center_z = _mm_set_ps(boxes.center_z[i3], boxes.center_z[i2], boxes.center_z[i1], boxes.center_z[i0]);
+            const __m128 extent_x = _mm_set_ps(boxes.extent_x[i3], boxes.extent_x[i2], boxes.extent_x[i1], boxes.extent_x[i0]);
+            const __m128 extent_y = _mm_set_ps(boxes.extent_y[i3], boxes.extent_y[i2], boxes.extent_y[i1], boxes.extent_y[i0]);
+            const __m128 extent_z = _mm_set_ps(boxes.extent_z[i3], boxes.extent_z[i2], boxes.extent_z[i1], boxes.extent_z[i0]);
+
+            __m128 outside = zero;
+            for (uint32_t p = plane_first; p < 6; p++)
+            {
+                __m128 d = _mm_add_ps(_mm_mul_ps(normal_x[p], center_x), distance[p]);
+                d = _mm_add_ps(d, _mm_mul_ps(normal_y[p], center_y));
+                d = _mm_add_ps(d, _mm_mul_ps(normal_z[p], center_z));
+
+                __m128 r = _mm_mul_ps(normal_abs_x[p], extent_x);
+                r = _mm_add_ps(r, _mm_mul_ps(normal_abs_y[p], extent_y));
+                r = _mm_add_ps(r, _mm_mul_ps(normal_abs_z[p], extent_z));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+            }
+
+            const int inside_mask = ~_mm_movemask_ps(outside) & 0xF;
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                if (inside_mask & (1 << lane))
+                {
+                    visible.emplace_back(indices[i + lane]);
+                }
+            }
+        }
+#endif
+
+        for (; i < index_count; i++)
+        {
+            const uint32_t index    = indices[i];
+            bool is_outside         = false;
+            for (uint32_t p = plane_first; p < 6 && !is_outside; p++)
+            {
+                const Plane& plane  = m_planes[p];
+                const float d       = plane.normal.x * boxes.center_x[index] + plane.normal.y * boxes.center_y[index] + plane.normal.z * boxes.center_z[index] + plane.d;
+                const float r       = Abs(plane.normal.x) * boxes.extent_x[index] + Abs(plane.normal.y) * boxes.extent_y[index] + Abs(plane.normal.z) * boxes.extent_z[index];
+                is_outside          = d + r < 0.0f;
+            }
+
+            if (!is_outside)
+            {
+                visible.emplace_back(index);
+            }
+        }
+    }
 }
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =============
+#include <vector>
 #include "../Math/Plane.h"
 #include "Matrix.h"
 #include "Vector3.h"
@@ -29,6 +30,41 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan::Math
 {
+    class BoundingBox;
+
+    // Axis aligned boxes as a structure of arrays, the layout Frustum::Cull() consumes
+    struct BoundingBoxSoA
+    {
+        void Resize(const uint32_t count)
+        {
+            center_x.resize(count);
+            center_y.resize(count);
+            center_z.resize(count);
+            extent_x.resize(count);
+            extent_y.resize(count);
+            extent_z.resize(count);
+        }
+
+        void Set(const uint32_t index, const Vector3& center, const Vector3& extent)
+        {
+            center_x[index] = center.x;
+            center_y[index] = center.y;
+            center_z[index] = center.z;
+            extent_x[index] = extent.x;
+            extent_y[index] = extent.y;
+            extent_z[index] = extent.z;
+        }
+
+        uint32_t Size() const { return static_cast<uint32_t>(center_x.size()); }
+
+        std::vector<float> center_x;
+        std::vector<float> center_y;
+        std::vector<float> center_z;
+        std::vector<float> extent_x;
+        std::vector<float> extent_y;
+        std::vector<float> extent_z;
+    };
+
 	class Frustum
 	{
 	public:
@@ -38,6 +74,14 @@ namespace Spartan::Math
 
         bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane = false) const;
 
+        // Returns whether a box is outside, intersecting or fully inside the frustum.
+        // With ignore_near_plane the depth planes are not tested, so that shadow casters behind the view point survive.
+        Intersection CheckBox(const BoundingBox& box, bool ignore_near_plane = false) const;
+
+        // Appends the indices (taken from the given list) of the boxes that are at least partially inside the frustum,
+        // four boxes are tested at a time with SSE. ignore_near_plane works like it does for CheckBox().
+        void Cull(const BoundingBoxSoA& boxes, const uint32_t* indices, uint32_t index_count, std::vector<uint32_t>& visible, bool ignore_near_plane = false) const;
+
 	private:
         Intersection CheckCube(const Vector3& center, const Vector3& extent) const;
         Intersection CheckSphere(const Vector3& center, float radius) const;
@@ -21,13 +21,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==============================
 #include "Ray.h"
-#include <algorithm>
 #include "RayHit.h"
 #include "../Core/Context.h"
 #include "../World/World.h"
-#include "../World/Entity.h"
-#include "../World/Components/Environment.h"
-#include "../World/Components/Renderable.h"
 //=========================================
 
 //= NAMESPACES =====
@@ -47,40 +43,21 @@ namespace Spartan::Math
 
 	vector<RayHit> Ray::Trace(Context* context) const
 	{
-		// Find all the entities that the ray hits
+		// Find all the entities that the ray hits, sorted by distance (ascending)
 		vector<RayHit> hits;
-		const auto& entities = context->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
-		{
-			// Make sure there entity has a renderable
-			if (!entity->HasComponent<Renderable>())
-				continue;
-
-			// Get object oriented bounding box
-			const auto& aabb = entity->GetComponent<Renderable>()->GetAabb();
-
-			// Compute hit distance
-			auto distance = HitDistance(aabb);
-
-			// Don't store hit data if there was no hit
-			if (distance == INFINITY)
-				continue;
-
-			hits.emplace_back(
-                entity,                             // Entity
-                m_start + distance * m_direction,   // Position
-                distance,                           // Distance
-                distance == 0.0f                    // Inside
-            );
-		}
+		context->GetSubsystem<World>()->SceneQueryRay(*this, hits);
+		return hits;
+	}
 
-		// Sort by distance (ascending)
-		sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
-		{
-			return a.m_distance < b.m_distance;
-		});
+	bool Ray::TraceNearest(Context* context, RayHit* hit) const
+	{
+		vector<RayHit> hits;
+		context->GetSubsystem<World>()->SceneQueryRay(*this, hits, true);
+		if (hits.empty())
+			return false;
 
-		return hits;
+		*hit = hits.front();
+		return true;
 	}
 
 	float Ray::HitDistance(const BoundingBox& box) const
@@ -43,9 +43,12 @@ namespace Spartan
 			Ray(const Vector3& start, const Vector3& end);
 			~Ray() = default;
 
-			// Traces a ray against all entities in the world, returns all hits in a vector.
+			// Traces a ray against all entities in the world (through the world's scene query), returns all hits sorted by distance.
 			std::vector<RayHit> Trace(Context* context) const;
 
+			// Traces a ray against all entities in the world, stopping at the nearest hit. Returns false if nothing was hit.
+			bool TraceNearest(Context* context, RayHit* hit) const;
+
 			// Returns hit distance to a bounding box, or infinity if there is no hit.
 			float HitDistance(const BoundingBox& box) const;
 
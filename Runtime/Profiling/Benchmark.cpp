@@ -0,0 +1,1975 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================================
+#include "Benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "../Core/Context.h"
+#include "../Core/FileSystem.h"
+#include "../Core/Stopwatch.h"
+#include "../Core/Timer.h"
+#include "../IO/FileStream.h"
+#include "../Logging/Log.h"
+#include "../Math/BoundingVolumeHierarchy.h"
+#include "../Math/Frustum.h"
+#include "../Math/Matrix.h"
+#include "../Math/Ray.h"
+#include "../Profiling/Profiler.h"
+#include "../Profiling/TimeBlock.h"
+#include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_Device.h"
+#include "../RHI/RHI_IndexBuffer.h"
+#include "../RHI/RHI_Texture2D.h"
+#include "../RHI/RHI_VertexBuffer.h"
+#include "../Rendering/Material.h"
+#include "../Rendering/MeshSimplifier.h"
+#include "../Rendering/Model.h"
+#include "../Rendering/Renderer.h"
+#include "../RHI/RHI_CommandList.h"
+#include "../Resource/IResource.h"
+#include "../Resource/ResourceCache.h"
+#include "../Utilities/Geometry.h"
+#include "../Utilities/RadixSort.h"
+#include "../World/World.h"
+#include "../World/WorldStreaming.h"
+#include "../World/Components/Camera.h"
+#include "../World/Components/Light.h"
+#include "../World/Components/Renderable.h"
+#include "../World/Components/Transform.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+//============================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        // The scheduler the job system replaced: one deque behind one mutex, with a shared_ptr and a std::function per task
+        class ThreadPoolReference
+        {
+        public:
+            ThreadPoolReference(const uint32_t thread_count)
+            {
+                for (uint32_t i = 0; i < thread_count; i++)
+                {
+                    m_threads.emplace_back(&ThreadPoolReference::Invoke, this);
+                }
+            }
+
+            ~ThreadPoolReference()
+            {
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_stopping = true;
+                }
+                m_condition.notify_all();
+
+                for (thread& thread : m_threads)
+                {
+                    thread.join();
+                }
+            }
+
+            template <typename Function>
+            void AddTask(Function&& task)
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_tasks.push_back(make_shared<function<void()>>(bind(forward<Function>(task))));
+                lock.unlock();
+
+                m_condition.notify_one();
+            }
+
+        private:
+            void Invoke()
+            {
+                shared_ptr<function<void()>> task;
+                while (true)
+                {
+                    unique_lock<mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+                    if (m_stopping && m_tasks.empty())
+                        return;
+
+                    task = m_tasks.front();
+                    m_tasks.pop_front();
+                    lock.unlock();
+
+                    (*task)();
+                }
+            }
+
+            vector<thread> m_threads;
+            deque<shared_ptr<function<void()>>> m_tasks;
+            mutex m_mutex;
+            condition_variable m_condition;
+            bool m_stopping = false;
+        };
+
+        // The lookups the resource cache replaced, a linear scan with string comparisons. Behind a mutex here,
+        // the original read without one and would race with the inserts.
+        class ResourceCacheReference
+        {
+        public:
+            shared_ptr<IResource> GetByName(const string& name)
+            {
+                lock_guard<mutex> lock(m_mutex);
+                for (const auto& resource : m_resources)
+                {
+                    if (resource->GetResourceName() == name)
+                        return resource;
+                }
+                return nullptr;
+            }
+
+            shared_ptr<IResource> GetByPath(const string& path)
+            {
+                lock_guard<mutex> lock(m_mutex);
+                for (const auto& resource : m_resources)
+                {
+                    if (resource->GetResourceFilePathNative() == path)
+                        return resource;
+                }
+                return nullptr;
+            }
+
+            void Cache(const shared_ptr<IResource>& resource)
+            {
+                if (GetByName(resource->GetResourceName()))
+                    return;
+
+                lock_guard<mutex> lock(m_mutex);
+                m_resources.emplace_back(resource);
+            }
+
+        private:
+            vector<shared_ptr<IResource>> m_resources;
+            mutex m_mutex;
+        };
+
+        // The most memory the process has had resident so far, in MB, it never goes down
+        float MemoryPeakMb()
+        {
+            #ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters = {};
+            GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+            return static_cast<float>(counters.PeakWorkingSetSize) / 1024.0f / 1024.0f;
+            #else
+            rusage usage = {};
+            getrusage(RUSAGE_SELF, &usage);
+            return static_cast<float>(usage.ru_maxrss) / 1024.0f; // KB
+            #endif
+        }
+    }
+
+    Benchmark::Benchmark(Context* context)
+    {
+        m_context = context;
+    }
+
+    bool Benchmark::Start(const string& command_line)
+    {
+        istringstream arguments(command_line);
+        string argument;
+        while (arguments >> argument)
+        {
+            if (argument != "-benchmark")
+                continue;
+
+            string name;
+            arguments >> name;
+            if (!(arguments >> m_count))
+            {
+                m_count = 0;
+            }
+
+            if (name == "jobs")
+            {
+                m_type = Benchmark_Jobs;
+            }
+            else if (name == "parallel_for")
+            {
+                m_type = Benchmark_ParallelFor;
+            }
+            else if (name == "transforms")
+            {
+                m_type = Benchmark_Transforms;
+            }
+            else if (name == "components")
+            {
+                m_type = Benchmark_Components;
+            }
+            else if (name == "draw_sort")
+            {
+                m_type = Benchmark_DrawSort;
+            }
+            else if (name == "culling")
+            {
+                m_type = Benchmark_Culling;
+            }
+            else if (name == "resource_cache")
+            {
+                m_type = Benchmark_ResourceCache;
+            }
+            else if (name == "scene_query")
+            {
+                m_type = Benchmark_SceneQuery;
+            }
+            else if (name == "world_load")
+            {
+                m_type = Benchmark_WorldLoad;
+            }
+            else if (name == "world_scaling")
+            {
+                m_type = Benchmark_WorldScaling;
+            }
+            else if (name == "fly_through")
+            {
+                m_type = Benchmark_FlyThrough;
+            }
+            else if (name == "mesh_lod")
+            {
+                m_type = Benchmark_MeshLod;
+            }
+            else if (name == "constant_buffer")
+            {
+                m_type = Benchmark_ConstantBuffer;
+            }
+            else if (name == "draws")
+            {
+                m_type = Benchmark_Draws;
+            }
+            else if (name == "gpu_memory")
+            {
+                m_type = Benchmark_GpuMemory;
+            }
+            else if (name == "buffer_churn")
+            {
+                m_type = Benchmark_BufferChurn;
+            }
+            else if (name == "draw_recording")
+            {
+                m_type = Benchmark_DrawRecording;
+            }
+            else if (name == "asset_load")
+            {
+                m_type = Benchmark_AssetLoad;
+            }
+            else if (name == "world_save")
+            {
+                m_type = Benchmark_WorldSave;
+            }
+            else
+            {
+                LOG_ERROR("Unknown benchmark \"%s\"", name.c_str());
+                return false;
+            }
+
+            LOG_INFO("Running benchmark \"%s\"", name.c_str());
+            return true;
+        }
+
+        return false;
+    }
+
+    void Benchmark::Tick()
+    {
+        if (m_type == Benchmark_Jobs)
+        {
+            if (m_count != 0)
+            {
+                Jobs(m_count);
+            }
+            else
+            {
+                for (uint32_t job_count = 1000; job_count <= 1000000; job_count *= 10)
+                {
+                    Jobs(job_count);
+                }
+            }
+
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_ParallelFor)
+        {
+            ParallelLoop(m_count != 0 ? m_count : 1000000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_Transforms)
+        {
+            Transforms(m_count != 0 ? m_count : 100000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_Components)
+        {
+            if (m_count != 0)
+            {
+                Components(m_count);
+            }
+            else
+            {
+                for (uint32_t entity_count = 10000; entity_count <= 1000000; entity_count *= 10)
+                {
+                    Components(entity_count);
+                }
+            }
+
+            m_context->GetSubsystem<World>()->Unload();
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_DrawSort)
+        {
+            if (m_count != 0)
+            {
+                DrawSort(m_count);
+            }
+            else
+            {
+                for (const uint32_t renderable_count : { 10000, 50000, 100000, 500000 })
+                {
+                    DrawSort(renderable_count);
+                }
+            }
+
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_Culling)
+        {
+            Culling(m_count != 0 ? m_count : 1000000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_ResourceCache)
+        {
+            ResourceCacheStress(m_count != 0 ? m_count : 10000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_SceneQuery)
+        {
+            if (m_count != 0)
+            {
+                SceneQuery(m_count);
+            }
+            else
+            {
+                SceneQuery(100000);
+                SceneQuery(1000000);
+            }
+
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_WorldLoad)
+        {
+            WorldLoad();
+        }
+        else if (m_type == Benchmark_WorldScaling)
+        {
+            WorldScaling();
+        }
+        else if (m_type == Benchmark_FlyThrough)
+        {
+            FlyThrough();
+        }
+        else if (m_type == Benchmark_MeshLod)
+        {
+            MeshLod(m_count != 0 ? m_count : 100000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_ConstantBuffer)
+        {
+            ConstantBuffer(m_count != 0 ? m_count : 10000);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_Draws)
+        {
+            Draws();
+        }
+        else if (m_type == Benchmark_GpuMemory)
+        {
+            GpuMemory(m_count != 0 ? m_count : 500);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_BufferChurn)
+        {
+            BufferChurn();
+        }
+        else if (m_type == Benchmark_DrawRecording)
+        {
+            DrawRecording();
+        }
+        else if (m_type == Benchmark_AssetLoad)
+        {
+            AssetLoad(m_count != 0 ? m_count : 20);
+            m_type = Benchmark_None;
+        }
+        else if (m_type == Benchmark_WorldSave)
+        {
+            WorldSave();
+        }
+    }
+
+    void Benchmark::Jobs(const uint32_t job_count)
+    {
+        Threading* threading        = m_context->GetSubsystem<Threading>();
+        const uint32_t thread_count = threading->GetThreadCount();
+        if (thread_count == 0)
+        {
+            LOG_WARNING("There are no worker threads, there is nothing to compare");
+            return;
+        }
+
+        atomic<uint32_t> counter    = 0;
+        const auto job              = [&counter]() { counter.fetch_add(1, memory_order_relaxed); };
+
+        // The handles are kept and waited on, like a caller which needs the results would
+        vector<JobHandle> handles(job_count);
+        Stopwatch timer;
+        for (JobHandle& handle : handles)
+        {
+            handle = threading->AddTask(job);
+        }
+        for (const JobHandle& handle : handles)
+        {
+            threading->Wait(handle);
+        }
+        const float time_jobs = timer.GetElapsedTimeMs();
+
+        // The replaced scheduler had no handles, callers counted completions and spun
+        counter = 0;
+        float time_reference = 0.0f;
+        {
+            ThreadPoolReference pool(thread_count);
+            timer.Start();
+            for (uint32_t i = 0; i < job_count; i++)
+            {
+                pool.AddTask(job);
+            }
+            while (counter.load(memory_order_acquire) != job_count)
+            {
+                this_thread::yield();
+            }
+            time_reference = timer.GetElapsedTimeMs();
+        }
+
+        const auto millions_per_second = [job_count](const float time_ms) { return time_ms > 0.0f ? static_cast<float>(job_count) / (time_ms * 1000.0f) : 0.0f; };
+        LOG_INFO("%u jobs on %u worker threads: %.2f ms (%.2f million per second), the replaced scheduler %.2f ms (%.2f million per second), %.1fx",
+            job_count, thread_count, time_jobs, millions_per_second(time_jobs), time_reference, millions_per_second(time_reference), time_jobs > 0.0f ? time_reference / time_jobs : 0.0f);
+    }
+
+    void Benchmark::ParallelLoop(const uint32_t range)
+    {
+        Threading* threading        = m_context->GetSubsystem<Threading>();
+        const uint32_t thread_count = threading->GetThreadCount();
+        if (thread_count == 0)
+        {
+            LOG_WARNING("There are no worker threads, there is nothing to compare");
+            return;
+        }
+
+        // The cost of an iteration grows with its index, up to 256 times the first, so equal slices are unbalanced
+        vector<float> results(range);
+        const auto iterate = [&results, range](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                const uint32_t steps    = 1 + static_cast<uint32_t>((static_cast<uint64_t>(i) * 256) / range);
+                float value             = static_cast<float>(i);
+                for (uint32_t step = 0; step < steps; step++)
+                {
+                    value = sqrt(value + static_cast<float>(step));
+                }
+                results[i] = value;
+            }
+        };
+
+        Stopwatch timer;
+        iterate(0, range);
+        const float time_serial = timer.GetElapsedTimeMs();
+
+        // The replaced Threading::Loop: one equal slice per worker plus the last one on the caller, which then spins until
+        // the workers are done (on atomic flags here, the original read a vector<bool> that the workers were writing)
+        float time_reference = 0.0f;
+        {
+            ThreadPoolReference pool(thread_count);
+            const uint32_t slice_size       = range / (thread_count + 1);
+            unique_ptr<atomic<bool>[]> done = make_unique<atomic<bool>[]>(thread_count);
+            for (uint32_t i = 0; i < thread_count; i++)
+            {
+                done[i] = false;
+            }
+
+            timer.Start();
+            for (uint32_t i = 0; i < thread_count; i++)
+            {
+                pool.AddTask([&iterate, &done, i, slice_size]() { iterate(slice_size * i, slice_size * (i + 1)); done[i].store(true, memory_order_release); });
+            }
+            iterate(slice_size * thread_count, range);
+            for (uint32_t i = 0; i < thread_count; i++)
+            {
+                while (!done[i].load(memory_order_acquire)) {}
+            }
+            time_reference = timer.GetElapsedTimeMs();
+        }
+
+        timer.Start();
+        threading->ParallelFor(iterate, range);
+        const float time_parallel_for = timer.GetElapsedTimeMs();
+
+        // The reduce computes bounds like Model::GeometryComputeAabb() does
+        mt19937 generator(1);
+        uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+        vector<RHI_Vertex_PosTexNorTan> vertices(range);
+        for (RHI_Vertex_PosTexNorTan& vertex : vertices)
+        {
+            vertex = RHI_Vertex_PosTexNorTan(Vector3(distribution(generator), distribution(generator), distribution(generator)), Vector2::Zero);
+        }
+
+        timer.Start();
+        const BoundingBox bounds_serial(vertices.data(), range);
+        const float time_bounds_serial = timer.GetElapsedTimeMs();
+
+        timer.Start();
+        const BoundingBox bounds_parallel = threading->ParallelReduce<BoundingBox>(
+            [&vertices](const uint32_t start, const uint32_t end)
+            {
+                return BoundingBox(vertices.data() + start, end - start);
+            },
+            [](const BoundingBox& a, const BoundingBox& b)
+            {
+                BoundingBox merged = a;
+                merged.Merge(b);
+                return merged;
+            },
+            range,
+            BoundingBox()
+        );
+        const float time_bounds_parallel = timer.GetElapsedTimeMs();
+        const bool bounds_identical      = bounds_parallel.GetMin() == bounds_serial.GetMin() && bounds_parallel.GetMax() == bounds_serial.GetMax();
+
+        const auto speedup = [time_serial](const float time_ms) { return time_ms > 0.0f ? time_serial / time_ms : 0.0f; };
+        LOG_INFO("%u uneven iterations on %u worker threads: serial %.2f ms, the replaced Loop %.2f ms (%.1fx), ParallelFor %.2f ms (%.1fx)",
+            range, thread_count, time_serial, time_reference, speedup(time_reference), time_parallel_for, speedup(time_parallel_for));
+        LOG_INFO("Bounds of %u vertices: serial %.2f ms, ParallelReduce %.2f ms (%.1fx), %s",
+            range, time_bounds_serial, time_bounds_parallel, time_bounds_parallel > 0.0f ? time_bounds_serial / time_bounds_parallel : 0.0f, bounds_identical ? "identical" : "different");
+    }
+
+    void Benchmark::Transforms(const uint32_t entity_count)
+    {
+        constexpr uint32_t chain_length = 100;
+        constexpr uint32_t frame_count  = 10;
+        World* world                    = m_context->GetSubsystem<World>();
+
+        for (const bool deep : { false, true })
+        {
+            world->Unload();
+
+            // Only the roots are moved, in the deep case every descendant follows its root
+            vector<Transform*> roots;
+            Transform* parent = nullptr;
+            Stopwatch timer;
+            for (uint32_t i = 0; i < entity_count; i++)
+            {
+                Transform* transform = world->EntityCreate()->GetTransform();
+                if (deep && i % chain_length != 0)
+                {
+                    transform->SetParent(parent);
+                    transform->SetPositionLocal(Vector3(0.0f, 1.0f, 0.0f));
+                }
+                else
+                {
+                    roots.emplace_back(transform);
+                }
+                parent = transform;
+            }
+            const float time_create = timer.GetElapsedTimeMs();
+
+            // The first resolve also sorts the transforms by depth
+            timer.Start();
+            world->TransformsResolve();
+            const float time_sort = timer.GetElapsedTimeMs();
+
+            // Every setter is called once per frame, they only mark the transforms dirty and the resolve computes them once
+            float time_set      = 0.0f;
+            float time_resolve  = 0.0f;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                const float offset = static_cast<float>(frame + 1);
+
+                timer.Start();
+                for (Transform* transform : roots)
+                {
+                    transform->SetPositionLocal(Vector3(offset, 0.0f, offset));
+                    transform->SetRotationLocal(Quaternion::FromEulerAngles(0.0f, offset * 10.0f, 0.0f));
+                    transform->SetScaleLocal(Vector3(1.0f + offset * 0.01f));
+                }
+                time_set += timer.GetElapsedTimeMs();
+
+                timer.Start();
+                world->TransformsResolve();
+                time_resolve += timer.GetElapsedTimeMs();
+            }
+
+            LOG_INFO("%u entities in %s: created in %.2f ms, first resolve (sorts by depth) %.2f ms",
+                entity_count, deep ? "chains of 100" : "a flat hierarchy", time_create, time_sort);
+            LOG_INFO("Moving %u roots per frame: setters %.2f ms, resolve %.2f ms (averages over %u frames)",
+                static_cast<uint32_t>(roots.size()), time_set / frame_count, time_resolve / frame_count, frame_count);
+        }
+
+        world->Unload();
+    }
+
+    void Benchmark::Components(const uint32_t entity_count)
+    {
+        constexpr uint32_t run_count    = 10;
+        World* world                    = m_context->GetSubsystem<World>();
+
+        world->Unload();
+        for (uint32_t i = 0; i < entity_count; i++)
+        {
+            Entity* entity = world->EntityCreate().get();
+            if (i % 2 == 0)
+            {
+                entity->AddComponent<Renderable>();
+            }
+        }
+
+        // Both should visit the same pairs, the checksums keep the loops from being optimized away
+        float sum_each      = 0.0f;
+        uint32_t count_each = 0;
+        Stopwatch timer;
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            world->Each<Transform, Renderable>([&sum_each, &count_each](Transform* transform, Renderable* renderable)
+            {
+                sum_each += transform->GetPositionLocal().x + static_cast<float>(renderable->GeometryIndexCount());
+                count_each++;
+            });
+        }
+        const float time_each = timer.GetElapsedTimeMs() / run_count;
+
+        float sum_get       = 0.0f;
+        uint32_t count_get  = 0;
+        timer.Start();
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            for (const auto& entity : world->EntityGetAll())
+            {
+                Transform* transform    = entity->GetComponent<Transform>();
+                Renderable* renderable  = entity->GetComponent<Renderable>();
+                if (!transform || !renderable)
+                    continue;
+
+                sum_get += transform->GetPositionLocal().x + static_cast<float>(renderable->GeometryIndexCount());
+                count_get++;
+            }
+        }
+        const float time_get = timer.GetElapsedTimeMs() / run_count;
+
+        LOG_INFO("%u entities, %u with a renderable: World::Each() %.3f ms, GetComponent() per entity %.3f ms (%.1fx), checksums %.0f/%.0f, %s pairs",
+            entity_count, count_each / run_count, time_each, time_get, time_each > 0.0f ? time_get / time_each : 0.0f, sum_each, sum_get, count_each == count_get ? "same" : "different");
+    }
+
+    void Benchmark::DrawSort(const uint32_t renderable_count)
+    {
+        Threading* threading = m_context->GetSubsystem<Threading>();
+
+        // Opaque keys as Renderer::RenderablesSort() packs them, [pass 4 | shader 12 | material 16 | depth 32], from 64 shaders and 1024 materials
+        mt19937 generator(1);
+        uniform_int_distribution<uint64_t> distribution_shader(1, 64);
+        uniform_int_distribution<uint64_t> distribution_material(1, 1024);
+        uniform_int_distribution<uint64_t> distribution_depth(0, 0xFFFFFFFF);
+        vector<uint64_t> keys(renderable_count);
+        vector<uint32_t> values(renderable_count);
+        for (uint32_t i = 0; i < renderable_count; i++)
+        {
+            keys[i]     = (distribution_shader(generator) << 48) | (distribution_material(generator) << 32) | distribution_depth(generator);
+            values[i]   = i;
+        }
+
+        vector<uint64_t> keys_sorted    = keys;
+        vector<uint32_t> values_sorted  = values;
+        Stopwatch timer;
+        Utility::RadixSort::Sort(keys_sorted, values_sorted);
+        const float time_serial = timer.GetElapsedTimeMs();
+        bool sorted             = is_sorted(keys_sorted.begin(), keys_sorted.end());
+
+        keys_sorted     = keys;
+        values_sorted   = values;
+        timer.Start();
+        Utility::RadixSort::Sort(keys_sorted, values_sorted, threading);
+        const float time_parallel = timer.GetElapsedTimeMs();
+        sorted = sorted && is_sorted(keys_sorted.begin(), keys_sorted.end());
+
+        vector<pair<uint64_t, uint32_t>> pairs(renderable_count);
+        for (uint32_t i = 0; i < renderable_count; i++)
+        {
+            pairs[i] = { keys[i], values[i] };
+        }
+        timer.Start();
+        sort(pairs.begin(), pairs.end());
+        const float time_std = timer.GetElapsedTimeMs();
+
+        LOG_INFO("%u renderables: radix sort %.2f ms serial, %.2f ms with %u worker threads, std::sort %.2f ms, %s",
+            renderable_count, time_serial, time_parallel, threading->GetThreadCount(), time_std, sorted ? "sorted" : "NOT sorted");
+
+        // The replaced sort formatted depth and material into a string and parsed it back, in every comparison
+        if (renderable_count <= 100000)
+        {
+            vector<pair<float, float>> depth_material(renderable_count);
+            for (uint32_t i = 0; i < renderable_count; i++)
+            {
+                depth_material[i] = { static_cast<float>(keys[i] & 0xFFFF), static_cast<float>((keys[i] >> 32) & 0xFFFF) };
+            }
+
+            const auto render_hash = [&depth_material](const uint32_t i) { return stof(to_string(depth_material[i].first) + "-" + to_string(depth_material[i].second)); };
+            vector<uint32_t> order = values;
+            timer.Start();
+            sort(order.begin(), order.end(), [&render_hash](const uint32_t a, const uint32_t b) { return render_hash(a) < render_hash(b); });
+            LOG_INFO("%u renderables: the replaced string keys %.2f ms", renderable_count, timer.GetElapsedTimeMs());
+        }
+    }
+
+    void Benchmark::Culling(const uint32_t box_count)
+    {
+        Threading* threading = m_context->GetSubsystem<Threading>();
+
+        // Boxes of 0.5 to 2 units spread over a square kilometre, up to 50 units high
+        mt19937 generator(1);
+        uniform_real_distribution<float> distribution_xz(-500.0f, 500.0f);
+        uniform_real_distribution<float> distribution_y(0.0f, 50.0f);
+        uniform_real_distribution<float> distribution_extent(0.25f, 1.0f);
+        BoundingBoxSoA boxes;
+        boxes.Resize(box_count);
+        for (uint32_t i = 0; i < box_count; i++)
+        {
+            boxes.Set(i, Vector3(distribution_xz(generator), distribution_y(generator), distribution_xz(generator)), Vector3(distribution_extent(generator), distribution_extent(generator), distribution_extent(generator)));
+        }
+        vector<uint32_t> indices(box_count);
+        for (uint32_t i = 0; i < box_count; i++)
+        {
+            indices[i] = i;
+        }
+
+        // The camera and the cascades of a directional light, which cover more of the world the further they reach
+        struct View
+        {
+            Frustum frustum;
+            bool ignore_near_plane;
+        };
+        vector<View> views;
+        const Vector3 camera_position = Vector3(0.0f, 20.0f, -100.0f);
+        views.push_back({ Frustum(Matrix::CreateLookAtLH(camera_position, Vector3(0.0f, 0.0f, 200.0f), Vector3::Up), Matrix::CreatePerspectiveFieldOfViewLH(1.5708f, 16.0f / 9.0f, 0.3f, 1000.0f), 1000.0f), false });
+        const Vector3 light_direction = Vector3(0.3f, -1.0f, 0.4f).Normalized();
+        for (const float extent : { 50.0f, 150.0f, 400.0f, 1000.0f })
+        {
+            const Vector3 center = camera_position + Vector3(0.0f, 0.0f, extent * 0.5f);
+            views.push_back({ Frustum(Matrix::CreateLookAtLH(center - light_direction * 500.0f, center, Vector3::Forward), Matrix::CreateOrthographicLH(extent, extent, 0.3f, 1000.0f), 1000.0f), true });
+        }
+        const uint32_t view_count = static_cast<uint32_t>(views.size());
+
+        // One box at a time, like the passes used to test every renderable. CheckBox() rather than IsVisible(), which
+        // keeps every box when the near plane is ignored, so that all three have to agree on the visible count.
+        uint32_t visible_scalar = 0;
+        Stopwatch timer;
+        for (const View& view : views)
+        {
+            for (uint32_t i = 0; i < box_count; i++)
+            {
+                const Vector3 center = Vector3(boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]);
+                const Vector3 extent = Vector3(boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]);
+                visible_scalar += view.frustum.CheckBox(BoundingBox(center - extent, center + extent), view.ignore_near_plane) != Outside ? 1 : 0;
+            }
+        }
+        const float time_scalar = timer.GetElapsedTimeMs();
+
+        // Four at a time into a compact visible list per view
+        vector<uint32_t> visible;
+        uint32_t visible_simd = 0;
+        timer.Start();
+        for (const View& view : views)
+        {
+            visible.clear();
+            view.frustum.Cull(boxes, indices.data(), box_count, visible, view.ignore_near_plane);
+            visible_simd += static_cast<uint32_t>(visible.size());
+        }
+        const float time_simd = timer.GetElapsedTimeMs();
+
+        // The same, with every view split into chunks which the workers claim, each chunk has its own list
+        constexpr uint32_t chunk_size   = 16384;
+        const uint32_t chunk_count      = (box_count + chunk_size - 1) / chunk_size;
+        vector<vector<uint32_t>> visible_chunks(view_count * chunk_count);
+        timer.Start();
+        threading->ParallelFor([&](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t task = start; task < end; task++)
+            {
+                const View& view        = views[task / chunk_count];
+                const uint32_t chunk    = task % chunk_count;
+                const uint32_t first    = chunk * chunk_size;
+                vector<uint32_t>& list  = visible_chunks[task];
+                list.clear();
+                view.frustum.Cull(boxes, indices.data() + first, Min(chunk_size, box_count - first), list, view.ignore_near_plane);
+            }
+        }, view_count * chunk_count, 1);
+        const float time_parallel = timer.GetElapsedTimeMs();
+        uint32_t visible_parallel = 0;
+        for (const vector<uint32_t>& list : visible_chunks)
+        {
+            visible_parallel += static_cast<uint32_t>(list.size());
+        }
+
+        LOG_INFO("%u boxes against %u views: one at a time %.2f ms, Frustum::Cull() %.2f ms (%.1fx), Frustum::Cull() with %u worker threads %.2f ms (%.1fx)",
+            box_count, view_count, time_scalar, time_simd, time_simd > 0.0f ? time_scalar / time_simd : 0.0f, threading->GetThreadCount(), time_parallel, time_parallel > 0.0f ? time_scalar / time_parallel : 0.0f);
+        LOG_INFO("Visible over all views: %u/%u/%u", visible_scalar, visible_simd, visible_parallel);
+    }
+
+    void Benchmark::ResourceCacheStress(const uint32_t resource_count)
+    {
+        constexpr uint32_t operation_count  = 100000; // one in ten is an insert, the rest are lookups by name or by path
+        constexpr uint32_t insert_count     = operation_count / 10;
+        ResourceCache* resource_cache       = m_context->GetSubsystem<ResourceCache>();
+        Threading* threading                = m_context->GetSubsystem<Threading>();
+        const uint32_t participant_count    = threading->GetThreadCount() + 1;
+
+        // The resources are created up front, the ones which start cached and the ones the inserts add
+        vector<shared_ptr<IResource>> resources(resource_count + insert_count);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(resources.size()); i++)
+        {
+            resources[i] = make_shared<IResource>(m_context, Resource_Unknown);
+            resources[i]->SetResourceFilePath(resource_cache->GetProjectDirectory() + "benchmark_resource_" + to_string(i) + EXTENSION_MATERIAL);
+        }
+
+        // Every participant takes an equal share of the operations, with its own seed
+        const auto run = [&](auto&& get_by_name, auto&& get_by_path, auto&& cache, uint32_t* found)
+        {
+            atomic<uint32_t> insert_next    = 0;
+            atomic<uint32_t> found_count    = 0;
+            Stopwatch timer;
+            threading->ParallelFor([&](const uint32_t start, const uint32_t end)
+            {
+                for (uint32_t participant = start; participant < end; participant++)
+                {
+                    mt19937 generator(participant + 1);
+                    uniform_int_distribution<uint32_t> distribution(0, resource_count - 1);
+                    uint32_t found_local = 0;
+                    for (uint32_t operation = participant; operation < operation_count; operation += participant_count)
+                    {
+                        if (operation % 10 == 0)
+                        {
+                            cache(resources[resource_count + insert_next.fetch_add(1, memory_order_relaxed)]);
+                        }
+                        else
+                        {
+                            const IResource* resource = resources[distribution(generator)].get();
+                            found_local += (operation % 2 == 0 ? get_by_name(resource->GetResourceName()) : get_by_path(resource->GetResourceFilePathNative())) ? 1 : 0;
+                        }
+                    }
+                    found_count.fetch_add(found_local, memory_order_relaxed);
+                }
+            }, participant_count, 1);
+            *found = found_count.load();
+            return timer.GetElapsedTimeMs();
+        };
+
+        for (uint32_t i = 0; i < resource_count; i++)
+        {
+            resources[i] = resource_cache->Cache(resources[i]);
+        }
+        uint32_t found = 0;
+        const float time_cache = run(
+            [resource_cache](const string& name) { return resource_cache->GetByName(name, Resource_Unknown); },
+            [resource_cache](const string& path) { return resource_cache->GetByPath(path, Resource_Unknown); },
+            [resource_cache](shared_ptr<IResource>& resource) { resource = resource_cache->Cache(resource); },
+            &found
+        );
+        for (shared_ptr<IResource>& resource : resources)
+        {
+            resource_cache->Remove(resource);
+        }
+
+        ResourceCacheReference reference;
+        for (uint32_t i = 0; i < resource_count; i++)
+        {
+            reference.Cache(resources[i]);
+        }
+        uint32_t found_reference = 0;
+        const float time_reference = run(
+            [&reference](const string& name) { return reference.GetByName(name); },
+            [&reference](const string& path) { return reference.GetByPath(path); },
+            [&reference](shared_ptr<IResource>& resource) { reference.Cache(resource); },
+            &found_reference
+        );
+
+        LOG_INFO("%u cached resources, %u operations (10%% inserts) from %u threads: ResourceCache %.2f ms, the replaced linear scan %.2f ms (%.1fx), %u/%u lookups found",
+            resource_count, operation_count, participant_count, time_cache, time_reference, time_cache > 0.0f ? time_reference / time_cache : 0.0f, found, found_reference);
+    }
+
+    void Benchmark::SceneQuery(const uint32_t object_count)
+    {
+        // Boxes of 0.5 to 2 units in a cube which grows with the count, so that the density stays the same
+        mt19937 generator(1);
+        const float extent = 10.0f * cbrt(static_cast<float>(object_count));
+        uniform_real_distribution<float> distribution_position(-extent, extent);
+        uniform_real_distribution<float> distribution_size(0.25f, 1.0f);
+        const auto random_position  = [&]() { return Vector3(distribution_position(generator), distribution_position(generator), distribution_position(generator)); };
+        const auto random_box       = [&](const Vector3& center, const float scale)
+        {
+            const Vector3 extents = Vector3(distribution_size(generator), distribution_size(generator), distribution_size(generator)) * scale;
+            return BoundingBox(center - extents, center + extents);
+        };
+
+        vector<BoundingBox> boxes(object_count);
+        for (BoundingBox& box : boxes)
+        {
+            box = random_box(random_position(), 1.0f);
+        }
+
+        // The queries are generated up front, so that only the tree is timed
+        constexpr uint32_t ray_count        = 10000;
+        constexpr uint32_t box_count        = 10000;
+        constexpr uint32_t frustum_count    = 1000;
+        vector<Ray> rays(ray_count);
+        vector<BoundingBox> query_boxes(box_count);
+        vector<Frustum> frustums(frustum_count);
+        for (Ray& ray : rays)
+        {
+            ray = Ray(random_position(), random_position());
+        }
+        for (BoundingBox& box : query_boxes)
+        {
+            box = random_box(random_position(), 10.0f);
+        }
+        const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.5708f, 16.0f / 9.0f, 0.3f, 100.0f);
+        for (Frustum& frustum : frustums)
+        {
+            frustum = Frustum(Matrix::CreateLookAtLH(random_position(), random_position(), Vector3::Up), projection, 100.0f);
+        }
+
+        // Build
+        BoundingVolumeHierarchy hierarchy;
+        vector<uint32_t> proxies(object_count);
+        Stopwatch timer;
+        for (uint32_t i = 0; i < object_count; i++)
+        {
+            proxies[i] = hierarchy.Insert(boxes[i], &boxes[i]);
+        }
+        const float time_build = timer.GetElapsedTimeMs();
+
+        // Nearest hit rays, candidates are tested against their exact box like the world does
+        uint32_t ray_hits = 0;
+        timer.Start();
+        for (const Ray& ray : rays)
+        {
+            float distance_nearest = numeric_limits<float>::infinity();
+            hierarchy.QueryRay(ray.GetStart(), ray.GetDirection(), ray.GetLength(), [&](const uint32_t proxy)
+            {
+                distance_nearest = Min(distance_nearest, ray.HitDistance(*static_cast<BoundingBox*>(hierarchy.GetUserData(proxy))));
+                return Min(distance_nearest, ray.GetLength());
+            });
+            ray_hits += distance_nearest <= ray.GetLength() ? 1 : 0;
+        }
+        const float time_rays = timer.GetElapsedTimeMs();
+
+        uint32_t box_results = 0;
+        timer.Start();
+        for (const BoundingBox& box : query_boxes)
+        {
+            hierarchy.QueryBox(box, [&](const uint32_t proxy)
+            {
+                box_results += box.IsInside(*static_cast<BoundingBox*>(hierarchy.GetUserData(proxy))) != Outside ? 1 : 0;
+                return true;
+            });
+        }
+        const float time_boxes = timer.GetElapsedTimeMs();
+
+        uint32_t frustum_results = 0;
+        timer.Start();
+        for (const Frustum& frustum : frustums)
+        {
+            hierarchy.QueryFrustum(frustum, false, [&](const uint32_t proxy)
+            {
+                frustum_results++;
+                return true;
+            });
+        }
+        const float time_frustums = timer.GetElapsedTimeMs();
+
+        // Refit a tenth of the objects, first moving within their fattened boxes (like most objects do every frame), then teleporting
+        const uint32_t move_count = Max(object_count / 10, 1u);
+        uniform_int_distribution<uint32_t> distribution_index(0, object_count - 1);
+        vector<uint32_t> moved(move_count);
+        for (uint32_t& index : moved)
+        {
+            index = distribution_index(generator);
+        }
+
+        uint32_t reinserted_small = 0;
+        timer.Start();
+        for (const uint32_t index : moved)
+        {
+            const Vector3 offset = Vector3(0.01f, 0.0f, 0.01f);
+            boxes[index] = BoundingBox(boxes[index].GetMin() + offset, boxes[index].GetMax() + offset);
+            reinserted_small += hierarchy.Move(proxies[index], boxes[index]) ? 1 : 0;
+        }
+        const float time_refit_small = timer.GetElapsedTimeMs();
+
+        for (const uint32_t index : moved)
+        {
+            boxes[index] = random_box(random_position(), 1.0f);
+        }
+        uint32_t reinserted_large = 0;
+        timer.Start();
+        for (const uint32_t index : moved)
+        {
+            reinserted_large += hierarchy.Move(proxies[index], boxes[index]) ? 1 : 0;
+        }
+        const float time_refit_large = timer.GetElapsedTimeMs();
+
+        LOG_INFO("%u objects: build %.2f ms, tree height %u", object_count, time_build, hierarchy.GetHeight());
+        LOG_INFO("%u nearest hit rays: %.2f ms (%.2f us each), %u hits", ray_count, time_rays, 1000.0f * time_rays / ray_count, ray_hits);
+        LOG_INFO("%u box queries: %.2f ms (%.2f us each), %u overlaps", box_count, time_boxes, 1000.0f * time_boxes / box_count, box_results);
+        LOG_INFO("%u frustum queries: %.2f ms (%.2f us each), %u candidates", frustum_count, time_frustums, 1000.0f * time_frustums / frustum_count, frustum_results);
+        LOG_INFO("%u small moves: %.2f ms, %u reinserted", move_count, time_refit_small, reinserted_small);
+        LOG_INFO("%u teleports: %.2f ms, %u reinserted", move_count, time_refit_large, reinserted_large);
+    }
+
+    void Benchmark::WorldLoad()
+    {
+        constexpr uint32_t run_count = 3;
+
+        // Create and save the world, then load it once per run
+        if (m_step == 0)
+        {
+            const uint32_t entity_count = m_count != 0 ? m_count : 100000;
+            WorldCreate(entity_count, 10.0f, 0.0f);
+            m_context->GetSubsystem<World>()->SaveToFile(m_world_file_path);
+            WorldLoadStart();
+            m_step++;
+            return;
+        }
+
+        if (!m_context->GetSubsystem<Threading>()->IsDone(m_job))
+            return;
+
+        if (m_load_times_ms.size() < run_count)
+        {
+            WorldLoadStart();
+            return;
+        }
+
+        // The first run also compiles shaders, so the best run is the one to compare
+        float time_best = numeric_limits<float>::max();
+        for (uint32_t i = 0; i < run_count; i++)
+        {
+            LOG_INFO("Run %u: %.2f ms", i, m_load_times_ms[i]);
+            time_best = Min(time_best, m_load_times_ms[i]);
+        }
+        LOG_INFO("%u entities with %u worker threads: best load %.2f ms", m_context->GetSubsystem<World>()->EntityGetCount(), m_context->GetSubsystem<Threading>()->GetThreadCount(), time_best);
+
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::WorldScaling()
+    {
+        constexpr uint32_t run_count    = 2;
+        constexpr uint32_t size_count   = 3;
+        const uint32_t entity_count_max = m_count != 0 ? m_count : 100000;
+        const uint32_t entity_counts[size_count] = { entity_count_max / 4, entity_count_max / 2, entity_count_max };
+        World* world = m_context->GetSubsystem<World>();
+
+        if (!m_context->GetSubsystem<Threading>()->IsDone(m_job))
+            return;
+
+        // Every size is created and saved once, then loaded a few times
+        if (m_step < size_count * run_count)
+        {
+            if (m_step % run_count == 0)
+            {
+                WorldCreate(entity_counts[m_step / run_count], 10.0f, 0.0f);
+                world->SaveToFile(m_world_file_path);
+            }
+
+            WorldLoadStart();
+            m_step++;
+            return;
+        }
+
+        // The first run also compiles shaders, so the best run of each size is the one to compare. Linear loading keeps the time per entity flat.
+        float time_per_entity_smallest = 0.0f;
+        for (uint32_t size = 0; size < size_count; size++)
+        {
+            float time_best = numeric_limits<float>::max();
+            for (uint32_t run = 0; run < run_count; run++)
+            {
+                time_best = Min(time_best, m_load_times_ms[size * run_count + run]);
+            }
+
+            const float time_per_entity = 1000.0f * time_best / static_cast<float>(entity_counts[size]);
+            time_per_entity_smallest    = size == 0 ? time_per_entity : time_per_entity_smallest;
+            LOG_INFO("%u entities: best load %.2f ms, %.2f us per entity (%.2fx the smallest)", entity_counts[size], time_best, time_per_entity, time_per_entity_smallest > 0.0f ? time_per_entity / time_per_entity_smallest : 0.0f);
+        }
+
+        // Lookups, the keys are gathered up front so that only the indices are timed
+        vector<uint32_t> ids;
+        vector<string> names;
+        vector<EntityHandle> handles;
+        for (const auto& entity : world->EntityGetAll())
+        {
+            ids.emplace_back(entity->GetId());
+            names.emplace_back(entity->GetName());
+            handles.emplace_back(entity->GetHandle());
+        }
+        const uint32_t lookup_count = static_cast<uint32_t>(ids.size());
+
+        uint32_t found_id = 0;
+        Stopwatch timer;
+        for (const uint32_t id : ids)
+        {
+            found_id += world->EntityGetById(id) ? 1 : 0;
+        }
+        const float time_id = timer.GetElapsedTimeMs();
+
+        uint32_t found_name = 0;
+        timer.Start();
+        for (const string& name : names)
+        {
+            found_name += world->EntityGetByName(name) ? 1 : 0;
+        }
+        const float time_name = timer.GetElapsedTimeMs();
+
+        uint32_t found_handle = 0;
+        timer.Start();
+        for (const EntityHandle& handle : handles)
+        {
+            found_handle += world->EntityGetByHandle(handle) ? 1 : 0;
+        }
+        const float time_handle = timer.GetElapsedTimeMs();
+
+        const auto per_lookup_ns = [lookup_count](const float time_ms) { return lookup_count != 0 ? 1000000.0f * time_ms / static_cast<float>(lookup_count) : 0.0f; };
+        LOG_INFO("%u lookups by id %.2f ms (%.0f ns each), by name %.2f ms (%.0f ns each), by handle %.2f ms (%.0f ns each), %u/%u/%u found",
+            lookup_count, time_id, per_lookup_ns(time_id), time_name, per_lookup_ns(time_name), time_handle, per_lookup_ns(time_handle), found_id, found_name, found_handle);
+
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::WorldSave()
+    {
+        constexpr uint32_t run_count = 2;
+        World* world = m_context->GetSubsystem<World>();
+        const string directory  = m_context->GetSubsystem<ResourceCache>()->GetProjectDirectory();
+        const string paths[2]   = { directory + "benchmark_compressed" + EXTENSION_WORLD, directory + "benchmark_uncompressed" + EXTENSION_WORLD };
+
+        if (!m_context->GetSubsystem<Threading>()->IsDone(m_job))
+            return;
+
+        // Save the same world both ways
+        if (m_step == 0)
+        {
+            WorldCreate(m_count != 0 ? m_count : 100000, 10.0f, 0.0f);
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                world->SetSaveCompressed(i == 0);
+                Stopwatch timer;
+                world->SaveToFile(paths[i]);
+                m_save_times_ms[i] = timer.GetElapsedTimeMs();
+
+                error_code error;
+                m_file_sizes[i] = static_cast<uint64_t>(filesystem::file_size(paths[i], error));
+            }
+            world->SetSaveCompressed(true);
+        }
+
+        // Then load them in turns, the first load also compiles shaders
+        if (m_step < 2 * run_count)
+        {
+            m_world_file_path = paths[m_step % 2];
+            WorldLoadStart();
+            m_step++;
+            return;
+        }
+
+        const uint32_t entity_count = world->EntityGetCount();
+        const char* names[2]        = { "Compressed", "Uncompressed" };
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            float time_best = numeric_limits<float>::max();
+            for (uint32_t run = 0; run < run_count; run++)
+            {
+                time_best = Min(time_best, m_load_times_ms[run * 2 + i]);
+            }
+
+            LOG_INFO("%s: %.2f MB, saved in %.2f ms, best load %.2f ms (%.2f us per entity)",
+                names[i], static_cast<float>(m_file_sizes[i]) / 1024.0f / 1024.0f, m_save_times_ms[i], time_best, 1000.0f * time_best / static_cast<float>(Max(entity_count, 1u)));
+        }
+        LOG_INFO("%u entities, compression ratio %.2f", entity_count, m_file_sizes[0] != 0 ? static_cast<float>(m_file_sizes[1]) / static_cast<float>(m_file_sizes[0]) : 0.0f);
+
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::FlyThrough()
+    {
+        // 100k spheres over about 1.1 km, in cells of 64 m which load within 150 m of the camera
+        constexpr uint32_t entity_count = 100000;
+        constexpr float spacing         = 10.0f;
+        constexpr float cell_size       = 64.0f;
+        constexpr float load_radius     = 150.0f;
+        const uint32_t frame_count      = m_count != 0 ? m_count : 2000;
+
+        World* world                = m_context->GetSubsystem<World>();
+        WorldStreaming* streaming   = world->GetStreaming();
+
+        // Create and save the world (saving writes the cells), then load it so that it streams
+        if (m_step == 0)
+        {
+            WorldCreate(entity_count, spacing, cell_size);
+            world->SaveToFile(m_world_file_path);
+            WorldLoadStart();
+            m_step++;
+            return;
+        }
+
+        // The camera only depends on the frame, so every run takes the same path: a loop at 40% of the world's size, looking ahead
+        const auto place_camera = [&](const uint32_t frame)
+        {
+            const float group_count = static_cast<float>((entity_count + 7) / 8);
+            const float radius      = 0.4f * ceil(sqrt(group_count)) * spacing;
+            const float angle       = 2.0f * PI * static_cast<float>(frame) / static_cast<float>(frame_count);
+            const Vector3 position  = Vector3(cos(angle) * radius, 20.0f, sin(angle) * radius);
+            const Vector3 direction = Vector3(-sin(angle), -0.2f, cos(angle)).Normalized();
+
+            // Through the world rather than the renderer, which only picks up the loaded camera once the world resolved
+            Transform* transform = world->EntityGetByName("Camera")->GetTransform();
+            transform->SetPositionLocal(position);
+            transform->SetRotationLocal(Quaternion::FromLookRotation(direction));
+        };
+
+        // Move to the start of the path
+        if (m_step == 1)
+        {
+            if (!m_context->GetSubsystem<Threading>()->IsDone(m_job))
+                return;
+
+            if (!world->EntityGetByName("Camera"))
+            {
+                LOG_ERROR("The benchmark world failed to load");
+                m_type = Benchmark_None;
+                return;
+            }
+
+            streaming->SetLoadRadius(load_radius);
+            place_camera(0);
+            m_step++;
+            return;
+        }
+
+        // Let the cells around the start stream in, so that only the flight is measured
+        if (m_step == 2)
+        {
+            if (streaming->GetStats().cells_in_flight != 0)
+                return;
+
+            m_streaming_hitch_frames    = streaming->GetStats().hitch_frames;
+            m_streaming_overruns        = streaming->GetStats().budget_overruns;
+            m_streaming_frame_ms_max    = 0.0f;
+            m_triangles_full            = 0;
+            m_triangles_drawn           = 0;
+            m_frame_times_ms.clear();
+            m_frame_times_ms.reserve(frame_count);
+            place_camera(1);
+            m_step++;
+            return;
+        }
+
+        // The frame that just ended, it rendered the camera placed by the previous tick
+        m_frame_times_ms.emplace_back(static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeMs()));
+        m_streaming_frame_ms_max = Max(m_streaming_frame_ms_max, streaming->GetStats().frame_ms);
+        m_triangles_full        += m_context->GetSubsystem<Profiler>()->m_renderer_triangles_full;
+        m_triangles_drawn       += m_context->GetSubsystem<Profiler>()->m_renderer_triangles_drawn;
+        if (m_frame_times_ms.size() < frame_count)
+        {
+            place_camera(static_cast<uint32_t>(m_frame_times_ms.size()) + 1);
+            return;
+        }
+
+        // A hitch is a frame which took more than twice the median
+        vector<float> sorted = m_frame_times_ms;
+        sort(sorted.begin(), sorted.end());
+        const float median  = sorted[sorted.size() / 2];
+        const float p99     = sorted[(sorted.size() * 99) / 100];
+        float total         = 0.0f;
+        uint32_t hitches    = 0;
+        for (const float time : m_frame_times_ms)
+        {
+            total   += time;
+            hitches += time > 2.0f * median ? 1 : 0;
+        }
+
+        const WorldStreamingStats& stats = streaming->GetStats();
+        LOG_INFO("%u frames: average %.2f ms, median %.2f ms, 99th percentile %.2f ms, max %.2f ms", frame_count, total / static_cast<float>(frame_count), median, p99, sorted.back());
+        LOG_INFO("Hitch frames (over twice the median): %u", hitches);
+        LOG_INFO("Streaming: %u hitch frames right after integrating, %u ticks over the integration budget, max %.2f ms, %u/%u cells loaded at the end",
+            stats.hitch_frames - m_streaming_hitch_frames, stats.budget_overruns - m_streaming_overruns, m_streaming_frame_ms_max, stats.cells_loaded, stats.cells_total);
+        const float triangle_reduction = m_triangles_full != 0 ? 100.0f * (1.0f - static_cast<float>(m_triangles_drawn) / static_cast<float>(m_triangles_full)) : 0.0f;
+        LOG_INFO("Triangles (all views): %.1f million drawn instead of %.1f million, %.1f%% reduction", m_triangles_drawn / 1000000.0f, m_triangles_full / 1000000.0f, triangle_reduction);
+
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::ConstantBuffer(const uint32_t draw_count)
+    {
+        constexpr uint32_t frame_count  = 100;
+        const shared_ptr<RHI_Device>& rhi_device = m_context->GetSubsystem<Renderer>()->GetRhiDevice();
+        if (!rhi_device)
+        {
+            LOG_WARNING("No RHI device, skipping");
+            return;
+        }
+
+        // The per draw data the renderer writes
+        BufferObject draw;
+
+        // Map()/Unmap() per draw, one element per draw
+        float time_map = 0.0f;
+        {
+            RHI_ConstantBuffer buffer(rhi_device);
+            buffer.Create<BufferObject>(draw_count);
+
+            Stopwatch timer;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                for (uint32_t i = 0; i < draw_count; i++)
+                {
+                    if (void* data = buffer.Map(i))
+                    {
+                        memcpy(data, &draw, sizeof(BufferObject));
+                        buffer.Unmap();
+                    }
+                }
+            }
+            time_map = timer.GetElapsedTimeMs();
+        }
+
+        // Allocate() per draw, the ring starts at 64 elements so the first frame grows it
+        float time_ring             = 0.0f;
+        uint32_t ring_growths       = 0;
+        uint32_t ring_element_count = 0;
+        {
+            RHI_ConstantBuffer buffer(rhi_device, true);
+            buffer.Create<BufferObject>(64);
+
+            Stopwatch timer;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                buffer.ResetRing(frame);
+                for (uint32_t i = 0; i < draw_count; i++)
+                {
+                    const uint32_t element_count = buffer.GetElementCount();
+                    if (void* data = buffer.Allocate())
+                    {
+                        memcpy(data, &draw, sizeof(BufferObject));
+                    }
+                    ring_growths += buffer.GetElementCount() != element_count ? 1 : 0;
+                }
+            }
+            time_ring           = timer.GetElapsedTimeMs();
+            ring_element_count  = buffer.GetElementCount();
+        }
+
+        // AllocateRange() per frame, then Map() per draw, like the parallel recording does
+        float time_range = 0.0f;
+        {
+            RHI_ConstantBuffer buffer(rhi_device, true);
+            buffer.Create<BufferObject>(64);
+
+            Stopwatch timer;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                buffer.ResetRing(frame);
+                const uint32_t index = buffer.AllocateRange(draw_count);
+                for (uint32_t i = 0; i < draw_count; i++)
+                {
+                    if (void* data = buffer.Map(index + i))
+                    {
+                        memcpy(data, &draw, sizeof(BufferObject));
+                    }
+                }
+            }
+            time_range = timer.GetElapsedTimeMs();
+        }
+
+        const uint32_t update_count = draw_count * frame_count;
+        const auto per_update_ns    = [update_count](const float time_ms) { return 1000000.0f * time_ms / static_cast<float>(update_count); };
+        LOG_INFO("%u draws for %u frames, %u bytes each", draw_count, frame_count, static_cast<uint32_t>(sizeof(BufferObject)));
+        LOG_INFO("Map()/Unmap(): %.2f ms (%.0f ns per draw)", time_map, per_update_ns(time_map));
+        LOG_INFO("Allocate(): %.2f ms (%.0f ns per draw), grew %u times to %u elements per frame", time_ring, per_update_ns(time_ring), ring_growths, ring_element_count);
+        LOG_INFO("AllocateRange(): %.2f ms (%.0f ns per draw)", time_range, per_update_ns(time_range));
+        LOG_INFO("%u releases waiting for the GPU", rhi_device->DeferredRelease_GetPendingCount());
+    }
+
+    void Benchmark::Draws()
+    {
+        constexpr uint32_t warm_up_frames   = 60;
+        constexpr uint32_t frame_count      = 300;
+        constexpr float spacing             = 2.0f;
+        const uint32_t entity_count         = m_count != 0 ? m_count : 50000;
+
+        Profiler* profiler = m_context->GetSubsystem<Profiler>();
+
+        // Create the world and profile every frame, so that the CPU time is fresh when it's read
+        if (m_step == 0)
+        {
+            WorldCreate(entity_count, spacing, 0.0f);
+            CameraPlaceOverGrid(entity_count, spacing);
+            m_profiler_interval_sec = profiler->GetUpdateInterval();
+            profiler->SetUpdateInterval(0.0f);
+            m_frame_times_ms.clear();
+            m_cpu_times_ms.clear();
+            m_draw_calls        = 0;
+            m_meshes_rendered   = 0;
+            m_step++;
+            return;
+        }
+
+        // Let shaders compile and the world resolve, so that only steady frames are measured
+        if (m_step < warm_up_frames)
+        {
+            CameraPlaceOverGrid(entity_count, spacing);
+            m_step++;
+            return;
+        }
+
+        // The frame that just ended
+        m_frame_times_ms.emplace_back(static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeMs()));
+        m_cpu_times_ms.emplace_back(profiler->GetTimeCpu());
+        m_draw_calls        += profiler->m_rhi_draw_calls;
+        m_meshes_rendered   += profiler->m_renderer_meshes_rendered;
+        if (m_frame_times_ms.size() < frame_count)
+        {
+            CameraPlaceOverGrid(entity_count, spacing);
+            return;
+        }
+
+        const auto average = [](const vector<float>& times)
+        {
+            float total = 0.0f;
+            for (const float time : times)
+            {
+                total += time;
+            }
+            return total / static_cast<float>(times.size());
+        };
+
+        vector<float> sorted = m_frame_times_ms;
+        sort(sorted.begin(), sorted.end());
+        const float cpu_average         = average(m_cpu_times_ms);
+        const float draw_calls_average  = static_cast<float>(m_draw_calls) / static_cast<float>(frame_count);
+        LOG_INFO("%u entities, %.0f meshes rendered and %.0f draw calls per frame", entity_count, static_cast<float>(m_meshes_rendered) / static_cast<float>(frame_count), draw_calls_average);
+        LOG_INFO("%u frames: average %.2f ms, median %.2f ms, max %.2f ms", frame_count, average(m_frame_times_ms), sorted[sorted.size() / 2], sorted.back());
+        LOG_INFO("CPU: average %.2f ms, %.2f us per draw call", cpu_average, draw_calls_average > 0.0f ? 1000.0f * cpu_average / draw_calls_average : 0.0f);
+
+        profiler->SetUpdateInterval(m_profiler_interval_sec);
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::GpuMemory(const uint32_t resource_count)
+    {
+        // Every mesh gets its own vertex and index buffer and every texture has a full mip chain, like a large imported scene
+        constexpr uint32_t texture_size = 256;
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        Utility::Geometry::CreateSphere(&vertices, &indices, 0.5f, 16, 16);
+        vector<vector<std::byte>> mips;
+        for (uint32_t size = texture_size; size >= 1; size /= 2)
+        {
+            mips.emplace_back(vector<std::byte>(size * size * 4, std::byte{ 128 }));
+        }
+
+        uint32_t device_allocations_start, allocations_start, reserved_start, used_start;
+        RHI_CommandList::Gpu_GetAllocatorStatistics(device_allocations_start, allocations_start, reserved_start, used_start);
+
+        vector<shared_ptr<Model>> models;
+        models.reserve(resource_count);
+        Stopwatch timer;
+        for (uint32_t i = 0; i < resource_count; i++)
+        {
+            auto model = make_shared<Model>(m_context);
+            model->AppendGeometry(indices, vertices);
+            model->UpdateGeometry();
+            models.emplace_back(model);
+        }
+        const float time_meshes = timer.GetElapsedTimeMs();
+
+        vector<shared_ptr<RHI_Texture2D>> textures;
+        textures.reserve(resource_count);
+        timer.Start();
+        for (uint32_t i = 0; i < resource_count; i++)
+        {
+            textures.emplace_back(make_shared<RHI_Texture2D>(m_context, texture_size, texture_size, RHI_Format_R8G8B8A8_Unorm, mips));
+        }
+        const float time_textures = timer.GetElapsedTimeMs();
+
+        uint32_t device_allocations, allocations, reserved, used;
+        RHI_CommandList::Gpu_GetAllocatorStatistics(device_allocations, allocations, reserved, used);
+
+        // Without sub-allocation, every buffer and image holds a device allocation of its own
+        const uint32_t resources_created = resource_count * 3;
+        LOG_INFO("%u meshes: %.2f ms (%.2f us each)", resource_count, time_meshes, 1000.0f * time_meshes / static_cast<float>(resource_count));
+        LOG_INFO("%u %ux%u textures with %u mips: %.2f ms (%.2f us each)", resource_count, texture_size, texture_size, static_cast<uint32_t>(mips.size()), time_textures, 1000.0f * time_textures / static_cast<float>(resource_count));
+        LOG_INFO("%u buffers and images: %u device allocations instead of %u, %u sub-allocations, %u MB reserved for %u MB used",
+            resources_created, device_allocations - device_allocations_start, resources_created, allocations - allocations_start, reserved - reserved_start, used - used_start);
+    }
+
+    void Benchmark::BufferChurn()
+    {
+        constexpr uint32_t frame_count  = 300;
+        const uint32_t buffer_count     = m_count != 0 ? m_count : 3000;
+        const shared_ptr<RHI_Device>& rhi_device = m_context->GetSubsystem<Renderer>()->GetRhiDevice();
+        if (!rhi_device)
+        {
+            LOG_WARNING("No RHI device, skipping");
+            m_type = Benchmark_None;
+            return;
+        }
+
+        if (m_step == 0)
+        {
+            m_frame_times_ms.clear();
+            m_cpu_times_ms.clear();
+            m_pending_releases_max = 0;
+        }
+        else
+        {
+            // The frame that just ended, it retired the buffers of the frames before it
+            m_frame_times_ms.emplace_back(static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeMs()));
+        }
+
+        if (m_step < frame_count)
+        {
+            vector<RHI_Vertex_PosTexNorTan> vertices(64);
+            vector<uint32_t> indices(96);
+
+            // A third of each kind, all of them are destroyed before the frame ends
+            Stopwatch timer;
+            {
+                vector<shared_ptr<RHI_Object>> buffers;
+                buffers.reserve(buffer_count);
+                for (uint32_t i = 0; i < buffer_count; i++)
+                {
+                    if (i % 3 == 0)
+                    {
+                        auto buffer = make_shared<RHI_VertexBuffer>(rhi_device, static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)));
+                        buffer->Create(vertices);
+                        buffers.emplace_back(buffer);
+                    }
+                    else if (i % 3 == 1)
+                    {
+                        auto buffer = make_shared<RHI_IndexBuffer>(rhi_device);
+                        buffer->Create(indices);
+                        buffers.emplace_back(buffer);
+                    }
+                    else
+                    {
+                        auto buffer = make_shared<RHI_ConstantBuffer>(rhi_device);
+                        buffer->Create<BufferObject>();
+                        buffers.emplace_back(buffer);
+                    }
+                }
+            }
+            m_cpu_times_ms.emplace_back(timer.GetElapsedTimeMs());
+            m_pending_releases_max = Max(m_pending_releases_max, rhi_device->DeferredRelease_GetPendingCount());
+            m_step++;
+            return;
+        }
+
+        // A hitch is a frame which took more than twice the median
+        vector<float> sorted = m_frame_times_ms;
+        sort(sorted.begin(), sorted.end());
+        const float median  = sorted[sorted.size() / 2];
+        float total         = 0.0f;
+        uint32_t hitches    = 0;
+        for (const float time : m_frame_times_ms)
+        {
+            total   += time;
+            hitches += time > 2.0f * median ? 1 : 0;
+        }
+
+        float churn_total = 0.0f;
+        float churn_max   = 0.0f;
+        for (const float time : m_cpu_times_ms)
+        {
+            churn_total += time;
+            churn_max   = Max(churn_max, time);
+        }
+
+        LOG_INFO("%u buffers created and destroyed per frame for %u frames", buffer_count, frame_count);
+        LOG_INFO("Frames: average %.2f ms, median %.2f ms, max %.2f ms, %u over twice the median", total / static_cast<float>(m_frame_times_ms.size()), median, sorted.back(), hitches);
+        LOG_INFO("Buffers: average %.2f ms per frame (%.2f us per buffer), max %.2f ms", churn_total / static_cast<float>(frame_count), 1000.0f * churn_total / static_cast<float>(frame_count * buffer_count), churn_max);
+        LOG_INFO("Releases waiting for the GPU: at most %u, %u now", m_pending_releases_max, rhi_device->DeferredRelease_GetPendingCount());
+
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::DrawRecording()
+    {
+        constexpr uint32_t warm_up_frames   = 30;
+        constexpr uint32_t frame_count      = 200;
+        constexpr float spacing             = 2.0f;
+        const uint32_t draw_count           = m_count != 0 ? m_count : 50000;
+
+        Renderer* renderer  = m_context->GetSubsystem<Renderer>();
+        Profiler* profiler  = m_context->GetSubsystem<Profiler>();
+
+        // Draws with the same geometry and material become one instanced draw, so every sphere gets a material of its own
+        if (m_step == 0)
+        {
+            WorldCreate(draw_count, spacing, 0.0f);
+            ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
+            uint32_t material_index = 0;
+            for (const auto& entity : m_context->GetSubsystem<World>()->EntityGetAll())
+            {
+                if (Renderable* renderable = entity->GetRenderable())
+                {
+                    auto material = make_shared<Material>(m_context);
+                    material->SetResourceFilePath(resource_cache->GetProjectDirectory() + "benchmark_material_" + to_string(material_index) + EXTENSION_MATERIAL);
+                    material->SetColorAlbedo(Vector4(static_cast<float>(material_index % 255) / 255.0f, 0.5f, 0.5f, 1.0f));
+                    renderable->SetMaterial(material);
+                    material_index++;
+                }
+            }
+
+            CameraPlaceOverGrid(draw_count, spacing);
+            m_profiler_interval_sec = profiler->GetUpdateInterval();
+            profiler->SetUpdateInterval(0.0f);
+            renderer->SetOption(Render_ParallelRecording, true);
+            m_pass_times_ms[0].clear();
+            m_pass_times_ms[1].clear();
+            m_cpu_time_ms[0]        = 0.0f;
+            m_cpu_time_ms[1]        = 0.0f;
+            m_cmd_lists_secondary   = 0;
+            m_step++;
+            return;
+        }
+
+        // The frame that just ended, the first frames of each run are skipped so that only steady frames are measured
+        const uint32_t frames_per_run   = warm_up_frames + frame_count;
+        const uint32_t run              = (m_step - 1) / frames_per_run;
+        const uint32_t frame            = (m_step - 1) % frames_per_run;
+        if (run < 2)
+        {
+            if (frame >= warm_up_frames)
+            {
+                // Every pass' Begin()/End() is a CPU time block named after the pass
+                for (const TimeBlock& time_block : profiler->GetTimeBlocks())
+                {
+                    if (time_block.IsComplete() && time_block.GetType() == TimeBlock_Cpu && time_block.GetParent())
+                    {
+                        m_pass_times_ms[run][time_block.GetName()] += time_block.GetDuration();
+                    }
+                }
+                m_cpu_time_ms[run] += profiler->GetTimeCpu();
+                m_cmd_lists_secondary += run == 0 ? profiler->m_rhi_cmd_lists_secondary : 0;
+            }
+
+            // The second run records everything on the main thread
+            if (frame == frames_per_run - 1)
+            {
+                renderer->SetOption(Render_ParallelRecording, run == 1);
+            }
+
+            CameraPlaceOverGrid(draw_count, spacing);
+            m_step++;
+            return;
+        }
+
+        LOG_INFO("%u draws with %u worker threads, %.1f secondary command lists per frame", draw_count, m_context->GetSubsystem<Threading>()->GetThreadCount(), static_cast<float>(m_cmd_lists_secondary) / static_cast<float>(frame_count));
+        for (const auto& pass : m_pass_times_ms[0])
+        {
+            const auto it               = m_pass_times_ms[1].find(pass.first);
+            const float time_parallel   = pass.second / static_cast<float>(frame_count);
+            const float time_serial     = it != m_pass_times_ms[1].end() ? it->second / static_cast<float>(frame_count) : 0.0f;
+            LOG_INFO("%s: %.3f ms parallel, %.3f ms serial (%.2fx)", pass.first.c_str(), time_parallel, time_serial, time_parallel > 0.0f ? time_serial / time_parallel : 0.0f);
+        }
+        const float cpu_parallel    = m_cpu_time_ms[0] / static_cast<float>(frame_count);
+        const float cpu_serial      = m_cpu_time_ms[1] / static_cast<float>(frame_count);
+        LOG_INFO("CPU: %.2f ms parallel, %.2f ms serial (%.2fx)", cpu_parallel, cpu_serial, cpu_parallel > 0.0f ? cpu_serial / cpu_parallel : 0.0f);
+
+        profiler->SetUpdateInterval(m_profiler_interval_sec);
+        m_type = Benchmark_None;
+    }
+
+    void Benchmark::AssetLoad(const uint32_t asset_count)
+    {
+        ResourceCache* resource_cache   = m_context->GetSubsystem<ResourceCache>();
+        const string directory          = resource_cache->GetProjectDirectory();
+        const auto path_texture         = [&directory](const char* format, const uint32_t i) { return directory + "benchmark_texture_" + format + "_" + to_string(i) + EXTENSION_TEXTURE; };
+        const auto path_model           = [&directory](const char* format, const uint32_t i) { return directory + "benchmark_model_" + format + "_" + to_string(i) + EXTENSION_MODEL; };
+
+        constexpr uint32_t texture_size = 1024;
+        vector<vector<std::byte>> mips;
+        for (uint32_t size = texture_size; size >= 1; size /= 2)
+        {
+            mips.emplace_back(vector<std::byte>(size * size * 4, std::byte{ 128 }));
+        }
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        Utility::Geometry::CreateSphere(&vertices, &indices, 1.0f, 256, 256);
+
+        // Write both formats, the stream format is what SaveToFile() wrote before the containers and it still loads
+        for (uint32_t i = 0; i < asset_count; i++)
+        {
+            RHI_Texture2D texture(m_context, false);
+            texture.SetWidth(texture_size);
+            texture.SetHeight(texture_size);
+            texture.SetFormat(RHI_Format_R8G8B8A8_Unorm);
+            texture.SetBpp(32);
+            texture.SetChannels(4);
+            for (const auto& mip : mips)
+            {
+                *texture.AddMipmap() = mip;
+            }
+            texture.SetResourceFilePath(path_texture("container", i));
+            texture.SaveToFile(path_texture("container", i));
+
+            FileStream file_texture(path_texture("stream", i), FileStream_Write);
+            file_texture.Write(static_cast<uint32_t>(0)); // byte count, unused
+            file_texture.Write(static_cast<uint32_t>(mips.size()));
+            for (const auto& mip : mips)
+            {
+                file_texture.Write(mip);
+            }
+            file_texture.Write(texture.GetBpp());
+            file_texture.Write(texture.GetWidth());
+            file_texture.Write(texture.GetHeight());
+            file_texture.Write(static_cast<uint32_t>(texture.GetFormat()));
+            file_texture.Write(texture.GetChannels());
+            file_texture.Write(static_cast<uint16_t>(RHI_Texture_ShaderView));
+            file_texture.Write(texture.GetId());
+            file_texture.Write(path_texture("stream", i));
+            file_texture.Close();
+
+            Model model(m_context);
+            model.AppendGeometry(indices, vertices);
+            model.SetResourceFilePath(path_model("container", i));
+            model.SaveToFile(path_model("container", i));
+
+            FileStream file_model(path_model("stream", i), FileStream_Write);
+            file_model.Write(path_model("stream", i));
+            file_model.Write(1.0f); // normalized scale
+            file_model.Write(indices);
+            file_model.Write(vertices);
+            file_model.Close();
+        }
+
+        // The peak only grows, so the containers go first and whatever the stream format adds on top of them shows up in its own delta
+        struct Result
+        {
+            float time_textures = 0.0f;
+            float time_models   = 0.0f;
+            float memory_peak   = 0.0f;
+        };
+        const auto load = [&](const char* format)
+        {
+            Result result;
+            const float memory_start = MemoryPeakMb();
+            vector<shared_ptr<RHI_Texture2D>> textures;
+            vector<shared_ptr<Model>> models;
+
+            Stopwatch timer;
+            for (uint32_t i = 0; i < asset_count; i++)
+            {
+                textures.emplace_back(make_shared<RHI_Texture2D>(m_context, false));
+                textures.back()->LoadFromFile(path_texture(format, i));
+            }
+            result.time_textures = timer.GetElapsedTimeMs();
+
+            timer.Start();
+            for (uint32_t i = 0; i < asset_count; i++)
+            {
+                models.emplace_back(make_shared<Model>(m_context));
+                models.back()->LoadFromFile(path_model(format, i));
+            }
+            result.time_models = timer.GetElapsedTimeMs();
+            result.memory_peak = MemoryPeakMb() - memory_start;
+
+            return result;
+        };
+        const Result container  = load("container");
+        const Result stream     = load("stream");
+
+        // Random access, the smallest mip of every texture without reading the ones before it
+        auto texture = make_shared<RHI_Texture2D>(m_context, false);
+        texture->LoadFromFile(path_texture("container", 0));
+        size_t mip_bytes = 0;
+        Stopwatch timer;
+        for (uint32_t i = 0; i < asset_count; i++)
+        {
+            mip_bytes += texture->GetMipmap(static_cast<uint32_t>(mips.size()) - 1).size();
+        }
+        const float time_mip = timer.GetElapsedTimeMs();
+
+        LOG_INFO("%u %ux%u textures with %u mips and %u models with %u triangles", asset_count, texture_size, texture_size, static_cast<uint32_t>(mips.size()), asset_count, static_cast<uint32_t>(indices.size() / 3));
+        LOG_INFO("Containers: textures %.2f ms, models %.2f ms, peak memory +%.1f MB", container.time_textures, container.time_models, container.memory_peak);
+        LOG_INFO("Streams: textures %.2f ms, models %.2f ms, peak memory +%.1f MB", stream.time_textures, stream.time_models, stream.memory_peak);
+        LOG_INFO("Smallest mip read %u times: %.3f ms, %u bytes", asset_count, time_mip, static_cast<uint32_t>(mip_bytes));
+
+        for (uint32_t i = 0; i < asset_count; i++)
+        {
+            FileSystem::Delete(path_texture("container", i));
+            FileSystem::Delete(path_texture("stream", i));
+            FileSystem::Delete(path_model("container", i));
+            FileSystem::Delete(path_model("stream", i));
+        }
+    }
+
+    void Benchmark::WorldCreate(const uint32_t entity_count, const float spacing, const float cell_size)
+    {
+        World* world                    = m_context->GetSubsystem<World>();
+        ResourceCache* resource_cache   = m_context->GetSubsystem<ResourceCache>();
+        m_world_file_path               = resource_cache->GetProjectDirectory() + "benchmark" + EXTENSION_WORLD;
+
+        world->Unload();
+        world->GetStreaming()->SetCellSize(cell_size);
+
+        // Every renderable shares one sphere, so that loading measures the entities rather than the geometry, and the
+        // sphere has levels of detail, so that the fly-through measures them too
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        Utility::Geometry::CreateSphere(&vertices, &indices, 0.5f, 48, 48);
+        vector<vector<uint32_t>> lods;
+        vector<float> lod_errors;
+        MeshSimplifier::SimplifyLevels(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), MeshSimplifier::level_count_max, MeshSimplifier::level_index_count_min, &lods, &lod_errors);
+        auto model = make_shared<Model>(m_context);
+        model->SetResourceFilePath(resource_cache->GetProjectDirectory() + "benchmark_sphere" + EXTENSION_MODEL);
+        model->AppendGeometry(indices, vertices);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(lods.size()); i++)
+        {
+            model->AppendLod(0, lods[i], lod_errors[i]);
+        }
+        model->UpdateGeometry();
+        model = resource_cache->Cache(model);
+        const BoundingBox bounding_box(vertices);
+
+        // Each group is a root with a binary tree of 7 descendants below it
+        constexpr uint32_t group_size   = 8;
+        const uint32_t group_count      = (entity_count + group_size - 1) / group_size;
+        const uint32_t grid_size        = static_cast<uint32_t>(ceil(sqrt(static_cast<float>(group_count))));
+        const float grid_offset         = static_cast<float>(grid_size) * spacing * 0.5f;
+        for (uint32_t group = 0; group < group_count; group++)
+        {
+            Transform* transforms[group_size] = {};
+            for (uint32_t i = 0; i < group_size && group * group_size + i < entity_count; i++)
+            {
+                Entity* entity = world->EntityCreate().get();
+                entity->SetName("Benchmark_" + to_string(group * group_size + i));
+                transforms[i] = entity->GetTransform();
+
+                if (i == 0)
+                {
+                    transforms[i]->SetPositionLocal(Vector3(static_cast<float>(group % grid_size) * spacing - grid_offset, 0.0f, static_cast<float>(group / grid_size) * spacing - grid_offset));
+                }
+                else
+                {
+                    transforms[i]->SetParent(transforms[(i - 1) / 2]);
+                    transforms[i]->SetPositionLocal(Vector3(i % 2 == 0 ? 1.0f : -1.0f, 1.5f, 0.0f));
+                    transforms[i]->SetScaleLocal(Vector3(0.75f, 0.75f, 0.75f));
+                }
+
+                Renderable* renderable = entity->AddComponent<Renderable>();
+                renderable->GeometrySet("Benchmark_Sphere", 0, static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(vertices.size()), bounding_box, model.get());
+                renderable->UseDefaultMaterial();
+            }
+        }
+
+        // A camera and a sun, they never stream
+        Entity* camera = world->EntityCreate().get();
+        camera->SetName("Camera");
+        camera->AddComponent<Camera>();
+        camera->GetTransform()->SetPositionLocal(Vector3(0.0f, 10.0f, 0.0f));
+
+        Entity* light = world->EntityCreate().get();
+        light->SetName("DirectionalLight");
+        light->GetTransform()->SetRotationLocal(Quaternion::FromEulerAngles(30.0f, 30.0f, 0.0f));
+        light->AddComponent<Light>()->SetLightType(LightType_Directional);
+    }
+
+    void Benchmark::CameraPlaceOverGrid(const uint32_t entity_count, const float spacing)
+    {
+        // Through the world rather than the renderer, which only picks up the camera once the world resolved
+        const float group_count = static_cast<float>((entity_count + 7) / 8);
+        const float extent      = ceil(sqrt(group_count)) * spacing;
+        Transform* transform    = m_context->GetSubsystem<World>()->EntityGetByName("Camera")->GetTransform();
+        transform->SetPositionLocal(Vector3(0.0f, extent, -extent * 0.75f));
+        transform->SetRotationLocal(Quaternion::FromLookRotation(Vector3(0.0f, -1.0f, 0.75f).Normalized()));
+    }
+
+    void Benchmark::WorldLoadStart()
+    {
+        m_job = m_context->GetSubsystem<Threading>()->AddTaskBackground([this]()
+        {
+            Stopwatch timer;
+            m_context->GetSubsystem<World>()->LoadFromFile(m_world_file_path);
+            m_load_times_ms.emplace_back(timer.GetElapsedTimeMs());
+        });
+    }
+
+    void Benchmark::MeshLod(const uint32_t triangle_count)
+    {
+        // A sphere has no borders and a single seam, so it simplifies about as well as a clean asset
+        const int segments = Max(static_cast<int>(sqrt(static_cast<float>(triangle_count) * 0.5f)), 8);
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        Utility::Geometry::CreateSphere(&vertices, &indices, 1.0f, segments, segments);
+
+        vector<vector<uint32_t>> lods;
+        vector<float> lod_errors;
+        Stopwatch timer;
+        MeshSimplifier::SimplifyLevels(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), MeshSimplifier::level_count_max, MeshSimplifier::level_index_count_min, &lods, &lod_errors);
+        const float time = timer.GetElapsedTimeMs();
+
+        const uint32_t triangles_full = static_cast<uint32_t>(indices.size() / 3);
+        LOG_INFO("LOD 0: %u triangles", triangles_full);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(lods.size()); i++)
+        {
+            const uint32_t triangles = static_cast<uint32_t>(lods[i].size() / 3);
+            LOG_INFO("LOD %u: %u triangles (%.1f%% reduction), error %.3g%% of the radius", i + 1, triangles, 100.0f * (1.0f - static_cast<float>(triangles) / static_cast<float>(triangles_full)), 100.0f * lod_errors[i]);
+        }
+        LOG_INFO("Simplified in %.2f ms", time);
+    }
+}
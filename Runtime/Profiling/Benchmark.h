@@ -0,0 +1,162 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <map>
+#include <string>
+#include <vector>
+#include "../Core/EngineDefs.h"
+#include "../Threading/Threading.h"
+//=============================
+
+namespace Spartan
+{
+    class Context;
+
+    // Runs the benchmark requested on the command line with -benchmark <name> [count] and logs its results.
+    // Every benchmark uses fixed seeds and paths, so that runs on different builds or machines can be compared.
+    //
+    // jobs [count]             Runs tiny jobs (1k to 1M by default) through the job system and through a copy of the scheduler it replaced
+    // parallel_for [range]     Runs an uneven loop (1M iterations by default) serially, like the replaced Threading::Loop did and with ParallelFor(),
+    //                          then computes the bounds of as many vertices serially and with ParallelReduce()
+    // transforms [entities]    Moves entities (100k by default) every frame, all of them as roots and then in chains of 100 which only move
+    //                          by their roots, and times the setters and the world's per level resolve
+    // components [entities]    Iterates the transforms and renderables of 10k, 100k and 1M entities (half have a renderable) with World::Each()
+    //                          and with a GetComponent() per entity
+    // draw_sort [renderables]  Sorts packed draw keys of 10k to 500k renderables with the radix sort (serial and parallel), std::sort and,
+    //                          up to 100k, the string keys RenderablesSort() used before
+    // culling [boxes]          Culls boxes (1M by default) against a camera and 4 shadow cascades, one box at a time, four at a time with
+    //                          Frustum::Cull() and with Frustum::Cull() spread over the worker threads
+    // resource_cache [count]   Looks up and caches resources (10k cached by default) from every thread at once, through the resource cache
+    //                          and through a copy of the linear scan it replaced
+    // scene_query [objects]    Dynamic BVH build, ray, box and frustum queries and refitting (100k and 1M objects by default)
+    // world_load [entities]    Saves a generated world (100k entities by default) and loads it a few times on the worker threads
+    // world_scaling [entities] Loads worlds of a quarter, half and all of the entities (100k by default) to show that loading scales linearly,
+    //                          then looks up every entity of the largest by id, name and handle
+    // fly_through [frames]     Streams a generated world while the camera flies a fixed loop over it (2000 frames by default), counts hitches
+    //                          and reports the triangles the levels of detail saved
+    // mesh_lod [triangles]     Builds the levels of detail of a sphere (100k triangles by default), like the model importer does
+    // constant_buffer [draws]  Writes the per draw data (10k draws by default) for 100 frames through Map()/Unmap() of a static constant buffer,
+    //                          through the ring's Allocate() and through one AllocateRange() per frame, starting the ring small so that it grows
+    // draws [entities]         Renders a scene of spheres (50k by default) which are all in view for 300 frames and reports the frame time,
+    //                          the CPU time and the draw calls, run it on builds before and after a renderer change to compare them
+    // gpu_memory [count]       Creates meshes and mipmapped textures (500 of each by default) like an import does and reports the time and the
+    //                          device allocations they took next to the allocations a dedicated allocation per resource would take
+    // buffer_churn [buffers]   Creates and destroys vertex, index and constant buffers (3000 by default) every frame for 300 frames and reports
+    //                          the frame time, the time spent on the buffers and the releases waiting for the GPU
+    // draw_recording [draws]   Renders spheres (50k by default) with a material each, so that no draws are batched, for 200 frames with parallel
+    //                          recording and 200 frames without it, and reports the CPU time of every pass for both
+    // asset_load [count]       Saves textures (1024x1024 with mips) and models (130k triangles), 20 of each by default, as asset containers and
+    //                          in the stream format that preceded them, then reports the load time and the peak memory of both
+    // world_save [entities]    Saves a generated world (100k entities by default) compressed and uncompressed, loads both twice on the worker
+    //                          threads and reports the save and load times and the file sizes
+    class SPARTAN_CLASS Benchmark
+    {
+    public:
+        Benchmark(Context* context);
+        ~Benchmark() = default;
+
+        // Returns false if the command line doesn't request a benchmark
+        bool Start(const std::string& command_line);
+
+        // Call once per frame after the engine ticked, benchmarks which measure the running engine take many frames
+        void Tick();
+        bool IsRunning() const { return m_type != Benchmark_None; }
+
+    private:
+        enum Benchmark_Type
+        {
+            Benchmark_None,
+            Benchmark_Jobs,
+            Benchmark_ParallelFor,
+            Benchmark_Transforms,
+            Benchmark_Components,
+            Benchmark_DrawSort,
+            Benchmark_Culling,
+            Benchmark_ResourceCache,
+            Benchmark_SceneQuery,
+            Benchmark_WorldLoad,
+            Benchmark_WorldScaling,
+            Benchmark_FlyThrough,
+            Benchmark_MeshLod,
+            Benchmark_ConstantBuffer,
+            Benchmark_Draws,
+            Benchmark_GpuMemory,
+            Benchmark_BufferChurn,
+            Benchmark_DrawRecording,
+            Benchmark_AssetLoad,
+            Benchmark_WorldSave
+        };
+
+        void Jobs(uint32_t job_count);
+        void ParallelLoop(uint32_t range);
+        void Transforms(uint32_t entity_count);
+        void Components(uint32_t entity_count);
+        void DrawSort(uint32_t renderable_count);
+        void Culling(uint32_t box_count);
+        void ResourceCacheStress(uint32_t resource_count);
+        static void SceneQuery(uint32_t object_count);
+        static void MeshLod(uint32_t triangle_count);
+        void WorldLoad();
+        void WorldScaling();
+        void WorldSave();
+        void FlyThrough();
+        void ConstantBuffer(uint32_t draw_count);
+        void Draws();
+        void GpuMemory(uint32_t resource_count);
+        void BufferChurn();
+        void DrawRecording();
+        void AssetLoad(uint32_t asset_count);
+
+        // Replaces the world with entity_count spheres (sharing one model with levels of detail) in hierarchies of 8, the roots are laid out on a grid on the XZ plane
+        void WorldCreate(uint32_t entity_count, float spacing, float cell_size);
+        // Places the camera high above the grid WorldCreate() lays out, looking down at it, so that every entity is in view
+        void CameraPlaceOverGrid(uint32_t entity_count, float spacing);
+        // World::LoadFromFile() waits for the world to stop ticking, so it runs on a worker while the engine keeps ticking
+        void WorldLoadStart();
+
+        Benchmark_Type m_type   = Benchmark_None;
+        uint32_t m_count        = 0;
+        uint32_t m_step         = 0;
+        std::string m_world_file_path;
+        JobHandle m_job;
+        std::vector<float> m_load_times_ms;
+        std::vector<float> m_frame_times_ms;
+        uint32_t m_streaming_hitch_frames   = 0; // at the start of the fly-through, the stats accumulate
+        uint32_t m_streaming_overruns       = 0;
+        float m_streaming_frame_ms_max      = 0.0f;
+        uint64_t m_triangles_full           = 0;
+        uint64_t m_triangles_drawn          = 0;
+        std::vector<float> m_cpu_times_ms;
+        uint64_t m_draw_calls               = 0;
+        uint64_t m_meshes_rendered          = 0;
+        float m_profiler_interval_sec       = 0.0f;
+        uint32_t m_pending_releases_max     = 0;
+        std::map<std::string, float> m_pass_times_ms[2]; // with and without parallel recording
+        float m_cpu_time_ms[2]              = {};
+        uint32_t m_cmd_lists_secondary      = 0;
+        float m_save_times_ms[2]            = {}; // compressed and uncompressed
+        uint64_t m_file_sizes[2]            = {};
+        Context* m_context      = nullptr;
+    };
+}
@@ -97,7 +97,9 @@ namespace Spartan
         if (m_profile)
         {
             // Get GPU memory usage
-            m_gpu_memory_used = RHI_CommandList::Gpu_GetMemoryUsed(m_renderer->GetRhiDevice().get());
+            m_gpu_memory_used   = RHI_CommandList::Gpu_GetMemoryUsed(m_renderer->GetRhiDevice().get());
+            m_gpu_memory_budget = RHI_CommandList::Gpu_GetMemoryBudget(m_renderer->GetRhiDevice().get());
+            RHI_CommandList::Gpu_GetAllocatorStatistics(m_gpu_allocations_device, m_gpu_allocations, m_gpu_allocator_reserved, m_gpu_allocator_used);
 
             // Create a string version of the rhi metrics
             if (m_renderer->GetOptions() & Render_Debug_PerformanceMetrics)
@@ -252,6 +254,10 @@ namespace Spartan
 		const auto texture_count	= m_resource_manager->GetResourceCount(Resource_Texture) + m_resource_manager->GetResourceCount(Resource_Texture2d) + m_resource_manager->GetResourceCount(Resource_TextureCube);
 		const auto material_count	= m_resource_manager->GetResourceCount(Resource_Material);
 
+        const uint32_t descriptor_set_lookups   = m_rhi_descriptor_set_hits + m_rhi_descriptor_set_updates;
+        const float descriptor_set_hit_rate     = descriptor_set_lookups != 0 ? 100.0f * static_cast<float>(m_rhi_descriptor_set_hits) / static_cast<float>(descriptor_set_lookups) : 0.0f;
+        const float triangle_reduction          = m_renderer_triangles_full != 0 ? 100.0f * (1.0f - static_cast<float>(m_renderer_triangles_drawn) / static_cast<float>(m_renderer_triangles_full)) : 0.0f;
+
         static const char* text =
             // Performance
             "FPS:\t\t\t\t\t\t\t%.2f\n"
@@ -260,9 +266,16 @@ namespace Spartan
             "GPU time:\t\t\t\t\t%.2f\n"
             "GPU:\t\t\t\t\t\t\t%s\n"
             "VRAM:\t\t\t\t\t\t%d/%d MB\n"
+            "VRAM budget:\t\t\t\t\t%d MB\n"
+            "GPU allocations:\t\t\t\t%d in %d blocks\n"
+            "GPU allocator memory:\t\t\t%d/%d MB\n"
             // Renderer
             "Resolution:\t\t\t\t\t%dx%d\n"
             "Meshes rendered:\t\t\t\t%d\n"
+            "Triangles (LOD):\t\t\t\t%d/%d (%.1f%% reduction)\n"
+            "Pass light depth:\t\t\t\t%d/%d\n"
+            "Pass depth prepass:\t\t\t%d/%d\n"
+            "Pass G-Buffer:\t\t\t\t%d/%d\n"
             "Textures:\t\t\t\t\t%d\n"
             "Materials:\t\t\t\t\t%d\n"
             // RHI
@@ -277,9 +290,12 @@ namespace Spartan
             "RHI Compute Shader bindings:\t%d\n"
             "RHI Render Target bindings:\t\t%d\n"
             "RHI Pipeline bindings:\t\t\t%d\n"
-            "RHI Descriptor Set bindings:\t\t%d";
+            "RHI Descriptor Set bindings:\t\t%d\n"
+            "RHI Descriptor Set cache:\t\t%d hits, %d updates (%.1f%% hit rate)\n"
+            "RHI Descriptor Set allocations:\t%d\n"
+            "RHI Secondary command lists:\t%d";
 
-		static char buffer[1024]; // real usage is around 800
+		static char buffer[2048]; // real usage is around 1100
 		sprintf_s
 		(
 			buffer, text,
@@ -292,10 +308,17 @@ namespace Spartan
 			m_gpu_name.c_str(),
 			m_gpu_memory_used,
 			m_gpu_memory_available,
+			m_gpu_memory_budget,
+			m_gpu_allocations, m_gpu_allocations_device,
+			m_gpu_allocator_used, m_gpu_allocator_reserved,
 
 			// Renderer
 			static_cast<int>(m_renderer->GetResolution().x), static_cast<int>(m_renderer->GetResolution().y),
 			m_renderer_meshes_rendered,
+			m_renderer_triangles_drawn, m_renderer_triangles_full, triangle_reduction,
+			m_renderer_pass_light_depth_drawn, m_renderer_pass_light_depth_considered,
+			m_renderer_pass_depth_prepass_drawn, m_renderer_pass_depth_prepass_considered,
+			m_renderer_pass_gbuffer_drawn, m_renderer_pass_gbuffer_considered,
 			texture_count,
 			material_count,
 
@@ -311,7 +334,10 @@ namespace Spartan
             m_rhi_bindings_shader_compute,
 			m_rhi_bindings_render_target,
             m_rhi_bindings_pipeline,
-            m_rhi_bindings_descriptor_set
+            m_rhi_bindings_descriptor_set,
+            m_rhi_descriptor_set_hits, m_rhi_descriptor_set_updates, descriptor_set_hit_rate,
+            m_rhi_descriptor_set_allocations,
+            m_rhi_cmd_lists_secondary
 		);
 
 		m_metrics = string(buffer);
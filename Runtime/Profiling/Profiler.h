@@ -71,6 +71,7 @@ namespace Spartan
 		const auto& GpuGetName() const { return m_gpu_name; }
         auto GpuGetMemoryAvailable() const { return m_gpu_memory_available; }
         auto GpuGetMemoryUsed() const { return m_gpu_memory_used; }
+        auto GpuGetMemoryBudget() const { return m_gpu_memory_budget; }
         bool IsCpuStuttering() const { return m_is_stuttering_cpu; }
         bool IsGpuStuttering() const { return m_is_stuttering_gpu; }
 		
@@ -87,10 +88,28 @@ namespace Spartan
 		uint32_t m_rhi_bindings_render_target	= 0;
         uint32_t m_rhi_bindings_descriptor_set  = 0;
         uint32_t m_rhi_bindings_pipeline        = 0;
+        uint32_t m_rhi_cmd_lists_secondary      = 0;
+
+        // Metrics - RHI descriptor sets (reused as is vs rewritten vs newly allocated)
+        uint32_t m_rhi_descriptor_set_hits          = 0;
+        uint32_t m_rhi_descriptor_set_updates       = 0;
+        uint32_t m_rhi_descriptor_set_allocations   = 0;
 
 		// Metrics - Renderer
 		uint32_t m_renderer_meshes_rendered = 0;
 
+        // Metrics - Renderer level of detail (triangles of every batched draw at full detail vs at the detail it was drawn with)
+        uint32_t m_renderer_triangles_full  = 0;
+        uint32_t m_renderer_triangles_drawn = 0;
+
+        // Metrics - Renderer passes (entities considered after culling vs entities drawn)
+        uint32_t m_renderer_pass_light_depth_considered     = 0;
+        uint32_t m_renderer_pass_light_depth_drawn          = 0;
+        uint32_t m_renderer_pass_depth_prepass_considered   = 0;
+        uint32_t m_renderer_pass_depth_prepass_drawn        = 0;
+        uint32_t m_renderer_pass_gbuffer_considered         = 0;
+        uint32_t m_renderer_pass_gbuffer_drawn              = 0;
+
 		// Metrics - Time
 		float m_time_frame_ms	= 0.0f;
 		float m_time_cpu_ms		= 0.0f;
@@ -101,6 +120,14 @@ namespace Spartan
         {
             m_rhi_draw_calls                = 0;
             m_renderer_meshes_rendered      = 0;
+            m_renderer_triangles_full       = 0;
+            m_renderer_triangles_drawn      = 0;
+            m_renderer_pass_light_depth_considered      = 0;
+            m_renderer_pass_light_depth_drawn           = 0;
+            m_renderer_pass_depth_prepass_considered    = 0;
+            m_renderer_pass_depth_prepass_drawn         = 0;
+            m_renderer_pass_gbuffer_considered          = 0;
+            m_renderer_pass_gbuffer_drawn               = 0;
             m_rhi_bindings_buffer_index     = 0;
             m_rhi_bindings_buffer_vertex    = 0;
             m_rhi_bindings_buffer_constant  = 0;
@@ -112,6 +139,10 @@ namespace Spartan
             m_rhi_bindings_render_target    = 0;
             m_rhi_bindings_descriptor_set   = 0;
             m_rhi_bindings_pipeline         = 0;
+            m_rhi_cmd_lists_secondary       = 0;
+            m_rhi_descriptor_set_hits           = 0;
+            m_rhi_descriptor_set_updates        = 0;
+            m_rhi_descriptor_set_allocations    = 0;
         }
 
 		TimeBlock* GetNewTimeBlock();
@@ -141,6 +172,13 @@ namespace Spartan
 		std::string m_gpu_name			= "N/A";
 		uint32_t m_gpu_memory_available	= 0;
 		uint32_t m_gpu_memory_used		= 0;
+		uint32_t m_gpu_memory_budget	= 0;
+
+        // Hardware - GPU allocator
+        uint32_t m_gpu_allocations_device   = 0;
+        uint32_t m_gpu_allocations          = 0;
+        uint32_t m_gpu_allocator_reserved   = 0;
+        uint32_t m_gpu_allocator_used       = 0;
 
         // Stutter detection
         double m_cpu_avg_ms             = 0.0;
@@ -35,6 +35,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Texture.h"
 #include "../RHI_Shader.h"
 #include "../RHI_ConstantBuffer.h"
+#include "../RHI_StructuredBuffer.h"
 #include "../RHI_VertexBuffer.h"
 #include "../RHI_IndexBuffer.h"
 #include "../RHI_BlendState.h"
@@ -320,13 +321,15 @@ namespace Spartan
         m_profiler->m_rhi_draw_calls++;
 	}
 
-	void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
+	void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count)
     {
-        m_rhi_device->GetContextRhi()->device_context->DrawIndexed
+        m_rhi_device->GetContextRhi()->device_context->DrawIndexedInstanced
         (
             static_cast<UINT>(index_count),
+            static_cast<UINT>(instance_count),
             static_cast<UINT>(index_offset),
-            static_cast<INT>(vertex_offset)
+            static_cast<INT>(vertex_offset),
+            0
         );
 
         m_profiler->m_rhi_draw_calls++;
@@ -453,6 +456,12 @@ namespace Spartan
         m_profiler->m_rhi_bindings_buffer_constant += scope & RHI_Buffer_PixelShader    ? 1 : 0;
     }
 
+    void RHI_CommandList::SetConstantBuffer(const uint32_t slot, uint8_t scope, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_index_dynamic) const
+    {
+        // D3D11 doesn't have dynamic offsets, the buffer holds whatever was mapped last
+        SetConstantBuffer(slot, scope, constant_buffer);
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         const UINT start_slot                     = slot;
@@ -521,6 +530,32 @@ namespace Spartan
         m_profiler->m_rhi_bindings_texture++;
 	}
 
+    void RHI_CommandList::SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer) const
+    {
+        void* resource_view                 = structured_buffer ? structured_buffer->GetResource() : nullptr;
+        ID3D11DeviceContext* device_context = m_rhi_device->GetContextRhi()->device_context;
+
+        // Skip if already set
+        ID3D11ShaderResourceView* set_view = nullptr;
+        device_context->VSGetShaderResources(slot, 1, &set_view);
+        if (set_view)
+        {
+            set_view->Release();
+        }
+        if (set_view == resource_view)
+            return;
+
+        const void* resource_array[1] = { resource_view };
+        device_context->VSSetShaderResources(slot, 1, reinterpret_cast<ID3D11ShaderResourceView* const*>(&resource_array));
+    }
+
+    bool RHI_CommandList::RecordParallel(const uint32_t draw_count, const function<void(RHI_CommandList*, uint32_t, uint32_t)>& record)
+    {
+        // The immediate context can't be used from multiple threads, so everything is recorded here
+        record(this, 0, draw_count);
+        return true;
+    }
+
 	bool RHI_CommandList::Submit()
 	{
 		return true;
@@ -650,6 +685,34 @@ namespace Spartan
         return 0;
     }
 
+    uint32_t RHI_CommandList::Gpu_GetMemoryBudget(RHI_Device* rhi_device)
+    {
+        if (const PhysicalDevice* physical_device = rhi_device->GetPrimaryPhysicalDevice())
+        {
+            if (auto adapter = static_cast<IDXGIAdapter3*>(physical_device->data))
+            {
+                DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+                const auto result = adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info);
+                if (FAILED(result))
+                {
+                    LOG_ERROR("Failed to get adapter memory info, %s", d3d11_common::dxgi_error_to_string(result));
+                    return 0;
+                }
+                return static_cast<uint32_t>(info.Budget / 1024 / 1024); // convert to MBs
+            }
+        }
+        return 0;
+    }
+
+    void RHI_CommandList::Gpu_GetAllocatorStatistics(uint32_t& device_allocations, uint32_t& allocations, uint32_t& memory_reserved, uint32_t& memory_used)
+    {
+        // D3D11 manages resource memory itself
+        device_allocations  = 0;
+        allocations         = 0;
+        memory_reserved     = 0;
+        memory_used         = 0;
+    }
+
     bool RHI_CommandList::Gpu_QueryCreate(RHI_Device* rhi_device, void** query, const RHI_Query_Type type)
     {
         RHI_Context* rhi_context = rhi_device->GetContextRhi();
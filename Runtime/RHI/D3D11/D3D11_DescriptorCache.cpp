@@ -32,12 +32,12 @@ namespace Spartan
     RHI_DescriptorCache::~RHI_DescriptorCache()
     = default;
 
-    void RHI_DescriptorCache::SetDescriptorSetCapacity(uint32_t descriptor_set_capacity)
+    void* RHI_DescriptorCache::AllocateDescriptorSet(void* descriptor_set_layout, const std::string& name)
     {
-
+        return nullptr;
     }
 
-    bool RHI_DescriptorCache::CreateDescriptorPool(uint32_t descriptor_set_capacity)
+    bool RHI_DescriptorCache::CreateDescriptorPool()
     {
         return true;
     }
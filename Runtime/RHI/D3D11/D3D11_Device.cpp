@@ -30,6 +30,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_RasterizerState.h"
 #include "../RHI_Shader.h"
 #include "../RHI_InputLayout.h"
+#include "../RHI_UploadManager.h"
 #include "../../Core/Settings.h"
 #include "../../Core/Context.h"
 #include "../../Logging/Log.h"
@@ -165,6 +166,16 @@ namespace Spartan
 			}
 		}
 
+        // Optional features
+        {
+            // Structured buffers are dynamic shader resources, which can only be mapped without discarding when this is supported
+            D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+            if (SUCCEEDED(m_rhi_context->device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+            {
+                m_rhi_context->map_no_overwrite_dynamic_srv = options.MapNoOverwriteOnDynamicBufferSRV != FALSE;
+            }
+        }
+
 		// Multi-thread protection
 		if (multithread_protection)
 		{
@@ -191,6 +202,9 @@ namespace Spartan
             }
         }
 
+        // Uploads
+        m_upload_manager = make_shared<RHI_UploadManager>(this);
+
 		m_initialized = true;
 	}
 
@@ -32,6 +32,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Core/FileSystem.h"
 #include <d3dcompiler.h>
 #include <sstream> 
+#include <cstring>
 //================================
 
 //= NAMESPACES =====
@@ -81,11 +82,25 @@ namespace Spartan
 		}
 		defines.emplace_back(D3D_SHADER_MACRO{ nullptr, nullptr });
 
+        // Try the bytecode cache first, only compile on a miss
+        const string compiler_signature = "d3dcompiler " + to_string(D3D_COMPILER_VERSION) + " flags " + to_string(compile_flags);
+        const uint64_t cache_key        = Cache_ComputeKey(shader, compiler_signature);
+        vector<unsigned char> bytecode;
+        m_from_cache = Cache_Load(cache_key, bytecode);
+
 		// Compile
 		ID3DBlob* blob_error	= nullptr;
 		ID3DBlob* shader_blob	= nullptr;
 		HRESULT result;
-		if (FileSystem::IsFile(shader)) // From file ?
+        if (m_from_cache) // From cache ?
+        {
+            result = D3DCreateBlob(static_cast<SIZE_T>(bytecode.size()), &shader_blob);
+            if (SUCCEEDED(result))
+            {
+                memcpy(shader_blob->GetBufferPointer(), bytecode.data(), bytecode.size());
+            }
+        }
+		else if (FileSystem::IsFile(shader)) // From file ?
 		{
             const auto file_path = FileSystem::StringToWstring(shader);
 			result = D3DCompileFromFile
@@ -159,6 +174,13 @@ namespace Spartan
 			}
 		}
 
+        // Cache it, so the next launch can skip compilation
+        if (!m_from_cache && SUCCEEDED(result) && shader_blob)
+        {
+            const unsigned char* bytecode_begin = static_cast<const unsigned char*>(shader_blob->GetBufferPointer());
+            Cache_Save(cache_key, vector<unsigned char>(bytecode_begin, bytecode_begin + shader_blob->GetBufferSize()));
+        }
+
 		// Create shader
 		void* shader_view = nullptr;
 		if (shader_blob)
@@ -0,0 +1,124 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= IMPLEMENTATION ===============
+#include "../RHI_Implementation.h"
+#ifdef API_GRAPHICS_D3D11
+//================================
+
+//= INCLUDES =======================
+#include "../RHI_StructuredBuffer.h"
+#include "../RHI_Device.h"
+#include "../../Logging/Log.h"
+//==================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    RHI_StructuredBuffer::~RHI_StructuredBuffer()
+    {
+        safe_release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource));
+        safe_release(*reinterpret_cast<ID3D11Buffer**>(&m_buffer));
+    }
+
+    bool RHI_StructuredBuffer::_Create()
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        safe_release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource));
+        safe_release(*reinterpret_cast<ID3D11Buffer**>(&m_buffer));
+        m_mapped = false;
+
+        // Buffer
+        D3D11_BUFFER_DESC buffer_desc   = {};
+        buffer_desc.ByteWidth           = static_cast<UINT>(GetSize());
+        buffer_desc.Usage               = D3D11_USAGE_DYNAMIC;
+        buffer_desc.BindFlags           = D3D11_BIND_SHADER_RESOURCE;
+        buffer_desc.CPUAccessFlags      = D3D11_CPU_ACCESS_WRITE;
+        buffer_desc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+        buffer_desc.StructureByteStride = m_stride;
+
+        if (FAILED(m_rhi_device->GetContextRhi()->device->CreateBuffer(&buffer_desc, nullptr, reinterpret_cast<ID3D11Buffer**>(&m_buffer))))
+        {
+            LOG_ERROR("Failed to create structured buffer");
+            return false;
+        }
+
+        // Shader resource view
+        D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc    = {};
+        srv_desc.Format                             = DXGI_FORMAT_UNKNOWN;
+        srv_desc.ViewDimension                      = D3D11_SRV_DIMENSION_BUFFER;
+        srv_desc.Buffer.FirstElement                = 0;
+        srv_desc.Buffer.NumElements                 = m_element_count * m_ring_frame_count;
+
+        if (FAILED(m_rhi_device->GetContextRhi()->device->CreateShaderResourceView(static_cast<ID3D11Buffer*>(m_buffer), &srv_desc, reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource))))
+        {
+            LOG_ERROR("Failed to create structured buffer view");
+            return false;
+        }
+
+        return true;
+    }
+
+    void* RHI_StructuredBuffer::Map(const uint32_t index /*= 0*/) const
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device_context || !m_buffer)
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return nullptr;
+        }
+
+        // The ring never writes over elements which the GPU might be reading, so after the first map of a frame nothing has to be discarded.
+        // Mapping a dynamic shader resource without discarding is only valid when the driver supports it, otherwise every map discards.
+        const bool no_overwrite     = m_mapped && m_rhi_device->GetContextRhi()->map_no_overwrite_dynamic_srv;
+        const D3D11_MAP map_type    = no_overwrite ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+        m_mapped                    = true;
+
+        D3D11_MAPPED_SUBRESOURCE mapped_resource;
+        if (FAILED(m_rhi_device->GetContextRhi()->device_context->Map(static_cast<ID3D11Buffer*>(m_buffer), 0, map_type, 0, &mapped_resource)))
+        {
+            LOG_ERROR("Failed to map structured buffer");
+            return nullptr;
+        }
+
+        return static_cast<uint8_t*>(mapped_resource.pData) + static_cast<uint64_t>(index) * m_stride;
+    }
+
+    bool RHI_StructuredBuffer::Unmap() const
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device_context || !m_buffer)
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return false;
+        }
+
+        m_rhi_device->GetContextRhi()->device_context->Unmap(static_cast<ID3D11Buffer*>(m_buffer), 0);
+        return true;
+    }
+}
+#endif
@@ -102,7 +102,7 @@ namespace Spartan
 		const uint32_t array_size,
 		const DXGI_FORMAT format,
 		const UINT bind_flags,
-		vector<vector<std::byte>>& data,
+		const vector<RHI_Texture_Mip>& data,
 		const shared_ptr<RHI_Device>& rhi_device
 	)
 	{
@@ -124,14 +124,14 @@ namespace Spartan
 		vector<D3D11_SUBRESOURCE_DATA> vec_subresource_data;
 		for (uint32_t mip_level = 0; mip_level < static_cast<uint32_t>(data.size()); mip_level++)
 		{
-			if (data[mip_level].empty())
+			if (!data[mip_level].data || data[mip_level].size == 0)
 			{
 				LOG_ERROR("Mipmap %d has invalid data.", mip_level);
 				return false;
 			}
 
 			auto& subresource_data				= vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
-			subresource_data.pSysMem			= data[mip_level].data();					    // Data pointer		
+			subresource_data.pSysMem			= data[mip_level].data;					        // Data pointer		
 			subresource_data.SysMemPitch		= (width >> mip_level) * channels * (bpc / 8);	// Line width in bytes
 			subresource_data.SysMemSlicePitch	= 0;								            // This is only used for 3D textures
 		}
@@ -198,7 +198,7 @@ namespace Spartan
 		return true;
 	}
 
-	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, vector<vector<std::byte>>& data, const shared_ptr<RHI_Device>& rhi_device)
+	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, const vector<RHI_Texture_Mip>& data, const shared_ptr<RHI_Device>& rhi_device)
 	{
 		// Describe
 		D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc	= {};
@@ -279,6 +279,9 @@ namespace Spartan
         const DXGI_FORMAT format_dsv	= GetDepthFormatDsv(m_format);
         const DXGI_FORMAT format_srv	= GetDepthFormatSrv(m_format);
 
+        // Mips either live in m_data or are still mapped from the texture's file
+        const vector<RHI_Texture_Mip> mips = GetMipViews();
+
 		// TEXTURE
 		result_tex = CreateTexture2d
 		(
@@ -290,7 +293,7 @@ namespace Spartan
 			m_array_size,
 			format,
 			flags,
-			m_data,
+			mips,
 			m_rhi_device
 		);
 
@@ -302,7 +305,7 @@ namespace Spartan
                 m_view_texture[0],
                 format_srv,
                 m_array_size,
-                m_data,
+                mips,
                 m_rhi_device
             );
         }
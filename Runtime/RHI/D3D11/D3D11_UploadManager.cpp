@@ -0,0 +1,72 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= IMPLEMENTATION ===============
+#include "../RHI_Implementation.h"
+#ifdef API_GRAPHICS_D3D11
+//================================
+
+//= INCLUDES =====================
+#include "../RHI_UploadManager.h"
+#include "../RHI_Device.h"
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+// D3D11 uploads initial data when resources are created (and the driver schedules the copies), so every token is complete.
+
+namespace Spartan
+{
+    RHI_UploadManager::RHI_UploadManager(RHI_Device* rhi_device)
+    {
+        m_rhi_device = rhi_device;
+    }
+
+    RHI_UploadManager::~RHI_UploadManager() = default;
+
+    uint64_t RHI_UploadManager::UploadTexture(RHI_Texture* texture)
+    {
+        return 0;
+    }
+
+    uint64_t RHI_UploadManager::UploadBuffer(void* buffer, const void* data, const uint64_t size)
+    {
+        return 0;
+    }
+
+    void RHI_UploadManager::Tick()
+    {
+
+    }
+
+    bool RHI_UploadManager::Wait(const uint64_t token)
+    {
+        return true;
+    }
+
+    void RHI_UploadManager::ReleaseAfter(const uint64_t token, function<void()>&& release)
+    {
+        release();
+    }
+}
+#endif
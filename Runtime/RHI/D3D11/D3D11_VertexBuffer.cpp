@@ -41,6 +41,12 @@ namespace Spartan
 		safe_release(*reinterpret_cast<ID3D11Buffer**>(&m_buffer));
 	}
 
+    bool RHI_VertexBuffer::IsResident() const
+    {
+        // The initial data is uploaded when the buffer is created
+        return true;
+    }
+
 	bool RHI_VertexBuffer::_Create(const void* vertices)
 	{
 		if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device_context)
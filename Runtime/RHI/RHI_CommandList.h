@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==============
 #include <vector>
+#include <memory>
+#include <functional>
 #include "RHI_Definition.h"
 //=========================
 
@@ -30,6 +32,7 @@ namespace Spartan
 {
 	class Profiler;
     class Renderer;
+    class Threading;
 
     enum RHI_Cmd_List_State
     {
@@ -54,7 +57,7 @@ namespace Spartan
 
 		// Draw/Dispatch
 		void Draw(uint32_t vertex_count);
-		void DrawIndexed(uint32_t index_count, uint32_t index_offset = 0, uint32_t vertex_offset = 0);
+		void DrawIndexed(uint32_t index_count, uint32_t index_offset = 0, uint32_t vertex_offset = 0, uint32_t instance_count = 1);
         void Dispatch(uint32_t x, uint32_t y, uint32_t z = 1) const;
 
 		// Viewport
@@ -79,6 +82,10 @@ namespace Spartan
         void SetConstantBuffer(const uint32_t slot, const uint8_t scope, RHI_ConstantBuffer* constant_buffer) const;
         inline void SetConstantBuffer(const uint32_t slot, const uint8_t scope, const std::shared_ptr<RHI_ConstantBuffer>& constant_buffer) const { SetConstantBuffer(slot, scope, constant_buffer.get()); }
 
+        // Dynamic constant buffer, bound at an explicit element instead of the buffer's dynamic offset (see RHI_ConstantBuffer::AllocateRange())
+        void SetConstantBuffer(const uint32_t slot, const uint8_t scope, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_index_dynamic) const;
+        inline void SetConstantBuffer(const uint32_t slot, const uint8_t scope, const std::shared_ptr<RHI_ConstantBuffer>& constant_buffer, const uint32_t offset_index_dynamic) const { SetConstantBuffer(slot, scope, constant_buffer.get(), offset_index_dynamic); }
+
 		// Sampler
         void SetSampler(const uint32_t slot, RHI_Sampler* sampler) const;
         inline void SetSampler(const uint32_t slot, const std::shared_ptr<RHI_Sampler>& sampler) const { SetSampler(slot, sampler.get()); }
@@ -86,7 +93,17 @@ namespace Spartan
 		// Texture
         void SetTexture(const uint32_t slot, RHI_Texture* texture);
         inline void SetTexture(const uint32_t slot, const std::shared_ptr<RHI_Texture>& texture) { SetTexture(slot, texture.get()); }
+
+        // Structured buffer (bound to the vertex shader)
+        void SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer) const;
+        inline void SetStructuredBuffer(const uint32_t slot, const std::shared_ptr<RHI_StructuredBuffer>& structured_buffer) const { SetStructuredBuffer(slot, structured_buffer.get()); }
         
+        // Parallel recording - Splits [0, draw_count) into chunks which the worker threads record into secondary command lists, which are then executed in order.
+        // The function has the signature void(RHI_CommandList* cmd_list, uint32_t start, uint32_t end) and runs concurrently, so it should only touch per draw state.
+        // When there are too few draws, Render_ParallelRecording is off, or the backend/pipeline can't use secondary command lists, everything is recorded into this command list instead.
+        bool RecordParallel(const uint32_t draw_count, const std::function<void(RHI_CommandList*, uint32_t, uint32_t)>& record);
+        static const uint32_t parallel_draws_min = 128; // draws per secondary command list
+
         // Submit/Flush
 		bool Submit();
         bool Flush();
@@ -98,6 +115,8 @@ namespace Spartan
 
         static uint32_t Gpu_GetMemory(RHI_Device* rhi_device);
         static uint32_t Gpu_GetMemoryUsed(RHI_Device* rhi_device);
+        static uint32_t Gpu_GetMemoryBudget(RHI_Device* rhi_device);
+        static void Gpu_GetAllocatorStatistics(uint32_t& device_allocations, uint32_t& allocations, uint32_t& memory_reserved, uint32_t& memory_used);
         static bool Gpu_QueryCreate(RHI_Device* rhi_device, void** query = nullptr, RHI_Query_Type type = RHI_Query_Timestamp);
         static void Gpu_QueryRelease(void*& query_object);
         
@@ -105,9 +124,16 @@ namespace Spartan
         void* GetResource_CommandBuffer() const { return m_cmd_buffer; }
 
 	private:
+        // Secondary command list, records a part of the primary's render pass on a worker thread
+        RHI_CommandList(RHI_CommandList* primary);
+        bool BeginSecondary(RHI_CommandList* primary);
+        bool IsSecondary() const { return m_primary != nullptr; }
+        void MetricsMerge(RHI_CommandList* cmd_list);
+        void MetricsToProfiler();
+
         void MarkAndProfileStart(const RHI_PipelineState* pipeline_state);
         void MarkAndProfileEnd(const RHI_PipelineState* pipeline_state);
-        void BeginRenderPass();
+        void BeginRenderPass(const bool secondary_contents = false);
         bool BindDescriptorSet();
         bool OnDraw();
 
@@ -125,11 +151,34 @@ namespace Spartan
         void* m_cmd_list_consumed_fence         = nullptr;
         void* m_query_pool                      = nullptr;
         bool m_render_pass_begun_pipeline_bound = false;
+        bool m_render_pass_secondary_contents   = false;
         std::vector<uint64_t> m_timestamps;
         std::vector<bool> m_passes_active;
 
+        // Secondary command lists
+        RHI_CommandList* m_primary  = nullptr;
+        Threading* m_threading      = nullptr;
+        void* m_cmd_pool            = nullptr; // secondaries record concurrently, so each has its own pool
+        std::shared_ptr<RHI_DescriptorCache> m_descriptor_cache_secondary;
+        std::vector<std::shared_ptr<RHI_CommandList>> m_cmd_lists_secondary;
+
+        // Secondaries can't write to the profiler from the worker threads, so every list counts here and the primary hands the counts over on submission
+        uint32_t m_metric_draw_calls                    = 0;
+        uint32_t m_metric_bindings_buffer_vertex        = 0;
+        uint32_t m_metric_bindings_buffer_index         = 0;
+        uint32_t m_metric_bindings_descriptor_set       = 0;
+        uint32_t m_metric_bindings_pipeline             = 0;
+        uint32_t m_metric_cmd_lists_secondary           = 0;
+        uint32_t m_metric_descriptor_set_hits           = 0;
+        uint32_t m_metric_descriptor_set_updates        = 0;
+        uint32_t m_metric_descriptor_set_allocations    = 0;
+
         // Variables to minimise state changes
         uint32_t m_set_id_buffer_vertex = 0;
         uint32_t m_set_id_buffer_pixel  = 0;
+
+        // Whether the last vertex/index buffers that were set have completed their upload, draws are skipped until they do
+        bool m_buffer_vertex_resident   = true;
+        bool m_buffer_index_resident    = true;
 	};
 }
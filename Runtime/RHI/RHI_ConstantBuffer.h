@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==========
 #include <memory>
+#include <vector>
 #include "RHI_Object.h"
 //=====================
 
@@ -31,11 +32,7 @@ namespace Spartan
 	class SPARTAN_CLASS RHI_ConstantBuffer : public RHI_Object
 	{
 	public:
-		RHI_ConstantBuffer(const std::shared_ptr<RHI_Device>& rhi_device, bool is_dynamic = false)
-		{
-			m_rhi_device = rhi_device;
-            m_is_dynamic = is_dynamic;
-		}
+		RHI_ConstantBuffer(const std::shared_ptr<RHI_Device>& rhi_device, bool is_dynamic = false);
 		~RHI_ConstantBuffer();
 
 		template<typename T>
@@ -67,6 +64,21 @@ namespace Spartan
         uint32_t GetOffsetIndexDynamic()                        const { return m_offset_dynamic_index; }
         void SetOffsetIndexDynamic(const uint32_t offset_index)       { m_offset_dynamic_index = offset_index; }
 
+        // Ring allocation - Every allocation hands out the next element of the current frame's region and points the dynamic offset at it.
+        // Running out of elements grows the buffer without waiting for the GPU, the previous buffer's release is deferred by the device.
+        void ResetRing(const uint64_t frame);
+        void* Allocate();
+        uint32_t GetRingAllocationCount() const { return m_ring_cursor; }
+        // One region per frame in flight, as many as the device had when the buffer was constructed
+        uint32_t GetRingFrameCount() const { return m_ring_frame_count; }
+
+        // Reserves count consecutive elements and returns the index of the first one, without mapping or moving the dynamic offset.
+        // The elements are written with Map(index) and bound with an explicit offset, so they can be used from multiple threads.
+        uint32_t AllocateRange(const uint32_t count);
+
+        // Changes whenever an allocation or a ring reset happens, so an element is only reused if nothing has moved since
+        uint64_t GetRingVersion() const { return m_ring_version; }
+
 	private:
 		bool _Create();
 
@@ -76,9 +88,16 @@ namespace Spartan
         uint32_t m_offset_index         = 0;
         uint32_t m_offset_dynamic_index = 0;
 
+        // Ring allocation
+        uint32_t m_ring_frame_count = 0;
+        uint64_t m_ring_frame   = 0;
+        uint32_t m_ring_cursor  = 0;
+        uint64_t m_ring_version = 0;
+
 		// API
 		void* m_buffer			= nullptr;
 		void* m_buffer_memory	= nullptr;
+        void* m_buffer_mapped   = nullptr;
 
         // Dependencies
         std::shared_ptr<RHI_Device> m_rhi_device;
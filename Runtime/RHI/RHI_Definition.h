@@ -39,6 +39,7 @@ namespace Spartan
 	class RHI_Pipeline;
     class RHI_DescriptorSetLayout;
     class RHI_DescriptorCache;
+    class RHI_UploadManager;
 	class RHI_SwapChain;
 	class RHI_RasterizerState;
 	class RHI_BlendState;
@@ -47,6 +48,7 @@ namespace Spartan
 	class RHI_VertexBuffer;
 	class RHI_IndexBuffer;
 	class RHI_ConstantBuffer;
+	class RHI_StructuredBuffer;
 	class RHI_Sampler;
 	class RHI_Viewport;
 	class RHI_Texture;
@@ -234,6 +236,7 @@ namespace Spartan
 		RHI_Descriptor_Texture,
 		RHI_Descriptor_ConstantBuffer,
         RHI_Descriptor_ConstantBufferDynamic,
+        RHI_Descriptor_StructuredBuffer,
         RHI_Descriptor_Undefined
 	};
 
@@ -275,6 +278,7 @@ namespace Spartan
         RHI_Descriptor_Type type    = RHI_Descriptor_Undefined;
         RHI_Image_Layout layout     = RHI_Image_Undefined;
         void* resource              = nullptr;
+        uint64_t resource_id        = 0; // see RHI_Object::GetResourceId()
     };
 
     inline const char* rhi_format_to_string(const RHI_Format result)
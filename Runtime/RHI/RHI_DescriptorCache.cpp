@@ -41,8 +41,8 @@ namespace Spartan
     {
         m_rhi_device = rhi_device;
 
-        // Set the descriptor set capacity to an initial value
-        SetDescriptorSetCapacity(m_descriptor_set_capacity);
+        // Create the first pool, more are added if needed
+        CreateDescriptorPool();
     }
 
     void RHI_DescriptorCache::SetPipelineState(RHI_PipelineState& pipeline_state)
@@ -73,7 +73,7 @@ namespace Spartan
         m_descriptor_layout_current->NeedsToBind();
     }
 
-    void RHI_DescriptorCache::SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer)
+    void RHI_DescriptorCache::SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_dynamic)
     {
         if (!m_descriptor_layout_current)
         {
@@ -81,7 +81,7 @@ namespace Spartan
             return;
         }
 
-        m_descriptor_layout_current->SetConstantBuffer(slot, constant_buffer);
+        m_descriptor_layout_current->SetConstantBuffer(slot, constant_buffer, offset_dynamic);
     }
 
     void RHI_DescriptorCache::SetSampler(const uint32_t slot, RHI_Sampler* sampler)
@@ -106,6 +106,17 @@ namespace Spartan
         m_descriptor_layout_current->SetTexture(slot, texture);
     }
 
+    void RHI_DescriptorCache::SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer)
+    {
+        if (!m_descriptor_layout_current)
+        {
+            LOG_ERROR("Invalid descriptor set layout");
+            return;
+        }
+
+        m_descriptor_layout_current->SetStructuredBuffer(slot, structured_buffer);
+    }
+
     void* RHI_DescriptorCache::GetResource_DescriptorSetLayout() const
     {
         if (!m_descriptor_layout_current)
@@ -139,34 +150,11 @@ namespace Spartan
         return m_descriptor_layout_current->GetDynamicOffsets();
     }
 
-    bool RHI_DescriptorCache::HasEnoughCapacity() const
+    RHI_DescriptorCache_Statistics RHI_DescriptorCache::ConsumeStatistics()
     {
-        return m_descriptor_set_capacity > GetDescriptorSetCount();
-    }
-
-    void RHI_DescriptorCache::GrowIfNeeded()
-    {
-        // If there is room for at least one more descriptor set (hence +1), we don't need to re-allocate yet
-        const uint32_t required_capacity = GetDescriptorSetCount() + 1;
-
-        // If we are over-budget, re-allocate the descriptor pool with double size
-        if (required_capacity > m_descriptor_set_capacity)
-        {
-            m_descriptor_set_capacity *= 2;
-            SetDescriptorSetCapacity(m_descriptor_set_capacity);
-            LOG_INFO("Capacity has been increased to %d elements", m_descriptor_set_capacity);
-        }
-    }
-
-    uint32_t RHI_DescriptorCache::GetDescriptorSetCount() const
-    {
-        uint32_t descriptor_set_count = 0;
-        for (const auto& it : m_descriptor_set_layouts)
-        {
-            descriptor_set_count += it.second->GetDescriptorSetCount();
-        }
-
-        return descriptor_set_count;
+        const RHI_DescriptorCache_Statistics statistics = m_statistics;
+        m_statistics = RHI_DescriptorCache_Statistics();
+        return statistics;
     }
 
     vector<RHI_Descriptor> RHI_DescriptorCache::GenerateDescriptors(RHI_PipelineState& pipeline_state)
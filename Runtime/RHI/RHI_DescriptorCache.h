@@ -27,10 +27,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <string>
 //=========================
 
 namespace Spartan
 {
+    struct RHI_DescriptorCache_Statistics
+    {
+        uint32_t hits           = 0; // descriptor sets which were reused as is
+        uint32_t updates        = 0; // descriptor sets which had to be written (recycled or newly allocated)
+        uint32_t allocations    = 0; // descriptor sets which had to be allocated from a pool
+    };
+
     class SPARTAN_CLASS RHI_DescriptorCache : public RHI_Object
     {
     public:
@@ -40,33 +48,37 @@ namespace Spartan
         void SetPipelineState(RHI_PipelineState& pipeline_state);
 
         // Descriptor resource updating
-        void SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer);
+        void SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_dynamic);
         void SetSampler(const uint32_t slot, RHI_Sampler* sampler);
         void SetTexture(const uint32_t slot, RHI_Texture* texture);
+        void SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer);
 
         // Properties
-        void* GetResource_DescriptorSetPool() const { return m_descriptor_pool; }
         void* GetResource_DescriptorSetLayout() const;
         bool GetResource_DescriptorSet(void*& descriptor_set);
         const std::vector<uint32_t>& GetDynamicOffsets() const;
 
-        // Capacity
-        bool HasEnoughCapacity() const;
-        void GrowIfNeeded();
+        // Allocation - pools have a fixed size and a new one is added when they run out, so existing descriptor sets are never invalidated
+        void* AllocateDescriptorSet(void* descriptor_set_layout, const std::string& name);
+
+        // Statistics - accumulate until they are consumed
+        RHI_DescriptorCache_Statistics& GetStatistics() { return m_statistics; }
+        RHI_DescriptorCache_Statistics ConsumeStatistics();
 
     private:
-        uint32_t GetDescriptorSetCount() const;
-        void SetDescriptorSetCapacity(uint32_t descriptor_capacity);
-        bool CreateDescriptorPool(uint32_t descriptor_set_capacity);
+        bool CreateDescriptorPool();
         std::vector<RHI_Descriptor> GenerateDescriptors(RHI_PipelineState& pipeline_state);
 
         // Descriptor set layouts 
         std::unordered_map<std::size_t, std::shared_ptr<RHI_DescriptorSetLayout>> m_descriptor_set_layouts;
         RHI_DescriptorSetLayout* m_descriptor_layout_current = nullptr;
 
-        // Descriptor pool
-        uint32_t m_descriptor_set_capacity = 16;
-        void* m_descriptor_pool = nullptr;
+        // Descriptor pools
+        static const uint32_t descriptor_pool_set_capacity = 256;
+        std::vector<void*> m_descriptor_pools;
+
+        // Statistics
+        RHI_DescriptorCache_Statistics m_statistics;
 
         // Dependencies
         const RHI_Device* m_rhi_device;
@@ -20,12 +20,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES =======================
+#include <algorithm>
 #include "RHI_DescriptorSetLayout.h"
 #include "RHI_ConstantBuffer.h"
 #include "RHI_Sampler.h"
 #include "RHI_Texture.h"
+#include "RHI_StructuredBuffer.h"
 #include "RHI_Implementation.h"
 #include "RHI_DescriptorCache.h"
+#include "RHI_Device.h"
 #include "../Utilities/Hash.h"
 //==================================
 
@@ -42,7 +45,7 @@ namespace Spartan
         m_descriptor_set_layout = CreateDescriptorSetLayout(m_descriptors);
     }
 
-    void RHI_DescriptorSetLayout::SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer)
+    void RHI_DescriptorSetLayout::SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_dynamic)
     {
         for (RHI_Descriptor& descriptor : m_descriptors)
         {
@@ -55,14 +58,16 @@ namespace Spartan
             {
                 // Determine if the descriptor set needs to bind
                 m_needs_to_bind = descriptor.resource   != constant_buffer->GetResource()   ? true : m_needs_to_bind;                                                                                       // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource_id != constant_buffer->GetResourceId() ? true : m_needs_to_bind;                                                                                      // affects vkUpdateDescriptorSets
                 m_needs_to_bind = descriptor.offset     != constant_buffer->GetOffset()     ? true : m_needs_to_bind;                                                                                       // affects vkUpdateDescriptorSets
                 m_needs_to_bind = descriptor.range      != constant_buffer->GetStride()     ? true : m_needs_to_bind;                                                                                       // affects vkUpdateDescriptorSets
-                m_needs_to_bind = !m_constant_buffer_dynamic_offsets.empty() ? (m_constant_buffer_dynamic_offsets[0] != constant_buffer->GetOffsetDynamic() ? true : m_needs_to_bind) : m_needs_to_bind;    // affects vkCmdBindDescriptorSets 
+                m_needs_to_bind = !m_constant_buffer_dynamic_offsets.empty() ? (m_constant_buffer_dynamic_offsets[0] != offset_dynamic ? true : m_needs_to_bind) : m_needs_to_bind;    // affects vkCmdBindDescriptorSets 
 
                 // Update
-                descriptor.resource = constant_buffer->GetResource();
-                descriptor.offset   = constant_buffer->GetOffset();
-                descriptor.range    = constant_buffer->GetStride();
+                descriptor.resource     = constant_buffer->GetResource();
+                descriptor.resource_id  = constant_buffer->GetResourceId();
+                descriptor.offset       = constant_buffer->GetOffset();
+                descriptor.range        = constant_buffer->GetStride();
 
                 // Update the dynamic offset.
                 // Note: This is not directly related to the descriptor, it's a value that gets set when vkCmdBindDescriptorSets is called, just before a draw call.
@@ -70,11 +75,11 @@ namespace Spartan
                 {
                     if (m_constant_buffer_dynamic_offsets.empty())
                     {
-                        m_constant_buffer_dynamic_offsets.emplace_back(constant_buffer->GetOffsetDynamic());
+                        m_constant_buffer_dynamic_offsets.emplace_back(offset_dynamic);
                     }
                     else
                     {
-                        m_constant_buffer_dynamic_offsets[0] = constant_buffer->GetOffsetDynamic();
+                        m_constant_buffer_dynamic_offsets[0] = offset_dynamic;
                     }
                 }
 
@@ -90,10 +95,12 @@ namespace Spartan
             if (descriptor.type == RHI_Descriptor_Sampler && descriptor.slot == slot + m_rhi_device->GetContextRhi()->shader_shift_sampler)
             {
                 // Determine if the descriptor set needs to bind
-                m_needs_to_bind = descriptor.resource != sampler->GetResource() ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource       != sampler->GetResource()   ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource_id    != sampler->GetResourceId() ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
 
                 // Update
-                descriptor.resource = sampler->GetResource();
+                descriptor.resource     = sampler->GetResource();
+                descriptor.resource_id  = sampler->GetResourceId();
 
                 break;
             }
@@ -119,11 +126,37 @@ namespace Spartan
             if (descriptor.type == RHI_Descriptor_Texture && descriptor.slot == slot + m_rhi_device->GetContextRhi()->shader_shift_texture)
             {
                 // Determine if the descriptor set needs to bind
-                m_needs_to_bind = descriptor.resource != texture->Get_View_Texture() ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource       != texture->Get_View_Texture()  ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource_id    != texture->GetResourceId()     ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.layout         != texture->GetLayout()         ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
 
                 // Update
-                descriptor.resource = texture->Get_View_Texture();
-                descriptor.layout   = texture->GetLayout();
+                descriptor.resource     = texture->Get_View_Texture();
+                descriptor.resource_id  = texture->GetResourceId();
+                descriptor.layout       = texture->GetLayout();
+
+                break;
+            }
+        }
+    }
+
+    void RHI_DescriptorSetLayout::SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer)
+    {
+        for (RHI_Descriptor& descriptor : m_descriptors)
+        {
+            // Structured buffers are t registers, so they share the texture shift
+            if (descriptor.type == RHI_Descriptor_StructuredBuffer && descriptor.slot == slot + m_rhi_device->GetContextRhi()->shader_shift_texture)
+            {
+                // Determine if the descriptor set needs to bind
+                m_needs_to_bind = descriptor.resource       != structured_buffer->GetResource()     ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.resource_id    != structured_buffer->GetResourceId()   ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.range          != structured_buffer->GetSize()         ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+
+                // Update
+                descriptor.resource     = structured_buffer->GetResource();
+                descriptor.resource_id  = structured_buffer->GetResourceId();
+                descriptor.offset       = 0;
+                descriptor.range        = structured_buffer->GetSize();
 
                 break;
             }
@@ -132,32 +165,117 @@ namespace Spartan
 
     bool RHI_DescriptorSetLayout::GetResource_DescriptorSet(RHI_DescriptorCache* descriptor_cache, void*& descriptor_set)
     {
+        // Nothing changed since the last bind, the bound descriptor set is still valid
+        if (!m_needs_to_bind)
+            return true;
+
+        // Once per frame, retire the descriptor sets which haven't been used for a while
+        const uint64_t frame = m_rhi_device->GetFrameIndex();
+        if (frame != m_frame_retired)
+        {
+            RetireDescriptorSets(frame);
+            m_frame_retired = frame;
+        }
+
         // Get the hash of the current state of the descriptors
         const size_t hash = ComputeDescriptorSetHash(m_descriptors);
 
-        // If we don't have a descriptor set to match that state, create one
-        if (m_descriptor_sets.find(hash) == m_descriptor_sets.end())
+        // If there is a descriptor set which was written with exactly these descriptors, reuse it
+        auto it = m_descriptor_sets.find(hash);
+        if (it != m_descriptor_sets.end() && IsMatch(it->second))
         {
-            // Only allocate if the descriptor set cache hash enough capacity
-            if (descriptor_cache->HasEnoughCapacity())
+            it->second.frame_used = frame;
+            descriptor_set  = it->second.resource;
+            m_needs_to_bind = false;
+            descriptor_cache->GetStatistics().hits++;
+            return true;
+        }
+
+        // A hash collision, the existing set might still be in use by frames in flight so it's retired (and checked before it's reused)
+        if (it != m_descriptor_sets.end())
+        {
+            m_descriptor_sets_free.emplace_back(move(it->second));
+            m_descriptor_sets.erase(it);
+        }
+
+        // Create a descriptor set to match that state (rewrites a retired one if possible)
+        descriptor_set = CreateDescriptorSet(descriptor_cache);
+        if (!descriptor_set)
+            return false;
+
+        DescriptorSet& entry    = m_descriptor_sets[hash];
+        entry.resource          = descriptor_set;
+        entry.frame_used        = frame;
+        entry.contents.resize(m_descriptors.size());
+        for (size_t i = 0; i < m_descriptors.size(); i++)
+        {
+            entry.contents[i].resource      = m_descriptors[i].resource;
+            entry.contents[i].resource_id   = m_descriptors[i].resource_id;
+            entry.contents[i].offset        = m_descriptors[i].offset;
+            entry.contents[i].range         = m_descriptors[i].range;
+            entry.contents[i].layout        = m_descriptors[i].layout;
+        }
+
+        m_needs_to_bind = false;
+        descriptor_cache->GetStatistics().updates++;
+        return true;
+    }
+
+    bool RHI_DescriptorSetLayout::IsMatch(const DescriptorSet& descriptor_set) const
+    {
+        if (descriptor_set.contents.size() != m_descriptors.size())
+            return false;
+
+        for (size_t i = 0; i < m_descriptors.size(); i++)
+        {
+            const DescriptorContents& contents = descriptor_set.contents[i];
+            const RHI_Descriptor& descriptor   = m_descriptors[i];
+
+            // The resource id is what tells a destroyed resource apart from a new one which was given the same handle value
+            if (contents.resource != descriptor.resource || contents.resource_id != descriptor.resource_id || contents.offset != descriptor.offset || contents.range != descriptor.range || contents.layout != descriptor.layout)
+                return false;
+        }
+
+        return true;
+    }
+
+    void RHI_DescriptorSetLayout::RetireDescriptorSets(const uint64_t frame)
+    {
+        // Only sets which no frame in flight can reference anymore, with some slack so that sets used every few frames are kept
+        const uint64_t frames_unused = max<uint64_t>(descriptor_set_retire_frames, m_rhi_device->GetFramesInFlight() + 1);
+
+        for (auto it = m_descriptor_sets.begin(); it != m_descriptor_sets.end();)
+        {
+            if (it->second.frame_used + frames_unused < frame)
             {
-                descriptor_set = CreateDescriptorSet(hash, descriptor_cache);
+                m_descriptor_sets_free.emplace_back(move(it->second));
+                it = m_descriptor_sets.erase(it);
             }
             else
             {
-                return false;
+                it++;
             }
         }
-        else // retrieve the existing one
+    }
+
+    void* RHI_DescriptorSetLayout::CreateDescriptorSet(RHI_DescriptorCache* descriptor_cache)
+    {
+        void* descriptor_set = nullptr;
+
+        // Rewrite a retired descriptor set, unless it might still be used by a frame in flight (only happens after a hash collision)
+        if (!m_descriptor_sets_free.empty() && m_descriptor_sets_free.back().frame_used + m_rhi_device->GetFramesInFlight() < m_rhi_device->GetFrameIndex())
         {
-            if (m_needs_to_bind)
-            {
-                descriptor_set  = m_descriptor_sets[hash];
-                m_needs_to_bind = false;
-            }
+            descriptor_set = m_descriptor_sets_free.back().resource;
+            m_descriptor_sets_free.pop_back();
+        }
+        else
+        {
+            descriptor_set = descriptor_cache->AllocateDescriptorSet(m_descriptor_set_layout, m_name);
         }
 
-        return true;
+        UpdateDescriptorSet(descriptor_set, m_descriptors);
+
+        return descriptor_set;
     }
 
     size_t RHI_DescriptorSetLayout::ComputeDescriptorSetHash(const vector<RHI_Descriptor>& descriptors)
@@ -171,6 +289,7 @@ namespace Spartan
             Utility::Hash::hash_combine(hash, descriptor.offset);
             Utility::Hash::hash_combine(hash, descriptor.range);
             Utility::Hash::hash_combine(hash, descriptor.resource);
+            Utility::Hash::hash_combine(hash, descriptor.resource_id);
             Utility::Hash::hash_combine(hash, static_cast<uint32_t>(descriptor.type));
             Utility::Hash::hash_combine(hash, static_cast<uint32_t>(descriptor.layout));
         }
@@ -37,20 +37,40 @@ namespace Spartan
         RHI_DescriptorSetLayout(const RHI_Device* rhi_device, const std::vector<RHI_Descriptor>& descriptors);
         ~RHI_DescriptorSetLayout();
 
-        void SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer);
+        void SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_dynamic);
         void SetSampler(const uint32_t slot, RHI_Sampler* sampler);
         void SetTexture(const uint32_t slot, RHI_Texture* texture);
+        void SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer);
 
         bool GetResource_DescriptorSet(RHI_DescriptorCache* descriptor_cache, void*& descriptor_set);
         void* GetResource_DescriptorSetLayout()             const { return m_descriptor_set_layout; }
         const std::vector<uint32_t>& GetDynamicOffsets()    const { return m_constant_buffer_dynamic_offsets; }
-        uint32_t GetDescriptorSetCount()                    const { return static_cast<uint32_t>(m_descriptor_sets.size()); }
 
         void NeedsToBind() { m_needs_to_bind = true; }
 
     private:
+        // What a descriptor set was written with, compared on lookup so that a hash collision can't return the wrong set.
+        // Resources are identified by their resource id as well as their handle, since handle values can be reused after a deferred release.
+        struct DescriptorContents
+        {
+            void* resource              = nullptr;
+            uint64_t resource_id        = 0;
+            uint64_t offset             = 0;
+            uint64_t range              = 0;
+            RHI_Image_Layout layout     = RHI_Image_Undefined;
+        };
+
+        struct DescriptorSet
+        {
+            void* resource      = nullptr;
+            uint64_t frame_used = 0;
+            std::vector<DescriptorContents> contents;
+        };
+
         std::size_t ComputeDescriptorSetHash(const std::vector<RHI_Descriptor>& descriptors);
-        void* CreateDescriptorSet(const std::size_t hash, const RHI_DescriptorCache* descriptor_cache);
+        bool IsMatch(const DescriptorSet& descriptor_set) const;
+        void RetireDescriptorSets(const uint64_t frame);
+        void* CreateDescriptorSet(RHI_DescriptorCache* descriptor_cache);
         void UpdateDescriptorSet(void* descriptor_set, const std::vector<RHI_Descriptor>& descriptors);
         void* CreateDescriptorSetLayout(const std::vector<RHI_Descriptor>& descriptors);
 
@@ -61,8 +81,12 @@ namespace Spartan
         // Descriptors
         std::vector<RHI_Descriptor> m_descriptors;
 
-        // Descriptor sets
-        std::unordered_map<std::size_t, void*> m_descriptor_sets;
+        // Descriptor sets, keyed by the hash of their contents and reused across draws and frames.
+        // Sets which haven't been used for a while are retired into a free list and rewritten instead of allocating new ones.
+        static constexpr uint64_t descriptor_set_retire_frames = 120;
+        std::unordered_map<std::size_t, DescriptorSet> m_descriptor_sets;
+        std::vector<DescriptorSet> m_descriptor_sets_free;
+        uint64_t m_frame_retired = 0;
 
         // Descriptor set layout
         void* m_descriptor_set_layout = nullptr;
@@ -99,6 +99,66 @@ namespace Spartan
         return Queue_Wait(RHI_Queue_Graphics) && Queue_Wait(RHI_Queue_Transfer) && Queue_Wait(RHI_Queue_Compute);
 	}
 
+    void RHI_Device::DeferredRelease_Add(function<void()>&& release) const
+    {
+        lock_guard<mutex> lock(m_deferred_release_mutex);
+        m_deferred_releases.push_back({ move(release), m_deferred_release_frame });
+    }
+
+    void RHI_Device::DeferredRelease_Tick()
+    {
+        // Collect what's safe to release, the releases themselves run outside of the lock as they can queue more releases
+        vector<function<void()>> releases;
+        {
+            lock_guard<mutex> lock(m_deferred_release_mutex);
+            m_deferred_release_frame++;
+
+            auto it = remove_if(m_deferred_releases.begin(), m_deferred_releases.end(), [this, &releases](DeferredRelease& deferred_release)
+            {
+                if (m_deferred_release_frame < deferred_release.frame + m_frames_in_flight)
+                    return false;
+
+                releases.emplace_back(move(deferred_release.release));
+                return true;
+            });
+            m_deferred_releases.erase(it, m_deferred_releases.end());
+        }
+
+        for (auto& release : releases)
+        {
+            release();
+        }
+    }
+
+    void RHI_Device::DeferredRelease_Flush()
+    {
+        Queue_WaitAll();
+
+        // Loop as releasing objects can cause more releases to be queued
+        while (true)
+        {
+            vector<DeferredRelease> releases;
+            {
+                lock_guard<mutex> lock(m_deferred_release_mutex);
+                releases.swap(m_deferred_releases);
+            }
+
+            if (releases.empty())
+                break;
+
+            for (auto& deferred_release : releases)
+            {
+                deferred_release.release();
+            }
+        }
+    }
+
+    uint32_t RHI_Device::DeferredRelease_GetPendingCount() const
+    {
+        lock_guard<mutex> lock(m_deferred_release_mutex);
+        return static_cast<uint32_t>(m_deferred_releases.size());
+    }
+
     void* RHI_Device::Queue_Get(const RHI_Queue_Type type) const
     {
         if (type == RHI_Queue_Graphics)
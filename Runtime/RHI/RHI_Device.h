@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <functional>
 #include "RHI_Definition.h"
 #include "RHI_Object.h"
 //=========================
@@ -127,6 +128,23 @@ namespace Spartan
         void* Queue_Get(const RHI_Queue_Type type) const;
         uint32_t Queue_Index(const RHI_Queue_Type type) const;
 
+        // Deferred release - GPU objects which might still be referenced by frames in flight are released once those frames are done.
+        // Tick once per rendered frame.
+        void DeferredRelease_Add(std::function<void()>&& release) const;
+        void DeferredRelease_Tick();
+        void DeferredRelease_Flush();
+        uint32_t DeferredRelease_GetPendingCount() const;
+
+        // Frame tracking, advanced by DeferredRelease_Tick (which happens before any recording for the frame starts)
+        uint64_t GetFrameIndex()        const { return m_deferred_release_frame; }
+        // The number of frames that can be recorded before the oldest one has to complete. The renderer sets it once it created its swap chain,
+        // before creating anything that keeps a copy per frame in flight (e.g. ring buffers), which is sized by it.
+        uint32_t GetFramesInFlight()    const { return m_frames_in_flight; }
+        void SetFramesInFlight(const uint32_t frames_in_flight) { m_frames_in_flight = frames_in_flight; }
+
+        // Uploads
+        RHI_UploadManager* GetUploadManager() const { return m_upload_manager.get(); }
+
         // Misc
 		auto IsInitialized()                const { return m_initialized; }
         RHI_Context* GetContextRhi()	    const { return m_rhi_context.get(); }
@@ -142,6 +160,22 @@ namespace Spartan
         bool m_initialized                          = false;
         Context* m_context                          = nullptr;
         mutable std::mutex m_queue_mutex;
+
+        // Deferred release
+        struct DeferredRelease
+        {
+            std::function<void()> release;
+            uint64_t frame = 0;
+        };
+        mutable std::vector<DeferredRelease> m_deferred_releases;
+        mutable std::mutex m_deferred_release_mutex;
+        uint64_t m_deferred_release_frame   = 0;
+        uint32_t m_frames_in_flight         = 3;
+
+        // Pipeline cache, persisted across runs (only used by APIs which expose one)
+        std::string m_pipeline_cache_file_path;
+
+        std::shared_ptr<RHI_UploadManager> m_upload_manager;
         std::shared_ptr<RHI_Context> m_rhi_context;
 	};
 }
@@ -281,6 +281,7 @@ static const VkDescriptorType vulkan_descriptor_type[] =
 	VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
 	VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
     VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
     VK_DESCRIPTOR_TYPE_MAX_ENUM
 };
 
@@ -314,6 +315,7 @@ namespace Spartan
             ID3D11Device* device                    = nullptr;
             ID3D11DeviceContext* device_context     = nullptr;
             ID3DUserDefinedAnnotation* annotation   = nullptr;
+            bool map_no_overwrite_dynamic_srv       = false; // D3D11_FEATURE_DATA_D3D11_OPTIONS::MapNoOverwriteOnDynamicBufferSRV
         #endif
 
         #if defined(API_GRAPHICS_VULKAN)
@@ -324,6 +326,7 @@ namespace Spartan
             VkPhysicalDeviceFeatures device_features        = {};
             VkFormat surface_format                         = VK_FORMAT_UNDEFINED;
             VkColorSpaceKHR surface_color_space             = VK_COLOR_SPACE_MAX_ENUM_KHR;
+            VkPipelineCache pipeline_cache                  = nullptr;
 
             // Extensions
             #ifdef DEBUG
@@ -375,6 +378,7 @@ namespace Spartan
         static const uint32_t descriptor_max_constant_buffers_dynamic   = 10;
         static const uint32_t descriptor_max_samplers                   = 10;
         static const uint32_t descriptor_max_textures                   = 10;
+        static const uint32_t descriptor_max_structured_buffers         = 10;
 
         // Device limits
         uint32_t max_texture_dimension_2d   = 16384;
@@ -74,6 +74,10 @@ namespace Spartan
 		bool Is16Bit()			    const { return sizeof(uint16_t) == m_stride; }
         bool Is32Bit()			    const { return sizeof(uint32_t) == m_stride; }
 
+        // Upload - Buffers with data are uploaded asynchronously, draws which use them are skipped until they are resident
+        uint64_t GetUploadToken() const { return m_upload_token; }
+        bool IsResident() const;
+
 	protected:
 		bool _Create(const void* indices);
 
@@ -85,5 +89,6 @@ namespace Spartan
 		void* m_buffer			= nullptr;
 		void* m_buffer_memory	= nullptr;
         bool m_mappable         = false;
+        uint64_t m_upload_token = 0;
 	};
 }
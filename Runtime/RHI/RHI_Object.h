@@ -30,12 +30,19 @@ namespace Spartan
     class SPARTAN_CLASS RHI_Object : public Spartan_Object
     {
     public:
-        RHI_Object()    = default;
+        RHI_Object();
         ~RHI_Object()   = default;
 
         const uint64_t GetSizeGpu() const { return m_size_gpu; }
 
+        // Unique across all objects and changes whenever the object's GPU resource is (re)created. Unlike a handle
+        // value, which the driver is free to hand out again once the resource is destroyed, it's never reused.
+        uint64_t GetResourceId() const { return m_resource_id; }
+
     protected:
-        uint64_t m_size_gpu = 0;
+        void ResourceIdUpdate();
+
+        uint64_t m_size_gpu     = 0;
+        uint64_t m_resource_id  = 0;
     };
 }
@@ -19,16 +19,26 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ======================
+//= INCLUDES =======================
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <thread>
 #include "RHI_Shader.h"
+#include "RHI_Device.h"
 #include "RHI_InputLayout.h"
 #include "../Core/Context.h"
+#include "../Core/Stopwatch.h"
 #include "../Threading/Threading.h"
 #include "../Core/FileSystem.h"
+#include "../IO/FileStream.h"
+#include "../Resource/ResourceCache.h"
+#include "../Utilities/Hash.h"
 #pragma warning(push, 0) // Hide warnings belonging SPIRV-Cross 
 #include <spirv_hlsl.hpp>
 #pragma warning(pop)
-//=================================
+//==================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -40,6 +50,19 @@ namespace Spartan
 	{
 		m_rhi_device	= rhi_device;
 		m_input_layout	= make_shared<RHI_InputLayout>(rhi_device);
+
+        // Bytecode cache directory
+        if (m_rhi_device && m_rhi_device->GetContext())
+        {
+            if (ResourceCache* resource_cache = m_rhi_device->GetContext()->GetSubsystem<ResourceCache>())
+            {
+                m_cache_directory = resource_cache->GetDataDirectory(Asset_Cache) + "/shaders/";
+                if (!FileSystem::Exists(m_cache_directory))
+                {
+                    FileSystem::CreateDirectory_(m_cache_directory);
+                }
+            }
+        }
 	}
 
 	template <typename T>
@@ -64,6 +87,8 @@ namespace Spartan
 		}
 
 		// Compile
+        Stopwatch timer;
+        m_from_cache        = false;
         m_compilation_state = Shader_Compilation_Compiling;
         m_resource          = _Compile(shader);
         m_compilation_state = m_resource ? Shader_Compilation_Succeeded : Shader_Compilation_Failed;
@@ -86,13 +111,14 @@ namespace Spartan
 
             if (m_compilation_state == Shader_Compilation_Succeeded)
             {
+                const char* cached = m_from_cache ? " (cached)" : "";
                 if (defines.empty())
                 {
-                    LOG_INFO("Successfully compiled %s shader from \"%s\"", type_str.c_str(), shader.c_str());
+                    LOG_INFO("Successfully compiled %s shader from \"%s\" in %.2f ms%s", type_str.c_str(), shader.c_str(), timer.GetElapsedTimeMs(), cached);
                 }
                 else
                 {
-                    LOG_INFO("Successfully compiled %s shader from \"%s\" with definitions \"%s\"", type_str.c_str(), shader.c_str(), defines.c_str());
+                    LOG_INFO("Successfully compiled %s shader from \"%s\" with definitions \"%s\" in %.2f ms%s", type_str.c_str(), shader.c_str(), defines.c_str(), timer.GetElapsedTimeMs(), cached);
                 }
             }
             else if (m_compilation_state == Shader_Compilation_Failed)
@@ -110,9 +136,9 @@ namespace Spartan
 	}
 
 	template <typename T>
-	void RHI_Shader::CompileAsync(Context* context, const Shader_Type type, const string& shader)
+	JobHandle RHI_Shader::CompileAsync(Context* context, const Shader_Type type, const string& shader)
 	{
-		context->GetSubsystem<Threading>()->AddTask([this, type, shader]()
+		return context->GetSubsystem<Threading>()->AddTaskBackground([this, type, shader]()
 		{
 			Compile<T>(type, shader);
 		});
@@ -211,14 +237,133 @@ namespace Spartan
                 shader_type                                                     // Stage
             );
 		}
+
+        // Get structured buffers
+        for (const auto& resource : resources.storage_buffers)
+        {
+            m_descriptors.emplace_back
+            (
+                RHI_Descriptor_Type::RHI_Descriptor_StructuredBuffer,           // Type
+                compiler.get_decoration(resource.id, spv::DecorationBinding),   // Slot
+                shader_type                                                     // Stage
+            );
+        }
 	}
 
+    // Bump this whenever the layout of a cache file changes, or when something that affects the bytecode changes but isn't part of the key
+    static const uint32_t cache_magic            = 0x43485053; // "SPHC"
+    static const uint32_t cache_format_version   = 1;
+
+    static string read_file(const string& file_path)
+    {
+        ifstream in(file_path, ios::binary);
+        stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    uint64_t RHI_Shader::Cache_ComputeKey(const string& shader, const string& compiler_signature) const
+    {
+        using namespace Utility::Hash;
+
+        uint64_t key = fnv1a_64(&cache_format_version, sizeof(cache_format_version));
+        key = fnv1a_64(compiler_signature, key);
+        key = fnv1a_64(string(GetEntryPoint()), key);
+        key = fnv1a_64(string(GetTargetProfile()), key);
+        key = fnv1a_64(&m_shader_type, sizeof(m_shader_type), key);
+
+        // Defines (std::map, so the order is deterministic)
+        for (const auto& define : m_defines)
+        {
+            key = fnv1a_64(define.first, key);
+            key = fnv1a_64(define.second, key);
+        }
+
+        // Source, the contents of every included file are part of the key, so that editing any of them invalidates the entry
+        if (FileSystem::IsFile(shader))
+        {
+            key = fnv1a_64(read_file(shader), key);
+            for (const string& include : FileSystem::GetIncludedFiles(shader))
+            {
+                key = fnv1a_64(include, key);
+                key = fnv1a_64(read_file(include), key);
+            }
+        }
+        else
+        {
+            key = fnv1a_64(shader, key);
+        }
+
+        return key;
+    }
+
+    string RHI_Shader::Cache_GetFilePath(const uint64_t key) const
+    {
+        const string name = m_file_path.empty() ? "source" : FileSystem::GetFileNameNoExtensionFromFilePath(m_file_path);
+
+        stringstream stream;
+        stream << m_cache_directory << name << "_" << hex << setw(16) << setfill('0') << key << ".bytecode";
+        return stream.str();
+    }
+
+    bool RHI_Shader::Cache_Load(const uint64_t key, vector<unsigned char>& bytecode) const
+    {
+        if (m_cache_directory.empty())
+            return false;
+
+        const string file_path = Cache_GetFilePath(key);
+        if (!FileSystem::Exists(file_path))
+            return false;
+
+        FileStream stream(file_path, FileStream_Read);
+        if (!stream.IsOpen())
+            return false;
+
+        // Header
+        if (stream.ReadAs<uint32_t>() != cache_magic || stream.ReadAs<uint32_t>() != cache_format_version || stream.ReadAs<uint64_t>() != key)
+            return false;
+
+        // Bytecode, the checksum catches truncated or partially written files
+        const uint64_t checksum = stream.ReadAs<uint64_t>();
+        stream.Read(&bytecode);
+
+        return !bytecode.empty() && Utility::Hash::fnv1a_64(bytecode.data(), bytecode.size()) == checksum;
+    }
+
+    void RHI_Shader::Cache_Save(const uint64_t key, const vector<unsigned char>& bytecode) const
+    {
+        if (m_cache_directory.empty() || bytecode.empty())
+            return;
+
+        // Write to a temporary file and then move it in place, so that a reader never sees a partially written file
+        const string file_path      = Cache_GetFilePath(key);
+        const string file_path_temp = file_path + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+        {
+            FileStream stream(file_path_temp, FileStream_Write);
+            if (!stream.IsOpen())
+                return;
+
+            stream.Write(cache_magic);
+            stream.Write(cache_format_version);
+            stream.Write(key);
+            stream.Write(Utility::Hash::fnv1a_64(bytecode.data(), bytecode.size()));
+            stream.Write(bytecode);
+        }
+
+        std::remove(file_path.c_str());
+        if (std::rename(file_path_temp.c_str(), file_path.c_str()) != 0)
+        {
+            LOG_WARNING("Failed to write shader cache entry \"%s\"", file_path.c_str());
+            std::remove(file_path_temp.c_str());
+        }
+    }
+
     //= Explicit template instantiation =============================================================================
-    template void RHI_Shader::CompileAsync<RHI_Vertex_Undefined>(Context*, const Shader_Type, const std::string&);
-    template void RHI_Shader::CompileAsync<RHI_Vertex_Pos>(Context*, const Shader_Type, const std::string&);
-    template void RHI_Shader::CompileAsync<RHI_Vertex_PosTex>(Context*, const Shader_Type, const std::string&);
-    template void RHI_Shader::CompileAsync<RHI_Vertex_PosCol>(Context*, const Shader_Type, const std::string&);
-    template void RHI_Shader::CompileAsync<RHI_Vertex_Pos2dTexCol8>(Context*, const Shader_Type, const std::string&);
-    template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTan>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_Undefined>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_Pos>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_PosTex>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_PosCol>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_Pos2dTexCol8>(Context*, const Shader_Type, const std::string&);
+    template JobHandle RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTan>(Context*, const Shader_Type, const std::string&);
     //===============================================================================================================
 }
@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Vertex.h"
 #include "RHI_Object.h"
 #include "RHI_Definition.h"
+#include "../Threading/Threading.h"
 //=========================
 
 namespace Spartan
@@ -51,17 +52,18 @@ namespace Spartan
             Compile<RHI_Vertex_Undefined>(type, shader);
         }
 
-        // Asynchronous compilation
+        // Asynchronous compilation, the returned job can be waited on with Threading::Wait()
         template<typename T>
-        void CompileAsync(Context* context, const Shader_Type type, const std::string& shader);
-        void CompileAsync(Context* context, const Shader_Type type, const std::string& shader)
+        JobHandle CompileAsync(Context* context, const Shader_Type type, const std::string& shader);
+        JobHandle CompileAsync(Context* context, const Shader_Type type, const std::string& shader)
         {
-            CompileAsync<RHI_Vertex_Undefined>(context, type, shader);
+            return CompileAsync<RHI_Vertex_Undefined>(context, type, shader);
         }
 
 		// Properties
         void* GetResource()             const										{ return m_resource; }
 		bool HasResource()              const										{ return m_resource != nullptr; }
+        bool IsFromCache()              const                                       { return m_from_cache; }
 		const auto& GetDescriptors()    const										{ return m_descriptors; }
 		const auto& GetInputLayout()    const										{ return m_input_layout; } // only valid for vertex shader
 		auto GetCompilationState()      const										{ return m_compilation_state; }
@@ -84,6 +86,12 @@ namespace Spartan
 		void* _Compile(const std::string& shader);
 		void _Reflect(const Shader_Type shader_type, const uint32_t* ptr, uint32_t size);
 
+        // Bytecode cache, keyed by source content (including includes), defines, entry point, profile and compiler signature
+        uint64_t Cache_ComputeKey(const std::string& shader, const std::string& compiler_signature) const;
+        bool Cache_Load(const uint64_t key, std::vector<unsigned char>& bytecode) const;
+        void Cache_Save(const uint64_t key, const std::vector<unsigned char>& bytecode) const;
+        std::string Cache_GetFilePath(const uint64_t key) const;
+
 		std::string m_name;
 		std::string m_file_path;
 		std::map<std::string, std::string> m_defines;
@@ -92,6 +100,8 @@ namespace Spartan
 		Shader_Compilation_State m_compilation_state    = Shader_Compilation_Unknown;
         Shader_Type m_shader_type                       = Shader_Unknown;
         RHI_Vertex_Type m_vertex_type                   = RHI_Vertex_Type_Unknown;
+        std::string m_cache_directory;
+        bool m_from_cache                               = false;
 
 		// API 
 		void* m_resource = nullptr;
@@ -0,0 +1,69 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =====================
+#include <limits>
+#include "RHI_StructuredBuffer.h"
+#include "RHI_Device.h"
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    RHI_StructuredBuffer::RHI_StructuredBuffer(const shared_ptr<RHI_Device>& rhi_device)
+    {
+        m_rhi_device        = rhi_device;
+        m_ring_frame_count  = rhi_device->GetFramesInFlight();
+    }
+
+    void RHI_StructuredBuffer::ResetRing(const uint64_t frame)
+    {
+        m_ring_frame    = frame;
+        m_ring_cursor   = 0;
+        m_mapped        = false;
+    }
+
+    uint32_t RHI_StructuredBuffer::AllocateRange(const uint32_t count)
+    {
+        // Out of elements for this frame, grow (the allocations made so far live on in the retired buffer)
+        if (m_ring_cursor + count > m_element_count)
+        {
+            while (count > m_element_count)
+            {
+                m_element_count *= 2;
+            }
+            m_element_count *= 2;
+
+            if (!_Create())
+                return numeric_limits<uint32_t>::max();
+
+            m_ring_cursor = 0;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(m_ring_frame % m_ring_frame_count) * m_element_count + m_ring_cursor;
+        m_ring_cursor += count;
+
+        return index;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==========
+#include <memory>
+#include "RHI_Object.h"
+//=====================
+
+namespace Spartan
+{
+    // A read-only buffer of structures which shaders index freely (e.g. per instance data).
+    // It's written by the CPU every frame, so like dynamic constant buffers, it has one region per frame in flight.
+    class SPARTAN_CLASS RHI_StructuredBuffer : public RHI_Object
+    {
+    public:
+        RHI_StructuredBuffer(const std::shared_ptr<RHI_Device>& rhi_device);
+        ~RHI_StructuredBuffer();
+
+        template<typename T>
+        bool Create(const uint32_t element_count)
+        {
+            m_stride        = static_cast<uint32_t>(sizeof(T));
+            m_element_count = element_count;
+
+            return _Create();
+        }
+
+        // Elements are addressed with the indices returned by AllocateRange()
+        void* Map(const uint32_t index = 0) const;
+        bool Unmap() const;
+
+        // Ring allocation - Reserves count consecutive elements of the current frame's region and returns the index of the first one.
+        // Running out of elements grows the buffer without waiting for the GPU, so the resource has to be bound after allocating.
+        void ResetRing(const uint64_t frame);
+        uint32_t AllocateRange(const uint32_t count);
+        // One region per frame in flight, as many as the device had when the buffer was constructed
+        uint32_t GetRingFrameCount() const { return m_ring_frame_count; }
+
+        void* GetResource()         const { return m_resource; }
+        uint32_t GetStride()        const { return m_stride; }
+        uint32_t GetElementCount()  const { return m_element_count; }
+        uint64_t GetSize()          const { return static_cast<uint64_t>(m_stride) * m_element_count * m_ring_frame_count; }
+
+    private:
+        bool _Create();
+
+        uint32_t m_stride           = 0;
+        uint32_t m_element_count    = 0;
+
+        // Ring allocation
+        uint32_t m_ring_frame_count = 0;
+        uint64_t m_ring_frame   = 0;
+        uint32_t m_ring_cursor  = 0;
+        mutable bool m_mapped   = false; // since the ring was reset or the buffer was created, D3D11 discards on the first map
+
+        // API
+        void* m_resource        = nullptr; // Vulkan: buffer, D3D11: shader resource view
+        void* m_buffer          = nullptr;
+        void* m_buffer_memory   = nullptr;
+        void* m_buffer_mapped   = nullptr;
+
+        // Dependencies
+        std::shared_ptr<RHI_Device> m_rhi_device;
+    };
+}
@@ -22,7 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ================================
 #include "RHI_Texture.h"
 #include "RHI_Device.h"
+#include "RHI_UploadManager.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetContainer.h"
 #include "../Rendering/Renderer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ImageImporter.h"
@@ -34,6 +36,27 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace
+    {
+        // Chunks of an engine texture file
+        constexpr uint32_t chunk_header = asset_chunk_type('T', 'X', 'H', 'D');
+        constexpr uint32_t chunk_path   = asset_chunk_type('P', 'A', 'T', 'H');
+        constexpr uint32_t chunk_mip    = asset_chunk_type('M', 'I', 'P', ' '); // one per mip, indexed by mip level
+
+        struct TextureHeader
+        {
+            uint32_t bpp;
+            uint32_t width;
+            uint32_t height;
+            uint32_t format;
+            uint32_t channels;
+            uint32_t mip_count;
+            uint32_t id;
+            uint16_t flags;
+            uint16_t padding;
+        };
+    }
+
 	RHI_Texture::RHI_Texture(Context* context) : IResource(context, Resource_Texture)
 	{
 		m_rhi_device = context->GetSubsystem<Renderer>()->GetRhiDevice();
@@ -45,67 +68,75 @@ namespace Spartan
 		m_data.shrink_to_fit();
 	}
 
+    bool RHI_Texture::IsResident() const
+    {
+        // Token 0 means nothing was uploaded, a failed upload (token_invalid) never completes
+        return m_rhi_device->GetUploadManager()->IsComplete(m_upload_token);
+    }
+
 	bool RHI_Texture::SaveToFile(const string& file_path)
 	{
-		// Check to see if the file already exists (if so, get the byte count)
-		uint32_t byte_count = 0;
-		{
-			if (FileSystem::Exists(file_path))
-			{
-				auto file = make_unique<FileStream>(file_path, FileStream_Read);
-				if (file->IsOpen())
-				{
-					file->Read(&byte_count);
-				}
-			}
-		}
+        TextureHeader header    = {};
+        header.bpp              = m_bpp;
+        header.width            = m_width;
+        header.height           = m_height;
+        header.format           = static_cast<uint32_t>(m_format);
+        header.channels         = m_channels;
+        header.mip_count        = static_cast<uint32_t>(m_data.size());
+        header.id               = GetId();
+        header.flags            = m_flags;
+
+        // If we hold no data but the file already has some, keep it (it's copied out, the mapping can't outlive the file being replaced)
+        if (m_data.empty() && FileSystem::Exists(file_path))
+        {
+            AssetContainer existing;
+            if (existing.Open(file_path))
+            {
+                // Nothing to do if the file already describes this texture (e.g. the texture was just loaded from it)
+                header.mip_count                        = existing.GetChunkCount(chunk_mip);
+                const TextureHeader* existing_header    = existing.GetChunk<TextureHeader>(chunk_header);
+                if (existing_header && memcmp(existing_header, &header, sizeof(header)) == 0 && existing.GetChunkString(chunk_path) == GetResourceFilePath())
+                    return true;
 
-		auto append = true;
-		auto file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Append);
-		if (!file->IsOpen())
-			return false;
+                for (uint32_t i = 0; i < header.mip_count; i++)
+                {
+                    uint64_t size           = 0;
+                    const std::byte* data   = existing.GetChunk(chunk_mip, i, &size);
+                    m_data.emplace_back(data, data + size);
+                }
+            }
+            else
+            {
+                auto file = make_unique<FileStream>(file_path, FileStream_Read);
+                if (file->IsOpen())
+                {
+                    file->ReadAs<uint32_t>(); // byte count
+                    m_data.resize(file->ReadAs<uint32_t>());
+                    for (auto& mip : m_data)
+                    {
+                        file->Read(&mip);
+                    }
+                }
+            }
 
-		// If the existing file has a byte count but we 
-		// hold no data, don't overwrite the file's bytes.
-		if (byte_count != 0 && m_data.empty())
-		{
-			file->Skip
-			(
-				sizeof(uint32_t) +	// byte count
-				sizeof(uint32_t) +	// mipmap count
-				byte_count			// bytes
-			);
-		}
-		else
-		{
-			byte_count = GetByteCount();
-
-			// Write byte count
-			file->Write(byte_count);
-			// Write mipmap count
-			file->Write(static_cast<uint32_t>(m_data.size()));
-			// Write bytes
-			for (auto& mip : m_data)
-			{
-				file->Write(mip);
-			}
-
-			// The bytes have been saved, so we can now free some memory
-			m_data.clear();
-			m_data.shrink_to_fit();
-		}
+            header.mip_count = static_cast<uint32_t>(m_data.size());
+        }
+
+        AssetContainerWriter writer;
+        writer.AddChunk(chunk_header, 0, &header, sizeof(header));
+        writer.AddChunk(chunk_path, 0, GetResourceFilePath());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_data.size()); i++)
+        {
+            writer.AddChunk(chunk_mip, i, m_data[i]);
+        }
 
-		// Write properties
-		file->Write(m_bpp);
-		file->Write(m_width);
-		file->Write(m_height);
-        file->Write(static_cast<uint32_t>(m_format));
-		file->Write(m_channels);
-		file->Write(m_flags);
-		file->Write(GetId());
-		file->Write(GetResourceFilePath());
+        const bool saved = writer.Save(file_path);
 
-		return true;
+        // The bytes have been saved, so we can now free some memory
+        m_data.clear();
+        m_data.shrink_to_fit();
+
+		return saved;
 	}
 
 	bool RHI_Texture::LoadFromFile(const string& path)
@@ -140,17 +171,20 @@ namespace Spartan
 			return false;
 		}
 
-        m_mip_levels = static_cast<uint32_t>(m_data.size());
+        m_mip_levels = static_cast<uint32_t>(GetMipViews().size());
 
 		// Create GPU resource
         if (!m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() || !CreateResourceGpu())
         {
             LOG_ERROR("Failed to create shader resource for \"%s\".", GetResourceFilePathNative().c_str());
+            m_data_container.reset();
             m_load_state = LoadState_Failed;
             return false;
         }
 
 		// Only clear texture bytes if that's an engine texture, if not, it's not serialized yet.
+		// The GPU resource has copied the mips by now, so the file can be unmapped as well.
+        m_data_container.reset();
 		if (FileSystem::IsEngineTextureFile(path))
 		{
 			m_data.clear();
@@ -186,44 +220,54 @@ namespace Spartan
 		return &m_data[index];
 	}
 
-    vector<std::byte> RHI_Texture::GetMipmap(const uint32_t index)
+    vector<RHI_Texture_Mip> RHI_Texture::GetMipViews() const
     {
-        vector<std::byte> data;
+        vector<RHI_Texture_Mip> mips;
 
-        // Use existing data, if it's there
-        if (index < m_data.size())
+        if (m_data_container)
         {
-            data = m_data[index];
+            const uint32_t mip_count = m_data_container->GetChunkCount(chunk_mip);
+            mips.resize(mip_count);
+            for (uint32_t i = 0; i < mip_count; i++)
+            {
+                mips[i].data = m_data_container->GetChunk(chunk_mip, i, &mips[i].size);
+            }
         }
-        // Else attempt to load the data
         else
         {
-            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
-            if (file->IsOpen())
+            mips.reserve(m_data.size());
+            for (const auto& mip : m_data)
             {
-                auto byte_count = file->ReadAs<uint32_t>();
-                const auto mip_count  = file->ReadAs<uint32_t>();
-
-                if (index < mip_count)
-                {
-                    for (uint32_t i = 0; i <= index; i++)
-                    {
-                        file->Read(&data);
-                    }
-                }
-                else
-                {
-                    LOG_ERROR("Invalid index");
-                }
-                file->Close();
-            }
-            else
-            {
-                LOG_ERROR("Unable to retreive data");
+                mips.push_back({ mip.data(), mip.size() });
             }
         }
 
-        return data;
+        return mips;
+    }
+
+    vector<std::byte> RHI_Texture::GetMipmap(const uint32_t index)
+    {
+        // Use existing data, if it's there
+        if (index < m_data.size())
+            return m_data[index];
+
+        // Else map the file and copy just the requested mip
+        AssetContainer container;
+        if (!container.Open(GetResourceFilePathNative()))
+        {
+            LOG_ERROR("Unable to retreive data");
+            return vector<std::byte>();
+        }
+
+        uint64_t size       = 0;
+        const std::byte* data    = container.GetChunk(chunk_mip, index, &size);
+        if (!data)
+        {
+            LOG_ERROR("Invalid index");
+            return vector<std::byte>();
+        }
+
+        return vector<std::byte>(data, data + size);
     }
 
     bool RHI_Texture::LoadFromFile_ForeignFormat(const string& file_path, const bool generate_mipmaps)
@@ -240,6 +284,40 @@ namespace Spartan
 	}
 
 	bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path)
+	{
+        // Textures saved before the container format existed are still readable
+        if (!AssetContainer::IsContainer(file_path))
+            return LoadFromFile_NativeFormatLegacy(file_path);
+
+        auto container = make_shared<AssetContainer>();
+        if (!container->Open(file_path))
+            return false;
+
+        const TextureHeader* header = container->GetChunk<TextureHeader>(chunk_header);
+        if (!header || container->GetChunkCount(chunk_mip) != header->mip_count)
+        {
+            LOG_ERROR("\"%s\" is missing chunks", file_path.c_str());
+            return false;
+        }
+
+		m_data.clear();
+		m_data.shrink_to_fit();
+
+        // Properties are read in place, the mips stay in the mapping until the GPU resource is created
+        m_bpp       = header->bpp;
+        m_width     = header->width;
+        m_height    = header->height;
+        m_format    = static_cast<RHI_Format>(header->format);
+        m_channels  = header->channels;
+        m_flags     = header->flags;
+        SetId(header->id);
+        SetResourceFilePath(container->GetChunkString(chunk_path));
+        m_data_container = container;
+
+		return true;
+	}
+
+    bool RHI_Texture::LoadFromFile_NativeFormatLegacy(const string& file_path)
 	{
 		auto file = make_unique<FileStream>(file_path, FileStream_Read);
 		if (!file->IsOpen())
@@ -293,16 +371,4 @@ namespace Spartan
 			default:						        return 0;
 		}
 	}
-
-	uint32_t RHI_Texture::GetByteCount()
-	{
-		uint32_t byte_count = 0;
-
-		for (auto& mip : m_data)
-		{
-			byte_count += static_cast<uint32_t>(mip.size());
-		}
-
-		return byte_count;
-	}
 }
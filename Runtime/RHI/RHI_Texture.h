@@ -31,6 +31,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class AssetContainer;
+
 	enum RHI_Texture_Flags : uint16_t
 	{
 		RHI_Texture_ShaderView			        = 1 << 0,
@@ -43,6 +45,13 @@ namespace Spartan
         RHI_Texture_GenerateMipsWhenLoading     = 1 << 7
 	};
 
+    // A mip's bytes, either owned by the texture or mapped from its file while it's being loaded
+    struct RHI_Texture_Mip
+    {
+        const std::byte* data   = nullptr;
+        uint64_t size           = 0;
+    };
+
     enum RHI_Shader_View_Type : uint8_t
     {
         RHI_Shader_View_ColorDepth,
@@ -90,6 +99,8 @@ namespace Spartan
         void SetData(const std::vector<std::vector<std::byte>>& data)   { m_data = data; }
         auto AddMipmap()                                                { return &m_data.emplace_back(std::vector<std::byte>()); }
         bool HasMipmaps() const                                         { return !m_data.empty();  }
+        bool HasData() const                                            { return !m_data.empty() || m_data_container; }
+        std::vector<RHI_Texture_Mip> GetMipViews() const;
         uint32_t GetMiplevels() const                                   { return m_mip_levels; }
         std::vector<std::byte>* GetData(uint32_t mipmap_index);
         std::vector<std::byte> GetMipmap(uint32_t index);
@@ -110,6 +121,10 @@ namespace Spartan
         void SetLayout(const RHI_Image_Layout layout, RHI_CommandList* command_list = nullptr);
         RHI_Image_Layout GetLayout() const { return m_layout; }
 
+        // Upload - Textures with data are uploaded asynchronously, they can't be bound until they are resident
+        uint64_t GetUploadToken() const { return m_upload_token; }
+        bool IsResident() const;
+
         // Misc
         auto GetArraySize()         const { return m_array_size; }
         const auto& GetViewport()   const { return m_viewport; }
@@ -124,6 +139,7 @@ namespace Spartan
 
 	protected:
 		bool LoadFromFile_NativeFormat(const std::string& file_path);
+        bool LoadFromFile_NativeFormatLegacy(const std::string& file_path);
 		bool LoadFromFile_ForeignFormat(const std::string& file_path, bool generate_mipmaps);
 		static uint32_t GetChannelCountFromFormat(RHI_Format format);
         virtual bool CreateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
@@ -140,7 +156,9 @@ namespace Spartan
         uint16_t m_flags	                    = 0;
 		RHI_Viewport m_viewport;
 		std::vector<std::vector<std::byte>> m_data;
+        std::shared_ptr<AssetContainer> m_data_container; // mapped mips of an engine texture, only held while the GPU resource is created
 		std::shared_ptr<RHI_Device> m_rhi_device;
+        uint64_t m_upload_token = 0;
 
         // API
         void* m_view_texture[2]         = { nullptr, nullptr }; // color/depth, stencil
@@ -150,7 +168,5 @@ namespace Spartan
         std::vector<void*> m_view_attachment_color;
         std::vector<void*> m_view_attachment_depth_stencil;
         std::vector<void*> m_view_attachment_depth_stencil_read_only;
-	private:
-		uint32_t GetByteCount();
 	};
 }
@@ -0,0 +1,112 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==============
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <functional>
+#include "RHI_Object.h"
+#include "RHI_Definition.h"
+//=========================
+
+namespace Spartan
+{
+    // Records texture and buffer uploads from any thread into a shared command buffer (batch), which is submitted to the
+    // transfer queue once per frame. Data goes through a persistently mapped staging ring, so uploads don't allocate.
+    // Every upload returns a token, loaders can poll it (or release resources after it) without blocking on the GPU.
+    // Token 0 means there was nothing to upload and is always complete, token_invalid means the upload failed and never completes.
+    class SPARTAN_CLASS RHI_UploadManager : public RHI_Object
+    {
+    public:
+        RHI_UploadManager(RHI_Device* rhi_device);
+        ~RHI_UploadManager();
+
+        // Uploads all the mips of a texture and transitions it to a shader read only layout
+        uint64_t UploadTexture(RHI_Texture* texture);
+        // Copies data into the beginning of a buffer
+        uint64_t UploadBuffer(void* buffer, const void* data, const uint64_t size);
+
+        // Submits the open batch and retires the completed ones, called once per frame
+        void Tick();
+
+        // Tokens
+        static const uint64_t token_invalid = std::numeric_limits<uint64_t>::max();
+        bool IsComplete(const uint64_t token) const { return token <= m_token_completed; }
+        bool Wait(const uint64_t token);
+        // Runs the release through the device's deferred release once the token has completed (right away for a failed upload)
+        void ReleaseAfter(const uint64_t token, std::function<void()>&& release);
+
+        // Stats
+        uint64_t GetStagingSize() const { return staging_ring_size; }
+        uint64_t GetStagingUsed() const { return m_ring_head - m_ring_tail; }
+        uint32_t GetBatchesInFlight() const { return static_cast<uint32_t>(m_batches_in_flight.size()); }
+
+        static const uint64_t staging_ring_size = 64 * 1024 * 1024;
+
+    private:
+        struct Batch
+        {
+            void* cmd_buffer    = nullptr;
+            void* fence         = nullptr;
+            uint64_t token      = 0;
+            uint64_t ring_end   = 0;
+            bool recording      = false;
+            uint32_t waiters    = 0; // threads waiting on the fence outside of the lock, the batch isn't recycled until they are done
+            std::vector<std::pair<void*, void*>> staging_dedicated; // staging buffers (and memory) of uploads that didn't fit the ring
+        };
+
+        // All of these expect m_mutex to be locked
+        bool BatchBegin();
+        bool BatchSubmit();
+        void BatchesRetire(const bool wait);
+        void BatchRecycle(Batch& batch);
+        bool StagingAllocate(const uint64_t size, const uint64_t alignment, void*& buffer, uint64_t& offset, uint8_t*& mapped);
+
+        // Batches
+        Batch m_batch_open;
+        std::deque<Batch> m_batches_in_flight;
+        std::vector<Batch> m_batches_free;
+        std::vector<Batch> m_batches_waited; // retired while they still had waiters
+        void* m_cmd_pool = nullptr;
+
+        // Staging ring, head and tail keep increasing, the physical offset is their remainder
+        void* m_staging_buffer          = nullptr;
+        void* m_staging_buffer_memory   = nullptr;
+        uint8_t* m_staging_mapped       = nullptr;
+        uint64_t m_ring_head            = 0;
+        uint64_t m_ring_tail            = 0;
+
+        // Tokens
+        uint64_t m_token_next                   = 1;
+        std::atomic<uint64_t> m_token_completed = 0;
+        std::vector<std::pair<uint64_t, std::function<void()>>> m_releases;
+
+        std::mutex m_mutex;
+
+        // Dependencies
+        RHI_Device* m_rhi_device = nullptr;
+    };
+}
@@ -74,6 +74,10 @@ namespace Spartan
         uint32_t GetStride()        const { return m_stride; }
         uint32_t GetVertexCount()   const { return m_vertex_count; }
 
+        // Upload - Buffers with data are uploaded asynchronously, draws which use them are skipped until they are resident
+        uint64_t GetUploadToken() const { return m_upload_token; }
+        bool IsResident() const;
+
 	private:
 		bool _Create(const void* vertices);
 
@@ -85,5 +89,6 @@ namespace Spartan
 		void* m_buffer			= nullptr;
 		void* m_buffer_memory	= nullptr;
         bool m_mappable         = false;
+        uint64_t m_upload_token = 0;
 	};
 }
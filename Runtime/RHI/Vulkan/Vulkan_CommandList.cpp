@@ -35,11 +35,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_IndexBuffer.h"
 #include "../RHI_PipelineState.h"
 #include "../RHI_ConstantBuffer.h"
+#include "../RHI_StructuredBuffer.h"
 #include "../RHI_DescriptorCache.h"
 #include "../RHI_PipelineCache.h"
 #include "../../Profiling/Profiler.h"
 #include "../../Logging/Log.h"
 #include "../../Rendering/Renderer.h"
+#include "../../Threading/Threading.h"
 //===================================
 
 //= NAMESPACES ===============
@@ -59,6 +61,7 @@ namespace Spartan
 		m_rhi_device	    = m_renderer->GetRhiDevice().get();
         m_pipeline_cache    = m_renderer->GetPipelineCache();
         m_descriptor_cache  = m_renderer->GetDescriptorCache();
+        m_threading         = context->GetSubsystem<Threading>();
         m_passes_active.reserve(100);
         m_passes_active.resize(100);
         m_timestamps.reserve(2);
@@ -85,6 +88,24 @@ namespace Spartan
         vulkan_common::fence::create(rhi_context, m_cmd_list_consumed_fence);
 	}
 
+    RHI_CommandList::RHI_CommandList(RHI_CommandList* primary)
+    {
+        m_primary           = primary;
+        m_swap_chain        = primary->m_swap_chain;
+        m_renderer          = primary->m_renderer;
+        m_profiler          = primary->m_profiler;
+        m_rhi_device        = primary->m_rhi_device;
+        m_pipeline_cache    = primary->m_pipeline_cache;
+
+        // Descriptor sets get allocated while recording, so each secondary has its own cache (and pool)
+        m_descriptor_cache_secondary    = make_shared<RHI_DescriptorCache>(m_rhi_device);
+        m_descriptor_cache              = m_descriptor_cache_secondary.get();
+
+        // Command buffer
+        vulkan_common::command_pool::create(m_rhi_device, m_cmd_pool, RHI_Queue_Graphics);
+        vulkan_common::command_buffer::create(m_rhi_device->GetContextRhi(), m_cmd_pool, m_cmd_buffer, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    }
+
 	RHI_CommandList::~RHI_CommandList()
 	{
         RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
@@ -92,6 +113,15 @@ namespace Spartan
 		// Wait in case the buffer is still in use by the graphics queue
         m_rhi_device->Queue_Wait(RHI_Queue_Graphics);
 
+        // Secondary command lists
+        m_cmd_lists_secondary.clear();
+        if (IsSecondary())
+        {
+            vulkan_common::command_buffer::free(rhi_context, m_cmd_pool, m_cmd_buffer);
+            vulkan_common::command_pool::destroy(rhi_context, m_cmd_pool);
+            return;
+        }
+
 		// Fence
         vulkan_common::fence::destroy(rhi_context, m_cmd_list_consumed_fence);
 
@@ -114,7 +144,6 @@ namespace Spartan
         if (m_cmd_state == RHI_Cmd_List_Idle_Sync_Cpu_To_Gpu)
         {
             Flush();
-            m_descriptor_cache->GrowIfNeeded();
             m_cmd_state = RHI_Cmd_List_Idle;
         }
 
@@ -181,12 +210,16 @@ namespace Spartan
             return false;
         }
 
-        // End render pass
+        // End render pass (secondaries record inside the primary's render pass)
         if (m_render_pass_begun_pipeline_bound)
         {
-            vkCmdEndRenderPass(CMD_BUFFER);
+            if (!IsSecondary())
+            {
+                vkCmdEndRenderPass(CMD_BUFFER);
+            }
             m_render_pass_begun_pipeline_bound = false;
         }
+        m_render_pass_secondary_contents = false;
 
         // End marker and profiler
         MarkAndProfileEnd(m_pipeline_state);
@@ -220,6 +253,9 @@ namespace Spartan
             return;
         }
 
+        if (!m_buffer_vertex_resident)
+            return;
+
         // Ensure correct state before attempting to draw
         if (!OnDraw())
             return;
@@ -232,10 +268,10 @@ namespace Spartan
             0               // firstInstance
         );
 
-        m_profiler->m_rhi_draw_calls++;
+        m_metric_draw_calls++;
 	}
 
-	void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
+	void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count)
 	{
         if (m_cmd_state != RHI_Cmd_List_Recording)
         {
@@ -243,6 +279,9 @@ namespace Spartan
             return;
         }
 
+        if (!m_buffer_vertex_resident || !m_buffer_index_resident)
+            return;
+
         // Ensure correct state before attempting to draw
         if (!OnDraw())
             return;
@@ -250,13 +289,13 @@ namespace Spartan
 		vkCmdDrawIndexed(
             CMD_BUFFER,     // commandBuffer
             index_count,    // indexCount
-            1,              // instanceCount
+            instance_count, // instanceCount
             index_offset,   // firstIndex
             vertex_offset,  // vertexOffset
             0               // firstInstance
         );
 
-        m_profiler->m_rhi_draw_calls++;
+        m_metric_draw_calls++;
 	}
 
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z /*= 1*/) const
@@ -318,6 +357,11 @@ namespace Spartan
             return;
         }
 
+        // A buffer that is still uploading can't be bound, the draws which use it are skipped instead
+        m_buffer_vertex_resident = buffer->IsResident();
+        if (!m_buffer_vertex_resident)
+            return;
+
         if (m_set_id_buffer_vertex == buffer->GetId())
             return;
 
@@ -332,7 +376,7 @@ namespace Spartan
             offsets         // pOffsets
         );
 
-        m_profiler->m_rhi_bindings_buffer_vertex++;
+        m_metric_bindings_buffer_vertex++;
         m_set_id_buffer_vertex = buffer->GetId();
 	}
 
@@ -344,6 +388,10 @@ namespace Spartan
             return;
         }
 
+        m_buffer_index_resident = buffer->IsResident();
+        if (!m_buffer_index_resident)
+            return;
+
         if (m_set_id_buffer_pixel == buffer->GetId())
             return;
 
@@ -354,7 +402,7 @@ namespace Spartan
 			buffer->Is16Bit() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 // indexType
 		);
 
-        m_profiler->m_rhi_bindings_buffer_index++;
+        m_metric_bindings_buffer_index++;
         m_set_id_buffer_pixel = buffer->GetId();
 	}
 
@@ -367,7 +415,19 @@ namespace Spartan
         }
 
         // Set (will only happen if it's not already set)
-        m_descriptor_cache->SetConstantBuffer(slot, constant_buffer);
+        m_descriptor_cache->SetConstantBuffer(slot, constant_buffer, constant_buffer->GetOffsetDynamic());
+    }
+
+    void RHI_CommandList::SetConstantBuffer(const uint32_t slot, uint8_t scope, RHI_ConstantBuffer* constant_buffer, const uint32_t offset_index_dynamic) const
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return;
+        }
+
+        // Set (will only happen if it's not already set)
+        m_descriptor_cache->SetConstantBuffer(slot, constant_buffer, offset_index_dynamic * constant_buffer->GetStride());
     }
 
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
@@ -390,8 +450,8 @@ namespace Spartan
             return;
         }
 
-        // Null textures are allowed, and get replaced with a black texture here
-        if (!texture || !texture->Get_View_Texture())
+        // Null textures are allowed, and get replaced with a black texture here (same goes for textures which are still uploading)
+        if (!texture || !texture->Get_View_Texture() || !texture->IsResident())
         {
             texture = m_renderer->GetBlackTexture();
         }
@@ -402,6 +462,19 @@ namespace Spartan
             texture = m_renderer->GetBlackTexture();
         }
 
+        // Secondaries record inside a render pass and on a worker thread, so they can't transition, anything that's not ready to be sampled is replaced with black
+        if (IsSecondary())
+        {
+            const bool needs_transition =
+                (texture->IsColorFormat() && texture->GetLayout() != RHI_Image_Shader_Read_Only_Optimal) ||
+                (texture->IsDepthFormat() && texture->GetLayout() != RHI_Image_Depth_Stencil_Read_Only_Optimal);
+
+            if (needs_transition)
+            {
+                texture = m_renderer->GetBlackTexture();
+            }
+        }
+
         // Transition to appropriate layout (if needed)
         {
             if (texture->IsColorFormat() && texture->GetLayout() != RHI_Image_Shader_Read_Only_Optimal)
@@ -419,6 +492,100 @@ namespace Spartan
         m_descriptor_cache->SetTexture(slot, texture);
     }
 
+    void RHI_CommandList::SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer) const
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return;
+        }
+
+        if (!structured_buffer || !structured_buffer->GetResource())
+            return;
+
+        // Set (will only happen if it's not already set)
+        m_descriptor_cache->SetStructuredBuffer(slot, structured_buffer);
+    }
+
+    bool RHI_CommandList::RecordParallel(const uint32_t draw_count, const function<void(RHI_CommandList*, uint32_t, uint32_t)>& record)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return false;
+        }
+
+        // Secondaries inherit the render pass but not the dynamic state, and they can't be mixed with draws which were recorded inline
+        const bool can_use_secondaries =
+            !IsSecondary()                                  &&
+            m_threading                                     &&
+            m_renderer->GetOption(Render_ParallelRecording) &&
+            !m_render_pass_begun_pipeline_bound             &&
+            m_pipeline_state->viewport.IsDefined()          &&
+            !m_pipeline_state->dynamic_scissor;
+
+        const uint32_t chunk_count = can_use_secondaries ? Math::Min(draw_count / parallel_draws_min, m_threading->GetThreadCount() + 1) : 0;
+
+        // Not worth it, record here
+        if (chunk_count <= 1)
+        {
+            record(this, 0, draw_count);
+            return true;
+        }
+
+        // Created on first use, Begin() waited for the previous submission so they are no longer in use
+        while (m_cmd_lists_secondary.size() < chunk_count)
+        {
+            m_cmd_lists_secondary.emplace_back(shared_ptr<RHI_CommandList>(new RHI_CommandList(this)));
+        }
+
+        // The render pass contents will come from the secondaries
+        BeginRenderPass(true);
+        m_render_pass_begun_pipeline_bound  = true;
+        m_render_pass_secondary_contents    = true;
+
+        // Every chunk is recorded into its own secondary, so executing them in order preserves the draw order
+        const uint32_t draws_per_chunk = (draw_count + chunk_count - 1) / chunk_count;
+        m_threading->ParallelFor([this, &record, draw_count, draws_per_chunk](const uint32_t chunk_start, const uint32_t chunk_end)
+        {
+            for (uint32_t chunk_index = chunk_start; chunk_index < chunk_end; chunk_index++)
+            {
+                RHI_CommandList* cmd_list = m_cmd_lists_secondary[chunk_index].get();
+                if (!cmd_list->BeginSecondary(this))
+                    continue;
+
+                const uint32_t start = chunk_index * draws_per_chunk;
+                record(cmd_list, start, Math::Min(start + draws_per_chunk, draw_count));
+
+                cmd_list->End();
+            }
+        }, chunk_count, 1);
+
+        // Execute
+        vector<VkCommandBuffer> cmd_buffers;
+        cmd_buffers.reserve(chunk_count);
+        for (uint32_t chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+        {
+            RHI_CommandList* cmd_list = m_cmd_lists_secondary[chunk_index].get();
+
+            if (cmd_list->m_cmd_state == RHI_Cmd_List_Ended)
+            {
+                cmd_buffers.emplace_back(static_cast<VkCommandBuffer>(cmd_list->m_cmd_buffer));
+            }
+
+            MetricsMerge(cmd_list);
+            cmd_list->m_cmd_state = RHI_Cmd_List_Idle;
+        }
+
+        if (!cmd_buffers.empty())
+        {
+            vkCmdExecuteCommands(CMD_BUFFER, static_cast<uint32_t>(cmd_buffers.size()), cmd_buffers.data());
+            m_metric_cmd_lists_secondary += static_cast<uint32_t>(cmd_buffers.size());
+        }
+
+        return true;
+    }
+
 	bool RHI_CommandList::Submit()
 	{
         if (m_cmd_state != RHI_Cmd_List_Ended)
@@ -427,6 +594,8 @@ namespace Spartan
             return false;
         }
 
+        MetricsToProfiler();
+
         RHI_PipelineState* state = m_pipeline->GetPipelineState();
 
         if (!m_rhi_device->Queue_Submit(
@@ -485,6 +654,34 @@ namespace Spartan
         return static_cast<uint32_t>(device_memory_budget_properties.heapUsage[0] / 1024 / 1024); // MBs
     }
 
+    uint32_t RHI_CommandList::Gpu_GetMemoryBudget(RHI_Device* rhi_device)
+    {
+        if (!rhi_device || !rhi_device->GetContextRhi() || !vulkan_common::functions::get_physical_device_memory_properties_2)
+            return 0;
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT device_memory_budget_properties = {};
+        device_memory_budget_properties.sType                                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        device_memory_budget_properties.pNext                                     = nullptr;
+
+        VkPhysicalDeviceMemoryProperties2 device_memory_properties = {};
+        device_memory_properties.sType                             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        device_memory_properties.pNext                             = &device_memory_budget_properties;
+
+        vulkan_common::functions::get_physical_device_memory_properties_2(static_cast<VkPhysicalDevice>(rhi_device->GetContextRhi()->device_physical), &device_memory_properties);
+
+        return static_cast<uint32_t>(device_memory_budget_properties.heapBudget[0] / 1024 / 1024); // MBs
+    }
+
+    void RHI_CommandList::Gpu_GetAllocatorStatistics(uint32_t& device_allocations, uint32_t& allocations, uint32_t& memory_reserved, uint32_t& memory_used)
+    {
+        const vulkan_common::memory::allocator::statistics statistics = vulkan_common::memory::allocator::get_statistics();
+
+        device_allocations  = statistics.device_allocations;
+        allocations         = statistics.allocations;
+        memory_reserved     = static_cast<uint32_t>(statistics.bytes_reserved / 1024 / 1024); // MBs
+        memory_used         = static_cast<uint32_t>(statistics.bytes_used / 1024 / 1024);     // MBs
+    }
+
     bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/) const
     {
         if (!m_rhi_device->GetContextRhi()->profiler)
@@ -564,6 +761,105 @@ namespace Spartan
         // Not needed
     }
 
+    bool RHI_CommandList::BeginSecondary(RHI_CommandList* primary)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Idle)
+        {
+            LOG_ERROR("Previous command list is still being used");
+            return false;
+        }
+
+        RHI_Pipeline* pipeline = primary->m_pipeline;
+        if (!pipeline || !pipeline->GetPipeline())
+        {
+            LOG_ERROR("Invalid pipeline");
+            return false;
+        }
+
+        // Continue the primary's render pass
+        VkCommandBufferInheritanceInfo inheritance_info = {};
+        inheritance_info.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass                     = static_cast<VkRenderPass>(pipeline->GetPipelineState()->GetRenderPass());
+        inheritance_info.subpass                        = 0;
+        inheritance_info.framebuffer                    = static_cast<VkFramebuffer>(pipeline->GetPipelineState()->GetFrameBuffer());
+
+        // Begin command buffer
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo         = &inheritance_info;
+        if (!vulkan_common::error::check(vkBeginCommandBuffer(CMD_BUFFER, &begin_info)))
+            return false;
+
+        m_cmd_state         = RHI_Cmd_List_Recording;
+        m_pipeline          = pipeline;
+        m_pipeline_state    = primary->m_pipeline_state;
+
+        // The descriptor set layout is defined identically to the one the pipeline was created with, so the sets are compatible
+        m_descriptor_cache->SetPipelineState(*m_pipeline_state);
+
+        // Nothing but the render pass is inherited, so the pipeline has to be bound here
+        vkCmdBindPipeline(CMD_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, static_cast<VkPipeline>(m_pipeline->GetPipeline()));
+        m_metric_bindings_pipeline++;
+        m_render_pass_begun_pipeline_bound = true;
+
+        // Shader resources
+        m_set_id_buffer_vertex  = 0;
+        m_set_id_buffer_pixel   = 0;
+        m_renderer->SetGlobalSamplersAndConstantBuffers(this);
+
+        return true;
+    }
+
+    void RHI_CommandList::MetricsMerge(RHI_CommandList* cmd_list)
+    {
+        m_metric_draw_calls                 += cmd_list->m_metric_draw_calls;
+        m_metric_bindings_buffer_vertex     += cmd_list->m_metric_bindings_buffer_vertex;
+        m_metric_bindings_buffer_index      += cmd_list->m_metric_bindings_buffer_index;
+        m_metric_bindings_descriptor_set    += cmd_list->m_metric_bindings_descriptor_set;
+        m_metric_bindings_pipeline          += cmd_list->m_metric_bindings_pipeline;
+
+        // The secondary's descriptor cache is only touched by its own recording thread, which has finished by now
+        const RHI_DescriptorCache_Statistics descriptor_statistics = cmd_list->m_descriptor_cache->ConsumeStatistics();
+        m_metric_descriptor_set_hits        += descriptor_statistics.hits;
+        m_metric_descriptor_set_updates     += descriptor_statistics.updates;
+        m_metric_descriptor_set_allocations += descriptor_statistics.allocations;
+
+        cmd_list->m_metric_draw_calls               = 0;
+        cmd_list->m_metric_bindings_buffer_vertex   = 0;
+        cmd_list->m_metric_bindings_buffer_index    = 0;
+        cmd_list->m_metric_bindings_descriptor_set  = 0;
+        cmd_list->m_metric_bindings_pipeline        = 0;
+    }
+
+    void RHI_CommandList::MetricsToProfiler()
+    {
+        if (!m_profiler)
+            return;
+
+        m_profiler->m_rhi_draw_calls                += m_metric_draw_calls;
+        m_profiler->m_rhi_bindings_buffer_vertex    += m_metric_bindings_buffer_vertex;
+        m_profiler->m_rhi_bindings_buffer_index     += m_metric_bindings_buffer_index;
+        m_profiler->m_rhi_bindings_descriptor_set   += m_metric_bindings_descriptor_set;
+        m_profiler->m_rhi_bindings_pipeline         += m_metric_bindings_pipeline;
+        m_profiler->m_rhi_cmd_lists_secondary       += m_metric_cmd_lists_secondary;
+
+        const RHI_DescriptorCache_Statistics descriptor_statistics = m_descriptor_cache->ConsumeStatistics();
+        m_profiler->m_rhi_descriptor_set_hits           += m_metric_descriptor_set_hits        + descriptor_statistics.hits;
+        m_profiler->m_rhi_descriptor_set_updates        += m_metric_descriptor_set_updates     + descriptor_statistics.updates;
+        m_profiler->m_rhi_descriptor_set_allocations    += m_metric_descriptor_set_allocations + descriptor_statistics.allocations;
+
+        m_metric_draw_calls                 = 0;
+        m_metric_bindings_buffer_vertex     = 0;
+        m_metric_bindings_buffer_index      = 0;
+        m_metric_bindings_descriptor_set    = 0;
+        m_metric_bindings_pipeline          = 0;
+        m_metric_cmd_lists_secondary        = 0;
+        m_metric_descriptor_set_hits        = 0;
+        m_metric_descriptor_set_updates     = 0;
+        m_metric_descriptor_set_allocations = 0;
+    }
+
     void RHI_CommandList::MarkAndProfileStart(const RHI_PipelineState* pipeline_state)
     {
         if (!pipeline_state || !pipeline_state->pass_name)
@@ -615,7 +911,7 @@ namespace Spartan
         }
     }
 
-    void RHI_CommandList::BeginRenderPass()
+    void RHI_CommandList::BeginRenderPass(const bool secondary_contents /*= false*/)
     {
         // Clear values
         array<VkClearValue, state_max_render_target_count + 1> clear_values; // +1 for depth-stencil
@@ -652,14 +948,14 @@ namespace Spartan
         render_pass_info.renderArea.extent.height   = m_pipeline->GetPipelineState()->GetHeight();
         render_pass_info.clearValueCount            = clear_value_count;
         render_pass_info.pClearValues               = clear_values.data();
-        vkCmdBeginRenderPass(CMD_BUFFER, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(CMD_BUFFER, &render_pass_info, secondary_contents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
     }
 
     bool RHI_CommandList::BindDescriptorSet()
     {
         // Descriptor set != null, result = true    -> the descriptor set must be bound
         // Descriptor set == null, result = true    -> the descriptor set is already bound
-        // Descriptor set == null, result = false   -> a new descriptor was needed but we are out of memory (allocates next frame)
+        // Descriptor set == null, result = false   -> a new descriptor set was needed but it couldn't be allocated
 
         void* descriptor_set = nullptr;
         bool result = m_descriptor_cache->GetResource_DescriptorSet(descriptor_set);
@@ -684,7 +980,7 @@ namespace Spartan
                 dynamic_offsets                                                 // pDynamicOffsets
             );
 
-            m_profiler->m_rhi_bindings_descriptor_set++;
+            m_metric_bindings_descriptor_set++;
 
             // Upon setting a new descriptor, resources have to be set again.
             // Note: I could optimize this further and see if the descriptor happens to contain them.
@@ -697,6 +993,13 @@ namespace Spartan
 
     bool RHI_CommandList::OnDraw()
     {
+        // The render pass contents come from secondary command lists
+        if (m_render_pass_secondary_contents)
+        {
+            LOG_ERROR("Can't record draws after RecordParallel(), the render pass expects secondary command lists");
+            return false;
+        }
+
         if (!m_render_pass_begun_pipeline_bound)
         {
             // Begin render pass
@@ -706,7 +1009,7 @@ namespace Spartan
             if (VkPipeline vk_pipeline = static_cast<VkPipeline>(m_pipeline->GetPipeline()))
             {
                 vkCmdBindPipeline(CMD_BUFFER, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
-                m_profiler->m_rhi_bindings_pipeline++;
+                m_metric_bindings_pipeline++;
             }
             else
             {
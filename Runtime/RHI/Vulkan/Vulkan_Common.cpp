@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =============
 #include "Vulkan_Common.h"
+#include <algorithm>
 //========================
 
 //= NAMESPACES =====
@@ -45,5 +46,313 @@ namespace Spartan::vulkan_common
     mutex                                                       command_buffer_immediate::m_mutex_begin;
     mutex                                                       command_buffer_immediate::m_mutex_end;
     map<RHI_Queue_Type, command_buffer_immediate::cmdbi_object> command_buffer_immediate::m_objects;
+    map<uint64_t, memory::allocator::pool>                      memory::allocator::m_pools;
+    mutex                                                       memory::allocator::m_mutex;
+    memory::allocator::statistics                               memory::allocator::m_statistics;
+
+    static const uint32_t block_dedicated = numeric_limits<uint32_t>::max();
+
+    static VkDeviceSize align_up(const VkDeviceSize value, const VkDeviceSize alignment)
+    {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    bool memory::allocator::allocate(const RHI_Context* rhi_context, const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags properties, const pool_kind kind, allocation*& allocation_out)
+    {
+        allocation_out = nullptr;
+
+        const uint32_t memory_type = get_type(rhi_context, properties, requirements.memoryTypeBits);
+        if (memory_type == numeric_limits<uint32_t>::max())
+        {
+            LOG_ERROR("Failed to find a suitable memory type");
+            return false;
+        }
+
+        // Host visible allocations are kept apart by nonCoherentAtomSize, so flushing one never touches its neighbours
+        const bool host_visible         = (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+        const VkDeviceSize alignment    = host_visible ? Math::Max<VkDeviceSize>(requirements.alignment, rhi_context->device_properties.limits.nonCoherentAtomSize) : requirements.alignment;
+        const VkDeviceSize size         = host_visible ? align_up(requirements.size, alignment) : requirements.size;
+
+        auto _allocation    = new allocation();
+        _allocation->size   = requirements.size;
+        _allocation->pool   = (static_cast<uint64_t>(memory_type) << 8) | static_cast<uint64_t>(kind);
+
+        lock_guard<mutex> lock(m_mutex);
+
+        // Big resources (e.g. render targets) get their own memory, they would only fragment the blocks
+        if (size > block_size / 2)
+        {
+            void* mapped = nullptr;
+            if (!allocate_device_memory(rhi_context, size, memory_type, _allocation->memory, mapped))
+            {
+                delete _allocation;
+                return false;
+            }
+
+            _allocation->block          = block_dedicated;
+            _allocation->range_size     = size;
+            _allocation->memory_size    = size;
+            _allocation->mapped         = mapped;
+        }
+        else
+        {
+            pool& _pool         = m_pools[_allocation->pool];
+            _pool.memory_type   = memory_type;
+            _pool.kind          = kind;
+            const bool linear   = kind == pool_kind::staging;
+
+            // Try the existing blocks first
+            bool allocated = false;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(_pool.blocks.size()) && !allocated; i++)
+            {
+                if (_pool.blocks[i].memory && allocate_from_block(_pool.blocks[i], linear, size, alignment, *_allocation))
+                {
+                    _allocation->block  = i;
+                    allocated           = true;
+                }
+            }
+
+            // Create a new block, re-using a released slot so block indices stay stable
+            if (!allocated)
+            {
+                uint32_t index = static_cast<uint32_t>(_pool.blocks.size());
+                for (uint32_t i = 0; i < static_cast<uint32_t>(_pool.blocks.size()); i++)
+                {
+                    if (!_pool.blocks[i].memory)
+                    {
+                        index = i;
+                        break;
+                    }
+                }
+                if (index == _pool.blocks.size())
+                {
+                    _pool.blocks.emplace_back();
+                }
+
+                block& _block = _pool.blocks[index];
+                _block = block();
+                if (!allocate_device_memory(rhi_context, block_size, memory_type, _block.memory, _block.mapped))
+                {
+                    delete _allocation;
+                    return false;
+                }
+                _block.size = block_size;
+                if (!linear)
+                {
+                    _block.ranges_free.push_back({ 0, block_size });
+                }
+
+                allocate_from_block(_block, linear, size, alignment, *_allocation);
+                _allocation->block = index;
+            }
+
+            const block& _block         = _pool.blocks[_allocation->block];
+            _allocation->memory         = _block.memory;
+            _allocation->memory_size    = _block.size;
+            _allocation->mapped         = _block.mapped ? static_cast<uint8_t*>(_block.mapped) + _allocation->offset : nullptr;
+        }
+
+        m_statistics.allocations++;
+        m_statistics.bytes_used += _allocation->range_size;
+
+        allocation_out = _allocation;
+        return true;
+    }
+
+    void memory::allocator::free(const RHI_Context* rhi_context, allocation* _allocation)
+    {
+        if (!_allocation)
+            return;
+
+        lock_guard<mutex> lock(m_mutex);
+
+        m_statistics.allocations--;
+        m_statistics.bytes_used -= _allocation->range_size;
+
+        if (_allocation->block == block_dedicated)
+        {
+            void* mapped = _allocation->mapped;
+            free_device_memory(rhi_context, _allocation->memory, mapped, _allocation->memory_size);
+        }
+        else
+        {
+            // The block can already be gone if the allocator was destroyed before the resource
+            pool& _pool = m_pools[_allocation->pool];
+            if (_allocation->block >= _pool.blocks.size() || _pool.blocks[_allocation->block].memory != _allocation->memory)
+            {
+                delete _allocation;
+                return;
+            }
+
+            block& _block = _pool.blocks[_allocation->block];
+            _block.allocation_count--;
+
+            if (_pool.kind == pool_kind::staging)
+            {
+                // Linear blocks rewind once everything that was carved out of them is gone
+                if (_block.allocation_count == 0)
+                {
+                    _block.linear_offset = 0;
+                }
+            }
+            else
+            {
+                // Insert the range back in offset order and coalesce it with its neighbours
+                auto& ranges    = _block.ranges_free;
+                auto it         = lower_bound(ranges.begin(), ranges.end(), _allocation->range_offset, [](const range& r, const VkDeviceSize offset) { return r.offset < offset; });
+                it              = ranges.insert(it, { _allocation->range_offset, _allocation->range_size });
+
+                auto next = it + 1;
+                if (next != ranges.end() && it->offset + it->size == next->offset)
+                {
+                    it->size += next->size;
+                    it = ranges.erase(next) - 1;
+                }
+
+                if (it != ranges.begin())
+                {
+                    auto previous = it - 1;
+                    if (previous->offset + previous->size == it->offset)
+                    {
+                        previous->size += it->size;
+                        ranges.erase(it);
+                    }
+                }
+            }
+        }
+
+        delete _allocation;
+    }
+
+    void memory::allocator::release_empty_blocks(const RHI_Context* rhi_context)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        for (auto& it : m_pools)
+        {
+            for (block& _block : it.second.blocks)
+            {
+                if (_block.memory && _block.allocation_count == 0)
+                {
+                    free_device_memory(rhi_context, _block.memory, _block.mapped, _block.size);
+                    _block = block();
+                }
+            }
+        }
+    }
+
+    void memory::allocator::destroy(const RHI_Context* rhi_context)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        for (auto& it : m_pools)
+        {
+            for (block& _block : it.second.blocks)
+            {
+                if (_block.memory)
+                {
+                    free_device_memory(rhi_context, _block.memory, _block.mapped, _block.size);
+                }
+            }
+        }
+
+        m_pools.clear();
+    }
+
+    memory::allocator::statistics memory::allocator::get_statistics()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    bool memory::allocator::allocate_device_memory(const RHI_Context* rhi_context, const VkDeviceSize size, const uint32_t memory_type, VkDeviceMemory& memory, void*& mapped)
+    {
+        VkMemoryAllocateInfo allocate_info  = {};
+        allocate_info.sType                 = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocate_info.allocationSize        = size;
+        allocate_info.memoryTypeIndex       = memory_type;
+
+        if (!error::check(vkAllocateMemory(rhi_context->device, &allocate_info, nullptr, &memory)))
+            return false;
+
+        // Host visible memory is mapped once, for as long as it lives
+        VkPhysicalDeviceMemoryProperties device_memory_properties;
+        vkGetPhysicalDeviceMemoryProperties(rhi_context->device_physical, &device_memory_properties);
+        mapped = nullptr;
+        if (device_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (!error::check(vkMapMemory(rhi_context->device, memory, 0, VK_WHOLE_SIZE, 0, &mapped)))
+            {
+                vkFreeMemory(rhi_context->device, memory, nullptr);
+                memory = nullptr;
+                return false;
+            }
+        }
+
+        m_statistics.device_allocations++;
+        m_statistics.bytes_reserved += size;
+
+        return true;
+    }
+
+    void memory::allocator::free_device_memory(const RHI_Context* rhi_context, VkDeviceMemory& memory, void*& mapped, const VkDeviceSize size)
+    {
+        if (!memory)
+            return;
+
+        if (mapped)
+        {
+            vkUnmapMemory(rhi_context->device, memory);
+            mapped = nullptr;
+        }
+
+        vkFreeMemory(rhi_context->device, memory, nullptr);
+        memory = nullptr;
+
+        m_statistics.device_allocations--;
+        m_statistics.bytes_reserved -= size;
+    }
+
+    bool memory::allocator::allocate_from_block(block& _block, const bool linear, const VkDeviceSize size, const VkDeviceSize alignment, allocation& _allocation)
+    {
+        if (linear)
+        {
+            const VkDeviceSize offset = align_up(_block.linear_offset, alignment);
+            if (offset + size > _block.size)
+                return false;
+
+            _allocation.offset          = offset;
+            _allocation.range_offset    = _block.linear_offset;
+            _allocation.range_size      = offset + size - _block.linear_offset;
+            _block.linear_offset        = offset + size;
+            _block.allocation_count++;
+            return true;
+        }
+
+        // First fit
+        for (auto it = _block.ranges_free.begin(); it != _block.ranges_free.end(); it++)
+        {
+            const VkDeviceSize offset   = align_up(it->offset, alignment);
+            const VkDeviceSize padding  = offset - it->offset;
+            if (it->size < padding + size)
+                continue;
+
+            _allocation.offset          = offset;
+            _allocation.range_offset    = it->offset;
+            _allocation.range_size      = padding + size;
+
+            it->offset  += padding + size;
+            it->size    -= padding + size;
+            if (it->size == 0)
+            {
+                _block.ranges_free.erase(it);
+            }
+
+            _block.allocation_count++;
+            return true;
+        }
+
+        return false;
+    }
 }
 #endif
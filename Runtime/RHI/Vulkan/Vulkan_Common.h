@@ -29,12 +29,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include "../RHI_Device.h"
 #include "../RHI_Texture.h"
+#include "../RHI_UploadManager.h"
 #include "../RHI_SwapChain.h"
 #include "../../Logging/Log.h"
 #include "../../Math/Vector4.h"
 #include <array>
 #include <map>
 #include <atomic>
+#include <mutex>
+#include <fstream>
+#include <cstring>
 //=============================
 
 namespace Spartan::vulkan_common
@@ -259,14 +263,121 @@ namespace Spartan::vulkan_common
 			return std::numeric_limits<uint32_t>::max(); 
 		}
 
+        // Sub-allocates buffers and images from large device memory blocks instead of calling vkAllocateMemory per resource.
+        // There is a pool per memory type and resource kind, so buffers and optimally tiled images never share a block (no
+        // bufferImageGranularity concerns). Staging memory comes from linear pools which rewind once all their allocations are freed.
+        // Host visible blocks stay mapped for their whole lifetime. Allocations larger than half a block get dedicated memory.
+        class allocator
+        {
+        public:
+            enum class pool_kind : uint8_t
+            {
+                buffer,
+                image,
+                staging
+            };
+
+            struct allocation
+            {
+                VkDeviceMemory memory       = nullptr;
+                VkDeviceSize offset         = 0;
+                VkDeviceSize size           = 0;
+                void* mapped                = nullptr;  // start of the allocation, if host visible
+                uint64_t pool               = 0;
+                uint32_t block              = 0;
+                VkDeviceSize range_offset   = 0;        // the range taken from the block, including alignment padding
+                VkDeviceSize range_size     = 0;
+                VkDeviceSize memory_size    = 0;        // size of the device memory the allocation lives in
+            };
+
+            struct statistics
+            {
+                uint32_t device_allocations = 0; // vkAllocateMemory calls that are alive (blocks and dedicated allocations)
+                uint32_t allocations        = 0; // resources that are alive
+                uint64_t bytes_reserved     = 0; // memory obtained from the driver
+                uint64_t bytes_used         = 0; // memory handed out to resources
+            };
+
+            static bool allocate(const RHI_Context* rhi_context, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, pool_kind kind, allocation*& allocation_out);
+            static void free(const RHI_Context* rhi_context, allocation* allocation);
+
+            // Defragmentation hook - Returns empty blocks to the driver, to be called when a lot of resources went away (e.g. on world unload)
+            static void release_empty_blocks(const RHI_Context* rhi_context);
+            // Frees everything, the device must be idle
+            static void destroy(const RHI_Context* rhi_context);
+
+            static statistics get_statistics();
+
+            static const VkDeviceSize block_size = 64 * 1024 * 1024;
+
+        private:
+            struct range
+            {
+                VkDeviceSize offset = 0;
+                VkDeviceSize size   = 0;
+            };
+
+            struct block
+            {
+                VkDeviceMemory memory           = nullptr;
+                VkDeviceSize size               = 0;
+                void* mapped                    = nullptr;
+                std::vector<range> ranges_free; // sorted by offset (general pools)
+                VkDeviceSize linear_offset      = 0; // bump pointer (linear pools)
+                uint32_t allocation_count       = 0;
+            };
+
+            struct pool
+            {
+                uint32_t memory_type    = 0;
+                pool_kind kind          = pool_kind::buffer;
+                std::vector<block> blocks;
+            };
+
+            static bool allocate_device_memory(const RHI_Context* rhi_context, VkDeviceSize size, uint32_t memory_type, VkDeviceMemory& memory, void*& mapped);
+            static void free_device_memory(const RHI_Context* rhi_context, VkDeviceMemory& memory, void*& mapped, VkDeviceSize size);
+            static bool allocate_from_block(block& block, bool linear, VkDeviceSize size, VkDeviceSize alignment, allocation& allocation);
+
+            static std::map<uint64_t, pool> m_pools;
+            static std::mutex m_mutex;
+            static statistics m_statistics;
+        };
+
 		inline void free(const RHI_Context* rhi_context, void*& device_memory)
 		{
 			if (!device_memory)
 				return;
 
-			vkFreeMemory(rhi_context->device, static_cast<VkDeviceMemory>(device_memory), nullptr);
+            allocator::free(rhi_context, static_cast<allocator::allocation*>(device_memory));
 			device_memory = nullptr;
 		}
+
+        inline VkDeviceMemory get_device_memory(void* device_memory) { return device_memory ? static_cast<allocator::allocation*>(device_memory)->memory : nullptr; }
+        inline VkDeviceSize get_offset(void* device_memory)          { return device_memory ? static_cast<allocator::allocation*>(device_memory)->offset : 0; }
+
+        // Returns the start of an allocation that lives in host visible memory (it's persistently mapped, so there is nothing to unmap)
+        inline void* map(void* device_memory) { return device_memory ? static_cast<allocator::allocation*>(device_memory)->mapped : nullptr; }
+
+        inline bool flush(const RHI_Context* rhi_context, void* device_memory, const VkDeviceSize offset = 0, const VkDeviceSize size = VK_WHOLE_SIZE)
+        {
+            if (!device_memory)
+                return false;
+
+            // Only flush the allocation's own range, expanded to multiples of nonCoherentAtomSize (or the end of the memory)
+            const auto allocation               = static_cast<allocator::allocation*>(device_memory);
+            const VkDeviceSize atom             = Math::Max<VkDeviceSize>(rhi_context->device_properties.limits.nonCoherentAtomSize, 1);
+            const VkDeviceSize start            = allocation->offset + offset;
+            const VkDeviceSize end              = allocation->offset + (size == VK_WHOLE_SIZE ? allocation->size : offset + size);
+            const VkDeviceSize aligned_start    = (start / atom) * atom;
+            const VkDeviceSize aligned_end      = Math::Min<VkDeviceSize>(((end + atom - 1) / atom) * atom, allocation->memory_size);
+
+            VkMappedMemoryRange mapped_memory_range = {};
+            mapped_memory_range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            mapped_memory_range.memory              = allocation->memory;
+            mapped_memory_range.offset              = aligned_start;
+            mapped_memory_range.size                = aligned_end == allocation->memory_size ? VK_WHOLE_SIZE : aligned_end - aligned_start;
+            return error::check(vkFlushMappedMemoryRanges(rhi_context->device, 1, &mapped_memory_range));
+        }
 	}
 
     namespace semaphore
@@ -511,10 +622,9 @@ namespace Spartan::vulkan_common
 
 	namespace buffer
 	{
-		inline bool create(const RHI_Context* rhi_context, void*& buffer, void*& device_memory, const uint64_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_property_flags, const void* data = nullptr)
+		inline bool create(const RHI_Context* rhi_context, void*& buffer, void*& device_memory, const uint64_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_property_flags, const void* data = nullptr, const bool shared_with_transfer_queue = false)
 		{
-            VkBuffer* buffer_vk              = reinterpret_cast<VkBuffer*>(&buffer);
-            VkDeviceMemory* buffer_memory_vk = reinterpret_cast<VkDeviceMemory*>(&device_memory);
+            VkBuffer* buffer_vk = reinterpret_cast<VkBuffer*>(&buffer);
 
 			VkBufferCreateInfo buffer_info	= {};
 			buffer_info.sType				= VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -522,46 +632,52 @@ namespace Spartan::vulkan_common
 			buffer_info.usage				= usage;
 			buffer_info.sharingMode			= VK_SHARING_MODE_EXCLUSIVE;
 
+            // Buffers which are written by the transfer queue and read by the graphics queue are shared by both queue families,
+            // like images, so that no ownership transfer is needed
+            const uint32_t queue_family_indices[] = { rhi_context->queue_graphics_index, rhi_context->queue_transfer_index };
+            if (shared_with_transfer_queue && queue_family_indices[0] != queue_family_indices[1])
+            {
+                buffer_info.sharingMode             = VK_SHARING_MODE_CONCURRENT;
+                buffer_info.queueFamilyIndexCount   = 2;
+                buffer_info.pQueueFamilyIndices     = queue_family_indices;
+            }
+
 			if (!error::check(vkCreateBuffer(rhi_context->device, &buffer_info, nullptr, buffer_vk)))
 				return false;
 
 			VkMemoryRequirements memory_requirements;
 			vkGetBufferMemoryRequirements(rhi_context->device, *buffer_vk, &memory_requirements);
 
-			VkMemoryAllocateInfo alloc_info = {};			
-			alloc_info.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			alloc_info.allocationSize		= memory_requirements.size;
-			alloc_info.memoryTypeIndex		= memory::get_type(rhi_context, memory_property_flags, memory_requirements.memoryTypeBits);
+            // Buffers which are only ever a copy source are short lived staging buffers, so they go to the linear pools
+            const memory::allocator::pool_kind kind = usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT ? memory::allocator::pool_kind::staging : memory::allocator::pool_kind::buffer;
 
-            if (!error::check(vkAllocateMemory(rhi_context->device, &alloc_info, nullptr, buffer_memory_vk)))
+            memory::allocator::allocation* allocation = nullptr;
+            if (!memory::allocator::allocate(rhi_context, memory_requirements, memory_property_flags, kind, allocation))
+            {
+                vkDestroyBuffer(rhi_context->device, *buffer_vk, nullptr);
+                buffer = nullptr;
                 return false;
+            }
+            device_memory = static_cast<void*>(allocation);
 
-            // If a pointer to the buffer data has been passed, map the buffer and copy over the data
+            // If a pointer to the buffer data has been passed, copy it over (host visible memory is persistently mapped)
             if (data != nullptr)
             {
-                void* mapped;
-                if (error::check(vkMapMemory(rhi_context->device, *buffer_memory_vk, 0, size, 0, &mapped)))
+                if (void* mapped = memory::map(device_memory))
                 {
                     memcpy(mapped, data, size);
 
                     // If host coherency hasn't been requested, do a manual flush to make writes visible
                     if ((memory_property_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
                     {
-                        VkMappedMemoryRange mappedRange = {};
-                        mappedRange.memory              = *buffer_memory_vk;
-                        mappedRange.offset              = 0;
-                        mappedRange.size                = size;
-
-                        if (!error::check(vkFlushMappedMemoryRanges(rhi_context->device, 1, &mappedRange)))
+                        if (!memory::flush(rhi_context, device_memory, 0, size))
                             return false;
                     }
-
-                    vkUnmapMemory(rhi_context->device, *buffer_memory_vk);
                 }
             }
 
             // Attach the memory to the buffer object
-            if (!error::check(vkBindBufferMemory(rhi_context->device, *buffer_vk, *buffer_memory_vk, 0)))
+            if (!error::check(vkBindBufferMemory(rhi_context->device, *buffer_vk, allocation->memory, allocation->offset)))
                 return false;
 
 			return true;
@@ -575,6 +691,33 @@ namespace Spartan::vulkan_common
 			vkDestroyBuffer(rhi_context->device, static_cast<VkBuffer>(_buffer), nullptr);
 			_buffer = nullptr;
 		}
+
+        // Hands the buffer and its memory over to the device, which releases them once the frames that might use them are done
+        // An upload token delays the release until the upload has completed too (the buffer is still being written)
+        inline void destroy_deferred(const RHI_Device* rhi_device, void*& _buffer, void*& device_memory, const uint64_t upload_token = 0)
+        {
+            if (!_buffer && !device_memory)
+                return;
+
+            RHI_Context* rhi_context = rhi_device->GetContextRhi();
+            auto release = [rhi_context, _buffer, device_memory]() mutable
+            {
+                destroy(rhi_context, _buffer);
+                memory::free(rhi_context, device_memory);
+            };
+
+            if (upload_token == 0)
+            {
+                rhi_device->DeferredRelease_Add(std::move(release));
+            }
+            else
+            {
+                rhi_device->GetUploadManager()->ReleaseAfter(upload_token, std::move(release));
+            }
+
+            _buffer         = nullptr;
+            device_memory   = nullptr;
+        }
 	}
 
     namespace image
@@ -596,20 +739,17 @@ namespace Spartan::vulkan_common
             return VK_IMAGE_TILING_MAX_ENUM;
         }
 
-        inline bool allocate_bind(const RHI_Context* rhi_context, const VkImage& image, VkDeviceMemory* memory, VkDeviceSize* memory_size = nullptr)
+        inline bool allocate_bind(const RHI_Context* rhi_context, const VkImage& image, void*& memory, VkDeviceSize* memory_size = nullptr)
         {
             VkMemoryRequirements memory_requirements;
             vkGetImageMemoryRequirements(rhi_context->device, image, &memory_requirements);
 
-            VkMemoryAllocateInfo allocate_info  = {};
-            allocate_info.sType                 = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocate_info.allocationSize        = memory_requirements.size;
-            allocate_info.memoryTypeIndex       = memory::get_type(rhi_context, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory_requirements.memoryTypeBits);
-
-            if (!error::check(vkAllocateMemory(rhi_context->device, &allocate_info, nullptr, memory)))
+            memory::allocator::allocation* allocation = nullptr;
+            if (!memory::allocator::allocate(rhi_context, memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory::allocator::pool_kind::image, allocation))
                 return false;
+            memory = static_cast<void*>(allocation);
 
-            if (!error::check(vkBindImageMemory(rhi_context->device, image, *memory, 0)))
+            if (!error::check(vkBindImageMemory(rhi_context->device, image, allocation->memory, allocation->offset)))
                 return false;
 
             if (memory_size)
@@ -660,7 +800,8 @@ namespace Spartan::vulkan_common
             const VkFormat format,
             const VkImageTiling tiling,
             const RHI_Image_Layout layout,
-            const VkImageUsageFlags usage
+            const VkImageUsageFlags usage,
+            const bool shared_with_transfer_queue = false
         )
         {
             VkImageCreateInfo create_info   = {};
@@ -678,6 +819,16 @@ namespace Spartan::vulkan_common
             create_info.samples             = VK_SAMPLE_COUNT_1_BIT;
             create_info.sharingMode         = VK_SHARING_MODE_EXCLUSIVE;
 
+            // Images which are written by the transfer queue and read by the graphics queue are shared by both queue families,
+            // that way no ownership transfer is needed (it makes no difference if both queues come from the same family).
+            const uint32_t queue_family_indices[] = { rhi_context->queue_graphics_index, rhi_context->queue_transfer_index };
+            if (shared_with_transfer_queue && queue_family_indices[0] != queue_family_indices[1])
+            {
+                create_info.sharingMode             = VK_SHARING_MODE_CONCURRENT;
+                create_info.queueFamilyIndexCount   = 2;
+                create_info.pQueueFamilyIndices     = queue_family_indices;
+            }
+
             return error::check(vkCreateImage(rhi_context->device, &create_info, nullptr, &image));
         }
 
@@ -1154,6 +1305,101 @@ namespace Spartan::vulkan_common
         }
     }
 
+    namespace pipeline_cache
+    {
+        // The data starts with a VkPipelineCacheHeaderVersionOne. Drivers are supposed to reject incompatible data themselves,
+        // but not all of them do it reliably, so data from a different device or driver is discarded before it gets to them.
+        inline bool is_compatible(const RHI_Context* rhi_context, const std::vector<char>& data)
+        {
+            const size_t header_size = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+            if (data.size() < header_size)
+                return false;
+
+            uint32_t header[4];
+            memcpy(header, data.data(), sizeof(header));
+
+            const uint32_t header_length    = header[0];
+            const uint32_t header_version   = header[1];
+            const uint32_t vendor_id        = header[2];
+            const uint32_t device_id        = header[3];
+
+            return
+                header_length   >= header_size                                  &&
+                header_version  == VK_PIPELINE_CACHE_HEADER_VERSION_ONE         &&
+                vendor_id       == rhi_context->device_properties.vendorID      &&
+                device_id       == rhi_context->device_properties.deviceID      &&
+                memcmp(data.data() + 4 * sizeof(uint32_t), rhi_context->device_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+        inline bool create(RHI_Context* rhi_context, const std::string& file_path)
+        {
+            // Load whatever a previous run has saved
+            std::vector<char> data;
+            {
+                std::ifstream in(file_path, std::ios::binary | std::ios::ate);
+                if (in)
+                {
+                    data.resize(static_cast<size_t>(in.tellg()));
+                    in.seekg(0, std::ios::beg);
+                    in.read(data.data(), data.size());
+                    data.resize(static_cast<size_t>(in.gcount()));
+                }
+
+                if (!data.empty() && !is_compatible(rhi_context, data))
+                {
+                    LOG_INFO("Discarding pipeline cache \"%s\", it was created by a different device or driver", file_path.c_str());
+                    data.clear();
+                }
+            }
+
+            VkPipelineCacheCreateInfo create_info   = {};
+            create_info.sType                       = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            create_info.initialDataSize             = data.size();
+            create_info.pInitialData                = data.empty() ? nullptr : data.data();
+
+            if (!error::check(vkCreatePipelineCache(rhi_context->device, &create_info, nullptr, &rhi_context->pipeline_cache)))
+                return false;
+
+            if (!data.empty())
+            {
+                LOG_INFO("Loaded pipeline cache \"%s\" (%.1f KB)", file_path.c_str(), data.size() / 1024.0f);
+            }
+
+            return true;
+        }
+
+        inline void save(const RHI_Context* rhi_context, const std::string& file_path)
+        {
+            if (!rhi_context->pipeline_cache)
+                return;
+
+            size_t size = 0;
+            if (!error::check(vkGetPipelineCacheData(rhi_context->device, rhi_context->pipeline_cache, &size, nullptr)) || size == 0)
+                return;
+
+            std::vector<char> data(size);
+            if (!error::check(vkGetPipelineCacheData(rhi_context->device, rhi_context->pipeline_cache, &size, data.data())))
+                return;
+
+            std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                LOG_WARNING("Failed to save pipeline cache \"%s\"", file_path.c_str());
+                return;
+            }
+            out.write(data.data(), size);
+        }
+
+        inline void destroy(RHI_Context* rhi_context)
+        {
+            if (!rhi_context->pipeline_cache)
+                return;
+
+            vkDestroyPipelineCache(rhi_context->device, rhi_context->pipeline_cache, nullptr);
+            rhi_context->pipeline_cache = nullptr;
+        }
+    }
+
     namespace surface
     {
         inline VkSurfaceCapabilitiesKHR capabilities(const RHI_Context* rhi_context, const VkSurfaceKHR surface)
@@ -39,11 +39,9 @@ namespace Spartan
 {
 	RHI_ConstantBuffer::~RHI_ConstantBuffer()
 	{
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
-		vulkan_common::buffer::destroy(m_rhi_device->GetContextRhi(), m_buffer);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_buffer_memory);
+        // The buffer might still be in use, so it's released once the frames in flight are done
+        m_buffer_mapped = nullptr;
+        vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory);
 	}
 
 	bool RHI_ConstantBuffer::_Create()
@@ -54,15 +52,10 @@ namespace Spartan
 			return false;
 		}
 
-        // Wait in case the buffer is still in use
-        if (m_buffer)
-        {
-            m_rhi_device->Queue_WaitAll();
-        }
-
-		// Clear previous buffer
-		vulkan_common::buffer::destroy(m_rhi_device->GetContextRhi(), m_buffer);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_buffer_memory);
+        // Don't wait for the GPU, the previous buffer is released once the frames that might use it are done
+        m_buffer_mapped = nullptr;
+        vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory);
+        ResourceIdUpdate();
 
         // Calculate required alignment based on minimum device offset alignment
         size_t min_ubo_alignment = m_rhi_device->GetContextRhi()->device_properties.limits.minUniformBufferOffsetAlignment;
@@ -70,65 +63,50 @@ namespace Spartan
         {
             m_stride = (m_stride + min_ubo_alignment - 1) & ~(min_ubo_alignment - 1);
         }
-        m_size_gpu = m_element_count * m_stride;
+        // Dynamic buffers have one region per frame in flight (see Allocate())
+        m_size_gpu = static_cast<uint64_t>(m_element_count) * m_stride * (m_is_dynamic ? m_ring_frame_count : 1);
 
 		// Create buffer
 		if (!vulkan_common::buffer::create(m_rhi_device->GetContextRhi(), m_buffer, m_buffer_memory, m_size_gpu, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
 			return false;
 
+        // The allocator keeps host visible memory mapped, the memory is host coherent so writes need no flushing
+        m_buffer_mapped = vulkan_common::memory::map(m_buffer_memory);
+        if (!m_buffer_mapped)
+            return false;
+
         // Set debug names
         vulkan_common::debug::set_buffer_name(m_rhi_device->GetContextRhi()->device, static_cast<VkBuffer>(m_buffer), "constant_buffer");
-        vulkan_common::debug::set_device_memory_name(m_rhi_device->GetContextRhi()->device, static_cast<VkDeviceMemory>(m_buffer_memory), "constant_buffer");
 
 		return true;
 	}
 
     void* RHI_ConstantBuffer::Map(const uint32_t offset_index /*= 0*/) const
     {
-        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device || !m_buffer_memory)
+        if (!m_buffer_mapped)
         {
             LOG_ERROR_INVALID_INTERNALS();
             return nullptr;
         }
 
-        void* ptr = nullptr;
-        vulkan_common::error::check
-        (
-            vkMapMemory
-            (
-                m_rhi_device->GetContextRhi()->device,
-                static_cast<VkDeviceMemory>(m_buffer_memory),
-                static_cast<uint64_t>(offset_index * m_stride),   // offset
-                m_stride,                                         // size
-                0,                                                // flags
-                reinterpret_cast<void**>(&ptr)
-            )
-        );
-
-        return ptr;
+        return static_cast<uint8_t*>(m_buffer_mapped) + static_cast<uint64_t>(offset_index) * m_stride;
     }
 
     bool RHI_ConstantBuffer::Unmap() const
     {
-        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device || !m_buffer_memory)
+        if (!m_buffer_mapped)
         {
             LOG_ERROR_INVALID_INTERNALS();
             return false;
         }
 
-        vkUnmapMemory(m_rhi_device->GetContextRhi()->device, static_cast<VkDeviceMemory>(m_buffer_memory));
-
+        // The buffer stays mapped for its whole lifetime
         return true;
     }
 
     bool RHI_ConstantBuffer::Flush(const uint32_t offset_index /*= 0*/)
     {
-        VkMappedMemoryRange mapped_memory_range = {};
-        mapped_memory_range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_memory_range.memory              = static_cast<VkDeviceMemory>(m_buffer_memory);
-        mapped_memory_range.offset              = static_cast<uint64_t>(offset_index * m_stride);
-        mapped_memory_range.size                = m_stride;
-        return vulkan_common::error::check(vkFlushMappedMemoryRanges(m_rhi_device->GetContextRhi()->device, 1, &mapped_memory_range));
+        return vulkan_common::memory::flush(m_rhi_device->GetContextRhi(), m_buffer_memory, static_cast<uint64_t>(offset_index) * m_stride, m_stride);
     }
 }
 #endif
@@ -37,51 +37,74 @@ namespace Spartan
 {
     RHI_DescriptorCache::~RHI_DescriptorCache()
     {
-        if (m_descriptor_pool)
+        // Layouts first, the descriptor sets they hold are freed along with the pools
+        m_descriptor_set_layouts.clear();
+        m_descriptor_layout_current = nullptr;
+
+        for (void*& descriptor_pool : m_descriptor_pools)
         {
-            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pool), nullptr);
-            m_descriptor_pool = nullptr;
+            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(descriptor_pool), nullptr);
         }
+        m_descriptor_pools.clear();
     }
 
-    void RHI_DescriptorCache::SetDescriptorSetCapacity(uint32_t descriptor_set_capacity)
+    void* RHI_DescriptorCache::AllocateDescriptorSet(void* descriptor_set_layout, const string& name)
     {
-        if (!m_rhi_device || !m_rhi_device->GetContextRhi())
+        if (m_descriptor_pools.empty() && !CreateDescriptorPool())
+            return nullptr;
+
+        VkDescriptorSetAllocateInfo allocate_info   = {};
+        allocate_info.sType                         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorSetCount            = 1;
+        allocate_info.pSetLayouts                   = reinterpret_cast<VkDescriptorSetLayout*>(&descriptor_set_layout);
+
+        // Allocate from the newest pool, if it's full, add a pool and try once more
+        VkDescriptorSet descriptor_set = nullptr;
+        for (uint32_t attempt = 0; attempt < 2; attempt++)
         {
-            LOG_ERROR_INVALID_INTERNALS();
-            return;
-        }
+            allocate_info.descriptorPool = static_cast<VkDescriptorPool>(m_descriptor_pools.back());
+            const VkResult result = vkAllocateDescriptorSets(m_rhi_device->GetContextRhi()->device, &allocate_info, &descriptor_set);
 
-        // Wait in case the pool is being used
-        m_rhi_device->Queue_WaitAll();
+            if (result == VK_SUCCESS)
+                break;
 
-        // Destroy layouts (and descriptor sets)
-        m_descriptor_set_layouts.clear();
-        m_descriptor_layout_current = nullptr;
+            descriptor_set = nullptr;
+            if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || attempt == 1)
+            {
+                vulkan_common::error::check(result);
+                return nullptr;
+            }
 
-        // Destroy pool
-        if (m_descriptor_pool)
-        {
-            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pool), nullptr);
-            m_descriptor_pool = nullptr;
+            if (!CreateDescriptorPool())
+                return nullptr;
         }
 
-        // Re-allocate everything with double size
-        CreateDescriptorPool(descriptor_set_capacity);
+        vulkan_common::debug::set_descriptor_set_name(m_rhi_device->GetContextRhi()->device, descriptor_set, name.c_str());
+        m_statistics.allocations++;
+
+        return static_cast<void*>(descriptor_set);
     }
 
-    bool RHI_DescriptorCache::CreateDescriptorPool(uint32_t descriptor_set_capacity)
+    bool RHI_DescriptorCache::CreateDescriptorPool()
     {
-        // Pool sizes
-        vector<VkDescriptorPoolSize> pool_sizes(4);
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi())
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return false;
+        }
+
+        // Pool sizes, enough for every set to use the maximum amount of each descriptor type
+        vector<VkDescriptorPoolSize> pool_sizes(5);
         pool_sizes[0].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        pool_sizes[0].descriptorCount   = RHI_Context::descriptor_max_constant_buffers;
+        pool_sizes[0].descriptorCount   = RHI_Context::descriptor_max_constant_buffers * descriptor_pool_set_capacity;
         pool_sizes[1].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        pool_sizes[1].descriptorCount   = RHI_Context::descriptor_max_constant_buffers_dynamic;
+        pool_sizes[1].descriptorCount   = RHI_Context::descriptor_max_constant_buffers_dynamic * descriptor_pool_set_capacity;
         pool_sizes[2].type              = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        pool_sizes[2].descriptorCount   = RHI_Context::descriptor_max_textures;
+        pool_sizes[2].descriptorCount   = RHI_Context::descriptor_max_textures * descriptor_pool_set_capacity;
         pool_sizes[3].type              = VK_DESCRIPTOR_TYPE_SAMPLER;
-        pool_sizes[3].descriptorCount   = RHI_Context::descriptor_max_samplers;
+        pool_sizes[3].descriptorCount   = RHI_Context::descriptor_max_samplers * descriptor_pool_set_capacity;
+        pool_sizes[4].type              = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[4].descriptorCount   = RHI_Context::descriptor_max_structured_buffers * descriptor_pool_set_capacity;
 
         // Create info
         VkDescriptorPoolCreateInfo pool_create_info = {};
@@ -89,13 +112,20 @@ namespace Spartan
         pool_create_info.flags          = 0;
         pool_create_info.poolSizeCount  = static_cast<uint32_t>(pool_sizes.size());
         pool_create_info.pPoolSizes     = pool_sizes.data();
-        pool_create_info.maxSets        = descriptor_set_capacity;
+        pool_create_info.maxSets        = descriptor_pool_set_capacity;
 
         // Pool
-        const auto descriptor_pool = reinterpret_cast<VkDescriptorPool*>(&m_descriptor_pool);
-        if (!vulkan_common::error::check(vkCreateDescriptorPool(m_rhi_device->GetContextRhi()->device, &pool_create_info, nullptr, descriptor_pool)))
+        VkDescriptorPool descriptor_pool = nullptr;
+        if (!vulkan_common::error::check(vkCreateDescriptorPool(m_rhi_device->GetContextRhi()->device, &pool_create_info, nullptr, &descriptor_pool)))
             return false;
 
+        m_descriptor_pools.emplace_back(static_cast<void*>(descriptor_pool));
+
+        if (m_descriptor_pools.size() > 1)
+        {
+            LOG_INFO("Added descriptor pool, capacity is now %d sets", static_cast<int>(m_descriptor_pools.size() * descriptor_pool_set_capacity));
+        }
+
         return true;
     }
 }
@@ -26,7 +26,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==========================
 #include "../RHI_DescriptorSetLayout.h"
-#include "../RHI_DescriptorCache.h"
 //=====================================
 
 //= NAMESPACES =====
@@ -39,38 +38,15 @@ namespace Spartan
     {
         if (m_descriptor_set_layout)
         {
-            vkDestroyDescriptorSetLayout(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorSetLayout>(m_descriptor_set_layout), nullptr);
+            VkDevice device = m_rhi_device->GetContextRhi()->device;
+            m_rhi_device->DeferredRelease_Add([device, descriptor_set_layout = m_descriptor_set_layout]()
+            {
+                vkDestroyDescriptorSetLayout(device, static_cast<VkDescriptorSetLayout>(descriptor_set_layout), nullptr);
+            });
             m_descriptor_set_layout = nullptr;
         }
     }
 
-    void* RHI_DescriptorSetLayout::CreateDescriptorSet(const size_t hash, const RHI_DescriptorCache* descriptor_cache)
-    {
-        // Allocate descriptor set
-        void* descriptor_set = nullptr;
-        {
-            // Allocate info
-            VkDescriptorSetAllocateInfo allocate_info   = {};
-            allocate_info.sType                         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            allocate_info.descriptorPool                = static_cast<VkDescriptorPool>(descriptor_cache->GetResource_DescriptorSetPool());
-            allocate_info.descriptorSetCount            = 1;
-            allocate_info.pSetLayouts                   = reinterpret_cast<VkDescriptorSetLayout*>(&m_descriptor_set_layout);
-
-            // Allocate		
-            if (!vulkan_common::error::check(vkAllocateDescriptorSets(m_rhi_device->GetContextRhi()->device, &allocate_info, reinterpret_cast<VkDescriptorSet*>(&descriptor_set))))
-                return nullptr;
-
-            vulkan_common::debug::set_descriptor_set_name(m_rhi_device->GetContextRhi()->device, *reinterpret_cast<VkDescriptorSet*>(&descriptor_set), m_name.c_str());
-        }
-
-        UpdateDescriptorSet(descriptor_set, m_descriptors);
-
-        // Cache descriptor
-        m_descriptor_sets[hash] = descriptor_set;
-
-        return descriptor_set;
-    }
-
     void RHI_DescriptorSetLayout::UpdateDescriptorSet(void* descriptor_set, const vector<RHI_Descriptor>& descriptors)
     {
         if (!descriptor_set)
@@ -101,13 +77,13 @@ namespace Spartan
                 descriptor.type == RHI_Descriptor_Texture && descriptor.resource ? vulkan_image_layout[descriptor.layout] : VK_IMAGE_LAYOUT_UNDEFINED   // imageLayout
             });
         
-            // Constant/Uniform buffer
-            const bool is_constant_buffer = descriptor.type == RHI_Descriptor_ConstantBuffer || descriptor.type == RHI_Descriptor_ConstantBufferDynamic;
+            // Constant/Uniform buffer or structured/storage buffer
+            const bool is_buffer = descriptor.type == RHI_Descriptor_ConstantBuffer || descriptor.type == RHI_Descriptor_ConstantBufferDynamic || descriptor.type == RHI_Descriptor_StructuredBuffer;
             buffer_infos.push_back
             ({
-                is_constant_buffer ? static_cast<VkBuffer>(descriptor.resource) : nullptr,  // buffer
-                is_constant_buffer ? descriptor.offset  : 0,                                // offset
-                is_constant_buffer ? descriptor.range   : 0                                 // range
+                is_buffer ? static_cast<VkBuffer>(descriptor.resource) : nullptr,   // buffer
+                is_buffer ? descriptor.offset  : 0,                                 // offset
+                is_buffer ? descriptor.range   : 0                                  // range
             });
         
             write_descriptor_sets.push_back
@@ -24,16 +24,19 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Implementation.h"
 //================================
 
-//= INCLUDES ========================
+//= INCLUDES ==========================
 #include <string>
 #include "../RHI_Device.h"
 #include "../RHI_CommandList.h"
+#include "../RHI_UploadManager.h"
 #include "../../Logging/Log.h"
 #include "../../Core/Settings.h"
 #include "../../Core/Context.h"
 #include "../../Core/Engine.h"
 #include "../../Rendering/Renderer.h"
-//===================================
+#include "../../Core/FileSystem.h"
+#include "../../Resource/ResourceCache.h"
+//=====================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -223,6 +226,24 @@ namespace Spartan
         settings->RegisterThirdPartyLib("Vulkan", version_major + "." + version_minor + "." + version_path, "https://vulkan.lunarg.com/");
 		LOG_INFO("Vulkan %s", version.c_str());
 
+        // Pipeline cache, saved on shutdown so that the next launch doesn't have to build pipelines from scratch
+        {
+            const string cache_directory = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Cache) + "/";
+            if (!FileSystem::Exists(cache_directory))
+            {
+                FileSystem::CreateDirectory_(cache_directory);
+            }
+
+            m_pipeline_cache_file_path = cache_directory + "pipeline_cache.bin";
+            if (!vulkan_common::pipeline_cache::create(m_rhi_context.get(), m_pipeline_cache_file_path))
+            {
+                LOG_WARNING("Failed to create pipeline cache, pipelines will be built from scratch");
+            }
+        }
+
+        // Uploads
+        m_upload_manager = make_shared<RHI_UploadManager>(this);
+
 		m_initialized = true;
 	}
 
@@ -231,6 +252,12 @@ namespace Spartan
         if (!m_rhi_context || !m_rhi_context->queue_graphics)
             return;
 
+        // Finish pending uploads (releases waiting on them are handed over to the deferred release)
+        m_upload_manager = nullptr;
+
+        // Release anything that's still waiting for its frames to complete
+        DeferredRelease_Flush();
+
         // Release resources
 		if (Queue_Wait(RHI_Queue_Graphics))
 		{
@@ -238,6 +265,9 @@ namespace Spartan
             {
                 vulkan_common::debug::shutdown(m_rhi_context->instance);
             }
+            vulkan_common::pipeline_cache::save(m_rhi_context.get(), m_pipeline_cache_file_path);
+            vulkan_common::pipeline_cache::destroy(m_rhi_context.get());
+            vulkan_common::memory::allocator::destroy(m_rhi_context.get());
 			vkDestroyDevice(m_rhi_context->device, nullptr);
 			vkDestroyInstance(m_rhi_context->instance, nullptr);
 		}
@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==================
 #include "../RHI_Device.h"
+#include "../RHI_UploadManager.h"
 #include "../RHI_IndexBuffer.h"
 #include "../RHI_CommandList.h"
 #include "../../Logging/Log.h"
@@ -39,11 +40,8 @@ namespace Spartan
 {
 	RHI_IndexBuffer::~RHI_IndexBuffer()
 	{
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
-		vulkan_common::buffer::destroy(m_rhi_device->GetContextRhi(), m_buffer);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_buffer_memory);
+        // The buffer might still be uploading or in use, so it's released once its upload and the frames in flight are done
+        vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory, m_upload_token);
 	}
 
 	bool RHI_IndexBuffer::_Create(const void* indices)
@@ -56,15 +54,9 @@ namespace Spartan
 
         RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
 
-        // Wait in case the buffer is still in use
-        if (m_buffer)
-        {
-            m_rhi_device->Queue_WaitAll();
-        }
-
-		// Clear previous buffer
-		vulkan_common::buffer::destroy(m_rhi_device->GetContextRhi(), m_buffer);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_buffer_memory);
+		// Clear previous buffer (it might still be uploading or in use, so its release is deferred)
+		vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory, m_upload_token);
+        m_upload_token = 0;
 
         bool use_staging    = indices != nullptr;
         m_mappable          = !use_staging;
@@ -87,61 +79,41 @@ namespace Spartan
         }
         else
         {
-            // Create staging/source buffer and copy the indices to it
-            void* staging_buffer        = nullptr;
-            void* staging_buffer_memory = nullptr;
+            // Create destination buffer, it's written by the transfer queue
             if (!vulkan_common::buffer::create(
-                rhi_context,
-                staging_buffer,
-                staging_buffer_memory,
-                m_size_gpu,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,                                               // usage
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,     // memory
-                indices
-                )
-            ) return false;
-
-            // Create destination buffer
-            if (!vulkan_common::buffer::create(
-                rhi_context,
-                m_buffer,
-                m_buffer_memory,
-                m_size_gpu,
-                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,    // usage
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT                                     // memory
+                    rhi_context,
+                    m_buffer,
+                    m_buffer_memory,
+                    m_size_gpu,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,    // usage
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,                                    // memory
+                    nullptr,                                                                // data
+                    true                                                                    // shared with the transfer queue
                 )
             ) return false;
 
-            // Copy from staging buffer
+            // Copy through the upload manager's staging ring without waiting, draws skip the buffer until it's resident
+            m_upload_token = m_rhi_device->GetUploadManager()->UploadBuffer(m_buffer, indices, m_size_gpu);
+            if (m_upload_token == RHI_UploadManager::token_invalid)
             {
-                // Create command buffer
-                VkCommandBuffer cmd_buffer = vulkan_common::command_buffer_immediate::begin(m_rhi_device.get(), RHI_Queue_Transfer);
-
-                VkBuffer* buffer_vk         = reinterpret_cast<VkBuffer*>(&m_buffer);
-                VkBuffer* buffer_staging_vk = reinterpret_cast<VkBuffer*>(&staging_buffer);
-
-                // Copy
-                VkBufferCopy copy_region = {};
-                copy_region.size = m_size_gpu;
-                vkCmdCopyBuffer(cmd_buffer, *buffer_staging_vk, *buffer_vk, 1, &copy_region);
-
-                // Flush and free command buffer
-                if (!vulkan_common::command_buffer_immediate::end(RHI_Queue_Transfer))
-                    return false;
-
-                // Destroy staging resources
-                vulkan_common::buffer::destroy(rhi_context, staging_buffer);
-                vulkan_common::memory::free(rhi_context, staging_buffer_memory);
+                LOG_ERROR("Failed to upload buffer");
+                vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory);
+                m_upload_token = 0;
+                return false;
             }
         }
 
         // Set debug names
         vulkan_common::debug::set_buffer_name(m_rhi_device->GetContextRhi()->device, static_cast<VkBuffer>(m_buffer), "index_buffer");
-        vulkan_common::debug::set_device_memory_name(m_rhi_device->GetContextRhi()->device, static_cast<VkDeviceMemory>(m_buffer_memory), "index_buffer");
 
 		return true;
 	}
 
+    bool RHI_IndexBuffer::IsResident() const
+    {
+        return m_rhi_device->GetUploadManager()->IsComplete(m_upload_token);
+    }
+
 	void* RHI_IndexBuffer::Map() const
 	{
 		if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device || !m_buffer_memory)
@@ -156,22 +128,8 @@ namespace Spartan
             return nullptr;
         }
 
-		void* ptr = nullptr;
-
-        vulkan_common::error::check
-        (
-            vkMapMemory
-            (
-                m_rhi_device->GetContextRhi()->device,
-                static_cast<VkDeviceMemory>(m_buffer_memory),
-                0,
-                m_size_gpu,
-                0,
-                reinterpret_cast<void**>(&ptr)
-            )
-        );
-
-		return ptr;
+        // The memory is persistently mapped by the allocator
+		return vulkan_common::memory::map(m_buffer_memory);
 	}
 
 	bool RHI_IndexBuffer::Unmap() const
@@ -188,18 +146,13 @@ namespace Spartan
             return nullptr;
         }
 
-		vkUnmapMemory(m_rhi_device->GetContextRhi()->device, static_cast<VkDeviceMemory>(m_buffer_memory));
+		// Nothing to do, the memory stays mapped for as long as it lives
 		return true;
 	}
 
     bool RHI_IndexBuffer::Flush() const
     {
-        VkMappedMemoryRange mapped_memory_range = {};
-        mapped_memory_range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_memory_range.memory              = static_cast<VkDeviceMemory>(m_buffer_memory);
-        mapped_memory_range.offset              = 0;
-        mapped_memory_range.size                = VK_WHOLE_SIZE;
-        return vulkan_common::error::check(vkFlushMappedMemoryRanges(m_rhi_device->GetContextRhi()->device, 1, &mapped_memory_range));
+        return vulkan_common::memory::flush(m_rhi_device->GetContextRhi(), m_buffer_memory);
     }
 }
 #endif
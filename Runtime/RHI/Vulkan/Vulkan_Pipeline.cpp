@@ -305,7 +305,7 @@ namespace Spartan
 		    pipeline_info.renderPass					= static_cast<VkRenderPass>(m_state.GetRenderPass());
 
             auto pipeline = reinterpret_cast<VkPipeline*>(&m_pipeline);
-            vulkan_common::error::check(vkCreateGraphicsPipelines(m_rhi_device->GetContextRhi()->device, nullptr, 1, &pipeline_info, nullptr, pipeline));
+            vulkan_common::error::check(vkCreateGraphicsPipelines(m_rhi_device->GetContextRhi()->device, m_rhi_device->GetContextRhi()->pipeline_cache, 1, &pipeline_info, nullptr, pipeline));
 
             // Set pipeline name
             string name = (m_state.shader_vertex ? m_state.shader_vertex->GetName() : "null") + "-" + (m_state.shader_pixel ? m_state.shader_pixel->GetName() : "null");
@@ -315,14 +315,16 @@ namespace Spartan
 
 	RHI_Pipeline::~RHI_Pipeline()
 	{
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
-		vkDestroyPipeline(m_rhi_device->GetContextRhi()->device, static_cast<VkPipeline>(m_pipeline), nullptr);
-		m_pipeline = nullptr;
+        // The pipeline might still be in use, so it's released once the frames in flight are done
+        VkDevice device = m_rhi_device->GetContextRhi()->device;
+        m_rhi_device->DeferredRelease_Add([device, pipeline = m_pipeline, pipeline_layout = m_pipeline_layout]()
+        {
+            vkDestroyPipeline(device, static_cast<VkPipeline>(pipeline), nullptr);
+            vkDestroyPipelineLayout(device, static_cast<VkPipelineLayout>(pipeline_layout), nullptr);
+        });
 
-		vkDestroyPipelineLayout(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineLayout>(m_pipeline_layout), nullptr);
-		m_pipeline_layout = nullptr;
+		m_pipeline          = nullptr;
+		m_pipeline_layout   = nullptr;
 	}
 }
 #endif
@@ -125,17 +125,26 @@ namespace Spartan
 
     void RHI_PipelineState::DestroyFrameResources()
     {
-        if (!m_rhi_device)
+        // The frame buffers are created after the render pass, so there is nothing to release without it
+        if (!m_rhi_device || !m_render_pass)
             return;
 
-        // Wait in case the buffer is still in use by the graphics queue
-        m_rhi_device->Queue_Wait(RHI_Queue_Graphics);
+        // The frame buffers and the render pass might still be in use, so they are released once the frames in flight are done
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+        m_rhi_device->DeferredRelease_Add([rhi_context, frame_buffers = vector<void*>(begin(m_frame_buffers), end(m_frame_buffers)), render_pass = m_render_pass]() mutable
+        {
+            for (auto& frame_buffer : frame_buffers)
+            {
+                vulkan_common::frame_buffer::destroy(rhi_context, frame_buffer);
+            }
+            vulkan_common::render_pass::destroy(rhi_context, render_pass);
+        });
 
         for (auto& frame_buffer : m_frame_buffers)
         {
-            vulkan_common::frame_buffer::destroy(m_rhi_device->GetContextRhi(), frame_buffer);
+            frame_buffer = nullptr;
         }
-        vulkan_common::render_pass::destroy(m_rhi_device->GetContextRhi(), m_render_pass);
+        m_render_pass = nullptr;
     }
 }
 #endif
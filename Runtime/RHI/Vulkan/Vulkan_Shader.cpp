@@ -226,6 +226,28 @@ namespace Spartan
 			{
 				DxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler), reinterpret_cast<void**>(&compiler));
 				DxcCreateInstance(CLSID_DxcLibrary, __uuidof(IDxcLibrary), reinterpret_cast<void**>(&library));
+
+                // Version (part of the shader cache key, a different compiler can produce different SPIR-V)
+                CComPtr<IDxcVersionInfo> version_info = nullptr;
+                if (compiler && SUCCEEDED(compiler->QueryInterface(__uuidof(IDxcVersionInfo), reinterpret_cast<void**>(&version_info))))
+                {
+                    uint32_t major = 0;
+                    uint32_t minor = 0;
+                    version_info->GetVersion(&major, &minor);
+                    version = to_string(major) + "." + to_string(minor);
+                }
+
+                CComPtr<IDxcVersionInfo2> version_info_2 = nullptr;
+                if (compiler && SUCCEEDED(compiler->QueryInterface(__uuidof(IDxcVersionInfo2), reinterpret_cast<void**>(&version_info_2))))
+                {
+                    uint32_t commit_count   = 0;
+                    char* commit_hash       = nullptr;
+                    if (SUCCEEDED(version_info_2->GetCommitInfo(&commit_count, &commit_hash)))
+                    {
+                        version += "." + to_string(commit_count) + " (" + string(commit_hash) + ")";
+                        CoTaskMemFree(commit_hash);
+                    }
+                }
 			}
 
 			static Instance& Get()
@@ -236,6 +258,7 @@ namespace Spartan
 
 			CComPtr<IDxcCompiler> compiler = nullptr;
 			CComPtr<IDxcLibrary> library = nullptr;
+            string version = "unknown";
 		};
 
 		typedef std::vector<uint8_t> Blob;
@@ -406,62 +429,87 @@ namespace Spartan
 			defines.emplace_back(DxcDefine{ define.first.c_str(), define.second.c_str() });
 		}
 
-		// Get shader source as a buffer
-		CComPtr<IDxcBlobEncoding> shader_blob = nullptr;
-		{
-			HRESULT result;
-			if (is_file)
-			{
-                const auto file_path = FileSystem::StringToWstring(shader);				
-				result = DxShaderCompiler::Instance::Get().library->CreateBlobFromFile(file_path.c_str(), nullptr, &shader_blob);
-			}
-			else // Source
-			{
-				result = DxShaderCompiler::Instance::Get().library->CreateBlobWithEncodingFromPinned(shader.c_str(), static_cast<uint32_t>(shader.size()), CP_UTF8, &shader_blob);
-			}
+        // Compiler signature, anything that affects the output but isn't the source, the defines, the entry point or the profile
+        string compiler_signature = "dxc " + DxShaderCompiler::Instance::Get().version;
+        for (const LPCWSTR argument : arguments)
+        {
+            compiler_signature += " " + string(CW2A(argument));
+        }
 
-			if (FAILED(result))
-			{
-				LOG_ERROR("Failed to create source buffer.");
-				return nullptr;
-			}
-		}
+        // Try the bytecode cache first, only compile on a miss
+        const uint64_t cache_key = Cache_ComputeKey(shader, compiler_signature);
+        vector<unsigned char> bytecode;
+        m_from_cache = Cache_Load(cache_key, bytecode);
+        if (!m_from_cache)
+        {
+            // Get shader source as a buffer
+            CComPtr<IDxcBlobEncoding> shader_blob = nullptr;
+            {
+                HRESULT result;
+                if (is_file)
+                {
+                    const auto file_path = FileSystem::StringToWstring(shader);				
+                    result = DxShaderCompiler::Instance::Get().library->CreateBlobFromFile(file_path.c_str(), nullptr, &shader_blob);
+                }
+                else // Source
+                {
+                    result = DxShaderCompiler::Instance::Get().library->CreateBlobWithEncodingFromPinned(shader.c_str(), static_cast<uint32_t>(shader.size()), CP_UTF8, &shader_blob);
+                }
 
-		// Compile
-        const CComPtr<IDxcIncludeHandler> include_handler = new DxShaderCompiler::SpartanIncludeHandler(file_directory);
-		CComPtr<IDxcOperationResult> compilation_result = nullptr;
-		{
-			if (FAILED(DxShaderCompiler::Instance::Get().compiler->Compile
-            (
-					shader_blob,												// shader blob
-					file_name.c_str(),											// file name (for warnings and errors)
-                    FileSystem::StringToWstring(GetEntryPoint()).c_str(),		// entry point function
-                    FileSystem::StringToWstring(GetTargetProfile()).c_str(),	// target profile
-					arguments.data(), static_cast<uint32_t>(arguments.size()),	// compilation arguments
-					defines.data(), static_cast<uint32_t>(defines.size()),		// shader defines
-					include_handler,											// handler for #include directives
-					&compilation_result))
-			){
-				LOG_ERROR("Failed to compile %s", file_name.c_str());
-				return nullptr;
-			}
+                if (FAILED(result))
+                {
+                    LOG_ERROR("Failed to create source buffer.");
+                    return nullptr;
+                }
+            }
+
+            // Compile
+            const CComPtr<IDxcIncludeHandler> include_handler = new DxShaderCompiler::SpartanIncludeHandler(file_directory);
+            CComPtr<IDxcOperationResult> compilation_result = nullptr;
+            {
+                if (FAILED(DxShaderCompiler::Instance::Get().compiler->Compile
+                (
+                        shader_blob,												// shader blob
+                        file_name.c_str(),											// file name (for warnings and errors)
+                        FileSystem::StringToWstring(GetEntryPoint()).c_str(),		// entry point function
+                        FileSystem::StringToWstring(GetTargetProfile()).c_str(),	// target profile
+                        arguments.data(), static_cast<uint32_t>(arguments.size()),	// compilation arguments
+                        defines.data(), static_cast<uint32_t>(defines.size()),		// shader defines
+                        include_handler,											// handler for #include directives
+                        &compilation_result))
+                ){
+                    LOG_ERROR("Failed to compile %s", file_name.c_str());
+                    return nullptr;
+                }
+
+                if (!DxShaderCompiler::ValidateOperationResult(compilation_result))
+                {
+                    LOG_ERROR("Failed to compile %s", shader.c_str());
+                    return nullptr;
+                }
+            }
+
+            // Get the SPIR-V
+            CComPtr<IDxcBlob> shader_compiled = nullptr;
+            if (FAILED(compilation_result->GetResult(&shader_compiled)) || !shader_compiled)
+            {
+                LOG_ERROR("Failed to get shader buffer.");
+                return nullptr;
+            }
+            const unsigned char* bytecode_begin = static_cast<const unsigned char*>(shader_compiled->GetBufferPointer());
+            bytecode.assign(bytecode_begin, bytecode_begin + shader_compiled->GetBufferSize());
+
+            // Cache it, so the next launch can skip compilation
+            Cache_Save(cache_key, bytecode);
+        }
 
-			if (!DxShaderCompiler::ValidateOperationResult(compilation_result))
-			{
-				LOG_ERROR("Failed to compile %s", shader.c_str());
-				return nullptr;
-			}
-		}
-		
 		// Create shader module
-		CComPtr<IDxcBlob> shader_compiled	= nullptr;
-		VkShaderModule shader_module		= nullptr;
-        if (SUCCEEDED(compilation_result->GetResult(&shader_compiled)))
+		VkShaderModule shader_module = nullptr;
         {
 			VkShaderModuleCreateInfo create_info = {};
 			create_info.sType		= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			create_info.codeSize	= static_cast<size_t>(shader_compiled->GetBufferSize());
-			create_info.pCode		= reinterpret_cast<const uint32_t*>(shader_compiled->GetBufferPointer());
+			create_info.codeSize	= static_cast<size_t>(bytecode.size());
+			create_info.pCode		= reinterpret_cast<const uint32_t*>(bytecode.data());
 	
 			if (vkCreateShaderModule(m_rhi_device->GetContextRhi()->device, &create_info, nullptr, &shader_module) == VK_SUCCESS)
 			{
@@ -469,8 +517,8 @@ namespace Spartan
 				_Reflect
 				(
                     m_shader_type,
-					reinterpret_cast<uint32_t*>(shader_compiled->GetBufferPointer()),
-					static_cast<uint32_t>(shader_compiled->GetBufferSize() / 4)
+					reinterpret_cast<const uint32_t*>(bytecode.data()),
+					static_cast<uint32_t>(bytecode.size() / 4)
 				);
 
                 // Create input layout
@@ -488,11 +536,6 @@ namespace Spartan
                 LOG_ERROR("Failed to create shader module.");
                 return nullptr;
             }
-		}	
-        else
-		{
-            LOG_ERROR("Failed to get shader buffer.");
-            return nullptr;
 		}
 
 		return static_cast<void*>(shader_module);
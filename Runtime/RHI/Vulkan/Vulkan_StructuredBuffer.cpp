@@ -0,0 +1,101 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= IMPLEMENTATION ===============
+#ifdef API_GRAPHICS_VULKAN
+#include "../RHI_Implementation.h"
+//================================
+
+//= INCLUDES =======================
+#include "../RHI_StructuredBuffer.h"
+#include "../RHI_Device.h"
+#include "../../Logging/Log.h"
+//==================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    RHI_StructuredBuffer::~RHI_StructuredBuffer()
+    {
+        // The buffer might still be in use, so it's released once the frames in flight are done
+        m_buffer_mapped = nullptr;
+        m_resource      = nullptr;
+        vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory);
+    }
+
+    bool RHI_StructuredBuffer::_Create()
+    {
+        if (!m_rhi_device || !m_rhi_device->GetContextRhi()->device)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Don't wait for the GPU, the previous buffer is released once the frames that might use it are done
+        m_buffer_mapped = nullptr;
+        m_resource      = nullptr;
+        vulkan_common::buffer::destroy_deferred(m_rhi_device.get(), m_buffer, m_buffer_memory);
+        ResourceIdUpdate();
+
+        // Create buffer
+        if (!vulkan_common::buffer::create(m_rhi_device->GetContextRhi(), m_buffer, m_buffer_memory, GetSize(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            return false;
+
+        // The allocator keeps host visible memory mapped, the memory is host coherent so writes need no flushing
+        m_buffer_mapped = vulkan_common::memory::map(m_buffer_memory);
+        if (!m_buffer_mapped)
+            return false;
+
+        m_resource = m_buffer;
+
+        // Set debug names
+        vulkan_common::debug::set_buffer_name(m_rhi_device->GetContextRhi()->device, static_cast<VkBuffer>(m_buffer), "structured_buffer");
+
+        return true;
+    }
+
+    void* RHI_StructuredBuffer::Map(const uint32_t index /*= 0*/) const
+    {
+        if (!m_buffer_mapped)
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return nullptr;
+        }
+
+        return static_cast<uint8_t*>(m_buffer_mapped) + static_cast<uint64_t>(index) * m_stride;
+    }
+
+    bool RHI_StructuredBuffer::Unmap() const
+    {
+        if (!m_buffer_mapped)
+        {
+            LOG_ERROR_INVALID_INTERNALS();
+            return false;
+        }
+
+        // The buffer stays mapped for its whole lifetime
+        return true;
+    }
+}
+#endif
@@ -30,6 +30,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_TextureCube.h"
 #include "../../Math/MathHelper.h"
 #include "../RHI_CommandList.h"
+#include "../RHI_UploadManager.h"
 //================================
 
 //= NAMESPACES ===============
@@ -44,15 +45,36 @@ namespace Spartan
         if (!m_rhi_device->IsInitialized())
             return;
 
-        m_rhi_device->Queue_WaitAll();
         m_data.clear();
-        const auto rhi_context = m_rhi_device->GetContextRhi();
-        vulkan_common::image::view::destroy(rhi_context, m_view_texture[0]);
-        vulkan_common::image::view::destroy(rhi_context, m_view_texture[1]);
-        vulkan_common::image::view::destroy(rhi_context, m_view_attachment_depth_stencil);
-        vulkan_common::frame_buffer::destroy(rhi_context, m_view_attachment_color);
-        vulkan_common::image::destroy(rhi_context, m_texture);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_resource_memory);
+
+        // The image might still be in use (or uploading), so it's released once the upload and the frames in flight are done
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+        m_rhi_device->GetUploadManager()->ReleaseAfter
+        (
+            m_upload_token,
+            [
+                rhi_context,
+                view_texture                            = vector<void*>{ m_view_texture[0], m_view_texture[1] },
+                view_attachment_color                   = move(m_view_attachment_color),
+                view_attachment_depth_stencil           = move(m_view_attachment_depth_stencil),
+                view_attachment_depth_stencil_read_only = move(m_view_attachment_depth_stencil_read_only),
+                texture                                 = m_texture,
+                resource_memory                         = m_resource_memory
+            ]() mutable
+            {
+                vulkan_common::image::view::destroy(rhi_context, view_texture);
+                vulkan_common::image::view::destroy(rhi_context, view_attachment_color);
+                vulkan_common::image::view::destroy(rhi_context, view_attachment_depth_stencil);
+                vulkan_common::image::view::destroy(rhi_context, view_attachment_depth_stencil_read_only);
+                vulkan_common::image::destroy(rhi_context, texture);
+                vulkan_common::memory::free(rhi_context, resource_memory);
+            }
+        );
+
+        m_view_texture[0]   = nullptr;
+        m_view_texture[1]   = nullptr;
+        m_texture           = nullptr;
+        m_resource_memory   = nullptr;
 	}
 
     void RHI_Texture::SetLayout(const RHI_Image_Layout layout, RHI_CommandList* command_list /*= nullptr*/)
@@ -73,6 +95,9 @@ namespace Spartan
 	{
         const RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
 
+        // New views, so descriptor sets written with the previous ones are never matched again
+        ResourceIdUpdate();
+
         // Get format support
         VkFormatFeatureFlags feature_flag   = IsRenderTargetDepthStencil() ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
         VkImageTiling image_tiling          = vulkan_common::image::is_format_supported(rhi_context, m_format, feature_flag);
@@ -93,9 +118,11 @@ namespace Spartan
 
         // Initialize
         SetLayout(RHI_Image_Preinitialized);
-        bool use_staging    = !m_data.empty();
+        bool use_staging    = HasData();
         auto image          = reinterpret_cast<VkImage*>(&m_texture);
-        auto image_memory   = reinterpret_cast<VkDeviceMemory*>(&m_resource_memory);
+
+        // Textures with data which are only sampled are uploaded asynchronously, on the transfer queue
+        const bool upload_async = use_staging && IsColorFormat() && !IsRenderTargetColor() && !IsRenderTargetDepthStencil();
 
         // Deduce usage flags
         VkImageUsageFlags usage_flags = 0;
@@ -112,139 +139,151 @@ namespace Spartan
 
         // Create image
         {
-            if (!vulkan_common::image::create(rhi_context, *image, m_width, m_height, m_mip_levels, m_array_size, vulkan_format[m_format], image_tiling, m_layout, usage_flags))
+            if (!vulkan_common::image::create(rhi_context, *image, m_width, m_height, m_mip_levels, m_array_size, vulkan_format[m_format], image_tiling, m_layout, usage_flags, upload_async))
             {
                 LOG_ERROR("Failed to create image");
                 return false;
             }
 
-            if (!vulkan_common::image::allocate_bind(rhi_context, *image, image_memory))
+            if (!vulkan_common::image::allocate_bind(rhi_context, *image, m_resource_memory))
             {
                 LOG_ERROR("Failed to allocate and bind image memory");
                 return false;
             }
         }
 
-        // Create command buffer (for later layout transitioning)
-        VkCommandBuffer cmd_buffer = vulkan_common::command_buffer_immediate::begin(m_rhi_device.get(), RHI_Queue_Graphics);
-
-        // Use staging if needed
-        void* stating_buffer        = nullptr;
-        void* staging_buffer_memory = nullptr;
-        if (use_staging)
+        if (upload_async)
         {
-            // Create buffer copy structs for each mip level
-            vector<VkBufferImageCopy> buffer_image_copies(m_mip_levels);
-            vector<uint64_t> mip_memory(m_array_size * m_mip_levels);
-            VkDeviceSize buffer_size = 0;
-            uint64_t offset = 0;
-            for (uint32_t array_index = 0; array_index < m_array_size; array_index++)
+            // Record the copy into the upload manager's batch, the texture becomes resident once that completes
+            m_upload_token = m_rhi_device->GetUploadManager()->UploadTexture(this);
+            if (m_upload_token == RHI_UploadManager::token_invalid)
             {
-                for (uint32_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
-                {
-                    uint32_t mip_width  = m_width >> mip_index;
-                    uint32_t mip_height = m_height >> mip_index;
-
-                    VkBufferImageCopy region				= {};
-                    region.bufferOffset						= offset;
-                    region.bufferRowLength					= 0;
-                    region.bufferImageHeight				= 0;
-                    region.imageSubresource.aspectMask      = vulkan_common::image::get_aspect_mask(this);
-                    region.imageSubresource.mipLevel		= mip_index;
-                    region.imageSubresource.baseArrayLayer	= array_index;
-                    region.imageSubresource.layerCount		= m_array_size;
-                    region.imageOffset						= { 0, 0, 0 };
-                    region.imageExtent						= { mip_width, mip_height, 1 };
-
-                    buffer_image_copies[mip_index] = region;
-
-                    // Update offset
-                    offset += static_cast<uint32_t>(m_data[mip_index].size());
-
-                    // Update memory requirements
-                    uint64_t memory_required = mip_width * mip_height * m_channels * (m_bpc / 8);
-                    mip_memory[array_index + mip_index] = memory_required;
-                    buffer_size += memory_required;
-                }
+                LOG_ERROR("Failed to upload texture");
+                return false;
             }
-            
-            // Create staging buffer
-            if (!vulkan_common::buffer::create(
-                rhi_context,
-                stating_buffer,
-                staging_buffer_memory,
-                buffer_size,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            )) return false;
-
-            // Copy mip levels to buffer
-            void* data = nullptr;
-            offset = 0;
-            if (vulkan_common::error::check(vkMapMemory(rhi_context->device, static_cast<VkDeviceMemory>(staging_buffer_memory), 0, buffer_size, 0, &data)))
+        }
+        else
+        {
+            // Create command buffer (for later layout transitioning)
+            VkCommandBuffer cmd_buffer = vulkan_common::command_buffer_immediate::begin(m_rhi_device.get(), RHI_Queue_Graphics);
+
+            // Use staging if needed
+            void* stating_buffer        = nullptr;
+            void* staging_buffer_memory = nullptr;
+            if (use_staging)
             {
+                const vector<RHI_Texture_Mip> mips = GetMipViews();
+
+                // Create buffer copy structs for each mip level
+                vector<VkBufferImageCopy> buffer_image_copies(m_mip_levels);
+                vector<uint64_t> mip_memory(m_array_size * m_mip_levels);
+                VkDeviceSize buffer_size = 0;
+                uint64_t offset = 0;
                 for (uint32_t array_index = 0; array_index < m_array_size; array_index++)
                 {
-                    for (uint32_t mip_level = 0; mip_level < m_mip_levels; mip_level++)
+                    for (uint32_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
                     {
-                        uint32_t index = array_index + mip_level;
-                        memcpy(static_cast<byte*>(data) + offset, m_data[index].data(), mip_memory[index]);
-                        offset += mip_memory[index];
+                        uint32_t mip_width  = m_width >> mip_index;
+                        uint32_t mip_height = m_height >> mip_index;
+
+                        VkBufferImageCopy region				= {};
+                        region.bufferOffset						= offset;
+                        region.bufferRowLength					= 0;
+                        region.bufferImageHeight				= 0;
+                        region.imageSubresource.aspectMask      = vulkan_common::image::get_aspect_mask(this);
+                        region.imageSubresource.mipLevel		= mip_index;
+                        region.imageSubresource.baseArrayLayer	= array_index;
+                        region.imageSubresource.layerCount		= m_array_size;
+                        region.imageOffset						= { 0, 0, 0 };
+                        region.imageExtent						= { mip_width, mip_height, 1 };
+
+                        buffer_image_copies[mip_index] = region;
+
+                        // Update offset
+                        offset += static_cast<uint32_t>(mips[mip_index].size);
+
+                        // Update memory requirements
+                        uint64_t memory_required = mip_width * mip_height * m_channels * (m_bpc / 8);
+                        mip_memory[array_index + mip_index] = memory_required;
+                        buffer_size += memory_required;
+                    }
+                }
+            
+                // Create staging buffer
+                if (!vulkan_common::buffer::create(
+                    rhi_context,
+                    stating_buffer,
+                    staging_buffer_memory,
+                    buffer_size,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                )) return false;
+
+                // Copy mip levels to buffer
+                offset = 0;
+                if (void* data = vulkan_common::memory::map(staging_buffer_memory))
+                {
+                    for (uint32_t array_index = 0; array_index < m_array_size; array_index++)
+                    {
+                        for (uint32_t mip_level = 0; mip_level < m_mip_levels; mip_level++)
+                        {
+                            uint32_t index = array_index + mip_level;
+                            memcpy(static_cast<byte*>(data) + offset, mips[index].data, mip_memory[index]);
+                            offset += mip_memory[index];
+                        }
                     }
                 }
 
-                vkUnmapMemory(rhi_context->device, static_cast<VkDeviceMemory>(staging_buffer_memory));
+                // Transition to RHI_Image_Transfer_Dst_Optimal
+                RHI_Image_Layout copy_layout = RHI_Image_Transfer_Dst_Optimal;
+                if (!vulkan_common::image::set_layout(m_rhi_device.get(), cmd_buffer, this, copy_layout))
+                    return false;
+
+                // Update layout
+                m_layout = copy_layout;
+
+                // Copy buffer to texture
+                vkCmdCopyBufferToImage(
+                    cmd_buffer,
+                    *reinterpret_cast<VkBuffer*>(&stating_buffer),
+                    static_cast<VkImage>(Get_Texture()),
+                    vulkan_image_layout[copy_layout],
+                    static_cast<uint32_t>(buffer_image_copies.size()),
+                    buffer_image_copies.data()
+                );
             }
 
-            // Transition to RHI_Image_Transfer_Dst_Optimal
-            RHI_Image_Layout copy_layout = RHI_Image_Transfer_Dst_Optimal;
-            if (!vulkan_common::image::set_layout(m_rhi_device.get(), cmd_buffer, this, copy_layout))
-                return false;
-
-            // Update layout
-            m_layout = copy_layout;
-
-            // Copy buffer to texture
-            vkCmdCopyBufferToImage(
-                cmd_buffer,
-                *reinterpret_cast<VkBuffer*>(&stating_buffer),
-                static_cast<VkImage>(Get_Texture()),
-                vulkan_image_layout[copy_layout],
-                static_cast<uint32_t>(buffer_image_copies.size()),
-                buffer_image_copies.data()
-            );
-        }
+            // Transition to target layout
+            {
+                // Deduce target layout
+                RHI_Image_Layout target_layout = m_layout;
 
-        // Transition to target layout
-        {
-            // Deduce target layout
-            RHI_Image_Layout target_layout = m_layout;
+                if (IsSampled() && IsColorFormat())
+                    target_layout = RHI_Image_Shader_Read_Only_Optimal;
 
-            if (IsSampled() && IsColorFormat())
-                target_layout = RHI_Image_Shader_Read_Only_Optimal;
+                if (IsRenderTargetColor())
+                    target_layout = RHI_Image_Color_Attachment_Optimal;
 
-            if (IsRenderTargetColor())
-                target_layout = RHI_Image_Color_Attachment_Optimal;
+                if (IsRenderTargetDepthStencil())
+                    target_layout = RHI_Image_Depth_Stencil_Attachment_Optimal;
 
-            if (IsRenderTargetDepthStencil())
-                target_layout = RHI_Image_Depth_Stencil_Attachment_Optimal;
+                // Transition
+                if (!vulkan_common::image::set_layout(m_rhi_device.get(), cmd_buffer, this, target_layout))
+                    return false;
 
-            // Transition
-            if (!vulkan_common::image::set_layout(m_rhi_device.get(), cmd_buffer, this, target_layout))
-                return false;
+                // Flush
+                if (!vulkan_common::command_buffer_immediate::end(RHI_Queue_Graphics))
+                    return false;
 
-            // Flush
-            if (!vulkan_common::command_buffer_immediate::end(RHI_Queue_Graphics))
-                return false;
+                // Update layout
+                m_layout = target_layout;
+            }
 
-            // Update layout
-            m_layout = target_layout;
+            // Free staging resources (must happen after we flush the command buffer
+            vulkan_common::buffer::destroy(rhi_context, stating_buffer);
+            vulkan_common::memory::free(rhi_context, staging_buffer_memory);
         }
 
-        // Free staging resources (must happen after we flush the command buffer
-        vulkan_common::buffer::destroy(rhi_context, stating_buffer);
-        vulkan_common::memory::free(rhi_context, staging_buffer_memory);
-
         // Create image views
         {
             string name = GetResourceName();
@@ -293,9 +332,19 @@ namespace Spartan
 	RHI_TextureCube::~RHI_TextureCube()
 	{
 		m_data.clear();
-        vkDestroyImageView(m_rhi_device->GetContextRhi()->device, reinterpret_cast<VkImageView>(m_view_texture), nullptr);
-		vkDestroyImage(m_rhi_device->GetContextRhi()->device, reinterpret_cast<VkImage>(m_texture), nullptr);
-		vulkan_common::memory::free(m_rhi_device->GetContextRhi(), m_resource_memory);
+
+        // The image might still be in use, so it's released once the frames in flight are done
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+        m_rhi_device->DeferredRelease_Add([rhi_context, view_texture = m_view_texture[0], texture = m_texture, resource_memory = m_resource_memory]() mutable
+        {
+            vulkan_common::image::view::destroy(rhi_context, view_texture);
+            vulkan_common::image::destroy(rhi_context, texture);
+            vulkan_common::memory::free(rhi_context, resource_memory);
+        });
+
+        m_view_texture[0]   = nullptr;
+        m_texture           = nullptr;
+        m_resource_memory   = nullptr;
 	}
 
 	bool RHI_TextureCube::CreateResourceGpu()
@@ -0,0 +1,493 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= IMPLEMENTATION ===============
+#ifdef API_GRAPHICS_VULKAN
+#include "../RHI_Implementation.h"
+//================================
+
+//= INCLUDES =====================
+#include "../RHI_UploadManager.h"
+#include "../RHI_Device.h"
+#include "../RHI_Texture.h"
+#include "Vulkan_Common.h"
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    // Buffer to image copies need offsets which are a multiple of the texel size (and 4), 16 covers every format we use
+    static const uint64_t staging_alignment = 16;
+
+    RHI_UploadManager::RHI_UploadManager(RHI_Device* rhi_device)
+    {
+        m_rhi_device                    = rhi_device;
+        const RHI_Context* rhi_context  = rhi_device->GetContextRhi();
+
+        if (!vulkan_common::command_pool::create(rhi_device, m_cmd_pool, RHI_Queue_Transfer))
+        {
+            LOG_ERROR("Failed to create command pool");
+            return;
+        }
+
+        if (!vulkan_common::buffer::create(rhi_context, m_staging_buffer, m_staging_buffer_memory, staging_ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            LOG_ERROR("Failed to create staging buffer");
+            return;
+        }
+        m_staging_mapped = static_cast<uint8_t*>(vulkan_common::memory::map(m_staging_buffer_memory));
+
+        vulkan_common::debug::set_buffer_name(rhi_context->device, static_cast<VkBuffer>(m_staging_buffer), "upload_staging_ring");
+    }
+
+    RHI_UploadManager::~RHI_UploadManager()
+    {
+        const RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+
+            // Finish everything, anything that's still recorded gets submitted first
+            BatchSubmit();
+            BatchesRetire(true);
+        }
+
+        // Run the releases which were waiting on uploads
+        m_rhi_device->DeferredRelease_Flush();
+
+        m_batches_free.insert(m_batches_free.end(), make_move_iterator(m_batches_waited.begin()), make_move_iterator(m_batches_waited.end()));
+        m_batches_waited.clear();
+        for (Batch& batch : m_batches_free)
+        {
+            vulkan_common::fence::destroy(rhi_context, batch.fence);
+            vulkan_common::command_buffer::free(rhi_context, m_cmd_pool, batch.cmd_buffer);
+        }
+        m_batches_free.clear();
+
+        vulkan_common::buffer::destroy(rhi_context, m_staging_buffer);
+        vulkan_common::memory::free(rhi_context, m_staging_buffer_memory);
+        m_staging_mapped = nullptr;
+
+        if (m_cmd_pool)
+        {
+            vulkan_common::command_pool::destroy(rhi_context, m_cmd_pool);
+        }
+    }
+
+    uint64_t RHI_UploadManager::UploadTexture(RHI_Texture* texture)
+    {
+        if (!texture || !texture->Get_Texture() || !texture->HasData())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return token_invalid;
+        }
+
+        // The mips might be mapped straight from the texture's file, in which case this is the only copy they go through
+        const auto data             = texture->GetMipViews();
+        const uint32_t mip_count    = texture->GetMiplevels();
+
+        // Every mip is transitioned to shader read only below, so every mip has to be written
+        if (data.size() < mip_count)
+        {
+            LOG_ERROR("The texture has data for %d of its %d mips", static_cast<uint32_t>(data.size()), mip_count);
+            return token_invalid;
+        }
+        const VkImage image         = static_cast<VkImage>(texture->Get_Texture());
+
+        // Everything goes into a single staging range
+        uint64_t size = 0;
+        for (uint32_t mip_index = 0; mip_index < mip_count; mip_index++)
+        {
+            size += (data[mip_index].size + staging_alignment - 1) / staging_alignment * staging_alignment;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        if (!BatchBegin())
+            return token_invalid;
+
+        void* staging_buffer    = nullptr;
+        uint64_t staging_offset = 0;
+        uint8_t* staging_mapped = nullptr;
+        if (!StagingAllocate(size, staging_alignment, staging_buffer, staging_offset, staging_mapped))
+            return token_invalid;
+
+        // Copy the mips into the staging memory and describe where they go
+        vector<VkBufferImageCopy> regions(mip_count);
+        uint64_t offset = 0;
+        for (uint32_t mip_index = 0; mip_index < mip_count; mip_index++)
+        {
+            memcpy(staging_mapped + offset, data[mip_index].data, data[mip_index].size);
+
+            VkBufferImageCopy& region               = regions[mip_index];
+            region.bufferOffset                     = staging_offset + offset;
+            region.bufferRowLength                  = 0;
+            region.bufferImageHeight                = 0;
+            region.imageSubresource.aspectMask      = vulkan_common::image::get_aspect_mask(texture);
+            region.imageSubresource.mipLevel        = mip_index;
+            region.imageSubresource.baseArrayLayer  = 0;
+            region.imageSubresource.layerCount      = texture->GetArraySize();
+            region.imageOffset                      = { 0, 0, 0 };
+            region.imageExtent                      = { Math::Max(texture->GetWidth() >> mip_index, 1u), Math::Max(texture->GetHeight() >> mip_index, 1u), 1 };
+
+            offset += (data[mip_index].size + staging_alignment - 1) / staging_alignment * staging_alignment;
+        }
+
+        const VkCommandBuffer cmd_buffer = static_cast<VkCommandBuffer>(m_batch_open.cmd_buffer);
+
+        VkImageMemoryBarrier barrier            = {};
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = image;
+        barrier.subresourceRange.aspectMask     = vulkan_common::image::get_aspect_mask(texture);
+        barrier.subresourceRange.baseMipLevel   = 0;
+        barrier.subresourceRange.levelCount     = texture->GetMiplevels();
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount     = texture->GetArraySize();
+
+        // Transition to transfer destination
+        barrier.oldLayout       = vulkan_image_layout[texture->GetLayout()];
+        barrier.newLayout       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask   = 0;
+        barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        // Copy
+        vkCmdCopyBufferToImage(cmd_buffer, static_cast<VkBuffer>(staging_buffer), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+        // Transition to shader read only. The transfer queue doesn't know about shader stages, but the texture
+        // isn't bound before the token completes (which is observed on the CPU), so that's all the ordering needed.
+        barrier.oldLayout       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout       = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask   = 0;
+        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        texture->SetLayout(RHI_Image_Shader_Read_Only_Optimal);
+
+        return m_batch_open.token;
+    }
+
+    uint64_t RHI_UploadManager::UploadBuffer(void* buffer, const void* data, const uint64_t size)
+    {
+        if (!buffer || !data || size == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return token_invalid;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+
+        if (!BatchBegin())
+            return token_invalid;
+
+        void* staging_buffer    = nullptr;
+        uint64_t staging_offset = 0;
+        uint8_t* staging_mapped = nullptr;
+        if (!StagingAllocate(size, staging_alignment, staging_buffer, staging_offset, staging_mapped))
+            return token_invalid;
+
+        memcpy(staging_mapped, data, size);
+
+        const VkCommandBuffer cmd_buffer = static_cast<VkCommandBuffer>(m_batch_open.cmd_buffer);
+
+        VkBufferCopy copy_region    = {};
+        copy_region.srcOffset       = staging_offset;
+        copy_region.dstOffset       = 0;
+        copy_region.size            = size;
+        vkCmdCopyBuffer(cmd_buffer, static_cast<VkBuffer>(staging_buffer), static_cast<VkBuffer>(buffer), 1, &copy_region);
+
+        // Make the copy available, the buffer is only used after the token completes
+        VkBufferMemoryBarrier barrier   = {};
+        barrier.sType                   = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask           = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask           = 0;
+        barrier.srcQueueFamilyIndex     = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex     = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer                  = static_cast<VkBuffer>(buffer);
+        barrier.offset                  = 0;
+        barrier.size                    = size;
+        vkCmdPipelineBarrier(cmd_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        return m_batch_open.token;
+    }
+
+    void RHI_UploadManager::Tick()
+    {
+        vector<function<void()>> releases;
+        {
+            lock_guard<mutex> lock(m_mutex);
+
+            BatchSubmit();
+            BatchesRetire(false);
+
+            // Hand over the releases whose uploads are done
+            for (auto it = m_releases.begin(); it != m_releases.end();)
+            {
+                if (IsComplete(it->first))
+                {
+                    releases.emplace_back(move(it->second));
+                    it = m_releases.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+
+        for (auto& release : releases)
+        {
+            m_rhi_device->DeferredRelease_Add(move(release));
+        }
+    }
+
+    bool RHI_UploadManager::Wait(const uint64_t token)
+    {
+        if (IsComplete(token))
+            return true;
+
+        if (token == token_invalid)
+            return false;
+
+        // Find the fence of the batch holding the token
+        void* fence = nullptr;
+        {
+            lock_guard<mutex> lock(m_mutex);
+
+            // The token might belong to the batch that's still recording
+            if (m_batch_open.recording && token >= m_batch_open.token)
+            {
+                if (!BatchSubmit())
+                    return false;
+            }
+
+            BatchesRetire(false);
+            if (IsComplete(token))
+                return true;
+
+            for (Batch& batch : m_batches_in_flight)
+            {
+                if (batch.token >= token)
+                {
+                    batch.waiters++;
+                    fence = batch.fence;
+                    break;
+                }
+            }
+
+            if (!fence)
+                return false;
+        }
+
+        // Wait without holding the lock, so that other threads can keep recording uploads
+        const bool result = vulkan_common::fence::wait(m_rhi_device->GetContextRhi(), fence);
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+
+            BatchesRetire(false);
+
+            // Let go of the batch, and recycle it if it was retired in the meantime
+            for (Batch& batch : m_batches_in_flight)
+            {
+                if (batch.fence == fence)
+                {
+                    batch.waiters--;
+                    break;
+                }
+            }
+            for (auto it = m_batches_waited.begin(); it != m_batches_waited.end(); it++)
+            {
+                if (it->fence == fence)
+                {
+                    if (--it->waiters == 0)
+                    {
+                        BatchRecycle(*it);
+                        m_batches_waited.erase(it);
+                    }
+                    break;
+                }
+            }
+        }
+
+        return result && IsComplete(token);
+    }
+
+    void RHI_UploadManager::ReleaseAfter(const uint64_t token, function<void()>&& release)
+    {
+        if (IsComplete(token) || token == token_invalid)
+        {
+            m_rhi_device->DeferredRelease_Add(move(release));
+            return;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        m_releases.emplace_back(token, move(release));
+    }
+
+    bool RHI_UploadManager::BatchBegin()
+    {
+        if (m_batch_open.recording)
+            return true;
+
+        const RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        // Re-use a retired batch or create a new one
+        if (!m_batches_free.empty())
+        {
+            m_batch_open = move(m_batches_free.back());
+            m_batches_free.pop_back();
+        }
+        else
+        {
+            m_batch_open = Batch();
+            if (!vulkan_common::command_buffer::create(rhi_context, m_cmd_pool, m_batch_open.cmd_buffer, VK_COMMAND_BUFFER_LEVEL_PRIMARY))
+                return false;
+
+            if (!vulkan_common::fence::create(rhi_context, m_batch_open.fence))
+                return false;
+        }
+
+        if (!vulkan_common::command_buffer::begin(m_batch_open.cmd_buffer))
+            return false;
+
+        m_batch_open.token      = m_token_next++;
+        m_batch_open.recording  = true;
+
+        return true;
+    }
+
+    bool RHI_UploadManager::BatchSubmit()
+    {
+        if (!m_batch_open.recording)
+            return true;
+
+        m_batch_open.recording  = false;
+        m_batch_open.ring_end   = m_ring_head;
+
+        if (!vulkan_common::command_buffer::end(m_batch_open.cmd_buffer))
+            return false;
+
+        if (!m_rhi_device->Queue_Submit(RHI_Queue_Transfer, m_batch_open.cmd_buffer, nullptr, m_batch_open.fence))
+            return false;
+
+        m_batches_in_flight.emplace_back(move(m_batch_open));
+        m_batch_open = Batch();
+
+        return true;
+    }
+
+    void RHI_UploadManager::BatchesRetire(const bool wait)
+    {
+        const RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        // Batches complete in submission order, so stop at the first one that's still running
+        while (!m_batches_in_flight.empty())
+        {
+            Batch& batch = m_batches_in_flight.front();
+
+            if (wait)
+            {
+                vulkan_common::fence::wait(rhi_context, batch.fence);
+            }
+            else if (vkGetFenceStatus(rhi_context->device, static_cast<VkFence>(batch.fence)) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            // Release the staging memory
+            m_ring_tail = batch.ring_end;
+            for (auto& staging : batch.staging_dedicated)
+            {
+                vulkan_common::buffer::destroy(rhi_context, staging.first);
+                vulkan_common::memory::free(rhi_context, staging.second);
+            }
+            batch.staging_dedicated.clear();
+
+            m_token_completed = batch.token;
+
+            // Recycle, unless a thread is still waiting on the fence (resetting it under a wait isn't allowed)
+            if (batch.waiters == 0)
+            {
+                BatchRecycle(batch);
+            }
+            else
+            {
+                m_batches_waited.emplace_back(move(batch));
+            }
+            m_batches_in_flight.pop_front();
+        }
+    }
+
+    void RHI_UploadManager::BatchRecycle(Batch& batch)
+    {
+        vulkan_common::fence::reset(m_rhi_device->GetContextRhi(), batch.fence);
+        vkResetCommandBuffer(static_cast<VkCommandBuffer>(batch.cmd_buffer), 0);
+        m_batches_free.emplace_back(move(batch));
+    }
+
+    bool RHI_UploadManager::StagingAllocate(const uint64_t size, const uint64_t alignment, void*& buffer, uint64_t& offset, uint8_t*& mapped)
+    {
+        // Free whatever the GPU is done with
+        BatchesRetire(false);
+
+        if (m_staging_mapped && size <= staging_ring_size)
+        {
+            // Align, and skip to the start of the ring if the allocation would wrap
+            uint64_t head           = (m_ring_head + alignment - 1) / alignment * alignment;
+            const uint64_t physical = head % staging_ring_size;
+            if (physical + size > staging_ring_size)
+            {
+                head += staging_ring_size - physical;
+            }
+
+            if (head + size - m_ring_tail <= staging_ring_size)
+            {
+                m_ring_head = head + size;
+                buffer      = m_staging_buffer;
+                offset      = head % staging_ring_size;
+                mapped      = m_staging_mapped + offset;
+                return true;
+            }
+        }
+
+        // The ring is full (or the upload is huge), use a dedicated staging buffer instead of waiting for the GPU
+        void* staging_buffer        = nullptr;
+        void* staging_buffer_memory = nullptr;
+        if (!vulkan_common::buffer::create(m_rhi_device->GetContextRhi(), staging_buffer, staging_buffer_memory, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            LOG_ERROR("Failed to create staging buffer");
+            return false;
+        }
+        m_batch_open.staging_dedicated.emplace_back(staging_buffer, staging_buffer_memory);
+
+        buffer  = staging_buffer;
+        offset  = 0;
+        mapped  = static_cast<uint8_t*>(vulkan_common::memory::map(staging_buffer_memory));
+        return mapped != nullptr;
+    }
+}
+#endif
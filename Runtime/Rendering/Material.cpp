@@ -28,6 +28,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../World/World.h"
+#include "../World/Components/Renderable.h"
 //====================================
 
 //= NAMESPACES ===============
@@ -87,7 +88,9 @@ namespace Spartan
 			{
 				texture = m_context->GetSubsystem<ResourceCache>()->Load<RHI_Texture2D>(tex_path);
 			}
-			SetTextureSlot(tex_type, texture);
+
+			// Don't acquire a shader per texture, every intermediate combination would get compiled
+			_SetTextureSlot(tex_type, texture);
 		}
 
 		AcquireShader();
@@ -129,6 +132,12 @@ namespace Spartan
 	}
 
 	void Material::SetTextureSlot(const TextureType type, const shared_ptr<RHI_Texture>& texture)
+	{
+		_SetTextureSlot(type, texture);
+		AcquireShader();
+	}
+
+	void Material::_SetTextureSlot(const TextureType type, const shared_ptr<RHI_Texture>& texture)
 	{
 		if (texture)
 		{
@@ -142,7 +151,6 @@ namespace Spartan
 		}
 
 		SetMultiplier(type, 1.0f);
-		AcquireShader();
 	}
 
 	void Material::SetTextureSlot(const TextureType type, const std::shared_ptr<RHI_Texture2D>& texture)
@@ -210,6 +218,11 @@ namespace Spartan
 
 		// Add a shader to the pool based on this material, if a 
 		// matching shader already exists, it will be returned.
+		m_shader = GetOrCreateShader(GetShaderFlags());
+	}
+
+	unsigned long Material::GetShaderFlags() const
+	{
 		unsigned long shader_flags = 0;
 
 		if (HasTexture(TextureType_Albedo))		shader_flags	|= Variation_Albedo;
@@ -221,7 +234,7 @@ namespace Spartan
 		if (HasTexture(TextureType_Emission))	shader_flags	|= Variation_Emission;
 		if (HasTexture(TextureType_Mask))		shader_flags	|= Variation_Mask;
 
-		m_shader = GetOrCreateShader(shader_flags);
+		return shader_flags;
 	}
 
 	std::shared_ptr<ShaderVariation> Material::GetOrCreateShader(const unsigned long shader_flags)
@@ -233,30 +246,49 @@ namespace Spartan
 			return empty;
 		}
 
-		// If an appropriate shader already exists, return it instead
-		if (const auto& existing_shader = ShaderVariation::GetMatchingShader(shader_flags))
-			return existing_shader;
-
-		// Create and compile shader
-		auto shader = make_shared<ShaderVariation>(m_rhi_device, m_context);
-		const auto dir_shaders = m_context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/";
-		shader->Compile(dir_shaders + "GBuffer.hlsl", shader_flags);
-
-		return shader;
+		// Returns the existing shader if there is one, otherwise creates and compiles it
+		return ShaderVariation::GetOrCreate(m_context, shader_flags);
 	}
 
     void Material::SetColorAlbedo(const Math::Vector4& color)
     {
-        // If an object switches from opaque to transparent or vice versa, make the world update so that the renderer
-        // goes through the entities and makes the ones that use this material, render in the correct mode.
+        // If an object switches from opaque to transparent or vice versa, mark the entities that use this material
+        // as changed, so that the renderer moves them to the render list of the correct mode.
         if ((m_color_albedo.w != 1.0f && color.w == 1.0f) || (m_color_albedo.w == 1.0f && color.w != 1.0f))
         {
-            m_context->GetSubsystem<World>()->MakeDirty();
+            // This can run on a worker (e.g. model importing), the world is locked first so that none of the entities can be removed
+            // (and destroyed) while they are marked, that's also the order in which a renderable that's being removed locks.
+            World* world = m_context->GetSubsystem<World>();
+            lock_guard<recursive_mutex> lock_world(world->GetMutex());
+            lock_guard<mutex> lock(m_renderables_mutex);
+
+            for (Renderable* renderable : m_renderables)
+            {
+                world->EntityMarkChanged(renderable->GetEntity());
+            }
         }
 
         m_color_albedo = color;
     }
 
+    void Material::RenderableAdd(Renderable* renderable)
+    {
+        lock_guard<mutex> lock(m_renderables_mutex);
+        m_renderables.emplace_back(renderable);
+    }
+
+    void Material::RenderableRemove(Renderable* renderable)
+    {
+        lock_guard<mutex> lock(m_renderables_mutex);
+
+        const auto it = find(m_renderables.begin(), m_renderables.end(), renderable);
+        if (it != m_renderables.end())
+        {
+            *it = m_renderables.back();
+            m_renderables.pop_back();
+        }
+    }
+
     TextureType Material::TextureTypeFromString(const string& type)
 	{
 		if (type == "Albedo")		return TextureType_Albedo;
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <map>
+#include <vector>
+#include <mutex>
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/Vector2.h"
@@ -35,6 +37,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {	
 	class ShaderVariation;
+	class Renderable;
 
 	enum TextureType
 	{
@@ -74,6 +77,7 @@ namespace Spartan
 
 		//= SHADER ====================================================================
 		void AcquireShader();
+		unsigned long GetShaderFlags() const;
 		std::shared_ptr<ShaderVariation> GetOrCreateShader(unsigned long shader_flags);
 		const auto& GetShader() const { return m_shader; }
 		auto HasShader()		const { return GetShader() != nullptr; }
@@ -98,7 +102,13 @@ namespace Spartan
 		static TextureType TextureTypeFromString(const std::string& type);
 		//=======================================================================================================
 
+		// The renderables which use this material, they register themselves so they can be reached without scanning the world
+		void RenderableAdd(Renderable* renderable);
+		void RenderableRemove(Renderable* renderable);
+
 	private:
+		void _SetTextureSlot(const TextureType type, const std::shared_ptr<RHI_Texture>& texture);
+
 		Math::Vector4 m_color_albedo	= Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f);
 		Math::Vector2 m_uv_tiling		= Math::Vector2(1.0f, 1.0f);
 		Math::Vector2 m_uv_offset		= Math::Vector2(0.0f, 0.0f);
@@ -108,5 +118,7 @@ namespace Spartan
 		std::shared_ptr<ShaderVariation> m_shader;	
 		std::shared_ptr<RHI_Texture> m_texture_empty;
 		std::shared_ptr<RHI_Device> m_rhi_device;
+		std::vector<Renderable*> m_renderables;
+		std::mutex m_renderables_mutex;
 	};
 }
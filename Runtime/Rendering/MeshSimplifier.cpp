@@ -0,0 +1,387 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===============
+#include "MeshSimplifier.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+//==========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::MeshSimplifier
+{
+    namespace
+    {
+        struct Position
+        {
+            double x, y, z;
+        };
+
+        Position subtract(const Position& a, const Position& b)  { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+        Position cross(const Position& a, const Position& b)     { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+        double dot(const Position& a, const Position& b)         { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+        // The sum of the squared distances to a set of planes, as a symmetric 4x4 matrix, weighted by the area of the triangles they came from
+        struct Quadric
+        {
+            double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+            double b2 = 0.0, bc = 0.0, bd = 0.0;
+            double c2 = 0.0, cd = 0.0;
+            double d2 = 0.0;
+            double weight = 0.0;
+
+            void AddPlane(const Position& n, const double d, const double w)
+            {
+                a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+                b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+                c2 += w * n.z * n.z; cd += w * n.z * d;
+                d2 += w * d * d;
+                weight += w;
+            }
+
+            void Add(const Quadric& q)
+            {
+                a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+                b2 += q.b2; bc += q.bc; bd += q.bd;
+                c2 += q.c2; cd += q.cd;
+                d2 += q.d2;
+                weight += q.weight;
+            }
+
+            // Mean squared distance of p to the planes
+            static double Error(const Quadric& a, const Quadric& b, const Position& p)
+            {
+                const double x = p.x, y = p.y, z = p.z;
+                const double e =
+                    (a.a2 + b.a2) * x * x + 2.0 * (a.ab + b.ab) * x * y + 2.0 * (a.ac + b.ac) * x * z + 2.0 * (a.ad + b.ad) * x +
+                    (a.b2 + b.b2) * y * y + 2.0 * (a.bc + b.bc) * y * z + 2.0 * (a.bd + b.bd) * y +
+                    (a.c2 + b.c2) * z * z + 2.0 * (a.cd + b.cd) * z +
+                    (a.d2 + b.d2);
+
+                const double weight = a.weight + b.weight;
+                return weight > 0.0 ? max(e, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from;  // vertex
+            uint32_t to;    // vertex
+            double error;
+        };
+
+        uint64_t edge_key(const uint32_t a, const uint32_t b)
+        {
+            return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+        }
+    }
+
+    float Simplify(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count, const uint32_t* indices, const uint32_t index_count, const uint32_t index_count_target, vector<uint32_t>* result)
+    {
+        result->assign(indices, indices + index_count);
+        if (vertex_count == 0 || index_count < 3 || index_count <= index_count_target)
+            return 0.0f;
+
+        // Positions in the unit sphere of the vertices, so that errors are relative to their radius
+        vector<Position> positions(vertex_count);
+        {
+            double min[3] = { vertices[0].pos[0], vertices[0].pos[1], vertices[0].pos[2] };
+            double max[3] = { min[0], min[1], min[2] };
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    min[axis] = std::min(min[axis], static_cast<double>(vertices[i].pos[axis]));
+                    max[axis] = std::max(max[axis], static_cast<double>(vertices[i].pos[axis]));
+                }
+            }
+
+            const Position center   = { (min[0] + max[0]) * 0.5, (min[1] + max[1]) * 0.5, (min[2] + max[2]) * 0.5 };
+            const Position extent   = { max[0] - center.x, max[1] - center.y, max[2] - center.z };
+            const double radius     = sqrt(dot(extent, extent));
+            const double scale      = radius > 0.0 ? 1.0 / radius : 1.0;
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                positions[i] = { (vertices[i].pos[0] - center.x) * scale, (vertices[i].pos[1] - center.y) * scale, (vertices[i].pos[2] - center.z) * scale };
+            }
+        }
+
+        // Vertices which share a position (e.g. both sides of a uv seam) share an id, the topology is built on these ids
+        vector<uint32_t> ids(vertex_count);
+        vector<uint32_t> id_vertex_count(vertex_count, 0);
+        {
+            struct PositionHash
+            {
+                size_t operator()(const Position& p) const
+                {
+                    uint64_t bits[3];
+                    memcpy(bits, &p, sizeof(bits));
+                    return static_cast<size_t>(bits[0] * 73856093ull ^ bits[1] * 19349663ull ^ bits[2] * 83492791ull);
+                }
+            };
+            struct PositionEqual
+            {
+                bool operator()(const Position& a, const Position& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+            };
+
+            unordered_map<Position, uint32_t, PositionHash, PositionEqual> position_ids;
+            position_ids.reserve(vertex_count);
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                ids[i] = position_ids.emplace(positions[i], i).first->second;
+                id_vertex_count[ids[i]]++;
+            }
+        }
+
+        // Seams and borders stay where they are, moving them would tear the mesh open or stretch its attributes
+        vector<uint8_t> locked(vertex_count, 0);
+        {
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                locked[ids[i]] |= id_vertex_count[ids[i]] > 1 ? 1 : 0;
+            }
+
+            unordered_map<uint64_t, uint32_t> edge_use;
+            edge_use.reserve(index_count);
+            for (uint32_t i = 0; i < index_count; i += 3)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    edge_use[edge_key(ids[indices[i + corner]], ids[indices[i + (corner + 1) % 3]])]++;
+                }
+            }
+
+            for (const auto& edge : edge_use)
+            {
+                if (edge.second != 2)
+                {
+                    locked[static_cast<uint32_t>(edge.first >> 32)]            = 1;
+                    locked[static_cast<uint32_t>(edge.first & 0xFFFFFFFF)]     = 1;
+                }
+            }
+        }
+
+        // Every id starts with the planes of the triangles around it
+        vector<Quadric> quadrics(vertex_count);
+        for (uint32_t i = 0; i < index_count; i += 3)
+        {
+            const Position& p0  = positions[indices[i + 0]];
+            const Position n    = cross(subtract(positions[indices[i + 1]], p0), subtract(positions[indices[i + 2]], p0));
+            const double length = sqrt(dot(n, n));
+            if (length == 0.0)
+                continue;
+
+            const Position normal   = { n.x / length, n.y / length, n.z / length };
+            const double d          = -dot(normal, p0);
+            const double area       = length * 0.5;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                quadrics[ids[indices[i + corner]]].AddPlane(normal, d, area);
+            }
+        }
+
+        vector<uint32_t>& current = *result;
+        vector<uint32_t> remap(vertex_count);
+        vector<uint8_t> touched(vertex_count);
+        vector<uint32_t> triangle_offsets(vertex_count + 1);
+        vector<uint32_t> triangles;
+        vector<Collapse> collapses;
+        double error_max = 0.0;
+
+        // Every pass collapses the cheapest edges which don't share a neighbourhood, until the target is met or nothing can collapse
+        while (current.size() > index_count_target)
+        {
+            const auto current_count = static_cast<uint32_t>(current.size());
+
+            // The triangles around every id
+            fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+            for (uint32_t i = 0; i < current_count; i++)
+            {
+                triangle_offsets[ids[current[i]] + 1]++;
+            }
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                triangle_offsets[i + 1] += triangle_offsets[i];
+            }
+            triangles.resize(current_count);
+            {
+                vector<uint32_t> cursor(triangle_offsets.begin(), triangle_offsets.end() - 1);
+                for (uint32_t i = 0; i < current_count; i++)
+                {
+                    triangles[cursor[ids[current[i]]]++] = i / 3;
+                }
+            }
+
+            // The cheapest collapse of every vertex which can move
+            collapses.clear();
+            {
+                vector<uint32_t> best(vertex_count, numeric_limits<uint32_t>::max());
+                for (uint32_t i = 0; i < current_count; i += 3)
+                {
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        for (uint32_t other = 1; other < 3; other++)
+                        {
+                            const uint32_t from = current[i + corner];
+                            const uint32_t to   = current[i + (corner + other) % 3];
+                            if (locked[ids[from]] || ids[from] == ids[to])
+                                continue;
+
+                            const double error = Quadric::Error(quadrics[ids[from]], quadrics[ids[to]], positions[to]);
+                            if (best[from] == numeric_limits<uint32_t>::max())
+                            {
+                                best[from] = static_cast<uint32_t>(collapses.size());
+                                collapses.push_back({ from, to, error });
+                            }
+                            else if (error < collapses[best[from]].error)
+                            {
+                                collapses[best[from]] = { from, to, error };
+                            }
+                        }
+                    }
+                }
+            }
+            sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            // Apply them, cheapest first
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                remap[i] = i;
+            }
+            fill(touched.begin(), touched.end(), static_cast<uint8_t>(0));
+
+            const uint32_t triangles_to_remove  = (current_count - index_count_target) / 3;
+            uint32_t triangles_removed          = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (triangles_removed >= triangles_to_remove)
+                    break;
+
+                const uint32_t id_from  = ids[collapse.from];
+                const uint32_t id_to    = ids[collapse.to];
+                if (touched[id_from] || touched[id_to])
+                    continue;
+
+                // Reject collapses which would flip a triangle
+                bool flips          = false;
+                uint32_t removes    = 0;
+                for (uint32_t t = triangle_offsets[id_from]; t < triangle_offsets[id_from + 1] && !flips; t++)
+                {
+                    const uint32_t* triangle = &current[triangles[t] * 3];
+                    if (ids[triangle[0]] == id_to || ids[triangle[1]] == id_to || ids[triangle[2]] == id_to)
+                    {
+                        removes++;
+                        continue;
+                    }
+
+                    Position p[3];
+                    Position q[3];
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        p[corner] = positions[triangle[corner]];
+                        q[corner] = ids[triangle[corner]] == id_from ? positions[collapse.to] : p[corner];
+                    }
+                    const Position n_before = cross(subtract(p[1], p[0]), subtract(p[2], p[0]));
+                    const Position n_after  = cross(subtract(q[1], q[0]), subtract(q[2], q[0]));
+                    flips = dot(n_before, n_after) <= 0.0;
+                }
+                if (flips)
+                    continue;
+
+                remap[collapse.from] = collapse.to;
+                quadrics[id_to].Add(quadrics[id_from]);
+                error_max           = max(error_max, collapse.error);
+                triangles_removed   += removes;
+
+                // The neighbourhood changed, so nothing else around it collapses during this pass
+                for (uint32_t t = triangle_offsets[id_from]; t < triangle_offsets[id_from + 1]; t++)
+                {
+                    const uint32_t* triangle = &current[triangles[t] * 3];
+                    touched[ids[triangle[0]]] = 1;
+                    touched[ids[triangle[1]]] = 1;
+                    touched[ids[triangle[2]]] = 1;
+                }
+            }
+
+            if (triangles_removed == 0)
+                break;
+
+            // Rebuild the triangles, dropping the ones which collapsed
+            uint32_t write = 0;
+            for (uint32_t i = 0; i < current_count; i += 3)
+            {
+                const uint32_t a = remap[current[i + 0]];
+                const uint32_t b = remap[current[i + 1]];
+                const uint32_t c = remap[current[i + 2]];
+                if (ids[a] == ids[b] || ids[b] == ids[c] || ids[a] == ids[c])
+                    continue;
+
+                current[write++] = a;
+                current[write++] = b;
+                current[write++] = c;
+            }
+            current.resize(write);
+        }
+
+        return static_cast<float>(sqrt(error_max));
+    }
+
+    void SimplifyLevels(
+        const RHI_Vertex_PosTexNorTan* vertices,
+        const uint32_t vertex_count,
+        const uint32_t* indices,
+        uint32_t index_count,
+        const uint32_t level_count_max,
+        const uint32_t index_count_min,
+        vector<vector<uint32_t>>* levels,
+        vector<float>* errors
+    )
+    {
+        float error = 0.0f;
+        while (levels->size() < level_count_max)
+        {
+            const uint32_t index_count_target = (index_count / 6) * 3;
+            if (index_count_target < index_count_min)
+                break;
+
+            vector<uint32_t> result;
+            const float level_error = Simplify(vertices, vertex_count, indices, index_count, index_count_target, &result);
+
+            // Not worth a level when it barely reduced anything
+            if (result.empty() || result.size() > (static_cast<size_t>(index_count) * 3) / 4)
+                break;
+
+            // Errors are measured against the previous level, so they add up
+            error += level_error;
+            levels->emplace_back(move(result));
+            errors->emplace_back(error);
+
+            indices     = levels->back().data();
+            index_count = static_cast<uint32_t>(levels->back().size());
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include "../Core/EngineDefs.h"
+#include "../RHI/RHI_Vertex.h"
+//=============================
+
+namespace Spartan::MeshSimplifier
+{
+    // Quadric edge collapse (Garland and Heckbert), restricted to collapsing a vertex onto one of its neighbours, so the
+    // result is a new index list for the same vertices. Vertices on borders and attribute seams never move, so the
+    // result can end up above the target when a mesh has a lot of them. Returns the error of the result, as a fraction
+    // of the radius of the vertices (so it's independent of the mesh's scale).
+    SPARTAN_CLASS float Simplify(
+        const RHI_Vertex_PosTexNorTan* vertices,
+        uint32_t vertex_count,
+        const uint32_t* indices,
+        uint32_t index_count,
+        uint32_t index_count_target,
+        std::vector<uint32_t>* result
+    );
+
+    // What models are imported with
+    constexpr uint32_t level_count_max          = 3;
+    constexpr uint32_t level_index_count_min    = 64 * 3;
+
+    // The levels of detail of a mesh, each one aims for half the triangles of the previous one. It stops at level_count_max
+    // levels, once a level would have fewer than index_count_min indices, or once a level barely reduces anything (borders
+    // and seams can't collapse). The errors add up, so each one is measured against the full detail mesh.
+    SPARTAN_CLASS void SimplifyLevels(
+        const RHI_Vertex_PosTexNorTan* vertices,
+        uint32_t vertex_count,
+        const uint32_t* indices,
+        uint32_t index_count,
+        uint32_t level_count_max,
+        uint32_t index_count_min,
+        std::vector<std::vector<uint32_t>>* levels,
+        std::vector<float>* errors
+    );
+}
@@ -24,7 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Mesh.h"
 #include "Renderer.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetContainer.h"
 #include "../Core/Stopwatch.h"
+#include "../Threading/Threading.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ModelImporter.h"
 #include "../World/Entity.h"
@@ -42,6 +44,32 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // Chunks of an engine model file
+        constexpr uint32_t chunk_header     = asset_chunk_type('M', 'D', 'H', 'D');
+        constexpr uint32_t chunk_path       = asset_chunk_type('P', 'A', 'T', 'H');
+        constexpr uint32_t chunk_indices    = asset_chunk_type('I', 'D', 'X', ' ');
+        constexpr uint32_t chunk_vertices   = asset_chunk_type('V', 'T', 'X', ' ');
+        constexpr uint32_t chunk_lods       = asset_chunk_type('L', 'O', 'D', 'S');
+
+        struct ModelHeader
+        {
+            float normalized_scale;
+            uint32_t index_count;
+            uint32_t vertex_count;
+            uint32_t padding;
+        };
+
+        struct ModelLod
+        {
+            uint32_t base_index_offset;
+            uint32_t index_offset;
+            uint32_t index_count;
+            float error;
+        };
+    }
+
 	Model::Model(Context* context) : IResource(context, Resource_Model)
 	{
 		m_resource_manager	= m_context->GetSubsystem<ResourceCache>();
@@ -60,6 +88,7 @@ namespace Spartan
         m_vertex_buffer.reset();
         m_index_buffer.reset();
         m_mesh->Geometry_Clear();
+        m_lods.clear();
         m_aabb.Undefine();
         m_normalized_scale = 1.0f;
         m_is_animated = false;
@@ -76,7 +105,47 @@ namespace Spartan
         }
 
         // Load engine format
-        if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
+        if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL && AssetContainer::IsContainer(file_path))
+        {
+            AssetContainer container;
+            if (!container.Open(file_path))
+                return false;
+
+            uint64_t index_count                        = 0;
+            uint64_t vertex_count                       = 0;
+            const ModelHeader* header                   = container.GetChunk<ModelHeader>(chunk_header);
+            const uint32_t* indices                     = container.GetChunk<uint32_t>(chunk_indices, 0, &index_count);
+            const RHI_Vertex_PosTexNorTan* vertices     = container.GetChunk<RHI_Vertex_PosTexNorTan>(chunk_vertices, 0, &vertex_count);
+            if (!header || !indices || !vertices || header->index_count != index_count || header->vertex_count != vertex_count)
+            {
+                LOG_ERROR("\"%s\" is missing chunks", file_path.c_str());
+                return false;
+            }
+
+            SetResourceFilePath(container.GetChunkString(chunk_path));
+
+            // Optional, models saved before LODs existed don't have them
+            uint64_t lod_count = 0;
+            if (const ModelLod* lods = container.GetChunk<ModelLod>(chunk_lods, 0, &lod_count))
+            {
+                for (uint64_t i = 0; i < lod_count; i++)
+                {
+                    if (static_cast<uint64_t>(lods[i].index_offset) + lods[i].index_count <= index_count)
+                    {
+                        m_lods[lods[i].base_index_offset].push_back({ lods[i].index_offset, lods[i].index_count, lods[i].error });
+                    }
+                }
+            }
+
+            // The GPU buffers are filled straight from the mapping, the mesh keeps a CPU copy for sub-mesh queries
+            m_mesh->Indices_Get().assign(indices, indices + index_count);
+            m_mesh->Vertices_Get().assign(vertices, vertices + vertex_count);
+            GeometryCreateBuffers(indices, static_cast<uint32_t>(index_count), vertices, static_cast<uint32_t>(vertex_count));
+            m_normalized_scale  = GeometryComputeNormalizedScale();
+            m_aabb              = GeometryComputeAabb();
+        }
+        // Load engine format (saved before the container format existed)
+        else if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
         {
             // Deserialize
             auto file = make_unique<FileStream>(file_path, FileStream_Read);
@@ -128,18 +197,31 @@ namespace Spartan
 
 	bool Model::SaveToFile(const string& file_path)
 	{
-		auto file = make_unique<FileStream>(file_path, FileStream_Write);
-		if (!file->IsOpen())
-			return false;
-
-		file->Write(GetResourceFilePath());
-		file->Write(m_normalized_scale);
-		file->Write(m_mesh->Indices_Get());
-		file->Write(m_mesh->Vertices_Get());
-
-        file->Close();
+        ModelHeader header          = {};
+        header.normalized_scale     = m_normalized_scale;
+        header.index_count          = m_mesh->Indices_Count();
+        header.vertex_count         = m_mesh->Vertices_Count();
+
+        AssetContainerWriter writer;
+        writer.AddChunk(chunk_header, 0, &header, sizeof(header));
+        writer.AddChunk(chunk_path, 0, GetResourceFilePath());
+        writer.AddChunk(chunk_indices, 0, m_mesh->Indices_Get());
+        writer.AddChunk(chunk_vertices, 0, m_mesh->Vertices_Get());
+
+        if (!m_lods.empty())
+        {
+            vector<ModelLod> lods;
+            for (const auto& mesh_lods : m_lods)
+            {
+                for (const MeshLod& lod : mesh_lods.second)
+                {
+                    lods.push_back({ mesh_lods.first, lod.index_offset, lod.index_count, lod.error });
+                }
+            }
+            writer.AddChunk(chunk_lods, 0, lods);
+        }
 
-		return true;
+		return writer.Save(file_path);
 	}
 
 	void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset) const
@@ -155,6 +237,27 @@ namespace Spartan
 		m_mesh->Vertices_Append(vertices, vertex_offset);
 	}
 
+    void Model::AppendLod(const uint32_t index_offset, const vector<uint32_t>& indices, const float error)
+    {
+        if (indices.empty())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        MeshLod lod;
+        lod.index_count = static_cast<uint32_t>(indices.size());
+        lod.error       = error;
+        m_mesh->Indices_Append(indices, &lod.index_offset);
+        m_lods[index_offset].push_back(lod);
+    }
+
+    const vector<MeshLod>* Model::GetLods(const uint32_t index_offset) const
+    {
+        const auto it = m_lods.find(index_offset);
+        return it != m_lods.end() ? &it->second : nullptr;
+    }
+
 	void Model::GetGeometry(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
 	{
 		m_mesh->Geometry_Get(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
@@ -168,9 +271,9 @@ namespace Spartan
 			return;
 		}
 
-		GeometryCreateBuffers();
+		GeometryCreateBuffers(m_mesh->Indices_Get().data(), m_mesh->Indices_Count(), m_mesh->Vertices_Get().data(), m_mesh->Vertices_Count());
 		m_normalized_scale	= GeometryComputeNormalizedScale();
-		m_aabb				= BoundingBox(m_mesh->Vertices_Get());
+		m_aabb				= GeometryComputeAabb();
 	}
 
 	void Model::AddMaterial(shared_ptr<Material>& material, const shared_ptr<Entity>& entity) const
@@ -216,18 +319,14 @@ namespace Spartan
 		}
 	}
 
-	bool Model::GeometryCreateBuffers()
+	bool Model::GeometryCreateBuffers(const uint32_t* indices, const uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count)
 	{
 		auto success = true;
 
-		// Get geometry
-		const auto indices	= m_mesh->Indices_Get();
-		const auto vertices	= m_mesh->Vertices_Get();
-
-		if (!indices.empty())
+		if (index_count != 0)
 		{
 			m_index_buffer = make_shared<RHI_IndexBuffer>(m_rhi_device);
-			if (!m_index_buffer->Create(indices))
+			if (!m_index_buffer->Create(indices, index_count))
 			{
 				LOG_ERROR("Failed to create index buffer for \"%s\".", GetResourceName().c_str());
 				success = false;
@@ -239,10 +338,10 @@ namespace Spartan
 			success = false;
 		}
 
-		if (!vertices.empty())
+		if (vertex_count != 0)
 		{
 			m_vertex_buffer = make_shared<RHI_VertexBuffer>(m_rhi_device);
-			if (!m_vertex_buffer->Create(vertices))
+			if (!m_vertex_buffer->Create(vertices, vertex_count))
 			{
 				LOG_ERROR("Failed to create vertex buffer for \"%s\".", GetResourceName().c_str());
 				success = false;
@@ -265,4 +364,25 @@ namespace Spartan
 		// Return normalized scale
 		return 1.0f / scale_offset;
 	}
+
+	BoundingBox Model::GeometryComputeAabb() const
+	{
+		// Terrains and large imports have millions of vertices, so the bounds of each chunk are computed in parallel and merged
+		const vector<RHI_Vertex_PosTexNorTan>& vertices = m_mesh->Vertices_Get();
+
+		return m_context->GetSubsystem<Threading>()->ParallelReduce<BoundingBox>(
+			[&vertices](const uint32_t start, const uint32_t end)
+			{
+				return BoundingBox(vertices.data() + start, end - start);
+			},
+			[](const BoundingBox& a, const BoundingBox& b)
+			{
+				BoundingBox merged = a;
+				merged.Merge(b);
+				return merged;
+			},
+			static_cast<uint32_t>(vertices.size()),
+			BoundingBox()
+		);
+	}
 }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include "Material.h"
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
@@ -38,6 +39,14 @@ namespace Spartan
 	class Mesh;
 	namespace Math{ class BoundingBox; }
 
+    // A simplified version of a mesh, its indices reference the same vertices
+    struct MeshLod
+    {
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+        float error             = 0.0f; // fraction of the mesh's bounding radius
+    };
+
 	class SPARTAN_CLASS Model : public RHI_Object, public IResource, public std::enable_shared_from_this<Model>
 	{
 	public:
@@ -70,6 +79,10 @@ namespace Spartan
         const auto& GetAabb() const { return m_aabb; }
         const auto& GetMesh() const { return m_mesh; }
 
+        // Level of detail, keyed by the index offset of the full detail mesh and ordered from finest to coarsest
+        void AppendLod(uint32_t index_offset, const std::vector<uint32_t>& indices, float error);
+        const std::vector<MeshLod>* GetLods(uint32_t index_offset) const;
+
 		// Add resources to the model
         void SetRootEntity(const std::shared_ptr<Entity>& entity) { m_root_entity = entity; }
 		void AddMaterial(std::shared_ptr<Material>& material, const std::shared_ptr<Entity>& entity) const;
@@ -84,14 +97,16 @@ namespace Spartan
 
 	private:
 		// Geometry
-		bool GeometryCreateBuffers();
+		bool GeometryCreateBuffers(const uint32_t* indices, uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices, uint32_t vertex_count);
 		float GeometryComputeNormalizedScale() const;
+		Math::BoundingBox GeometryComputeAabb() const;
 
 		// Misc
 		std::weak_ptr<Entity> m_root_entity;
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
 		std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
 		std::shared_ptr<Mesh> m_mesh;
+        std::unordered_map<uint32_t, std::vector<MeshLod>> m_lods;
 		Math::BoundingBox m_aabb;
 		float m_normalized_scale	= 1.0f;
 		bool m_is_animated			= false;
@@ -20,16 +20,24 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES ==============================
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
 #include "Renderer.h"
 #include "Model.h"
+#include "Material.h"
+#include "ShaderVariation.h"
 #include "Font/Font.h"
 #include "Gizmos/Grid.h"
 #include "Gizmos/Transform_Gizmo.h"
 #include "../Utilities/Sampling.h"
+#include "../Utilities/RadixSort.h"
+#include "../Utilities/Hash.h"
 #include "../Profiling/Profiler.h"
 #include "../Resource/ResourceCache.h"
 #include "../Core/Engine.h"
 #include "../Core/Timer.h"
+#include "../World/World.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
@@ -38,12 +46,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_PipelineCache.h"
 #include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_CommandList.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_SwapChain.h"
 #include "../RHI/RHI_VertexBuffer.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_DescriptorCache.h"
+#include "../RHI/RHI_UploadManager.h"
 //=========================================
 
 //= NAMESPACES ===============
@@ -71,6 +81,7 @@ namespace Spartan
         m_options |= Render_ScreenSpaceReflections;	
         m_options |= Render_AntiAliasing_Taa;
         m_options |= Render_Sharpening_LumaSharpen;             // Helps with TAA induced blurring
+        m_options |= Render_ParallelRecording;
         //m_options |= Render_PostProcess_FXAA;                 // Disabled by default: TAA is superior.
         //m_options |= Render_PostProcess_Dithering;            // Disabled by default: It's only needed in very dark scenes to fix smooth color gradients.
         //m_options |= Render_PostProcess_ChromaticAberration;	// Disabled by default: It doesn't improve the image quality, it's more of a stylistic effect.	
@@ -85,16 +96,17 @@ namespace Spartan
         m_option_values[Option_Value_Sharpen_Clamp]           = 0.35f;
         m_option_values[Option_Value_Bloom_Intensity]         = 0.003f;
         m_option_values[Option_Value_Motion_Blur_Intensity]   = 0.01f;
+        m_option_values[Option_Value_Lod_Pixel_Error]         = 1.0f;
 
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete,    EVENT_HANDLER_VARIANT(RenderablesAcquire));
+		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete,    EVENT_HANDLER(RenderablesAcquire));
         SUBSCRIBE_TO_EVENT(Event_World_Unload,              EVENT_HANDLER(ClearEntities));
 	}
 
 	Renderer::~Renderer()
 	{
 		// Unsubscribe from events
-		UNSUBSCRIBE_FROM_EVENT(Event_World_Resolve_Complete, EVENT_HANDLER_VARIANT(RenderablesAcquire));
+		UNSUBSCRIBE_FROM_EVENT(Event_World_Resolve_Complete, EVENT_HANDLER(RenderablesAcquire));
 
 		m_entities.clear();
 		m_camera = nullptr;
@@ -108,6 +120,7 @@ namespace Spartan
         // Get required systems		
         m_resource_cache    = m_context->GetSubsystem<ResourceCache>();
         m_profiler          = m_context->GetSubsystem<Profiler>();
+        m_threading         = m_context->GetSubsystem<Threading>();
 
         // Create device
         m_rhi_device = make_shared<RHI_Device>(m_context);
@@ -143,6 +156,10 @@ namespace Spartan
                 LOG_ERROR("Failed to create swap chain");
                 return false;
             }
+
+            // A command list waits for its previous submission before recording again, so once every swap chain buffer has been
+            // recorded past a frame, that frame is done. Deferred releases and the ring buffers created below are sized by this.
+            m_rhi_device->SetFramesInFlight(m_swap_chain->GetBufferCount() + 1);
         }
 
 		// Editor specific
@@ -182,6 +199,13 @@ namespace Spartan
 		if (!m_rhi_device || !m_rhi_device->IsInitialized())
 			return;
 
+        // Submit the uploads recorded since the last frame and retire the completed ones (textures become resident)
+        m_rhi_device->GetUploadManager()->Tick();
+
+        // Release GPU objects which are no longer referenced by any frame in flight.
+        // This happens before anything can return early, so releases don't pile up while there is no world to render.
+        m_rhi_device->DeferredRelease_Tick();
+
         RHI_CommandList* cmd_list = m_swap_chain->GetCmdList();
 
 		// If there is no camera, do nothing
@@ -201,6 +225,10 @@ namespace Spartan
 		m_frame_num++;
 		m_is_odd_frame = (m_frame_num % 2) == 1;
 
+        // Per draw data is allocated linearly from this frame's region of the object buffer
+        m_buffer_object_gpu->ResetRing(m_frame_num);
+        m_buffer_instance_gpu->ResetRing(m_frame_num);
+
 		// Get camera matrices
 		{
 			m_near_plane	                            = m_camera->GetNearPlane();
@@ -235,6 +263,11 @@ namespace Spartan
             m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * m_camera->GetProjectionMatrix();
 		}
 
+        // Order the renderables for this frame's camera and cull them against every view
+        RenderablesSort();
+        RenderablesCull();
+        RenderablesBucket();
+
 		m_is_rendering = true;
 		Pass_Main(cmd_list);
 		m_is_rendering = false;
@@ -385,48 +418,31 @@ namespace Spartan
 		return m_buffer_uber_gpu->Unmap();
 	}
 
-    bool Renderer::UpdateObjectBuffer(RHI_CommandList* cmd_list, const uint32_t entity_index /*= 0*/)
+    bool Renderer::UpdateObjectBuffer(RHI_CommandList* cmd_list)
     {
-        // Only update if needed
-        const bool same_content   = m_buffer_object_cpu == m_buffer_object_cpu_previous;
-        const bool same_offset    = m_buffer_object_gpu->GetOffsetIndexDynamic() == entity_index;
-        if (same_content && same_offset)
+        // Only update if needed (the last allocation already holds the same content and nothing was allocated or reset since)
+        if (m_buffer_object_cpu == m_buffer_object_cpu_previous && m_buffer_object_gpu->GetRingVersion() == m_buffer_object_ring_version)
             return true;
 
-        const uint32_t entity_count = entity_index + 1;
-
-        // Re-allocate buffer with double size (if needed)
-        if (entity_count >= m_buffer_object_gpu->GetElementCount())
+        // Allocate the next element, this also points the dynamic offset at it
+        BufferObject* buffer = static_cast<BufferObject*>(m_buffer_object_gpu->Allocate());
+        if (!buffer)
         {
-            const uint32_t new_size = Math::NextPowerOfTwo(entity_count);
-            if (!m_buffer_object_gpu->Create<BufferObject>(new_size))
-            {
-                LOG_ERROR("Failed to re-allocate buffer with %d offsets", new_size);
-                return false;
-            }
+            LOG_ERROR("Failed to allocate from buffer");
+            return false;
         }
 
-        // Set new buffer offset
-        m_buffer_object_gpu->SetOffsetIndexDynamic(entity_index);
+        // Update
+        *buffer = m_buffer_object_cpu;
+        m_buffer_object_cpu_previous    = m_buffer_object_cpu;
+        m_buffer_object_ring_version    = m_buffer_object_gpu->GetRingVersion();
 
         // Dynamic buffers with offsets have to be rebound whenever the offset changes
         if (cmd_list)
         {
-            cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader, m_buffer_object_gpu);
+            cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_object_gpu);
         }
 
-        // Map  
-        BufferObject* buffer = static_cast<BufferObject*>(m_buffer_object_gpu->Map(entity_index));
-        if (!buffer)
-        {
-            LOG_ERROR("Failed to map buffer");
-            return false;
-        }
-
-        // Update
-        *buffer = m_buffer_object_cpu;
-        m_buffer_object_cpu_previous = m_buffer_object_cpu;
-
         // Unmap
         return m_buffer_object_gpu->Unmap();
     }
@@ -466,80 +482,570 @@ namespace Spartan
         return m_buffer_light_gpu->Unmap();
     }
 
-	void Renderer::RenderablesAcquire(const Variant& entities_variant)
+	void Renderer::RenderablesAcquire()
 	{
         SCOPED_TIME_BLOCK(m_profiler);
 
-		// Clear previous state
-		m_entities.clear();
-		m_camera = nullptr;
+        // Apply the changes the world made since the last resolve. Every entity that was touched is
+        // removed from the render lists and, if it's still part of the world, added back according to its current state.
+        const auto& deltas = m_context->GetSubsystem<World>()->EntityGetDeltas();
+        unordered_set<Entity*> entities_processed;
+        entities_processed.reserve(deltas.size());
+        for (const EntityDelta& delta : deltas)
+        {
+            Entity* entity = delta.entity.get();
+            if (!entities_processed.insert(entity).second)
+                continue;
 
-		vector<shared_ptr<Entity>> entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
-		for (const auto& entity : entities)
-		{
-			if (!entity || !entity->IsActive())
-				continue;
+            RenderablesRemove(entity);
 
-			// Get all the components we are interested in
-            const auto renderable = entity->GetComponent<Renderable>();
-            const auto light      = entity->GetComponent<Light>();
-			auto camera		= entity->GetComponent<Camera>();
+            if (entity->GetHandle().IsValid())
+            {
+                RenderablesAdd(entity);
+            }
+        }
+	}
 
-			if (renderable)
-			{
-				const auto is_transparent = !renderable->HasMaterial() ? false : renderable->GetMaterial()->GetColorAlbedo().w < 1.0f;
-                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity.get());
-			}
+    void Renderer::RenderablesAdd(Entity* entity)
+    {
+        if (!entity->IsActive())
+            return;
 
-			if (light)
-			{
-				m_entities[Renderer_Object_Light].emplace_back(entity.get());
+        RenderableLocation location;
 
-                if (light->GetLightType() == LightType_Directional) m_entities[Renderer_Object_LightDirectional].emplace_back(entity.get());
-                if (light->GetLightType() == LightType_Point)       m_entities[Renderer_Object_LightPoint].emplace_back(entity.get());
-                if (light->GetLightType() == LightType_Spot)        m_entities[Renderer_Object_LightSpot].emplace_back(entity.get());
-			}
+        if (Renderable* renderable = entity->GetComponent<Renderable>())
+        {
+            const auto is_transparent       = !renderable->HasMaterial() ? false : renderable->GetMaterial()->GetColorAlbedo().w < 1.0f;
+            const Renderer_Object_Type type = is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque;
 
-			if (camera)
-			{
-				m_entities[Renderer_Object_Camera].emplace_back(entity.get());
-				m_camera = camera->GetPtrShared<Camera>();
-			}
-		}
+            // Keep the list sorted by material (to minimize state changes), then by id
+            const uint64_t material_id  = renderable->HasMaterial() ? renderable->GetMaterial()->GetId() : 0;
+            location.sort_key           = (material_id << 32) | entity->GetId();
 
-		RenderablesSort(&m_entities[Renderer_Object_Opaque]);
-		RenderablesSort(&m_entities[Renderer_Object_Transparent]);
-	}
+            auto& keys          = m_entities_sort_keys[type];
+            auto& entities      = m_entities[type];
+            const auto index    = upper_bound(keys.begin(), keys.end(), location.sort_key) - keys.begin();
+            keys.insert(keys.begin() + index, location.sort_key);
+            entities.insert(entities.begin() + index, entity);
 
-	void Renderer::RenderablesSort(vector<Entity*>* renderables)
-	{
-		if (!m_camera || renderables->size() <= 2)
-			return;
+            location.object_mask |= 1 << type;
+        }
 
-		auto render_hash = [this](Entity* entity)
-		{
-			// Get renderable
-			auto renderable = entity->GetRenderable();
-			if (!renderable)
-				return 0.0f;
+        if (Light* light = entity->GetComponent<Light>())
+        {
+            Renderer_Object_Type type = Renderer_Object_LightDirectional;
+            if (light->GetLightType() == LightType_Point)   type = Renderer_Object_LightPoint;
+            if (light->GetLightType() == LightType_Spot)    type = Renderer_Object_LightSpot;
 
-			// Get material
-			const auto material = renderable->GetMaterial();
-			if (!material)
-				return 0.0f;
+            m_entities[Renderer_Object_Light].emplace_back(entity);
+            m_entities[type].emplace_back(entity);
 
-			const auto num_depth    = (renderable->GetAabb().GetCenter() - m_camera->GetTransform()->GetPosition()).LengthSquared();
-			const auto num_material = static_cast<float>(material->GetId());
+            location.object_mask |= (1 << Renderer_Object_Light) | (1 << type);
+        }
 
-			return stof(to_string(num_depth) + "-" + to_string(num_material));
-		};
+        if (Camera* camera = entity->GetComponent<Camera>())
+        {
+            m_entities[Renderer_Object_Camera].emplace_back(entity);
+            m_camera = camera->GetPtrShared<Camera>();
 
-		// Sort by depth (front to back), then sort by material		
-		sort(renderables->begin(), renderables->end(), [&render_hash](Entity* a, Entity* b)
-		{
-            return render_hash(a) < render_hash(b);
-		});
-	}
+            location.object_mask |= 1 << Renderer_Object_Camera;
+        }
+
+        if (location.object_mask != 0)
+        {
+            m_entities_location[entity] = location;
+        }
+    }
+
+    void Renderer::RenderablesRemove(Entity* entity)
+    {
+        const auto it = m_entities_location.find(entity);
+        if (it == m_entities_location.end())
+            return;
+
+        const RenderableLocation& location = it->second;
+
+        for (uint32_t i = Renderer_Object_Opaque; i <= Renderer_Object_Camera; i++)
+        {
+            const Renderer_Object_Type type = static_cast<Renderer_Object_Type>(i);
+            if (!(location.object_mask & (1 << type)))
+                continue;
+
+            auto& entities = m_entities[type];
+
+            if (type == Renderer_Object_Opaque || type == Renderer_Object_Transparent)
+            {
+                // Binary search for the key, then find the entity among the entities that share it
+                auto& keys = m_entities_sort_keys[type];
+                for (auto index = lower_bound(keys.begin(), keys.end(), location.sort_key) - keys.begin(); index < static_cast<int64_t>(keys.size()) && keys[index] == location.sort_key; index++)
+                {
+                    if (entities[index] == entity)
+                    {
+                        keys.erase(keys.begin() + index);
+                        entities.erase(entities.begin() + index);
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                entities.erase(remove(entities.begin(), entities.end(), entity), entities.end());
+            }
+        }
+
+        // Fall back to any other camera
+        if (m_camera && m_camera->GetEntity() == entity)
+        {
+            const auto& cameras = m_entities[Renderer_Object_Camera];
+            m_camera = cameras.empty() ? nullptr : cameras.back()->GetComponent<Camera>()->GetPtrShared<Camera>();
+        }
+
+        m_entities_location.erase(it);
+    }
+
+    void Renderer::RenderablesSort()
+    {
+        // Draw key fields, ids are remapped to dense per-frame indices since object ids are global and grow without bound
+        static constexpr uint64_t key_pass_bits         = 4;
+        static constexpr uint64_t key_shader_bits       = 12;
+        static constexpr uint64_t key_material_bits     = 16;
+        static constexpr uint64_t key_depth_bits        = 32;
+        static constexpr uint64_t key_shader_max        = (1ull << key_shader_bits) - 1;
+        static constexpr uint64_t key_material_max      = (1ull << key_material_bits) - 1;
+        static constexpr uint64_t key_depth_max         = (1ull << key_depth_bits) - 1;
+        static_assert(key_pass_bits + key_shader_bits + key_material_bits + key_depth_bits == 64, "The draw key fields have to add up to 64 bits");
+
+        const Vector3 camera_position   = m_camera->GetTransform()->GetPosition();
+        const float depth_scale         = m_far_plane > 0.0f ? 1.0f / m_far_plane : 0.0f;
+
+        m_draw_key_shader_index.clear();
+        m_draw_key_material_index.clear();
+
+        for (const Renderer_Object_Type type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            const vector<Entity*>& entities = m_entities[type];
+            vector<Entity*>& entities_sorted = m_entities_sorted[type];
+            const uint32_t entity_count = static_cast<uint32_t>(entities.size());
+
+            m_draw_keys.resize(entity_count);
+            entities_sorted.assign(entities.begin(), entities.end());
+
+            // Pack a 64-bit draw key per renderable, the pass comes first so that the keys of both lists order correctly when merged
+            // Opaque:      [pass 4 | shader 12 | material 16 | depth 32] - group state changes, then draw front to back
+            // Transparent: [pass 4 | inverted depth 32 | shader 12 | material 16] - draw back to front
+            const bool is_transparent   = type == Renderer_Object_Transparent;
+            const uint64_t pass         = static_cast<uint64_t>(is_transparent ? 1 : 0) << (64 - key_pass_bits);
+
+            // The state part of the keys, serially as it assigns the dense indices. The lists are kept in material order,
+            // so the lookups only happen when the material changes.
+            {
+                const Material* material_previous   = nullptr;
+                uint64_t state                      = 0;
+                for (uint32_t i = 0; i < entity_count; i++)
+                {
+                    const Material* material = entities[i]->GetRenderable()->GetMaterial().get();
+                    if (i == 0 || material != material_previous)
+                    {
+                        material_previous = material;
+
+                        uint64_t shader_index   = 0;
+                        uint64_t material_index = 0;
+                        if (material)
+                        {
+                            if (const ShaderVariation* shader = material->GetShader().get())
+                            {
+                                shader_index = m_draw_key_shader_index.emplace(shader->GetId(), static_cast<uint32_t>(m_draw_key_shader_index.size() + 1)).first->second;
+                            }
+                            material_index = m_draw_key_material_index.emplace(material->GetId(), static_cast<uint32_t>(m_draw_key_material_index.size() + 1)).first->second;
+                        }
+
+                        // Out of range indices only lose their grouping, the order stays valid
+                        SPARTAN_ASSERT(shader_index <= key_shader_max && material_index <= key_material_max);
+                        state = (Math::Min(shader_index, key_shader_max) << key_material_bits) | Math::Min(material_index, key_material_max);
+                    }
+
+                    m_draw_keys[i] = state;
+                }
+            }
+
+            const auto compute_keys = [this, &entities, &camera_position, depth_scale, is_transparent, pass](const uint32_t start, const uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    const float distance    = Vector3::Distance(camera_position, entities[i]->GetRenderable()->GetAabb().GetCenter());
+                    const uint64_t depth    = static_cast<uint64_t>(static_cast<double>(Math::Clamp(distance * depth_scale, 0.0f, 1.0f)) * static_cast<double>(key_depth_max));
+                    const uint64_t state    = m_draw_keys[i];
+
+                    m_draw_keys[i] = pass | (is_transparent ? ((key_depth_max - depth) << (key_shader_bits + key_material_bits)) | state : (state << key_depth_bits) | depth);
+                }
+            };
+
+            if (entity_count >= Utility::RadixSort::parallel_threshold)
+            {
+                m_threading->ParallelFor(compute_keys, entity_count);
+            }
+            else
+            {
+                compute_keys(0, entity_count);
+            }
+
+            Utility::RadixSort::Sort(m_draw_keys, entities_sorted, m_threading);
+        }
+    }
+
+    void Renderer::RenderablesCull()
+    {
+        // Gather the views, the camera first and then every shadow slice of every shadow casting light
+        m_culling_views.clear();
+        m_culling_views_light.clear();
+        m_culling_views.push_back({ &m_camera->GetFrustum(), false });
+        for (Entity* entity : m_entities[Renderer_Object_Light])
+        {
+            const Light* light = entity->GetComponent<Light>();
+            if (!light || !light->GetShadowsEnabled())
+                continue;
+
+            // Directional lights have to keep the shadow casters behind their view point ("pancaking")
+            const bool ignore_near_plane = light->GetLightType() == LightType_Directional;
+
+            m_culling_views_light[light] = static_cast<uint32_t>(m_culling_views.size());
+            for (uint32_t i = 0; i < light->GetShadowArraySize(); i++)
+            {
+                m_culling_views.push_back({ &light->GetFrustum(i), ignore_near_plane });
+            }
+        }
+        const uint32_t view_count = static_cast<uint32_t>(m_culling_views.size());
+
+        // Gather the exact bounds of the renderables in draw order (opaque first, then transparent) and map the scene query
+        // proxy of every renderable to that index. Renderables without a proxy have no bounds, so they can't be culled.
+        const BoundingVolumeHierarchy& scene_query  = m_context->GetSubsystem<World>()->SceneQueryGetHierarchy();
+        const vector<Entity*>& entities_opaque      = m_entities_sorted[Renderer_Object_Opaque];
+        const vector<Entity*>& entities_transparent = m_entities_sorted[Renderer_Object_Transparent];
+        const uint32_t opaque_count                 = static_cast<uint32_t>(entities_opaque.size());
+        const uint32_t entity_count                 = opaque_count + static_cast<uint32_t>(entities_transparent.size());
+        const bool parallel                         = entity_count >= culling_parallel_threshold;
+        m_culling_proxy_index.assign(scene_query.GetCapacity(), culling_index_invalid);
+        m_culling_boxes.Resize(entity_count);
+        {
+            const auto gather = [this, &entities_opaque, &entities_transparent, opaque_count](const uint32_t start, const uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    const Entity* entity    = i < opaque_count ? entities_opaque[i] : entities_transparent[i - opaque_count];
+                    const uint32_t proxy    = entity->GetSceneQueryProxy();
+                    if (proxy != BoundingVolumeHierarchy::null_proxy)
+                    {
+                        const BoundingBox& aabb = entity->GetRenderable()->GetAabb();
+                        m_culling_boxes.Set(i, aabb.GetCenter(), aabb.GetExtents());
+                        m_culling_proxy_index[proxy] = i;
+                    }
+                }
+            };
+
+            if (parallel)
+            {
+                m_threading->ParallelFor(gather, entity_count);
+            }
+            else
+            {
+                gather(0, entity_count);
+            }
+
+            m_culling_unbounded.clear();
+            for (uint32_t i = 0; i < entity_count; i++)
+            {
+                const Entity* entity = i < opaque_count ? entities_opaque[i] : entities_transparent[i - opaque_count];
+                if (entity->GetSceneQueryProxy() == BoundingVolumeHierarchy::null_proxy)
+                {
+                    m_culling_unbounded.emplace_back(i);
+                }
+            }
+        }
+
+        // Split every view into subtrees of the hierarchy, so that a single view (typically the camera, which sees the most)
+        // is spread over the threads too. Without the parallelism a view is a single task which walks the whole tree.
+        const uint32_t subtrees_per_view = parallel ? (m_threading->GetThreadCount() + 1) * 2 : 1;
+        m_culling_view_tasks.resize(view_count + 1);
+        uint32_t task_count = 0;
+        for (uint32_t view = 0; view < view_count; view++)
+        {
+            m_culling_view_tasks[view] = task_count;
+            scene_query.QueryFrustumSplit(*m_culling_views[view].frustum, m_culling_views[view].ignore_near_plane, subtrees_per_view, &m_culling_subtrees);
+
+            if (m_culling_tasks.size() < task_count + m_culling_subtrees.size())
+            {
+                m_culling_tasks.resize(task_count + m_culling_subtrees.size());
+            }
+            for (const BoundingVolumeHierarchy::FrustumSubtree& subtree : m_culling_subtrees)
+            {
+                m_culling_tasks[task_count].view    = view;
+                m_culling_tasks[task_count].subtree = subtree;
+                task_count++;
+            }
+        }
+        m_culling_view_tasks[view_count] = task_count;
+
+        // Walk the subtrees. Leaves in subtrees that are entirely inside are visible as they are, the rest are tested
+        // against the renderable's own bounds four at a time.
+        const auto cull = [this, &scene_query](const uint32_t task_start, const uint32_t task_end)
+        {
+            for (uint32_t task_index = task_start; task_index < task_end; task_index++)
+            {
+                CullingTask& task               = m_culling_tasks[task_index];
+                const CullingView& view         = m_culling_views[task.view];
+                task.candidates.clear();
+                task.visible.clear();
+
+                scene_query.QueryFrustumSubtree(*view.frustum, view.ignore_near_plane, task.subtree, [this, &task](const uint32_t proxy, const bool inside)
+                {
+                    const uint32_t index = m_culling_proxy_index[proxy];
+                    if (index != culling_index_invalid)
+                    {
+                        (inside ? task.visible : task.candidates).emplace_back(index);
+                    }
+
+                    return true;
+                });
+
+                view.frustum->Cull(m_culling_boxes, task.candidates.data(), static_cast<uint32_t>(task.candidates.size()), task.visible, view.ignore_near_plane);
+            }
+        };
+
+        // Merge the tasks of every view, the visible lists are sorted so that they keep the draw order
+        m_entities_visible[Renderer_Object_Opaque].resize(view_count);
+        m_entities_visible[Renderer_Object_Transparent].resize(view_count);
+        vector<vector<uint32_t>>& visible_opaque        = m_entities_visible[Renderer_Object_Opaque];
+        vector<vector<uint32_t>>& visible_transparent   = m_entities_visible[Renderer_Object_Transparent];
+        const auto merge = [this, &visible_opaque, &visible_transparent, opaque_count](const uint32_t view_start, const uint32_t view_end)
+        {
+            for (uint32_t view = view_start; view < view_end; view++)
+            {
+                vector<uint32_t>& opaque        = visible_opaque[view];
+                vector<uint32_t>& transparent   = visible_transparent[view];
+                opaque.assign(m_culling_unbounded.begin(), m_culling_unbounded.end());
+                transparent.clear();
+
+                for (uint32_t task_index = m_culling_view_tasks[view]; task_index < m_culling_view_tasks[view + 1]; task_index++)
+                {
+                    const vector<uint32_t>& visible = m_culling_tasks[task_index].visible;
+                    opaque.insert(opaque.end(), visible.begin(), visible.end());
+                }
+                sort(opaque.begin(), opaque.end());
+
+                // Everything from opaque_count on is transparent
+                const auto transparent_begin = lower_bound(opaque.begin(), opaque.end(), opaque_count);
+                for (auto it = transparent_begin; it != opaque.end(); it++)
+                {
+                    transparent.emplace_back(*it - opaque_count);
+                }
+                opaque.erase(transparent_begin, opaque.end());
+            }
+        };
+
+        if (parallel)
+        {
+            m_threading->ParallelFor(cull, task_count, 1);
+            m_threading->ParallelFor(merge, view_count, 1);
+        }
+        else
+        {
+            cull(0, task_count);
+            merge(0, view_count);
+        }
+    }
+
+    void Renderer::RenderablesBucket()
+    {
+        for (const Renderer_Object_Type type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            // Keep the buckets (and their memory) around, variations come and go rarely
+            auto& buckets = m_draw_buckets[type];
+            for (auto& bucket : buckets)
+            {
+                bucket.second.clear();
+            }
+
+            const bool is_transparent       = type == Renderer_Object_Transparent;
+            const vector<Entity*>& entities = m_entities_sorted[type];
+            const vector<uint32_t>& visible = m_entities_visible[type][0];
+            m_profiler->m_renderer_pass_gbuffer_considered += static_cast<uint32_t>(visible.size());
+
+            // The visible list is in draw order, so every bucket is too (grouped by material for opaque, back to front for transparent)
+            for (const uint32_t index : visible)
+            {
+                Renderable* renderable = entities[index]->GetRenderable();
+
+                // Get material
+                Material* material = renderable->GetMaterial().get();
+                if (!material)
+                    continue;
+
+                // Skip transparent objects that won't contribute
+                if (is_transparent && material->GetColorAlbedo().w == 0)
+                    continue;
+
+                // Get shader
+                const auto& shader = material->GetShader();
+                if (!shader || !shader->IsCompiled())
+                    continue;
+
+                // Get geometry
+                const auto& model = renderable->GeometryModel();
+                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                    continue;
+
+                buckets[shader->GetId()].emplace_back(index);
+            }
+        }
+    }
+
+    void Renderer::DrawBatchesBuild(const vector<Entity*>& entities, const vector<uint32_t>& draws, const bool shadow_casters_only, const bool keep_order, const Matrix& view_projection, const float viewport_height)
+    {
+        m_draw_batches.clear();
+        m_draw_batch_instances.clear();
+        m_draw_batch_lookup.clear();
+        m_draw_batch_assignments.assign(draws.size(), numeric_limits<uint32_t>::max());
+
+        // Level of detail, the projected size of a world space length at a point is length * scale_y / w (in NDC, which spans 2 units).
+        // Orthographic projections have a constant w of 1, so their levels only depend on the size of the mesh.
+        const float lod_pixel_error = m_option_values[Option_Value_Lod_Pixel_Error];
+        const float lod_scale_y     = Vector3(view_projection.m01, view_projection.m11, view_projection.m21).Length() * viewport_height * 0.5f;
+        const auto select_lod = [&view_projection, lod_pixel_error, lod_scale_y](Renderable* renderable, uint32_t* index_offset, uint32_t* index_count)
+        {
+            *index_offset   = renderable->GeometryIndexOffset();
+            *index_count    = renderable->GeometryIndexCount();
+
+            const vector<MeshLod>* lods = renderable->GeometryModel()->GetLods(*index_offset);
+            if (!lods || lod_pixel_error <= 0.0f)
+                return;
+
+            const BoundingBox& aabb = renderable->GetAabb();
+            const Vector3 center    = aabb.GetCenter();
+            const float w           = Max(center.x * view_projection.m03 + center.y * view_projection.m13 + center.z * view_projection.m23 + view_projection.m33, 0.0001f);
+            const float radius_px   = aabb.GetExtents().Length() * lod_scale_y / w;
+
+            // The coarsest level which is still within the error
+            for (const MeshLod& lod : *lods)
+            {
+                if (lod.error * radius_px > lod_pixel_error)
+                    break;
+
+                *index_offset   = lod.index_offset;
+                *index_count    = lod.index_count;
+            }
+        };
+
+        // Draws can be batched if they draw the same part of the same model with the same material
+        const auto is_same_batch = [](const DrawBatch& batch, const Renderable* renderable, const uint32_t index_offset, const uint32_t index_count)
+        {
+            const Renderable* a = batch.renderable;
+            return
+                a->GeometryModel()          == renderable->GeometryModel()          &&
+                batch.index_offset          == index_offset                         &&
+                batch.index_count           == index_count                          &&
+                a->GeometryVertexOffset()   == renderable->GeometryVertexOffset()   &&
+                a->GetMaterial()            == renderable->GetMaterial();
+        };
+
+        // Assign every draw to a batch, batches are in the order of their first draw, so the draw order is roughly preserved
+        for (uint32_t draw_index = 0; draw_index < static_cast<uint32_t>(draws.size()); draw_index++)
+        {
+            Renderable* renderable = entities[draws[draw_index]]->GetRenderable();
+            if (!renderable || !renderable->GetMaterial())
+                continue;
+
+            if (shadow_casters_only && !renderable->GetCastShadows())
+                continue;
+
+            const Model* model = renderable->GeometryModel();
+            if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                continue;
+
+            // The index range identifies the part of the model as well as its level of detail
+            uint32_t index_offset   = 0;
+            uint32_t index_count    = 0;
+            select_lod(renderable, &index_offset, &index_count);
+
+            m_profiler->m_renderer_triangles_full   += renderable->GeometryIndexCount() / 3;
+            m_profiler->m_renderer_triangles_drawn  += index_count / 3;
+
+            uint32_t batch_index = numeric_limits<uint32_t>::max();
+            if (keep_order)
+            {
+                // Only consecutive draws can be merged, otherwise (e.g. back to front) sorting would break
+                if (!m_draw_batches.empty() && is_same_batch(m_draw_batches.back(), renderable, index_offset, index_count))
+                {
+                    batch_index = static_cast<uint32_t>(m_draw_batches.size() - 1);
+                }
+            }
+            else
+            {
+                size_t hash = 0;
+                Utility::Hash::hash_combine(hash, model);
+                Utility::Hash::hash_combine(hash, index_offset);
+                Utility::Hash::hash_combine(hash, index_count);
+                Utility::Hash::hash_combine(hash, renderable->GeometryVertexOffset());
+                Utility::Hash::hash_combine(hash, renderable->GetMaterial().get());
+
+                // On a hash collision, the draw simply gets a batch of its own
+                const auto it = m_draw_batch_lookup.find(hash);
+                if (it != m_draw_batch_lookup.end() && is_same_batch(m_draw_batches[it->second], renderable, index_offset, index_count))
+                {
+                    batch_index = it->second;
+                }
+                else if (it == m_draw_batch_lookup.end())
+                {
+                    m_draw_batch_lookup[hash] = static_cast<uint32_t>(m_draw_batches.size());
+                }
+            }
+
+            if (batch_index == numeric_limits<uint32_t>::max())
+            {
+                batch_index = static_cast<uint32_t>(m_draw_batches.size());
+                DrawBatch& batch    = m_draw_batches.emplace_back();
+                batch.renderable    = renderable;
+                batch.index_offset  = index_offset;
+                batch.index_count   = index_count;
+            }
+
+            m_draw_batches[batch_index].instance_count++;
+            m_draw_batch_assignments[draw_index] = batch_index;
+        }
+
+        // Give every batch a contiguous range of instances
+        uint32_t instance_count = 0;
+        for (DrawBatch& batch : m_draw_batches)
+        {
+            batch.instance_start    = instance_count;
+            instance_count          += batch.instance_count;
+            batch.instance_count    = 0;
+        }
+
+        // Fill the ranges, in draw order
+        m_draw_batch_instances.resize(instance_count);
+        for (uint32_t draw_index = 0; draw_index < static_cast<uint32_t>(draws.size()); draw_index++)
+        {
+            const uint32_t batch_index = m_draw_batch_assignments[draw_index];
+            if (batch_index == numeric_limits<uint32_t>::max())
+                continue;
+
+            DrawBatch& batch = m_draw_batches[batch_index];
+            m_draw_batch_instances[batch.instance_start + batch.instance_count++] = entities[draws[draw_index]];
+        }
+    }
+
+    void Renderer::ClearEntities()
+    {
+        m_entities.clear();
+        m_entities_sort_keys.clear();
+        m_entities_location.clear();
+        m_entities_sorted.clear();
+        m_entities_visible.clear();
+        m_culling_views.clear();
+        m_culling_views_light.clear();
+        m_draw_buckets.clear();
+        m_camera = nullptr;
+    }
 
     const shared_ptr<Spartan::RHI_Texture>& Renderer::GetEnvironmentTexture()
     {
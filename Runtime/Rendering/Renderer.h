@@ -27,6 +27,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Viewport.h"
 #include "../Math/Rectangle.h"
+#include "../Math/Frustum.h"
+#include "../Math/BoundingVolumeHierarchy.h"
 #include "Renderer_ConstantBuffers.h"
 //===================================
 
@@ -34,6 +36,7 @@ namespace Spartan
 {
     // Forward declarations
 	class Entity;
+	class Renderable;
 	class Camera;
 	class Light;
 	class ResourceCache;
@@ -42,10 +45,10 @@ namespace Spartan
 	class Grid;
 	class Transform_Gizmo;
 	class Profiler;
+	class Threading;
 	namespace Math
 	{
 		class BoundingBox;
-		class Frustum;
 	}
 
 	enum Renderer_Option : uint64_t
@@ -71,7 +74,8 @@ namespace Spartan
 		Render_ChromaticAberration	        = 1 << 18,
 		Render_Dithering			        = 1 << 19,
         Render_ReverseZ                     = 1 << 20,
-        Render_DepthPrepass                 = 1 << 21
+        Render_DepthPrepass                 = 1 << 21,
+        Render_ParallelRecording            = 1 << 22  // large draw lists are recorded into secondary command lists by the worker threads
 	};
 
     enum Renderer_Option_Value
@@ -84,7 +88,8 @@ namespace Spartan
         Option_Value_Bloom_Intensity,
         Option_Value_Sharpen_Strength,
         Option_Value_Sharpen_Clamp, // Limits maximum amount of sharpening a pixel receives - Algorithm's default: 0.035f
-        Option_Value_Motion_Blur_Intensity
+        Option_Value_Motion_Blur_Intensity,
+        Option_Value_Lod_Pixel_Error // The screen space error, in pixels, a mesh LOD is allowed to have
     };
 
     enum Renderer_ToneMapping_Type
@@ -318,13 +323,18 @@ namespace Spartan
         // Constant buffers
         bool UpdateFrameBuffer();
         bool UpdateUberBuffer();
-        bool UpdateObjectBuffer(RHI_CommandList* cmd_list, const uint32_t entity_index = 0);
+        bool UpdateObjectBuffer(RHI_CommandList* cmd_list);
         bool UpdateLightBuffer(const Light* light);
 
         // Misc
-        void RenderablesAcquire(const Variant& renderables);
-        void RenderablesSort(std::vector<Entity*>* renderables);
-        void ClearEntities() { m_entities.clear(); }
+        void RenderablesAcquire();
+        void RenderablesAdd(Entity* entity);
+        void RenderablesRemove(Entity* entity);
+        void RenderablesSort();
+        void RenderablesCull();
+        void RenderablesBucket();
+        void DrawBatchesBuild(const std::vector<Entity*>& entities, const std::vector<uint32_t>& draws, const bool shadow_casters_only, const bool keep_order, const Math::Matrix& view_projection, const float viewport_height);
+        void ClearEntities();
 
         // Render textures
         std::unordered_map<Renderer_RenderTarget_Type, std::shared_ptr<RHI_Texture>> m_render_targets;
@@ -415,17 +425,73 @@ namespace Spartan
 
         BufferObject m_buffer_object_cpu;
         BufferObject m_buffer_object_cpu_previous;
+        uint64_t m_buffer_object_ring_version = 0;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_object_gpu;
 
+        std::shared_ptr<RHI_StructuredBuffer> m_buffer_instance_gpu;
+
         BufferLight m_buffer_light_cpu;
         BufferLight m_buffer_light_cpu_previous;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_gpu;
         //======================================================
 
         // Entities & Components
+        struct RenderableLocation
+        {
+            uint32_t object_mask    = 0; // the lists (Renderer_Object_Type bits) the entity is in
+            uint64_t sort_key       = 0; // the key the entity was inserted with into the opaque/transparent list
+        };
         std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities;
+        std::unordered_map<Renderer_Object_Type, std::vector<uint64_t>> m_entities_sort_keys; // parallel to the opaque/transparent lists
+        std::unordered_map<Entity*, RenderableLocation> m_entities_location;
+        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities_sorted; // opaque/transparent lists in draw order, rebuilt every frame
+        std::vector<uint64_t> m_draw_keys;
+        std::unordered_map<uint32_t, uint32_t> m_draw_key_shader_index;    // shader id -> dense index in the draw keys, rebuilt every frame
+        std::unordered_map<uint32_t, uint32_t> m_draw_key_material_index;  // material id -> dense index in the draw keys, rebuilt every frame
         std::shared_ptr<Camera> m_camera;
 
+        // Frustum culling
+        struct CullingView
+        {
+            const Math::Frustum* frustum    = nullptr;
+            bool ignore_near_plane          = false;
+        };
+        std::vector<CullingView> m_culling_views;                                                   // the camera first, then every shadow slice of every shadow casting light
+        std::unordered_map<const Light*, uint32_t> m_culling_views_light;                           // index of a light's first shadow slice view
+        std::unordered_map<Renderer_Object_Type, std::vector<std::vector<uint32_t>>> m_entities_visible; // per view, indices into m_entities_sorted
+        struct CullingTask
+        {
+            uint32_t view = 0;
+            Math::BoundingVolumeHierarchy::FrustumSubtree subtree;
+            std::vector<uint32_t> candidates;   // leaves which intersect the view, tested against their exact bounds
+            std::vector<uint32_t> visible;
+        };
+        static constexpr uint32_t culling_index_invalid     = 0xFFFFFFFF;
+        static constexpr uint32_t culling_parallel_threshold = 2048;                               // renderables, below this culling stays on the calling thread
+        std::vector<uint32_t> m_culling_proxy_index;                                                // scene query proxy -> culling index (opaque first, then transparent)
+        Math::BoundingBoxSoA m_culling_boxes;                                                       // exact bounds per culling index
+        std::vector<uint32_t> m_culling_unbounded;                                                  // culling indices of renderables without bounds, visible in every view
+        std::vector<Math::BoundingVolumeHierarchy::FrustumSubtree> m_culling_subtrees;
+        std::vector<CullingTask> m_culling_tasks;                                                   // kept around so their lists keep their memory
+        std::vector<uint32_t> m_culling_view_tasks;                                                 // per view, the first task (view_count + 1 entries)
+
+        // Draw buckets, the camera visible entities per shader variation id (indices into m_entities_sorted, in draw order)
+        std::unordered_map<Renderer_Object_Type, std::unordered_map<uint32_t, std::vector<uint32_t>>> m_draw_buckets;
+
+        // Draw batches, the draws of a pass which share geometry and material become one instanced draw (rebuilt by every pass, on the main thread)
+        struct DrawBatch
+        {
+            Renderable* renderable  = nullptr; // the first instance, all instances share its geometry and material
+            uint32_t instance_start = 0;       // index into m_draw_batch_instances
+            uint32_t instance_count = 0;
+            uint32_t index_offset   = 0;       // the level of detail of the view, all instances share it
+            uint32_t index_count    = 0;
+        };
+        std::vector<DrawBatch> m_draw_batches;
+        std::vector<Entity*> m_draw_batch_instances;          // the entities of every batch, contiguous per batch
+        std::vector<uint32_t> m_draw_batch_assignments;       // per draw, the batch it went into
+        std::unordered_map<size_t, uint32_t> m_draw_batch_lookup;
+
         // RHI Core
         std::shared_ptr<RHI_Device> m_rhi_device;
         std::shared_ptr<RHI_SwapChain> m_swap_chain;
@@ -434,6 +500,7 @@ namespace Spartan
 
         // Dependencies
         Profiler* m_profiler            = nullptr;
+        Threading* m_threading          = nullptr;
         ResourceCache* m_resource_cache = nullptr;
     };
 }
@@ -70,16 +70,6 @@ namespace Spartan
     {
         Math::Matrix transform;
 
-        Math::Vector4 mat_albedo;
-    
-        Math::Vector2 mat_tiling_uv;
-        Math::Vector2 mat_offset_uv;
-    
-        float mat_roughness_mul;
-        float mat_metallic_mul;
-        float mat_normal_mul;
-        float mat_height_mul;
-    
         Math::Vector4 color;
     
         Math::Vector3 transform_axis;
@@ -92,13 +82,6 @@ namespace Spartan
         {
             return
                 transform           == rhs.transform            &&
-                mat_albedo          == rhs.mat_albedo           &&
-                mat_tiling_uv       == rhs.mat_tiling_uv        &&
-                mat_offset_uv       == rhs.mat_offset_uv        &&
-                mat_roughness_mul   == rhs.mat_roughness_mul    &&
-                mat_metallic_mul    == rhs.mat_metallic_mul     &&
-                mat_normal_mul      == rhs.mat_normal_mul       &&
-                mat_height_mul      == rhs.mat_height_mul       &&
                 color               == rhs.color                &&
                 transform_axis      == rhs.transform_axis       &&
                 blur_sigma          == rhs.blur_sigma           &&
@@ -113,15 +96,41 @@ namespace Spartan
         Math::Matrix object;
         Math::Matrix wvp_current;
         Math::Matrix wvp_previous;
+        uint32_t instance_offset = 0; // instanced draws read their instances from here on (see BufferInstance)
+        Math::Vector3 padding;
+
+        // Material properties live here and not in BufferUber, every batch owns its element so batches can be recorded in parallel
+        Math::Vector4 mat_albedo;
+        Math::Vector2 mat_tiling_uv;
+        Math::Vector2 mat_offset_uv;
+        float mat_roughness_mul = 1.0f;
+        float mat_metallic_mul  = 1.0f;
+        float mat_normal_mul    = 1.0f;
+        float mat_height_mul    = 1.0f;
     
         bool operator==(const BufferObject& rhs) const
         {
             return
-                object          == rhs.object       &&
-                wvp_current     == rhs.wvp_current  &&
-                wvp_previous    == rhs.wvp_previous;
+                object              == rhs.object               &&
+                wvp_current         == rhs.wvp_current          &&
+                wvp_previous        == rhs.wvp_previous         &&
+                instance_offset     == rhs.instance_offset      &&
+                mat_albedo          == rhs.mat_albedo           &&
+                mat_tiling_uv       == rhs.mat_tiling_uv        &&
+                mat_offset_uv       == rhs.mat_offset_uv        &&
+                mat_roughness_mul   == rhs.mat_roughness_mul    &&
+                mat_metallic_mul    == rhs.mat_metallic_mul     &&
+                mat_normal_mul      == rhs.mat_normal_mul       &&
+                mat_height_mul      == rhs.mat_height_mul;
         }
     };
+
+    // Per instance - Lives in a structured buffer, instanced draws read BufferObject::instance_offset + SV_InstanceID
+    struct BufferInstance
+    {
+        Math::Matrix transform;     // world matrix, or world view projection matrix for the depth passes
+        Math::Matrix wvp_previous;  // for velocity
+    };
     
     // Light buffer
     struct BufferLight
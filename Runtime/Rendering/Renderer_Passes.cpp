@@ -20,6 +20,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES ==============================
+#include <atomic>
+#include <limits>
 #include "Renderer.h"
 #include "Model.h"
 #include "Font/Font.h"
@@ -28,6 +30,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Gizmos/Grid.h"
 #include "Gizmos/Transform_Gizmo.h"
 #include "../RHI/RHI_CommandList.h"
+#include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_VertexBuffer.h"
 #include "../RHI/RHI_PipelineState.h"
@@ -51,7 +55,7 @@ namespace Spartan
         // Constant buffers
         cmd_list->SetConstantBuffer(0, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_frame_gpu);
         cmd_list->SetConstantBuffer(1, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_uber_gpu);
-        cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader, m_buffer_object_gpu);
+        cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_object_gpu);
         cmd_list->SetConstantBuffer(3, RHI_Buffer_PixelShader, m_buffer_light_gpu);
         
         // Samplers
@@ -141,7 +145,7 @@ namespace Spartan
 			return;
 
         // Get entities
-        const auto& entities = m_entities[object_type];
+        const vector<Entity*>& entities = m_entities_sorted[object_type];
         if (entities.empty())
             return;
 
@@ -191,6 +195,9 @@ namespace Spartan
 
                 const Matrix& view_projection = light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
 
+                // Entities inside this slice's frustum
+                const vector<uint32_t>& entities_visible = m_entities_visible[object_type][m_culling_views_light[light] + array_index];
+
                 // Set appropriate rasterizer state
                 if (light->GetLightType() == LightType_Directional)
                 {
@@ -206,66 +213,75 @@ namespace Spartan
 
                 if (cmd_list->Begin(pipeline_state))
                 {
-                    // Only useful to minimize D3D11 state changes (Vulkan backend is smarter)
-                    uint32_t m_set_material_id = 0;
-
-                    for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
-                    {
-                        Entity* entity = entities[entity_index];
-
-                        // Acquire renderable component
-                        const auto& renderable = entity->GetRenderable();
-                        if (!renderable)
-                            continue;
+                    m_profiler->m_renderer_pass_light_depth_considered += static_cast<uint32_t>(entities_visible.size());
 
-                        // Skip meshes that don't cast shadows
-                        if (!renderable->GetCastShadows())
-                            continue;
+                    // Entities which share geometry and material are drawn with a single instanced draw
+                    DrawBatchesBuild(entities, entities_visible, true, transparent_pass, view_projection, static_cast<float>(tex_depth->GetHeight()));
+                    const uint32_t batch_count = static_cast<uint32_t>(m_draw_batches.size());
 
-                        // Acquire geometry
-                        const auto& model = renderable->GeometryModel();
-                        if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                            continue;
+                    // Every batch gets its own element of the object buffer and its instances a range of the instance buffer up front, so the batches can be recorded by multiple threads
+                    const uint32_t object_index     = m_buffer_object_gpu->AllocateRange(batch_count);
+                    const uint32_t instance_index   = m_buffer_instance_gpu->AllocateRange(static_cast<uint32_t>(m_draw_batch_instances.size()));
+                    atomic<uint32_t> drawn          = 0;
 
-                        // Acquire material
-                        const auto& material = renderable->GetMaterial();
-                        if (!material)
-                            continue;
-
-                        // Skip objects outside of the view frustum
-                        if (!light->IsInViewFrustrum(renderable, array_index))
-                            continue;
-
-                        // Bind material
-                        if (m_set_material_id != material->GetId())
+                    if (batch_count != 0 && object_index != numeric_limits<uint32_t>::max() && instance_index != numeric_limits<uint32_t>::max())
+                    {
+                        cmd_list->RecordParallel(batch_count, [this, &view_projection, object_index, instance_index, &drawn](RHI_CommandList* cmd_list, const uint32_t start, const uint32_t end)
                         {
-                            // Bind material textures
-                            RHI_Texture* tex_albedo = material->GetTexture_PtrRaw(TextureType_Albedo);
-                            cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+                            // Only useful to minimize D3D11 state changes (Vulkan backend is smarter)
+                            uint32_t set_material_id = 0;
 
-                            // Update uber buffer with material properties
-                            m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
-                            m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
-                            m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
-
-                            // Update constant buffer
-                            UpdateUberBuffer();
-
-                            m_set_material_id = material->GetId();
-                        }
-
-                        // Bind geometry
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
-
-                        // Update uber buffer with cascade transform
-                        m_buffer_object_cpu.object = entity->GetTransform()->GetMatrix() * view_projection;
-                        if (!UpdateObjectBuffer(cmd_list, array_index))
-                            continue;
-
-                        cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                            cmd_list->SetStructuredBuffer(31, m_buffer_instance_gpu);
 
+                            for (uint32_t batch_index = start; batch_index < end; batch_index++)
+                            {
+                                const DrawBatch& batch          = m_draw_batches[batch_index];
+                                const Renderable* renderable    = batch.renderable;
+                                const Model* model              = renderable->GeometryModel();
+                                Material* material              = renderable->GetMaterial().get();
+
+                                // Bind material
+                                if (set_material_id != material->GetId())
+                                {
+                                    // Bind material textures
+                                    RHI_Texture* tex_albedo = material->GetTexture_PtrRaw(TextureType_Albedo);
+                                    cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+
+                                    set_material_id = material->GetId();
+                                }
+
+                                // Bind geometry
+                                cmd_list->SetBufferIndex(model->GetIndexBuffer());
+                                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+
+                                // Update the instances with their cascade transforms
+                                BufferInstance* instances = static_cast<BufferInstance*>(m_buffer_instance_gpu->Map(instance_index + batch.instance_start));
+                                if (!instances)
+                                    continue;
+                                for (uint32_t i = 0; i < batch.instance_count; i++)
+                                {
+                                    instances[i].transform = m_draw_batch_instances[batch.instance_start + i]->GetTransform()->GetMatrix() * view_projection;
+                                }
+                                m_buffer_instance_gpu->Unmap();
+
+                                // Update object buffer with where the instances start and the material properties (the element belongs to this batch alone, so no locking)
+                                BufferObject* buffer = static_cast<BufferObject*>(m_buffer_object_gpu->Map(object_index + batch_index));
+                                if (!buffer)
+                                    continue;
+                                buffer->instance_offset = instance_index + batch.instance_start;
+                                buffer->mat_albedo      = material->GetColorAlbedo();
+                                buffer->mat_tiling_uv   = material->GetTiling();
+                                buffer->mat_offset_uv   = material->GetOffset();
+                                m_buffer_object_gpu->Unmap();
+                                cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_object_gpu, object_index + batch_index);
+
+                                cmd_list->DrawIndexed(batch.index_count, batch.index_offset, renderable->GeometryVertexOffset(), batch.instance_count);
+                                drawn.fetch_add(batch.instance_count, memory_order_relaxed);
+                            }
+                        });
                     }
+
+                    m_profiler->m_renderer_pass_light_depth_drawn += drawn;
                     cmd_list->End(); // end of array
                     cmd_list->Submit();
                 }
@@ -279,9 +295,10 @@ namespace Spartan
         // just their depth information into a depth map.
 
         // Acquire required resources/data
-        const auto& shader_depth    = m_shaders[Shader_Depth_V];
-        const auto& tex_depth       = m_render_targets[RenderTarget_Gbuffer_Depth];
-        const auto& entities        = m_entities[Renderer_Object_Opaque];
+        const auto& shader_depth        = m_shaders[Shader_Depth_V];
+        const auto& tex_depth           = m_render_targets[RenderTarget_Gbuffer_Depth];
+        const auto& entities            = m_entities_sorted[Renderer_Object_Opaque];
+        const auto& entities_visible    = m_entities_visible[Renderer_Object_Opaque][0];
 
         // Ensure the shader has compiled
         if (!shader_depth->IsCompiled())
@@ -303,46 +320,49 @@ namespace Spartan
         // Submit commands
         if (cmd_list->Begin(pipeline_state))
         { 
-            if (!entities.empty())
+            m_profiler->m_renderer_pass_depth_prepass_considered += static_cast<uint32_t>(entities_visible.size());
+
+            // Entities which share geometry (and material) are drawn with a single instanced draw
+            DrawBatchesBuild(entities, entities_visible, false, false, m_buffer_frame_cpu.view_projection, static_cast<float>(tex_depth->GetHeight()));
+            const uint32_t batch_count      = static_cast<uint32_t>(m_draw_batches.size());
+            const uint32_t object_index     = m_buffer_object_gpu->AllocateRange(batch_count);
+            const uint32_t instance_index   = m_buffer_instance_gpu->AllocateRange(static_cast<uint32_t>(m_draw_batch_instances.size()));
+
+            if (batch_count != 0 && object_index != numeric_limits<uint32_t>::max() && instance_index != numeric_limits<uint32_t>::max())
             {
-                // Variables that help reduce state changes
-                uint32_t currently_bound_geometry = 0;
+                cmd_list->SetStructuredBuffer(31, m_buffer_instance_gpu);
 
-                // Draw opaque
-                for (const auto& entity : entities)
+                for (uint32_t batch_index = 0; batch_index < batch_count; batch_index++)
                 {
-                    // Get renderable
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
+                    const DrawBatch& batch          = m_draw_batches[batch_index];
+                    const Renderable* renderable    = batch.renderable;
+                    const Model* model              = renderable->GeometryModel();
 
-                    // Get geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+                    // Bind geometry (will only happen if not already set)
+                    cmd_list->SetBufferIndex(model->GetIndexBuffer());
+                    cmd_list->SetBufferVertex(model->GetVertexBuffer());
 
-                    // Skip objects outside of the view frustum
-                    if (!m_camera->IsInViewFrustrum(renderable))
+                    // Update the instances with their transforms
+                    BufferInstance* instances = static_cast<BufferInstance*>(m_buffer_instance_gpu->Map(instance_index + batch.instance_start));
+                    if (!instances)
                         continue;
-
-                    // Bind geometry
-                    if (currently_bound_geometry != model->GetId())
+                    for (uint32_t i = 0; i < batch.instance_count; i++)
                     {
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                        currently_bound_geometry = model->GetId();
+                        instances[i].transform = m_draw_batch_instances[batch.instance_start + i]->GetTransform()->GetMatrix() * m_buffer_frame_cpu.view_projection;
                     }
+                    m_buffer_instance_gpu->Unmap();
 
-                    // Update uber buffer with entity transform
-                    if (Transform* transform = entity->GetTransform())
-                    {
-                        // Update uber buffer with cascade transform
-                        m_buffer_uber_cpu.transform = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                        UpdateUberBuffer(); // only updates if needed
-                    }
+                    // Update object buffer with where the instances start
+                    BufferObject* buffer = static_cast<BufferObject*>(m_buffer_object_gpu->Map(object_index + batch_index));
+                    if (!buffer)
+                        continue;
+                    buffer->instance_offset = instance_index + batch.instance_start;
+                    m_buffer_object_gpu->Unmap();
+                    cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader, m_buffer_object_gpu, object_index + batch_index);
 
-                    // Draw	
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                    // Draw
+                    cmd_list->DrawIndexed(batch.index_count, batch.index_offset, renderable->GeometryVertexOffset(), batch.instance_count);
+                    m_profiler->m_renderer_pass_depth_prepass_drawn += batch.instance_count;
                 }
             }
             cmd_list->End();
@@ -391,113 +411,120 @@ namespace Spartan
         // Clear
         cmd_list->Clear(pso);
 
-        // Only useful to minimize D3D11 state changes (Vulkan backend is smarter)
-        uint32_t m_set_material_id = 0;
-        
+        const auto& entities    = m_entities_sorted[object_type];
+        auto& buckets           = m_draw_buckets[object_type];
+
         // Iterate through all the G-Buffer shader variations
         for (const shared_ptr<ShaderVariation>& resource : ShaderVariation::GetVariations())
         {
             if (!resource->IsCompiled())
                 continue;
 
+            // Only the entities that use this variation
+            const auto it = buckets.find(resource->GetId());
+            if (it == buckets.end() || it->second.empty())
+                continue;
+
             // Set pixel shader
             pso.shader_pixel = static_cast<RHI_Shader*>(resource.get());
 
             // Set pass name
             pso.pass_name = pso.shader_pixel->GetName().c_str();
 
-            auto& entities = m_entities[object_type];
-
             // Submit command list
             if (cmd_list->Begin(pso))
             {
-                for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
-                {
-                    Entity* entity = entities[i];
+                // Entities which share geometry and material are drawn with a single instanced draw
+                DrawBatchesBuild(entities, it->second, false, is_transparent, m_buffer_frame_cpu.view_projection, static_cast<float>(tex_depth->GetHeight()));
+                const uint32_t batch_count = static_cast<uint32_t>(m_draw_batches.size());
 
-                    // Get renderable
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
-
-                    // Get material
-                    Material* material = renderable->GetMaterial().get();
-                    if (!material)
-                        continue;
+                // Every batch gets its own element of the object buffer and its instances a range of the instance buffer up front, so the batches can be recorded by multiple threads
+                const uint32_t object_index     = m_buffer_object_gpu->AllocateRange(batch_count);
+                const uint32_t instance_index   = m_buffer_instance_gpu->AllocateRange(static_cast<uint32_t>(m_draw_batch_instances.size()));
+                atomic<uint32_t> drawn          = 0;
 
-                    // Skip transparent objects that won't contribute
-                    if (material->GetColorAlbedo().w == 0 && is_transparent)
-                        continue;
+                if (batch_count != 0 && object_index != numeric_limits<uint32_t>::max() && instance_index != numeric_limits<uint32_t>::max())
+                {
+                    cmd_list->RecordParallel(batch_count, [this, object_index, instance_index, &drawn](RHI_CommandList* cmd_list, const uint32_t start, const uint32_t end)
+                    {
+                        // Only useful to minimize D3D11 state changes (Vulkan backend is smarter)
+                        uint32_t set_material_id = 0;
 
-                    // Get shader
-                    const auto& shader = material->GetShader();
-                    if (!shader || !shader->IsCompiled())
-                        continue;
+                        cmd_list->SetStructuredBuffer(31, m_buffer_instance_gpu);
 
-                    // Get geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+                        for (uint32_t batch_index = start; batch_index < end; batch_index++)
+                        {
+                            const DrawBatch& batch          = m_draw_batches[batch_index];
+                            const Renderable* renderable    = batch.renderable;
+                            const Model* model              = renderable->GeometryModel();
+                            Material* material              = renderable->GetMaterial().get();
 
-                    // Draw matching shader entities
-                    if (pso.shader_pixel->GetId() == shader->GetId())
-                    {
-                        // Skip objects outside of the view frustum
-                        if (!m_camera->IsInViewFrustrum(renderable))
-                            continue;
+                            // Set geometry (will only happen if not already set)
+                            cmd_list->SetBufferIndex(model->GetIndexBuffer());
+                            cmd_list->SetBufferVertex(model->GetVertexBuffer());
 
-                        // Set geometry (will only happen if not already set)
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                            // Bind material
+                            if (set_material_id != material->GetId())
+                            {
+                                // Bind material textures		
+                                cmd_list->SetTexture(0, material->GetTexture_PtrRaw(TextureType_Albedo));
+                                cmd_list->SetTexture(1, material->GetTexture_PtrRaw(TextureType_Roughness));
+                                cmd_list->SetTexture(2, material->GetTexture_PtrRaw(TextureType_Metallic));
+                                cmd_list->SetTexture(3, material->GetTexture_PtrRaw(TextureType_Normal));
+                                cmd_list->SetTexture(4, material->GetTexture_PtrRaw(TextureType_Height));
+                                cmd_list->SetTexture(5, material->GetTexture_PtrRaw(TextureType_Occlusion));
+                                cmd_list->SetTexture(6, material->GetTexture_PtrRaw(TextureType_Emission));
+                                cmd_list->SetTexture(7, material->GetTexture_PtrRaw(TextureType_Mask));
+
+                                set_material_id = material->GetId();
+                            }
 
-                        // Bind material
-                        if (m_set_material_id != material->GetId())
-                        {
-                            // Bind material textures		
-                            cmd_list->SetTexture(0, material->GetTexture_PtrRaw(TextureType_Albedo));
-                            cmd_list->SetTexture(1, material->GetTexture_PtrRaw(TextureType_Roughness));
-                            cmd_list->SetTexture(2, material->GetTexture_PtrRaw(TextureType_Metallic));
-                            cmd_list->SetTexture(3, material->GetTexture_PtrRaw(TextureType_Normal));
-                            cmd_list->SetTexture(4, material->GetTexture_PtrRaw(TextureType_Height));
-                            cmd_list->SetTexture(5, material->GetTexture_PtrRaw(TextureType_Occlusion));
-                            cmd_list->SetTexture(6, material->GetTexture_PtrRaw(TextureType_Emission));
-                            cmd_list->SetTexture(7, material->GetTexture_PtrRaw(TextureType_Mask));
-                        
-                            // Update uber buffer with material properties
-                            m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
-                            m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
-                            m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
-                            m_buffer_uber_cpu.mat_roughness_mul = material->GetMultiplier(TextureType_Roughness);
-                            m_buffer_uber_cpu.mat_metallic_mul  = material->GetMultiplier(TextureType_Metallic);
-                            m_buffer_uber_cpu.mat_normal_mul    = material->GetMultiplier(TextureType_Normal);
-                            m_buffer_uber_cpu.mat_height_mul    = material->GetMultiplier(TextureType_Height);
-
-                            // Update constant buffer
-                            UpdateUberBuffer();
-
-                            m_set_material_id = material->GetId();
-                        }
-                        
-                        // Update uber buffer with entity transform
-                        if (Transform* transform = entity->GetTransform())
-                        {
-                            m_buffer_object_cpu.object          = transform->GetMatrix();
-                            m_buffer_object_cpu.wvp_current     = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                            m_buffer_object_cpu.wvp_previous    = transform->GetWvpLastFrame();
+                            // Update the instances with their transforms (matrices were resolved during culling, so this is only reading)
+                            BufferInstance* instances = static_cast<BufferInstance*>(m_buffer_instance_gpu->Map(instance_index + batch.instance_start));
+                            if (!instances)
+                                continue;
+                            for (uint32_t i = 0; i < batch.instance_count; i++)
+                            {
+                                Transform* transform = m_draw_batch_instances[batch.instance_start + i]->GetTransform();
 
-                            // Save matrix for velocity computation
-                            transform->SetWvpLastFrame(m_buffer_object_cpu.wvp_current);
+                                instances[i].transform      = transform->GetMatrix();
+                                instances[i].wvp_previous   = transform->GetWvpLastFrame();
+                            }
+                            m_buffer_instance_gpu->Unmap();
 
-                            // Update object buffer
-                            if (!UpdateObjectBuffer(cmd_list, i))
+                            // Update object buffer with where the instances start and the material properties (the element belongs to this batch alone, so no locking)
+                            BufferObject* buffer = static_cast<BufferObject*>(m_buffer_object_gpu->Map(object_index + batch_index));
+                            if (!buffer)
                                 continue;
+                            buffer->instance_offset     = instance_index + batch.instance_start;
+                            buffer->mat_albedo          = material->GetColorAlbedo();
+                            buffer->mat_tiling_uv       = material->GetTiling();
+                            buffer->mat_offset_uv       = material->GetOffset();
+                            buffer->mat_roughness_mul   = material->GetMultiplier(TextureType_Roughness);
+                            buffer->mat_metallic_mul    = material->GetMultiplier(TextureType_Metallic);
+                            buffer->mat_normal_mul      = material->GetMultiplier(TextureType_Normal);
+                            buffer->mat_height_mul      = material->GetMultiplier(TextureType_Height);
+                            m_buffer_object_gpu->Unmap();
+                            cmd_list->SetConstantBuffer(2, RHI_Buffer_VertexShader | RHI_Buffer_PixelShader, m_buffer_object_gpu, object_index + batch_index);
+
+                            // Render
+                            cmd_list->DrawIndexed(batch.index_count, batch.index_offset, renderable->GeometryVertexOffset(), batch.instance_count);
+                            drawn.fetch_add(batch.instance_count, memory_order_relaxed);
                         }
-                        
-                        // Render	
-                        cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                        m_profiler->m_renderer_meshes_rendered++;
+                    });
+
+                    // Save matrices for velocity computation, this happens here on the calling thread once recording has finished, so the
+                    // recording threads only ever read them and every transform is written exactly once per frame (an entity is drawn by a single G-Buffer pass)
+                    for (Entity* entity : m_draw_batch_instances)
+                    {
+                        Transform* transform = entity->GetTransform();
+                        transform->SetWvpLastFrame(transform->GetMatrix() * m_buffer_frame_cpu.view_projection);
                     }
                 }
+
+                m_profiler->m_renderer_meshes_rendered      += drawn;
+                m_profiler->m_renderer_pass_gbuffer_drawn   += drawn;
+
                 cmd_list->End();
                 cmd_list->Submit();
             }
@@ -28,8 +28,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Sampler.h"
 #include "../RHI/RHI_BlendState.h"
 #include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_RasterizerState.h"
 #include "../RHI/RHI_DepthStencilState.h"
+#include "../RHI/RHI_UploadManager.h"
+#include "../RHI/RHI_Device.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -49,7 +52,10 @@ namespace Spartan
 
         bool is_dynamic = true;
         m_buffer_object_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, is_dynamic);
-        m_buffer_object_gpu->Create<BufferObject>();
+        m_buffer_object_gpu->Create<BufferObject>(256); // per frame, grows as needed
+
+        m_buffer_instance_gpu = make_shared<RHI_StructuredBuffer>(m_rhi_device);
+        m_buffer_instance_gpu->Create<BufferInstance>(4096); // per frame, grows as needed
 
         m_buffer_light_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device);
         m_buffer_light_gpu->Create<BufferLight>();
@@ -383,6 +389,11 @@ namespace Spartan
         m_tex_black = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
         m_tex_black->LoadFromFile(dir_texture + "black.png");
 
+        // These are what get bound while other textures are still uploading, so they have to be resident right away
+        RHI_UploadManager* upload_manager = m_rhi_device->GetUploadManager();
+        upload_manager->Wait(m_tex_white->GetUploadToken());
+        upload_manager->Wait(m_tex_black->GetUploadToken());
+
         // Gizmo icons
         m_gizmo_tex_light_directional = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
         m_gizmo_tex_light_directional->LoadFromFile(dir_texture + "sun.png");
@@ -19,9 +19,16 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ===============
+//= INCLUDES ===========================
+#include <algorithm>
 #include "ShaderVariation.h"
-//==========================
+#include "Material.h"
+#include "Renderer.h"
+#include "../Core/Stopwatch.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ProgressReport.h"
+#include "../Logging/Log.h"
+//======================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -30,17 +37,112 @@ using namespace std;
 namespace Spartan
 {
 	vector<shared_ptr<ShaderVariation>> ShaderVariation::m_variations;
+	array<shared_ptr<ShaderVariation>, variation_permutation_count> ShaderVariation::m_variations_by_flags;
+	mutex ShaderVariation::m_variations_mutex;
 
-	const shared_ptr<ShaderVariation>& ShaderVariation::GetMatchingShader(const unsigned long flags)
+	shared_ptr<ShaderVariation> ShaderVariation::GetOrCreate(Context* context, const unsigned long flags)
 	{
-		for (const auto& shader : m_variations)
+		if (!context || flags >= variation_permutation_count)
 		{
-			if (shader->GetShaderFlags() == flags)
-				return shader;
+			LOG_ERROR_INVALID_PARAMETER();
+			return nullptr;
 		}
 
+		// Lookup and creation have to be atomic, otherwise two threads asking for the same flags would both compile it
+		lock_guard<mutex> lock(m_variations_mutex);
+
+		// If an appropriate shader already exists, return it instead
+		if (const shared_ptr<ShaderVariation>& existing_shader = m_variations_by_flags[flags])
+			return existing_shader;
+
+		// Create and compile shader
+		auto shader = make_shared<ShaderVariation>(context->GetSubsystem<Renderer>()->GetRhiDevice(), context);
+		const auto dir_shaders = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/";
+		shader->Compile(dir_shaders + "GBuffer.hlsl", flags);
+
+		return shader;
+	}
+
+	const shared_ptr<ShaderVariation>& ShaderVariation::GetMatchingShader(const unsigned long flags)
+	{
 		static shared_ptr<ShaderVariation> empty;
-		return empty;
+		if (flags >= variation_permutation_count)
+			return empty;
+
+		// Slots are written once and never reset, so the reference stays valid after the lock is released
+		lock_guard<mutex> lock(m_variations_mutex);
+		return m_variations_by_flags[flags];
+	}
+
+	vector<shared_ptr<ShaderVariation>> ShaderVariation::GetVariations()
+	{
+		lock_guard<mutex> lock(m_variations_mutex);
+		return m_variations;
+	}
+
+	vector<unsigned long> ShaderVariation::BuildManifest(Context* context)
+	{
+		vector<unsigned long> manifest;
+
+		for (const shared_ptr<IResource>& resource : context->GetSubsystem<ResourceCache>()->GetByType(Resource_Material))
+		{
+			const unsigned long flags = static_cast<Material*>(resource.get())->GetShaderFlags();
+			if (find(manifest.begin(), manifest.end(), flags) == manifest.end())
+			{
+				manifest.emplace_back(flags);
+			}
+		}
+
+		return manifest;
+	}
+
+	void ShaderVariation::Precompile(Context* context, const vector<unsigned long>& manifest, const int progress_id)
+	{
+		if (manifest.empty())
+			return;
+
+		Stopwatch timer;
+
+		ProgressReport::Get().SetStatus(progress_id, "Compiling shaders...");
+		ProgressReport::Get().SetJobCount(progress_id, static_cast<int>(manifest.size()));
+		ProgressReport::Get().SetJobsDone(progress_id, 0);
+
+		// Kick off every missing variation, each one is compiled as a separate task so they spread across all the threads
+		vector<shared_ptr<ShaderVariation>> variations;
+		variations.reserve(manifest.size());
+		for (const unsigned long flags : manifest)
+		{
+			if (shared_ptr<ShaderVariation> variation = GetOrCreate(context, flags))
+			{
+				variations.emplace_back(variation);
+			}
+		}
+
+		// Wait for all of them (including the ones that were already compiling), this thread helps out with other jobs in the meantime
+		Threading* threading	= context->GetSubsystem<Threading>();
+		uint32_t failed			= 0;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(variations.size()); i++)
+		{
+			const shared_ptr<ShaderVariation>& variation = variations[i];
+			threading->Wait(variation->m_compilation_job);
+
+			if (!variation->IsCompiled())
+			{
+				LOG_ERROR("Failed to compile shader variation with flags %lu", variation->GetShaderFlags());
+				failed++;
+			}
+
+			ProgressReport::Get().SetJobsDone(progress_id, static_cast<int>(i + 1));
+		}
+
+		if (failed != 0)
+		{
+			LOG_ERROR("Failed to pre-warm %d out of %d shader variations", static_cast<int>(failed), static_cast<int>(variations.size()));
+		}
+		else
+		{
+			LOG_INFO("Pre-warmed %d shader variations in %.2f ms", static_cast<int>(variations.size()), timer.GetElapsedTimeMs());
+		}
 	}
 
 	ShaderVariation::ShaderVariation(const shared_ptr<RHI_Device>& rhi_device, Context* context) : RHI_Shader(rhi_device)
@@ -55,9 +157,10 @@ namespace Spartan
 
 		// Load and compile the pixel shader
 		AddDefinesBasedOnMaterial();
-		CompileAsync(m_context, Shader_Pixel, file_path);
+		m_compilation_job = CompileAsync(m_context, Shader_Pixel, file_path);
 
 		m_variations.emplace_back(shared_from_this());
+		m_variations_by_flags[shader_flags] = m_variations.back();
 	}
 
 	void ShaderVariation::AddDefinesBasedOnMaterial()
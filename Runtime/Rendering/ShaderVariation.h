@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <vector>
+#include <array>
+#include <mutex>
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Shader.h"
 //================================
@@ -42,6 +44,9 @@ namespace Spartan
 		Variation_Mask		= 1UL << 7
 	};
 
+	// Every combination of the flags above
+	static const unsigned long variation_permutation_count = 1UL << 8;
+
 	class ShaderVariation : public RHI_Shader, public std::enable_shared_from_this<ShaderVariation>
 	{
 	public:
@@ -61,14 +66,23 @@ namespace Spartan
 		bool HasMaskTexture() const				{ return m_flags & Variation_Mask; }
 
 		// Variation cache
+		static std::shared_ptr<ShaderVariation> GetOrCreate(Context* context, unsigned long flags);
 		static const std::shared_ptr<ShaderVariation>& GetMatchingShader(unsigned long flags);
-        static const auto& GetVariations() { return m_variations; }
+		static std::vector<std::shared_ptr<ShaderVariation>> GetVariations(); // a snapshot, variations can be added by other threads while it's iterated
+
+		// Pre-warming - the manifest holds the flags of every variation the cached materials need,
+		// Precompile() compiles the missing ones across all the threads, waits on their jobs and reports the ones that failed.
+		static std::vector<unsigned long> BuildManifest(Context* context);
+		static void Precompile(Context* context, const std::vector<unsigned long>& manifest, int progress_id);
 
 	private:
 		void AddDefinesBasedOnMaterial();
 		
 		Context* m_context;
-		unsigned long m_flags;	
+		unsigned long m_flags;
+		JobHandle m_compilation_job;
 		static std::vector<std::shared_ptr<ShaderVariation>> m_variations;
+		static std::array<std::shared_ptr<ShaderVariation>, variation_permutation_count> m_variations_by_flags;
+		static std::mutex m_variations_mutex;
 	};
 }
@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ============================
 #include "IResource.h"
+#include "ResourceCache.h"
 #include "../Audio/AudioClip.h"
 #include "../Rendering/Model.h"
 #include "../Rendering/Font/Font.h"
@@ -42,6 +43,49 @@ IResource::IResource(Context* context, const Resource_Type type)
 	m_load_state	= LoadState_Idle;
 }
 
+void IResource::SetResourceFilePath(const string& path)
+{
+    const bool is_native_file = FileSystem::IsEngineMaterialFile(path) || FileSystem::IsEngineModelFile(path);
+
+    // If this is an native engine file, don't do a file check as no actual foreign material exists (it was created on the fly)
+    if (!is_native_file)
+    {
+        if (!FileSystem::IsFile(path))
+        {
+            LOG_ERROR("\"%s\" is not a valid file path", path.c_str());
+            return;
+        }
+    }
+
+    const string file_path_relative = FileSystem::GetRelativePath(path);
+    const string name_old           = m_resource_name;
+    const string path_native_old    = m_resource_file_path_native;
+
+    // Foreign file
+    if (!FileSystem::IsEngineFile(path))
+    {
+        m_resource_file_path_foreign    = file_path_relative;
+        m_resource_file_path_native     = FileSystem::NativizeFilePath(file_path_relative);
+    }
+    // Native file
+    else
+    {
+        m_resource_file_path_foreign.clear();
+        m_resource_file_path_native = file_path_relative;
+    }
+    m_resource_name                 = FileSystem::GetFileNameNoExtensionFromFilePath(file_path_relative);
+    m_resource_directory            = FileSystem::GetDirectoryFromFilePath(file_path_relative);
+
+    // The cache indexes resources by name and path
+    if (m_resource_name != name_old || m_resource_file_path_native != path_native_old)
+    {
+        if (ResourceCache* resource_cache = m_context ? m_context->GetSubsystem<ResourceCache>() : nullptr)
+        {
+            resource_cache->Rekey(this, name_old, path_native_old);
+        }
+    }
+}
+
 template <typename T>
 inline constexpr Resource_Type IResource::TypeToEnum() { return Resource_Unknown; }
 
@@ -60,37 +60,8 @@ namespace Spartan
 		IResource(Context* context, Resource_Type type);
 		virtual ~IResource() = default;
 
-		void SetResourceFilePath(const std::string& path)
-        {
-            const bool is_native_file = FileSystem::IsEngineMaterialFile(path) || FileSystem::IsEngineModelFile(path);
-
-            // If this is an native engine file, don't do a file check as no actual foreign material exists (it was created on the fly)
-            if (!is_native_file)
-            {
-                if (!FileSystem::IsFile(path))
-                {
-                    LOG_ERROR("\"%s\" is not a valid file path", path.c_str());
-                    return;
-                }
-            }
-
-            const std::string file_path_relative = FileSystem::GetRelativePath(path);
-
-            // Foreign file
-            if (!FileSystem::IsEngineFile(path))
-            {
-                m_resource_file_path_foreign    = file_path_relative;
-                m_resource_file_path_native     = FileSystem::NativizeFilePath(file_path_relative);
-            }
-            // Native file
-            else
-            {
-                m_resource_file_path_foreign.clear();
-                m_resource_file_path_native = file_path_relative;
-            }
-            m_resource_name                 = FileSystem::GetFileNameNoExtensionFromFilePath(file_path_relative);
-            m_resource_directory            = FileSystem::GetDirectoryFromFilePath(file_path_relative);
-        }
+		// Also re-keys the resource in the resource cache, if it's cached
+		void SetResourceFilePath(const std::string& path);
         
         Resource_Type GetResourceType()                 const { return m_resource_type; }
         const char* GetResourceTypeCstr()               const { return typeid(*this).name(); }
@@ -46,7 +46,6 @@ namespace _ImagImporter
 		uint32_t height		    = 0;
 		uint32_t channels	    = 0;
 		vector<std::byte>* data	= nullptr;
-		bool done			    = false;
 
 		RescaleJob(const uint32_t width, const uint32_t height, const uint32_t channels)
 		{
@@ -225,9 +224,11 @@ namespace Spartan
 
 		// Parallelize mipmap generation using multiple threads (because FreeImage_Rescale() using FILTER_LANCZOS3 is expensive)
 		auto threading = m_context->GetSubsystem<Threading>();
+		vector<JobHandle> handles;
+		handles.reserve(jobs.size());
 		for (auto& job : jobs)
 		{
-			threading->AddTask([this, &job, &bitmap]()
+			handles.emplace_back(threading->AddTask([this, &job, &bitmap]()
 			{
 				const auto bitmap_scaled = FreeImage_Rescale(bitmap, job.width, job.height, _ImagImporter::rescale_filter);
 				if (!GetBitsFromFibitmap(job.data, bitmap_scaled, job.width, job.height, job.channels))
@@ -235,22 +236,13 @@ namespace Spartan
 					LOG_ERROR("Failed to create mip level %dx%d", job.width, job.height);
 				}
 				FreeImage_Unload(bitmap_scaled);
-				job.done = true;
-			});
+			}));
 		}
 
 		// Wait until all mipmaps have been generated
-		auto ready = false;
-		while (!ready)
+		for (const auto& handle : handles)
 		{
-			ready = true;
-			for (const auto& job : jobs)
-			{
-				if (!job.done)
-				{
-					ready = false;
-				}
-			}
+			threading->Wait(handle);
 		}
 	}
 
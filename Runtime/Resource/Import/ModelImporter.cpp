@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =================================
 #include "ModelImporter.h"
+#include <unordered_set>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/version.h>
@@ -28,11 +29,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../ProgressReport.h"
 #include "../../RHI/RHI_Texture.h"
 #include "../../Core/Settings.h"
+#include "../../Rendering/Mesh.h"
 #include "../../Rendering/Model.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Material.h"
+#include "../../Rendering/MeshSimplifier.h"
 #include "../../World/World.h"
 #include "../../World/Components/Renderable.h"
+#include "../../World/Components/Transform.h"
+#include "../../Threading/Threading.h"
 //============================================
 
 //= NAMESPACES ================
@@ -134,6 +139,8 @@ namespace Spartan
 			ParseNode(scene->mRootNode, params, nullptr, new_entity.get());
             // Parse animations
 			ParseAnimations(params);
+            // Simplify the meshes
+            BuildLods(new_entity.get(), params);
             // Update model geometry
 			model->UpdateGeometry();
 
@@ -256,6 +263,64 @@ namespace Spartan
 		}
 	}
 
+    void ModelImporter::BuildLods(Entity* root, const ModelParams& params) const
+    {
+        struct MeshLods
+        {
+            const Renderable* renderable = nullptr;
+            vector<vector<uint32_t>> indices;
+            vector<float> errors;
+        };
+
+        // The meshes of the model, once each (renderables can share a mesh)
+        vector<MeshLods> meshes;
+        {
+            vector<Transform*> descendants;
+            root->GetTransform()->GetDescendants(&descendants);
+            descendants.emplace_back(root->GetTransform());
+
+            unordered_set<uint32_t> index_offsets;
+            for (Transform* transform : descendants)
+            {
+                const Renderable* renderable = transform->GetEntity()->GetComponent<Renderable>();
+                if (!renderable || renderable->GeometryModel() != params.model || renderable->GeometryIndexCount() < MeshSimplifier::level_index_count_min * 2)
+                    continue;
+
+                if (index_offsets.emplace(renderable->GeometryIndexOffset()).second)
+                {
+                    meshes.emplace_back().renderable = renderable;
+                }
+            }
+        }
+
+        ProgressReport::Get().SetStatus(g_progress_model_importer, "Simplifying meshes...");
+
+        // The meshes are independent of each other, so they are simplified in parallel (the model's geometry is only read)
+        Mesh* mesh = params.model->GetMesh().get();
+        m_context->GetSubsystem<Threading>()->ParallelFor([&meshes, mesh](const uint32_t start, const uint32_t end)
+        {
+            const auto& mesh_indices    = mesh->Indices_Get();
+            const auto& mesh_vertices   = mesh->Vertices_Get();
+
+            for (uint32_t i = start; i < end; i++)
+            {
+                MeshLods& lods                          = meshes[i];
+                const RHI_Vertex_PosTexNorTan* vertices = mesh_vertices.data() + lods.renderable->GeometryVertexOffset();
+                const uint32_t* indices                 = mesh_indices.data() + lods.renderable->GeometryIndexOffset();
+                MeshSimplifier::SimplifyLevels(vertices, lods.renderable->GeometryVertexCount(), indices, lods.renderable->GeometryIndexCount(), MeshSimplifier::level_count_max, MeshSimplifier::level_index_count_min, &lods.indices, &lods.errors);
+            }
+        }, static_cast<uint32_t>(meshes.size()), 1);
+
+        // Appending grows the model's index buffer, so it happens after every mesh has been read
+        for (const MeshLods& lods : meshes)
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(lods.indices.size()); i++)
+            {
+                params.model->AppendLod(lods.renderable->GeometryIndexOffset(), lods.indices[i], lods.errors[i]);
+            }
+        }
+    }
+
 	void ModelImporter::LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params)
 	{
 		if (!assimp_mesh || !entity_parent)
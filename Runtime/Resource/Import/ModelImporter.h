@@ -67,6 +67,9 @@ namespace Spartan
         void ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, const ModelParams& params);
         void ParseAnimations(const ModelParams& params);
 
+        // Level of detail
+        void BuildLods(Entity* root, const ModelParams& params) const;
+
         // Loading
 		void LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params);
         void LoadBones(const aiMesh* assimp_mesh, const ModelParams& params);
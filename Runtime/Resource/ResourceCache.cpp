@@ -20,6 +20,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES ======================
+#include <algorithm>
 #include "ResourceCache.h"
 #include "ProgressReport.h"
 #include "Import/ImageImporter.h"
@@ -28,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../World/World.h"
 #include "../World/Entity.h"
 #include "../IO/FileStream.h"
+#include "../Threading/Threading.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../Audio/AudioClip.h"
@@ -46,6 +48,7 @@ namespace Spartan
         const string data_dir = "Data/";
 
 		// Add engine standard resource directories
+		AddDataDirectory(Asset_Cache,			data_dir + "cache");
 		AddDataDirectory(Asset_Cubemaps,		data_dir + "environment");
 		AddDataDirectory(Asset_Fonts,			data_dir + "fonts");
 		AddDataDirectory(Asset_Icons,			data_dir + "icons");
@@ -87,46 +90,135 @@ namespace Spartan
 			return false;
 		}
 
-		for (const auto& resource : m_resource_groups[resource_type])
-		{
-			if (resource_name == resource->GetResourceName())
-				return true;
-		}
-
-		return false;
+		return GetByName(resource_name, resource_type) != nullptr;
 	}
 
-	shared_ptr<IResource>& ResourceCache::GetByName(const string& name, const Resource_Type type)
+	shared_ptr<IResource> ResourceCache::GetByName(const string& name, const Resource_Type type)
 	{
-		for (auto& resource : m_resource_groups[type])
-		{
-			if (name == resource->GetResourceName())
-				return resource;
-		}
+        shared_lock<shared_mutex> lock(m_mutex);
+
+        const auto group = m_resource_groups.find(type);
+        if (group == m_resource_groups.end())
+            return nullptr;
 
-        static shared_ptr<IResource> empty;
-		return empty;
+        const auto it = group->second.index_name.find(name);
+        return it != group->second.index_name.end() ? it->second : nullptr;
 	}
 
+    shared_ptr<IResource> ResourceCache::GetByPath(const string& path, const Resource_Type type)
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+
+        const auto group = m_resource_groups.find(type);
+        if (group == m_resource_groups.end())
+            return nullptr;
+
+        const auto it = group->second.index_path.find(path);
+        return it != group->second.index_path.end() ? it->second : nullptr;
+    }
+
 	vector<shared_ptr<IResource>> ResourceCache::GetByType(const Resource_Type type /*= Resource_Unknown*/)
 	{
+        shared_lock<shared_mutex> lock(m_mutex);
+
 		vector<shared_ptr<IResource>> resources;
 
 		if (type == Resource_Unknown)
 		{
 			for (const auto& resource_group : m_resource_groups)
 			{
-				resources.insert(resources.end(), resource_group.second.begin(), resource_group.second.end());
+				resources.insert(resources.end(), resource_group.second.resources.begin(), resource_group.second.resources.end());
 			}
 		}
 		else
 		{
-			resources = m_resource_groups[type];
+            const auto group = m_resource_groups.find(type);
+            if (group != m_resource_groups.end())
+            {
+                resources = group->second.resources;
+            }
 		}
 
 		return resources;
 	}
 
+    void ResourceCache::Clear()
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        m_resource_groups.clear();
+    }
+
+    shared_ptr<IResource> ResourceCache::CacheInternal(const shared_ptr<IResource>& resource)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+
+        ResourceGroup& group = m_resource_groups[resource->GetResourceType()];
+
+        // Checking and inserting under the same lock, so that two threads can't cache the same name
+        const auto result = group.index_name.emplace(resource->GetResourceName(), resource);
+        if (!result.second)
+            return result.first->second;
+
+        group.index_path.emplace(resource->GetResourceFilePathNative(), resource); // keep the first resource with a given path
+        group.resources.emplace_back(resource);
+
+        return resource;
+    }
+
+    void ResourceCache::RemoveInternal(const shared_ptr<IResource>& resource)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+
+        const auto group = m_resource_groups.find(resource->GetResourceType());
+        if (group == m_resource_groups.end())
+            return;
+
+        auto& resources = group->second.resources;
+        const auto it = find(resources.begin(), resources.end(), resource);
+        if (it == resources.end())
+            return;
+        resources.erase(it);
+
+        // Only erase index entries that point to this resource
+        const auto erase_from_index = [&resource](unordered_map<string, shared_ptr<IResource>>& index, const string& key)
+        {
+            const auto entry = index.find(key);
+            if (entry != index.end() && entry->second == resource)
+            {
+                index.erase(entry);
+            }
+        };
+        erase_from_index(group->second.index_name, resource->GetResourceName());
+        erase_from_index(group->second.index_path, resource->GetResourceFilePathNative());
+    }
+
+    void ResourceCache::Rekey(IResource* resource, const string& name_old, const string& path_old)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+
+        const auto group = m_resource_groups.find(resource->GetResourceType());
+        if (group == m_resource_groups.end())
+            return;
+
+        // Only entries that point to this resource move, a key that's already taken keeps its resource
+        const auto rekey = [resource](unordered_map<string, shared_ptr<IResource>>& index, const string& key_old, const string& key_new)
+        {
+            const auto entry = index.find(key_old);
+            if (key_old == key_new || entry == index.end() || entry->second.get() != resource)
+                return true;
+
+            shared_ptr<IResource> shared = move(entry->second);
+            index.erase(entry);
+            return index.emplace(key_new, move(shared)).second;
+        };
+
+        if (!rekey(group->second.index_name, name_old, resource->GetResourceName()))
+        {
+            LOG_WARNING("A resource named \"%s\" is already cached, \"%s\" can only be found by path now", resource->GetResourceName().c_str(), name_old.c_str());
+        }
+        rekey(group->second.index_path, path_old, resource->GetResourceFilePathNative());
+    }
+
 	void ResourceCache::SaveResourcesToFiles()
 	{
 		// Start progress report
@@ -149,24 +241,21 @@ namespace Spartan
 		// Save resource count
 		file->Write(resource_count);
 
-		// Save all the currently used resources to disk
-		for (const auto& resource_group : m_resource_groups)
+		// Save all the currently used resources to disk (from a snapshot, saving a resource can cache others)
+		for (const auto& resource : GetByType())
 		{
-			for (const auto& resource : resource_group.second)
-			{
-				if (!resource->HasFilePathNative())
-					continue;
-
-				// Save file path
-				file->Write(resource->GetResourceFilePathNative());
-				// Save type
-				file->Write(static_cast<uint32_t>(resource->GetResourceType()));
-				// Save resource (to a dedicated file)
-				resource->SaveToFile(resource->GetResourceFilePathNative());
-
-				// Update progress
-				ProgressReport::Get().IncrementJobsDone(g_progress_resource_cache);
-			}
+			if (!resource->HasFilePathNative())
+				continue;
+
+			// Save file path
+			file->Write(resource->GetResourceFilePathNative());
+			// Save type
+			file->Write(static_cast<uint32_t>(resource->GetResourceType()));
+			// Save resource (to a dedicated file)
+			resource->SaveToFile(resource->GetResourceFilePathNative());
+
+			// Update progress
+			ProgressReport::Get().IncrementJobsDone(g_progress_resource_cache);
 		}
 
 		// Finish with progress report
@@ -184,63 +273,75 @@ namespace Spartan
 		// Load resource count
         const auto resource_count = file->ReadAs<uint32_t>();
 
+        // Group the resources so that everything a tier depends on is loaded by an earlier tier
+        vector<pair<string, Resource_Type>> textures;
+        vector<string> materials, models, audio;
 		for (uint32_t i = 0; i < resource_count; i++)
 		{
-			// Load resource file path
-			auto file_path = file->ReadAs<string>();
-
-			// Load resource type
+			auto file_path  = file->ReadAs<string>();
             const auto type = static_cast<Resource_Type>(file->ReadAs<uint32_t>());
 
 			switch (type)
 			{
-			case Resource_Model:
-				Load<Model>(file_path);
-				break;
-			case Resource_Material:
-				Load<Material>(file_path);
-				break;
 			case Resource_Texture:
-				Load<RHI_Texture>(file_path);
-				break;
 			case Resource_Texture2d:
-				Load<RHI_Texture2D>(file_path);
-				break;
 			case Resource_TextureCube:
-				Load<RHI_TextureCube>(file_path);
+				textures.emplace_back(file_path, type);
+				break;
+			case Resource_Material:
+				materials.emplace_back(file_path);
+				break;
+			case Resource_Model:
+				models.emplace_back(file_path);
 				break;
             case Resource_Audio:
-                Load<AudioClip>(file_path);
+                audio.emplace_back(file_path);
                 break;
 			}
 		}
-	}
 
-    uint64_t ResourceCache::GetMemoryUsageCpu(Resource_Type type /*= Resource_Unknown*/)
-    {
-        uint64_t size = 0;
-
-        if (type == Resource_Unknown)
+        // Loading and caching are thread safe, so every tier is loaded in parallel
+        Threading* threading = m_context->GetSubsystem<Threading>();
+        const auto load_tier = [threading](const auto& paths, const auto& load)
         {
-            for (const auto& group : m_resource_groups)
+            threading->ParallelFor([&paths, &load](const uint32_t start, const uint32_t end)
             {
-                for (const auto& resource : group.second)
+                for (uint32_t i = start; i < end; i++)
                 {
-                    if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
-                    {
-                        size += object->GetSizeCpu();
-                    }
+                    load(paths[i]);
                 }
+            }, static_cast<uint32_t>(paths.size()), 1);
+        };
+
+        load_tier(textures,     [this](const pair<string, Resource_Type>& texture)
+        {
+            switch (texture.second)
+            {
+            case Resource_Texture:      Load<RHI_Texture>(texture.first);     break;
+            case Resource_Texture2d:    Load<RHI_Texture2D>(texture.first);   break;
+            case Resource_TextureCube:  Load<RHI_TextureCube>(texture.first); break;
+            default: break;
             }
+        });
+        load_tier(materials,    [this](const string& path) { Load<Material>(path); });
+        load_tier(models,       [this](const string& path) { Load<Model>(path); });
+
+        // The audio backend is left on a single thread
+        for (const string& path : audio)
+        {
+            Load<AudioClip>(path);
         }
-        else
+	}
+
+    uint64_t ResourceCache::GetMemoryUsageCpu(Resource_Type type /*= Resource_Unknown*/)
+    {
+        uint64_t size = 0;
+
+        for (const auto& resource : GetByType(type))
         {
-            for (const auto& resource : m_resource_groups[type])
+            if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
             {
-                if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
-                {
-                    size += object->GetSizeCpu();
-                }
+                size += object->GetSizeCpu();
             }
         }
 
@@ -251,27 +352,11 @@ namespace Spartan
     {
         uint64_t size = 0;
 
-        if (type == Resource_Unknown)
-        {
-            for (const auto& group : m_resource_groups)
-            {
-                for (const auto& resource : group.second)
-                {
-                    if (RHI_Object* object = dynamic_cast<RHI_Object*>(resource.get()))
-                    {
-                        size += object->GetSizeGpu();
-                    }
-                }
-            }
-        }
-        else
+        for (const auto& resource : GetByType(type))
         {
-            for (const auto& resource : m_resource_groups[type])
+            if (RHI_Object* object = dynamic_cast<RHI_Object*>(resource.get()))
             {
-                if (RHI_Object* object = dynamic_cast<RHI_Object*>(resource.get()))
-                {
-                    size += object->GetSizeGpu();
-                }
+                size += object->GetSizeGpu();
             }
         }
 
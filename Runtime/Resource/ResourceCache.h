@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==================
 #include <map>
+#include <unordered_map>
+#include <shared_mutex>
 #include "IResource.h"
 #include "../Core/ISubsystem.h"
 //=============================
@@ -36,6 +38,7 @@ namespace Spartan
 
 	enum Asset_Type
 	{
+		Asset_Cache,
 		Asset_Cubemaps,
 		Asset_Fonts,
 		Asset_Icons,
@@ -56,7 +59,7 @@ namespace Spartan
 		//=========================
 
         // Get by name
-		std::shared_ptr<IResource>& GetByName(const std::string& name, Resource_Type type);
+		std::shared_ptr<IResource> GetByName(const std::string& name, Resource_Type type);
 		template <class T> 
 		constexpr std::shared_ptr<T> GetByName(const std::string& name) 
 		{ 
@@ -67,16 +70,11 @@ namespace Spartan
 		std::vector<std::shared_ptr<IResource>> GetByType(Resource_Type type = Resource_Unknown);
 
 		// Get by path
+		std::shared_ptr<IResource> GetByPath(const std::string& path, Resource_Type type);
 		template <class T>
 		std::shared_ptr<T> GetByPath(const std::string& path)
 		{
-			for (auto& resource : m_resource_groups[IResource::TypeToEnum<T>()])
-			{
-				if (path == resource->GetResourceFilePathNative())
-					return std::static_pointer_cast<T>(resource);
-			}
-
-            return nullptr;
+			return std::static_pointer_cast<T>(GetByPath(path, IResource::TypeToEnum<T>()));
 		}
 
 		// Caches resource, or replaces with existing cached resource
@@ -101,18 +99,16 @@ namespace Spartan
                 return nullptr;
             }
 
-			// Ensure that this resource is not already cached
-			if (IsCached(resource->GetResourceName(), resource->GetResourceType()))
-				return GetByName<T>(resource->GetResourceName());
-
-            // Prevent threads from colliding in critical section
-            std::lock_guard<mutex> guard(m_mutex);
+			// Cache it, or get the resource that is already cached under the same name
+			const std::shared_ptr<IResource> cached = CacheInternal(resource);
 
-            // In order to guarantee deserialization, we save it now
-            resource->SaveToFile(resource->GetResourceFilePathNative());
+            // In order to guarantee deserialization, we save it now (outside of the lock, saving can cache other resources)
+            if (cached == resource)
+            {
+                resource->SaveToFile(resource->GetResourceFilePathNative());
+            }
 
-			// Cache it
-			return static_pointer_cast<T>(m_resource_groups[resource->GetResourceType()].emplace_back(resource));
+			return std::static_pointer_cast<T>(cached);
 		}
 		bool IsCached(const std::string& resource_name, Resource_Type resource_type);
 
@@ -122,18 +118,7 @@ namespace Spartan
             if (!resource)
                 return;
 
-            if (!IsCached(resource->GetResourceName(), resource->GetResourceType()))
-                return;
-
-            auto& vector = m_resource_groups[resource->GetResourceType()];
-            for (auto it = vector.begin(); it != vector.end(); it++)
-            {
-                if (dynamic_cast<Spartan_Object*>((*it).get())->GetId() == resource->GetId())
-                {
-                    vector.erase(it);
-                    break;
-                }
-            }
+            RemoveInternal(resource);
         }
 
 		// Loads a resource and adds it to the resource cache
@@ -148,8 +133,8 @@ namespace Spartan
 
 			// Check if the resource is already loaded
             const auto name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
-			if (IsCached(name, IResource::TypeToEnum<T>()))
-				return GetByName<T>(name);
+			if (auto cached = GetByName<T>(name))
+				return cached;
 
 			// Create new resource
 			auto typed = std::make_shared<T>(m_context);
@@ -178,7 +163,7 @@ namespace Spartan
         uint64_t GetMemoryUsageCpu(Resource_Type type = Resource_Unknown);
         uint64_t GetMemoryUsageGpu(Resource_Type type = Resource_Unknown);
 		// Unloads all resources
-		void Clear() { m_resource_groups.clear(); }
+		void Clear();
 		// Returns all resources of a given type
 		uint32_t GetResourceCount(Resource_Type type = Resource_Unknown);
 		//===============================================================
@@ -198,9 +183,22 @@ namespace Spartan
 		auto GetFontImporter()  const { return m_importer_font.get(); }
 
 	private:
+        std::shared_ptr<IResource> CacheInternal(const std::shared_ptr<IResource>& resource);
+        void RemoveInternal(const std::shared_ptr<IResource>& resource);
+
+        // Moves the index entries of a resource whose file path changed, nothing happens if it isn't cached
+        friend class IResource;
+        void Rekey(IResource* resource, const std::string& name_old, const std::string& path_old);
+
 		// Cache
-		std::map<Resource_Type, std::vector<std::shared_ptr<IResource>>> m_resource_groups;
-		std::mutex m_mutex;
+        struct ResourceGroup
+        {
+            std::vector<std::shared_ptr<IResource>> resources; // in caching order
+            std::unordered_map<std::string, std::shared_ptr<IResource>> index_name;
+            std::unordered_map<std::string, std::shared_ptr<IResource>> index_path;
+        };
+		std::map<Resource_Type, ResourceGroup> m_resource_groups;
+		std::shared_mutex m_mutex; // shared for lookups, exclusive for inserts and removals
 
 		// Directories
 		std::map<Asset_Type, std::string> m_standard_resource_directories;
@@ -30,16 +30,45 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace _threading
+    {
+        constexpr uint32_t worker_index_invalid = numeric_limits<uint32_t>::max();
+        static thread_local uint32_t worker_index   = worker_index_invalid;
+        static thread_local uint32_t random_state   = 0;
+
+        inline uint32_t random()
+        {
+            // xorshift, only used to pick a victim to steal from
+            uint32_t x = random_state ? random_state : 2463534242u;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            random_state = x;
+            return x;
+        }
+
+        inline void lock(atomic_flag& flag)     { while (flag.test_and_set(memory_order_acquire)) { this_thread::yield(); } }
+        inline void unlock(atomic_flag& flag)   { flag.clear(memory_order_release); }
+    }
+
 	Threading::Threading(Context* context) : ISubsystem(context)
 	{
 		m_stopping	                            = false;
         m_thread_max                            = thread::hardware_concurrency();
 		m_thread_count                          = m_thread_max - 1; // exclude the main (this) thread
         m_thread_names[this_thread::get_id()]   = "main";
+        m_job_pool                              = make_unique<Job[]>(m_job_pool_size);
+
+        // The main thread owns queue 0
+        _threading::worker_index = 0;
+        for (uint32_t i = 0; i < m_thread_count + 1; i++)
+        {
+            m_queues.emplace_back(make_unique<WorkStealingQueue<Job>>());
+        }
 
 		for (uint32_t i = 0; i < m_thread_count; i++)
 		{
-			m_threads.emplace_back(thread(&Threading::Invoke, this));
+			m_threads.emplace_back(thread(&Threading::Invoke, this, i + 1));
             m_thread_names[m_threads.back().get_id()] = "worker_" + to_string(i);
 		}
 
@@ -48,14 +77,11 @@ namespace Spartan
 
 	Threading::~Threading()
 	{
-		// Put unique lock on task mutex.
-		unique_lock<mutex> lock(m_mutex_tasks);
-
 		// Set termination flag to true.
-		m_stopping = true;
-
-		// Unlock the mutex
-		lock.unlock();
+        {
+            lock_guard<mutex> lock(m_mutex_sleep);
+            m_stopping = true;
+        }
 
 		// Wake up all threads.
 		m_condition_var.notify_all();
@@ -70,43 +96,288 @@ namespace Spartan
 		m_threads.clear();
 	}
 
-	void Threading::Invoke()
+	void Threading::Invoke(const uint32_t worker_index)
 	{
-		shared_ptr<Task> task;
+        _threading::worker_index = worker_index;
+        _threading::random_state = worker_index * 2654435761u;
+
 		while (true)
 		{
-			// Lock tasks mutex
-			unique_lock<mutex> lock(m_mutex_tasks);
+            if (Job* job = JobGet(worker_index, true))
+            {
+                JobExecute(job);
+                continue;
+            }
 
-			// Check condition on notification
-			m_condition_var.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            // Nothing to do, go to sleep until a job is pushed
+            m_threads_sleeping.fetch_add(1);
+            {
+                unique_lock<mutex> lock(m_mutex_sleep);
+                m_condition_var.wait(lock, [this] { return m_jobs_pending.load() != 0 || m_stopping; });
+            }
+            m_threads_sleeping.fetch_sub(1);
 
 			// If m_stopping is true, it's time to shut everything down
-			if (m_stopping && m_tasks.empty())
-				return;
+            if (m_stopping && m_jobs_pending.load() == 0)
+                return;
+		}
+	}
+
+    void Threading::Wait(const JobHandle& handle)
+    {
+        const uint32_t worker_index = _threading::worker_index;
 
-			// Get next task in the queue.
-			task = m_tasks.front();
+        while (!IsDone(handle))
+        {
+            // Help out instead of blocking, background tasks are left to the workers unless it's the one we are waiting for
+            Job* job = JobGet(worker_index, false);
+            if (!job && m_queue_background_count.load(memory_order_acquire) != 0)
+            {
+                job = JobTakeBackground(handle);
+            }
 
-			// Remove it from the queue.
-			m_tasks.pop_front();
+            if (job)
+            {
+                JobExecute(job);
+            }
+            else
+            {
+                this_thread::yield();
+            }
+        }
+    }
 
-			// Unlock the mutex
-			lock.unlock();
+    bool Threading::IsDone(const JobHandle& handle) const
+    {
+        if (!handle.IsValid())
+            return true;
 
-			// Execute the task.
-			task->Execute();
-		}
-	}
+        if (handle.job->m_generation.load(memory_order_acquire) != handle.generation)
+            return true;
 
-    uint32_t Threading::GetThreadsAvailable()
+        // The slot can be recycled between the two reads, so validate the generation again
+        return handle.job->m_unfinished.load(memory_order_acquire) == 0 || handle.job->m_generation.load(memory_order_acquire) != handle.generation;
+    }
+
+    uint32_t Threading::GetThreadsAvailable() const
+    {
+        const uint32_t executing = m_jobs_executing.load(memory_order_relaxed);
+        return executing < m_thread_count ? m_thread_count - executing : 0;
+    }
+
+    Job* Threading::JobAllocate()
+    {
+        while (true)
+        {
+            for (uint32_t i = 0; i < m_job_pool_size; i++)
+            {
+                Job& job        = m_job_pool[m_job_pool_index.fetch_add(1, memory_order_relaxed) & (m_job_pool_size - 1)];
+                bool expected   = false;
+                if (job.m_in_use.compare_exchange_strong(expected, true, memory_order_acquire))
+                {
+                    _threading::lock(job.m_lock);
+                    job.m_generation.fetch_add(1, memory_order_release);
+                    job.m_unfinished.store(1, memory_order_release);
+                    job.m_dependencies.store(0, memory_order_relaxed);
+                    job.m_continuation_count = 0;
+                    _threading::unlock(job.m_lock);
+
+                    return &job;
+                }
+            }
+
+            // The pool is exhausted, execute something to free up a slot
+            if (Job* job = JobGet(_threading::worker_index, false))
+            {
+                JobExecute(job);
+            }
+            else
+            {
+                this_thread::yield();
+            }
+        }
+    }
+
+    JobHandle Threading::JobSubmit(Job* job, const JobHandle* dependencies, const uint32_t dependency_count)
     {
-        uint32_t available_threads = 0;
-        for (const auto& task : m_tasks)
+        JobHandle handle;
+        handle.job          = job;
+        handle.generation   = job->m_generation.load(memory_order_relaxed);
+
+        // Hold an extra dependency so that the job can't be scheduled while we are still registering
+        job->m_dependencies.store(1, memory_order_relaxed);
+        for (uint32_t i = 0; i < dependency_count; i++)
+        {
+            job->m_dependencies.fetch_add(1, memory_order_relaxed);
+            if (!JobAddContinuation(dependencies[i], job))
+            {
+                // Already complete
+                job->m_dependencies.fetch_sub(1, memory_order_relaxed);
+            }
+        }
+
+        if (job->m_dependencies.fetch_sub(1, memory_order_acq_rel) == 1)
+        {
+            JobPush(job);
+        }
+
+        return handle;
+    }
+
+    bool Threading::JobAddContinuation(const JobHandle& dependency, Job* job)
+    {
+        if (!dependency.IsValid())
+            return false;
+
+        Job* dependency_job = dependency.job;
+
+        _threading::lock(dependency_job->m_lock);
         {
-            available_threads += task->IsExecuting() ? 1 : 0;
+            const bool done = dependency_job->m_generation.load(memory_order_relaxed) != dependency.generation || dependency_job->m_unfinished.load(memory_order_relaxed) == 0;
+            if (!done && dependency_job->m_continuation_count < Job::continuation_max)
+            {
+                dependency_job->m_continuations[dependency_job->m_continuation_count++] = job;
+                _threading::unlock(dependency_job->m_lock);
+                return true;
+            }
         }
+        _threading::unlock(dependency_job->m_lock);
 
-        return m_thread_count - available_threads;
+        // Either complete or out of continuation slots, in which case we simply wait for it
+        Wait(dependency);
+        return false;
+    }
+
+    void Threading::JobPush(Job* job)
+    {
+        const uint32_t worker_index = _threading::worker_index;
+
+        m_jobs_pending.fetch_add(1);
+
+        if (job->m_background)
+        {
+            lock_guard<mutex> lock(m_mutex_queue_background);
+            m_queue_background.push_back(job);
+            m_queue_background_count.fetch_add(1, memory_order_release);
+        }
+        else if (worker_index == _threading::worker_index_invalid || !m_queues[worker_index]->Push(job))
+        {
+            lock_guard<mutex> lock(m_mutex_queue_shared);
+            m_queue_shared.push_back(job);
+            m_queue_shared_count.fetch_add(1, memory_order_release);
+        }
+
+        // Wake up a thread
+        if (m_threads_sleeping.load() != 0)
+        {
+            { lock_guard<mutex> lock(m_mutex_sleep); }
+            m_condition_var.notify_one();
+        }
+    }
+
+    Job* Threading::JobGet(const uint32_t worker_index, const bool background)
+    {
+        if (m_jobs_pending.load(memory_order_acquire) == 0)
+            return nullptr;
+
+        Job* job = nullptr;
+
+        // Own queue
+        if (worker_index != _threading::worker_index_invalid)
+        {
+            job = m_queues[worker_index]->Pop();
+        }
+
+        // Shared queue
+        if (!job && m_queue_shared_count.load(memory_order_acquire) != 0)
+        {
+            lock_guard<mutex> lock(m_mutex_queue_shared);
+            if (!m_queue_shared.empty())
+            {
+                job = m_queue_shared.front();
+                m_queue_shared.pop_front();
+                m_queue_shared_count.fetch_sub(1, memory_order_relaxed);
+            }
+        }
+
+        // Steal
+        if (!job)
+        {
+            const uint32_t queue_count  = static_cast<uint32_t>(m_queues.size());
+            const uint32_t offset       = _threading::random();
+            for (uint32_t i = 0; i < queue_count && !job; i++)
+            {
+                const uint32_t victim = (offset + i) % queue_count;
+                if (victim != worker_index)
+                {
+                    job = m_queues[victim]->Steal();
+                }
+            }
+        }
+
+        // Background, only when there is nothing else to do
+        if (!job && background && m_queue_background_count.load(memory_order_acquire) != 0)
+        {
+            lock_guard<mutex> lock(m_mutex_queue_background);
+            if (!m_queue_background.empty())
+            {
+                job = m_queue_background.front();
+                m_queue_background.pop_front();
+                m_queue_background_count.fetch_sub(1, memory_order_relaxed);
+            }
+        }
+
+        if (job)
+        {
+            m_jobs_pending.fetch_sub(1, memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    Job* Threading::JobTakeBackground(const JobHandle& handle)
+    {
+        lock_guard<mutex> lock(m_mutex_queue_background);
+
+        // A queued job hasn't executed yet, so its slot can't be recycled while we hold the lock
+        const auto it = find(m_queue_background.begin(), m_queue_background.end(), handle.job);
+        if (it == m_queue_background.end() || handle.job->m_generation.load(memory_order_acquire) != handle.generation)
+            return nullptr;
+
+        m_queue_background.erase(it);
+        m_queue_background_count.fetch_sub(1, memory_order_relaxed);
+        m_jobs_pending.fetch_sub(1, memory_order_relaxed);
+
+        return handle.job;
+    }
+
+    void Threading::JobExecute(Job* job)
+    {
+        m_jobs_executing.fetch_add(1, memory_order_relaxed);
+        job->Execute();
+        m_jobs_executing.fetch_sub(1, memory_order_relaxed);
+
+        // Mark as complete and grab the continuations
+        Job* continuations[Job::continuation_max];
+        _threading::lock(job->m_lock);
+        job->m_unfinished.store(0, memory_order_release);
+        const uint32_t continuation_count = job->m_continuation_count;
+        for (uint32_t i = 0; i < continuation_count; i++)
+        {
+            continuations[i] = job->m_continuations[i];
+        }
+        _threading::unlock(job->m_lock);
+
+        // Return the slot to the pool
+        job->m_in_use.store(false, memory_order_release);
+
+        // Schedule any continuations that have no more pending dependencies
+        for (uint32_t i = 0; i < continuation_count; i++)
+        {
+            if (continuations[i]->m_dependencies.fetch_sub(1, memory_order_acq_rel) == 1)
+            {
+                JobPush(continuations[i]);
+            }
+        }
     }
 }
@@ -28,24 +28,85 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <deque>
 #include <map>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include "WorkStealingQueue.h"
 #include "../Logging/Log.h"
 #include "../Core/ISubsystem.h"
 //=============================
 
 namespace Spartan
 {
-	class Task
+    class Job;
+
+    // A lightweight reference to a job, it remains valid (and reports completion) after the job's slot has been recycled
+    struct JobHandle
+    {
+        Job* job            = nullptr;
+        uint32_t generation = 0;
+
+        bool IsValid() const { return job != nullptr; }
+    };
+
+    // A job stores its callable inline (no std::function or heap allocation unless the captures are unusually large)
+	class Job
 	{
 	public:
-		typedef std::function<void()> function_type;
+        static constexpr uint32_t storage_size      = 64;
+        static constexpr uint32_t continuation_max  = 8;
+
+        template <typename Function>
+        void SetFunction(Function&& function)
+        {
+            using function_type = std::decay_t<Function>;
+
+            if constexpr (sizeof(function_type) <= storage_size && alignof(function_type) <= alignof(std::max_align_t))
+            {
+                new (m_storage) function_type(std::forward<Function>(function));
+                m_function = [](void* storage)
+                {
+                    function_type* f = reinterpret_cast<function_type*>(storage);
+                    (*f)();
+                    f->~function_type();
+                };
+            }
+            else
+            {
+                // Fall back to the heap for captures that don't fit
+                *reinterpret_cast<function_type**>(m_storage) = new function_type(std::forward<Function>(function));
+                m_function = [](void* storage)
+                {
+                    function_type* f = *reinterpret_cast<function_type**>(storage);
+                    (*f)();
+                    delete f;
+                };
+            }
+        }
 
-		Task(function_type&& function)  { m_function = std::forward<function_type>(function); }
-        void Execute()                  { m_is_executing = true; m_function(); m_is_executing = false; }
-        bool IsExecuting() const { return m_is_executing; }
+        void Execute() { m_function(m_storage); }
 
 	private:
-        bool m_is_executing = false;
-		function_type m_function;
+        friend class Threading;
+
+        // Function
+        void (*m_function)(void*) = nullptr;
+        alignas(std::max_align_t) unsigned char m_storage[storage_size];
+
+        // State
+        std::atomic<uint32_t> m_generation      = 0;
+        std::atomic<uint32_t> m_unfinished      = 0; // 1 until the job has executed
+        std::atomic<uint32_t> m_dependencies    = 0; // dependencies that have to complete before the job can be scheduled
+        std::atomic<bool> m_in_use              = false;
+        bool m_background                       = false; // goes to the background queue, see AddTaskBackground()
+        std::atomic_flag m_lock                 = ATOMIC_FLAG_INIT;
+
+        // Jobs to schedule once this one completes
+        Job* m_continuations[continuation_max];
+        uint32_t m_continuation_count = 0;
 	};
 
 	class Threading : public ISubsystem
@@ -55,77 +116,195 @@ namespace Spartan
 		~Threading();
 
 		// This function is invoked by the threads
-		void Invoke();
+		void Invoke(uint32_t worker_index);
 
 		// Add a task
 		template <typename Function>
-		void AddTask(Function&& function)
+		JobHandle AddTask(Function&& function)
 		{
-			if (m_threads.empty())
-			{
-				LOG_WARNING("Threading::AddTask: No available threads, function will execute in the same thread");
-				function();
-				return;
-			}
-
-			// Lock tasks mutex
-			std::unique_lock<std::mutex> lock(m_mutex_tasks);
+            return AddTask(std::forward<Function>(function), nullptr, 0, false);
+		}
 
-			// Save the task
-			m_tasks.push_back(std::make_shared<Task>(std::bind(std::forward<Function>(function))));
+        // Add a long running task (loading, importing, compiling, streaming). These only run on the workers, a thread which
+        // waits never picks one up (unless it waits on that very task), so per-frame waits can't stall on them or deadlock.
+        template <typename Function>
+        JobHandle AddTaskBackground(Function&& function)
+        {
+            return AddTask(std::forward<Function>(function), nullptr, 0, true);
+        }
 
-			// Unlock the mutex
-			lock.unlock();
+        // Add a task which will only be scheduled once the dependency completes
+        template <typename Function>
+        JobHandle AddTask(Function&& function, const JobHandle& dependency)
+        {
+            return AddTask(std::forward<Function>(function), &dependency, 1, false);
+        }
 
-			// Wake up a thread
-			m_condition_var.notify_one();
-		}
+        // Add a task which will only be scheduled once all the dependencies complete
+        template <typename Function>
+        JobHandle AddTask(Function&& function, const std::vector<JobHandle>& dependencies)
+        {
+            return AddTask(std::forward<Function>(function), dependencies.data(), static_cast<uint32_t>(dependencies.size()), false);
+        }
 
+        // Splits [0, range) into chunks of grain_size which are claimed dynamically by the workers and the calling thread.
+        // The function has the signature void(uint32_t start, uint32_t end), a grain_size of 0 picks one automatically.
         template <typename Function>
-        void Loop(Function&& function, uint32_t range)
+        void ParallelFor(Function&& function, const uint32_t range, uint32_t grain_size = 0)
         {
-            uint32_t available_threads  = GetThreadsAvailable();
-            vector<bool> tasks_done     = vector<bool>(available_threads, false);
-            const uint32_t task_count         = available_threads + 1; // plus one for the current thread
+            if (range == 0)
+                return;
 
-            uint32_t start  = 0;
-            uint32_t end    = 0;
-            for (uint32_t i = 0; i < available_threads; i++)
+            grain_size                  = grain_size != 0 ? grain_size : ComputeGrainSize(range);
+            const uint32_t chunk_count  = (range + grain_size - 1) / grain_size;
+            const uint32_t helper_count = std::min(m_thread_count, chunk_count - 1);
+            std::atomic<uint32_t> chunk_next = 0;
+
+            const auto work = [&function, &chunk_next, range, grain_size]()
             {
-                start   = (range / task_count) * i;
-                end     = start + (range / task_count);
+                uint32_t start = 0;
+                while ((start = chunk_next.fetch_add(grain_size, std::memory_order_relaxed)) < range)
+                {
+                    function(start, std::min(start + grain_size, range));
+                }
+            };
 
-                // Kick off task
-                AddTask([&function, &tasks_done, i, start, end] { function(start, end); tasks_done[i] = true; });
+            std::vector<JobHandle> helpers;
+            helpers.reserve(helper_count);
+            for (uint32_t i = 0; i < helper_count; i++)
+            {
+                helpers.emplace_back(AddTask(work));
             }
 
-            // Do last task in the current thread
-            function(end, range);
+            // Participate
+            work();
 
-            // Wait till the threads are done
-            uint32_t tasks = 0;
-            while (tasks != tasks_done.size())
+            // Helpers which were never picked up return immediately, Wait() executes them if need be
+            for (const JobHandle& helper : helpers)
             {
-                tasks = 0;
-                for (const bool job_done : tasks_done)
+                Wait(helper);
+            }
+        }
+
+        // Same chunking as ParallelFor(), the function has the signature T(uint32_t start, uint32_t end)
+        // and the partial results are combined with reduce, which has the signature T(const T&, const T&).
+        template <typename T, typename Function, typename Reduce>
+        T ParallelReduce(Function&& function, Reduce&& reduce, const uint32_t range, const T& identity, uint32_t grain_size = 0)
+        {
+            if (range == 0)
+                return identity;
+
+            grain_size                  = grain_size != 0 ? grain_size : ComputeGrainSize(range);
+            const uint32_t chunk_count  = (range + grain_size - 1) / grain_size;
+            const uint32_t helper_count = std::min(m_thread_count, chunk_count - 1);
+            std::atomic<uint32_t> chunk_next = 0;
+
+            // One slot per participant, each on its own cache line (this also keeps std::vector<bool> and its packed bits out of the picture)
+            struct alignas(64) Partial { T value; };
+            std::vector<Partial> partials(helper_count + 1, Partial{ identity });
+
+            const auto work = [&function, &reduce, &chunk_next, &partials, range, grain_size](const uint32_t participant)
+            {
+                T partial = partials[participant].value;
+                uint32_t start = 0;
+                while ((start = chunk_next.fetch_add(grain_size, std::memory_order_relaxed)) < range)
                 {
-                    tasks += job_done ? 1 : 0;
+                    partial = reduce(partial, function(start, std::min(start + grain_size, range)));
                 }
+                partials[participant].value = partial;
+            };
+
+            std::vector<JobHandle> helpers;
+            helpers.reserve(helper_count);
+            for (uint32_t i = 0; i < helper_count; i++)
+            {
+                helpers.emplace_back(AddTask([&work, i]() { work(i + 1); }));
             }
+
+            // Participate
+            work(0);
+
+            for (const JobHandle& helper : helpers)
+            {
+                Wait(helper);
+            }
+
+            T result = identity;
+            for (const Partial& partial : partials)
+            {
+                result = reduce(result, partial.value);
+            }
+
+            return result;
         }
 
+        // Blocks until the job completes, the calling thread executes other jobs in the meantime
+        void Wait(const JobHandle& handle);
+        bool IsDone(const JobHandle& handle) const;
+
         uint32_t GetThreadCount() const { return m_thread_count; }
         uint32_t GetThreadCountMax() const { return m_thread_max; }
-        uint32_t GetThreadsAvailable();
+        uint32_t GetThreadsAvailable() const;
 
 	private:
+        template <typename Function>
+        JobHandle AddTask(Function&& function, const JobHandle* dependencies, const uint32_t dependency_count, const bool background)
+        {
+            if (m_threads.empty())
+            {
+                LOG_WARNING("No available threads, function will execute in the same thread");
+                for (uint32_t i = 0; i < dependency_count; i++)
+                {
+                    Wait(dependencies[i]);
+                }
+                function();
+                return JobHandle();
+            }
+
+            Job* job = JobAllocate();
+            job->SetFunction(std::forward<Function>(function));
+            job->m_background = background;
+            return JobSubmit(job, dependencies, dependency_count);
+        }
+
+        // Aim for a few chunks per thread so that uneven iterations can be balanced
+        uint32_t ComputeGrainSize(const uint32_t range) const { return std::max(range / ((m_thread_count + 1) * 4), 1u); }
+
+        Job* JobAllocate();
+        JobHandle JobSubmit(Job* job, const JobHandle* dependencies, uint32_t dependency_count);
+        void JobPush(Job* job);
+        Job* JobGet(uint32_t worker_index, bool background);
+        Job* JobTakeBackground(const JobHandle& handle);
+        void JobExecute(Job* job);
+        bool JobAddContinuation(const JobHandle& dependency, Job* job);
+
 		uint32_t m_thread_count = 0;
         uint32_t m_thread_max   = 0;
 		std::vector<std::thread> m_threads;
-		std::deque<std::shared_ptr<Task>> m_tasks;
-		std::mutex m_mutex_tasks;
-		std::condition_variable m_condition_var;
         std::map<std::thread::id, std::string> m_thread_names;
-		bool m_stopping;
+
+        // Job pool
+        static constexpr uint32_t m_job_pool_size = 4096;
+        std::unique_ptr<Job[]> m_job_pool;
+        std::atomic<uint32_t> m_job_pool_index = 0;
+
+        // Queues, one per worker (index 0 is the main thread) and a shared one for any other thread
+        std::vector<std::unique_ptr<WorkStealingQueue<Job>>> m_queues;
+        std::deque<Job*> m_queue_shared;
+        std::mutex m_mutex_queue_shared;
+        std::atomic<uint32_t> m_queue_shared_count = 0;
+
+        // Background queue, only drained by idle workers
+        std::deque<Job*> m_queue_background;
+        std::mutex m_mutex_queue_background;
+        std::atomic<uint32_t> m_queue_background_count = 0;
+
+        // Sleeping
+        std::atomic<uint32_t> m_jobs_pending    = 0;
+        std::atomic<uint32_t> m_jobs_executing  = 0;
+        std::atomic<uint32_t> m_threads_sleeping= 0;
+		std::mutex m_mutex_sleep;
+		std::condition_variable m_condition_var;
+		std::atomic<bool> m_stopping;
 	};
 }
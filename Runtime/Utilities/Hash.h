@@ -21,6 +21,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+//= INCLUDES =====
+#include <string>
+//================
+
 namespace Spartan::Utility::Hash
 {
     template <class T>
@@ -29,4 +33,26 @@ namespace Spartan::Utility::Hash
         std::hash<T> hasher;
         seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
+
+    // 64-bit FNV-1a, unlike std::hash it's stable across runs and builds, so it can be used for keys that are persisted to disk
+    static const uint64_t fnv1a_seed = 14695981039346656037ull;
+
+    inline uint64_t fnv1a_64(const void* data, const size_t size, uint64_t seed = fnv1a_seed)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            seed ^= static_cast<uint64_t>(bytes[i]);
+            seed *= 1099511628211ull;
+        }
+
+        return seed;
+    }
+
+    inline uint64_t fnv1a_64(const std::string& value, const uint64_t seed = fnv1a_seed)
+    {
+        // Hash the length too, so that consecutive strings can't alias each other ("ab" + "c" vs "a" + "bc")
+        const uint64_t length = static_cast<uint64_t>(value.size());
+        return fnv1a_64(value.data(), value.size(), fnv1a_64(&length, sizeof(length), seed));
+    }
 }
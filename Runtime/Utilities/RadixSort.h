@@ -0,0 +1,142 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <array>
+#include <algorithm>
+#include "../Threading/Threading.h"
+//================================
+
+namespace Spartan::Utility::RadixSort
+{
+    // Below this many elements the bookkeeping of the parallel passes costs more than it saves
+    constexpr uint32_t parallel_threshold = 16384;
+
+    // Stable LSD radix sort of 64-bit keys (8 passes of 8 bits) with an accompanying value per key.
+    // Each pass builds per chunk histograms and scatters the chunks in parallel, passes where all keys
+    // share the same digit (typically the unused high bits) are skipped.
+    template <typename T>
+    void Sort(std::vector<uint64_t>& keys, std::vector<T>& values, Threading* threading = nullptr)
+    {
+        const uint32_t count = static_cast<uint32_t>(keys.size());
+        if (count <= 1)
+            return;
+
+        const uint32_t chunk_count  = (!threading || count < parallel_threshold) ? 1 : threading->GetThreadCount() + 1;
+        const uint32_t chunk_size   = (count + chunk_count - 1) / chunk_count;
+
+        std::vector<uint64_t> keys_scratch(count);
+        std::vector<T> values_scratch(count);
+        std::vector<std::array<uint32_t, 256>> histograms(chunk_count);
+
+        const auto for_each_chunk = [threading, chunk_count](auto&& function)
+        {
+            if (chunk_count == 1)
+            {
+                function(0, 1);
+            }
+            else
+            {
+                threading->ParallelFor(function, chunk_count, 1);
+            }
+        };
+
+        uint64_t* keys_src      = keys.data();
+        uint64_t* keys_dst      = keys_scratch.data();
+        T* values_src           = values.data();
+        T* values_dst           = values_scratch.data();
+
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            // Histograms
+            for_each_chunk([&](const uint32_t chunk_start, const uint32_t chunk_end)
+            {
+                for (uint32_t chunk = chunk_start; chunk < chunk_end; chunk++)
+                {
+                    auto& histogram = histograms[chunk];
+                    histogram.fill(0);
+
+                    const uint32_t end = std::min((chunk + 1) * chunk_size, count);
+                    for (uint32_t i = chunk * chunk_size; i < end; i++)
+                    {
+                        histogram[(keys_src[i] >> shift) & 0xFF]++;
+                    }
+                }
+            });
+
+            // Skip the pass if every key has the same digit
+            bool skip = false;
+            for (uint32_t digit = 0; digit < 256 && !skip; digit++)
+            {
+                uint32_t total = 0;
+                for (const auto& histogram : histograms)
+                {
+                    total += histogram[digit];
+                }
+                skip = total == count;
+            }
+            if (skip)
+                continue;
+
+            // Turn the histograms into per chunk write offsets (digit major, chunk minor keeps the sort stable)
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < 256; digit++)
+            {
+                for (auto& histogram : histograms)
+                {
+                    const uint32_t digit_count = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += digit_count;
+                }
+            }
+
+            // Scatter
+            for_each_chunk([&](const uint32_t chunk_start, const uint32_t chunk_end)
+            {
+                for (uint32_t chunk = chunk_start; chunk < chunk_end; chunk++)
+                {
+                    auto& offsets = histograms[chunk];
+
+                    const uint32_t end = std::min((chunk + 1) * chunk_size, count);
+                    for (uint32_t i = chunk * chunk_size; i < end; i++)
+                    {
+                        const uint32_t index    = offsets[(keys_src[i] >> shift) & 0xFF]++;
+                        keys_dst[index]         = keys_src[i];
+                        values_dst[index]       = values_src[i];
+                    }
+                }
+            });
+
+            std::swap(keys_src, keys_dst);
+            std::swap(values_src, values_dst);
+        }
+
+        // An odd number of passes leaves the result in the scratch buffers
+        if (keys_src != keys.data())
+        {
+            std::copy(keys_src, keys_src + count, keys.data());
+            std::copy(values_src, values_src + count, values.data());
+        }
+    }
+}
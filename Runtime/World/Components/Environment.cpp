@@ -65,7 +65,7 @@ namespace Spartan
         if (!m_is_dirty)
             return;
 
-        m_context->GetSubsystem<Threading>()->AddTask([this]
+        m_context->GetSubsystem<Threading>()->AddTaskBackground([this]
         {
             SetFromTextureSphere(m_file_paths.front());
         });
@@ -84,7 +84,7 @@ namespace Spartan
         m_environment_type = static_cast<Environment_Type>(stream->ReadAs<uint8_t>());
         stream->Read(&m_file_paths);
 
-        m_context->GetSubsystem<Threading>()->AddTask([this]
+        m_context->GetSubsystem<Threading>()->AddTaskBackground([this]
         {
             if (m_environment_type == Enviroment_Cubemap)
             {
@@ -171,8 +171,11 @@ namespace Spartan
             CreateShadowMap();
         }
 
-        
-        m_context->GetSubsystem<World>()->MakeDirty();
+        // The renderer keeps lights in a list per type
+        if (m_entity)
+        {
+            m_context->GetSubsystem<World>()->EntityMarkChanged(m_entity);
+        }
 	}
 
 	void Light::SetShadowsEnabled(bool cast_shadows)
@@ -22,11 +22,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ============================
 #include "Renderable.h"
 #include "Transform.h"
+#include "../World.h"
 #include "../../IO/FileStream.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Utilities/Geometry.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../Rendering/Model.h"
+#include "../../Rendering/Material.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -100,7 +102,7 @@ namespace Spartan
 		m_receiveShadows		= true;
 
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_material_default,       bool);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_material,              shared_ptr<Material>);
+		REGISTER_ATTRIBUTE_VALUE_SET(m_material, MaterialAssign, shared_ptr<Material>);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_castShadows,           bool);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_receiveShadows,        bool);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryIndexOffset,   uint32_t);
@@ -113,6 +115,11 @@ namespace Spartan
 		REGISTER_ATTRIBUTE_GET_SET(Geometry_Type, GeometrySet, Geometry_Type);
 	}
 
+	Renderable::~Renderable()
+	{
+		MaterialAssign(nullptr);
+	}
+
 	void Renderable::Serialize(FileStream* stream)
 	{
 		// Mesh
@@ -135,17 +142,44 @@ namespace Spartan
 	}
 
 	void Renderable::Deserialize(FileStream* stream)
+	{
+		RenderableRecord record;
+		DeserializeRecord(stream, &record);
+		Deserialize(record);
+	}
+
+	void Renderable::DeserializeRecord(FileStream* stream, RenderableRecord* record)
 	{
 		// Geometry
-		m_geometry_type			= static_cast<Geometry_Type>(stream->ReadAs<uint32_t>());
-		m_geometryIndexOffset	= stream->ReadAs<uint32_t>();
-		m_geometryIndexCount	= stream->ReadAs<uint32_t>();
-		m_geometryVertexOffset	= stream->ReadAs<uint32_t>();
-		m_geometryVertexCount	= stream->ReadAs<uint32_t>();
-		stream->Read(&m_bounding_box);
-		string model_name;
-		stream->Read(&model_name);
-		m_model = m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(model_name);
+		record->geometry_type			= static_cast<Geometry_Type>(stream->ReadAs<uint32_t>());
+		record->geometry_index_offset	= stream->ReadAs<uint32_t>();
+		record->geometry_index_count	= stream->ReadAs<uint32_t>();
+		record->geometry_vertex_offset	= stream->ReadAs<uint32_t>();
+		record->geometry_vertex_count	= stream->ReadAs<uint32_t>();
+		stream->Read(&record->bounding_box);
+		stream->Read(&record->model_name);
+
+		// Material
+		stream->Read(&record->cast_shadows);
+		stream->Read(&record->receive_shadows);
+		stream->Read(&record->material_default);
+		if (!record->material_default)
+		{
+			stream->Read(&record->material_name);
+		}
+	}
+
+	void Renderable::Deserialize(const RenderableRecord& record)
+	{
+		// Geometry
+		m_geometry_type			= record.geometry_type;
+		m_geometryIndexOffset	= record.geometry_index_offset;
+		m_geometryIndexCount	= record.geometry_index_count;
+		m_geometryVertexOffset	= record.geometry_vertex_offset;
+		m_geometryVertexCount	= record.geometry_vertex_count;
+		m_bounding_box			= record.bounding_box;
+		m_is_dirty = true;
+		m_model = m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(record.model_name);
 
 		// If it was a default mesh, we have to reconstruct it
 		if (m_geometry_type != Geometry_Custom) 
@@ -154,18 +188,16 @@ namespace Spartan
 		}
 
 		// Material
-		stream->Read(&m_castShadows);
-		stream->Read(&m_receiveShadows);
-		stream->Read(&m_material_default);
+		m_castShadows		= record.cast_shadows;
+		m_receiveShadows	= record.receive_shadows;
+		m_material_default	= record.material_default;
 		if (m_material_default)
 		{
 			UseDefaultMaterial();		
 		}
 		else
 		{
-			string material_name;
-			stream->Read(&material_name);
-			m_material = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(material_name);
+			MaterialAssign(m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(record.material_name));
 		}
 	}
 
@@ -178,6 +210,10 @@ namespace Spartan
 		m_geometryVertexCount	= vertex_count;
 		m_bounding_box			= bounding_box;
 		m_model					= model ? model->GetSharedPtr() : nullptr;
+
+		// The bounds changed, so refit them into the scene query
+		m_is_dirty = true;
+		m_context->GetSubsystem<World>()->SceneQueryMarkDirty(m_entity);
 	}
 
 	void Renderable::GeometrySet(const Geometry_Type type)
@@ -206,20 +242,15 @@ namespace Spartan
 		m_model->GetGeometry(m_geometryIndexOffset, m_geometryIndexCount, m_geometryVertexOffset, m_geometryVertexCount, indices, vertices);
 	}
 
-    const BoundingBox& Renderable::GetAabb()
+    void Renderable::UpdateAabb()
 	{
-        if (m_last_transform != GetTransform()->GetMatrix())
-        {
-            m_is_dirty = true;
-        }
+        const Matrix& transform = GetTransform()->GetMatrix();
+        if (!m_is_dirty && m_last_transform == transform)
+            return;
 
-		if (m_is_dirty)
-		{
-			m_aabb = m_bounding_box.Transform(GetTransform()->GetMatrix());
-            m_last_transform = GetTransform()->GetMatrix();
-		}
-
-		return m_aabb;
+        m_aabb              = m_bounding_box.Transform(transform);
+        m_last_transform    = transform;
+        m_is_dirty          = false;
 	}
 
 	// All functions (set/load) resolve to this
@@ -232,7 +263,7 @@ namespace Spartan
 		}
 
         // In order for the component to guarantee serialization/deserialization, we cache the material
-		m_material = m_context->GetSubsystem<ResourceCache>()->Cache(material);
+		MaterialAssign(m_context->GetSubsystem<ResourceCache>()->Cache(material));
 
         // Set to false otherwise material won't serialize/deserialize
         m_material_default = false;
@@ -276,6 +307,25 @@ namespace Spartan
         m_material_default = true;
 	}
 
+	void Renderable::MaterialAssign(const shared_ptr<Material>& material)
+	{
+		if (m_material == material)
+			return;
+
+		// Keep the material's list of renderables in sync, that's how it finds the entities it affects
+		if (m_material)
+		{
+			m_material->RenderableRemove(this);
+		}
+
+		m_material = material;
+
+		if (m_material)
+		{
+			m_material->RenderableAdd(this);
+		}
+	}
+
 	string Renderable::GetMaterialName() const
     {
 		return m_material ? m_material->GetResourceName() : "";
@@ -49,17 +49,37 @@ namespace Spartan
 		Geometry_Default_Cone
 	};
 
+	// The serialized state of a renderable, it can be read on any thread and applied
+	// later, which is when the model and the material are looked up in the resource cache
+	struct RenderableRecord
+	{
+		Geometry_Type geometry_type		= Geometry_Custom;
+		uint32_t geometry_index_offset	= 0;
+		uint32_t geometry_index_count	= 0;
+		uint32_t geometry_vertex_offset	= 0;
+		uint32_t geometry_vertex_count	= 0;
+		Math::BoundingBox bounding_box;
+		std::string model_name;
+		bool cast_shadows				= true;
+		bool receive_shadows			= true;
+		bool material_default			= true;
+		std::string material_name;
+	};
+
 	class SPARTAN_CLASS Renderable : public IComponent
 	{
 	public:
 		Renderable(Context* context, Entity* entity, uint32_t id = 0);
-		~Renderable() = default;
+		~Renderable();
 
 		//= ICOMPONENT ===============================
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
 		//============================================
 
+		static void DeserializeRecord(FileStream* stream, RenderableRecord* record);
+		void Deserialize(const RenderableRecord& record);
+
 		//= GEOMETRY ==========================================================================================
 		void GeometrySet(
 			const std::string& name,
@@ -81,7 +101,9 @@ namespace Spartan
 		const auto& GeometryName()	                const { return m_geometryName; }
 		const Model* GeometryModel()                const { return m_model.get(); }
         const Math::BoundingBox& GetBoundingBox()   const { return m_bounding_box; }
-        const Math::BoundingBox& GetAabb();
+        // The world space bounds, updated by the World once the transforms have been resolved, so reading them is safe from any thread
+        const Math::BoundingBox& GetAabb()          const { return m_aabb; }
+        void UpdateAabb();
 		//=====================================================================================================
 
 		//= MATERIAL ============================================================
@@ -105,6 +127,8 @@ namespace Spartan
 		//=========================================================================================
 
 	private:
+		void MaterialAssign(const std::shared_ptr<Material>& material);
+
 		std::string m_geometryName;
 		uint32_t m_geometryIndexOffset;
 		uint32_t m_geometryIndexCount;
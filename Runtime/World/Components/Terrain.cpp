@@ -101,7 +101,7 @@ namespace Spartan
             return;
         }
 
-        m_context->GetSubsystem<Threading>()->AddTask([this]()
+        m_context->GetSubsystem<Threading>()->AddTaskBackground([this]()
         {
             m_is_generating = true;
 
@@ -377,7 +377,7 @@ namespace Spartan
             }
         };
 
-        m_context->GetSubsystem<Threading>()->Loop(compute_vertex_normals_tangents, vertex_count);
+        m_context->GetSubsystem<Threading>()->ParallelFor(compute_vertex_normals_tangents, vertex_count);
 
         return true;
     }
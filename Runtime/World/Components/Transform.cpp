@@ -20,6 +20,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES =====================
+#include <algorithm>
 #include "Transform.h"
 #include "../World.h"
 #include "../Entity.h"
@@ -43,6 +44,7 @@ namespace Spartan
 		m_matrixLocal		= Matrix::Identity;
 		m_wvp_previous		= Matrix::Identity;
 		m_parent			= nullptr;
+		m_world				= context->GetSubsystem<World>();
 
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_positionLocal,	Vector3);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_rotationLocal,	Quaternion);
@@ -69,25 +71,64 @@ namespace Spartan
 
 	void Transform::Deserialize(FileStream* stream)
 	{
-		stream->Read(&m_positionLocal);
-		stream->Read(&m_rotationLocal);
-		stream->Read(&m_scaleLocal);
-		stream->Read(&m_lookAt);
-		uint32_t parententity_id = 0;
-		stream->Read(&parententity_id);
+		TransformRecord record;
+		DeserializeRecord(stream, &record);
+		Deserialize(record);
+	}
 
-		if (parententity_id != 0)
-		{
-			if (const auto parent = GetContext()->GetSubsystem<World>()->EntityGetById(parententity_id))
-			{
-				parent->GetTransform()->AddChild(this);
-			}
-		}
+	void Transform::DeserializeRecord(FileStream* stream, TransformRecord* record)
+	{
+		stream->Read(&record->position);
+		stream->Read(&record->rotation);
+		stream->Read(&record->scale);
+		stream->Read(&record->look_at);
+		stream->Skip(sizeof(uint32_t)); // parent id, the entity links the parent
+	}
+
+	void Transform::Deserialize(const TransformRecord& record)
+	{
+		m_positionLocal	= record.position;
+		m_rotationLocal	= record.rotation;
+		m_scaleLocal	= record.scale;
+		m_lookAt		= record.look_at;
 
 		UpdateTransform();
 	}
 	//===============================================================================================
 	void Transform::UpdateTransform()
+	{
+		MarkDirty();
+	}
+
+	void Transform::MarkDirty()
+	{
+		// The bounds of the entity have to be refit into the scene query
+		m_world->SceneQueryMarkDirty(GetEntity());
+
+		// A dirty transform always has dirty descendants, so there is nothing more to do
+		if (m_is_dirty)
+			return;
+
+		m_is_dirty = true;
+
+		for (const auto& child : m_children)
+		{
+			child->MarkDirty();
+		}
+	}
+
+	void Transform::Resolve() const
+	{
+		// Resolve any dirty ancestors first
+		if (HasParent() && m_parent->IsDirty())
+		{
+			m_parent->Resolve();
+		}
+
+		ComputeMatrices();
+	}
+
+	void Transform::ComputeMatrices() const
 	{
 		// Compute local transform
 		m_matrixLocal = Matrix(m_positionLocal, m_rotationLocal, m_scaleLocal);
@@ -101,12 +142,8 @@ namespace Spartan
 		{
 			m_matrix = m_matrixLocal * GetParentTransformMatrix();
 		}
-		
-		// Update children
-		for (const auto& child : m_children)
-		{
-			child->UpdateTransform();
-		}
+
+		m_is_dirty = false;
 	}
 
 	//= TRANSLATION ==================================================================================
@@ -115,7 +152,7 @@ namespace Spartan
 		if (GetPosition() == position)
 			return;
 
-		SetPositionLocal(!HasParent() ? position : position * GetParent()->GetMatrix().Inverted());
+		SetPositionLocal(!HasParent() ? position : position * GetParent()->GetMatrixResolved().Inverted());
 	}
 
 	void Transform::SetPositionLocal(const Vector3& position)
@@ -182,7 +219,7 @@ namespace Spartan
 		}
 		else
 		{
-			SetPositionLocal(m_positionLocal + GetParent()->GetMatrix().Inverted() * delta);
+			SetPositionLocal(m_positionLocal + GetParent()->GetMatrixResolved().Inverted() * delta);
 		}
 	}
 
@@ -262,7 +299,8 @@ namespace Spartan
 			if (this->HasParent())
 			{
 				// assign the parent of this transform to the children
-				for (const auto& child : m_children)
+				const auto children = m_children;
+				for (const auto& child : children)
 				{
 					child->SetParent(GetParent());
 				}
@@ -270,7 +308,8 @@ namespace Spartan
 			else // if this transform doesn't have a parent
 			{
 				// make the children orphans
-				for (const auto& child : m_children)
+				const auto children = m_children;
+				for (const auto& child : children)
 				{
 					child->BecomeOrphan();
 				}
@@ -280,17 +319,21 @@ namespace Spartan
 		// Switch parent but keep a pointer to the old one
 		auto parent_old = m_parent;
 		m_parent = new_parent;
-		if (parent_old) parent_old->AcquireChildren(); // update the old parent (so it removes this child)
+		if (parent_old) parent_old->UnregisterChild(this); // update the old parent (so it removes this child)
 
 		// make the new parent "aware" of this transform/child
-		if (m_parent)
-		{
-			m_parent->AcquireChildren();
-		}
+		m_parent->RegisterChild(this);
 
+		GetContext()->GetSubsystem<World>()->TransformsMarkHierarchyDirty();
 		UpdateTransform();
 	}
 
+	void Transform::LinkParent(Transform* parent)
+	{
+		m_parent = parent;
+		m_parent->m_children.emplace_back(this);
+	}
+
 	void Transform::AddChild(Transform* child)
 	{
 		if (!child)
@@ -407,14 +450,23 @@ namespace Spartan
 		m_parent = nullptr;
 
 		// Update the transform without the parent now
+		GetContext()->GetSubsystem<World>()->TransformsMarkHierarchyDirty();
 		UpdateTransform();
 
-		// make the parent search for children,
-		// that's indirect way of making the parent "forget"
-		// about this child, since it won't be able to find it
-		if (temp_ref)
+		// make the parent forget about this child
+		temp_ref->UnregisterChild(this);
+	}
+
+	void Transform::RegisterChild(Transform* child)
+	{
+		if (find(m_children.begin(), m_children.end(), child) == m_children.end())
 		{
-			temp_ref->AcquireChildren();
+			m_children.emplace_back(child);
 		}
 	}
+
+	void Transform::UnregisterChild(Transform* child)
+	{
+		m_children.erase(remove(m_children.begin(), m_children.end(), child), m_children.end());
+	}
 }
@@ -33,6 +33,16 @@ namespace Spartan
 {
 	class RHI_Device;
 	class RHI_ConstantBuffer;
+	class World;
+
+	// The serialized state of a transform, it can be read on any thread and applied later
+	struct TransformRecord
+	{
+		Math::Vector3 position;
+		Math::Quaternion rotation;
+		Math::Vector3 scale;
+		Math::Vector3 look_at;
+	};
 
 	class SPARTAN_CLASS Transform : public IComponent
 	{
@@ -46,24 +56,30 @@ namespace Spartan
 		void Deserialize(FileStream* stream) override;
 		//============================================
 
+		static void DeserializeRecord(FileStream* stream, TransformRecord* record);
+		void Deserialize(const TransformRecord& record);
+
+		// Marks the transform (and its descendants) as dirty, the matrices are recomputed once per frame by the World,
+		// or on demand when a world space position, rotation or scale is requested (e.g. right after setting one).
 		void UpdateTransform();
+		bool IsDirty() const { return m_is_dirty; }
 
 		//= POSITION ================================================================
-		auto GetPosition() const { return m_matrix.GetTranslation(); }
+		auto GetPosition() const { return GetMatrixResolved().GetTranslation(); }
 		const auto& GetPositionLocal() const	{ return m_positionLocal; }
 		void SetPosition(const Math::Vector3& position);
 		void SetPositionLocal(const Math::Vector3& position);
 		//===========================================================================
 
 		//= ROTATION ===========================================================
-		Math::Quaternion GetRotation()  const { return m_matrix.GetRotation(); }
+		Math::Quaternion GetRotation()  const { return GetMatrixResolved().GetRotation(); }
 		const auto& GetRotationLocal()  const { return m_rotationLocal; }
 		void SetRotation(const Math::Quaternion& rotation);
 		void SetRotationLocal(const Math::Quaternion& rotation);
 		//======================================================================
 
 		//= SCALE =========================================================
-		auto GetScale() const { return m_matrix.GetScale(); }
+		auto GetScale() const { return GetMatrixResolved().GetScale(); }
 		const auto& GetScaleLocal() const	{ return m_scaleLocal; }
 		void SetScale(const Math::Vector3& scale);
 		void SetScaleLocal(const Math::Vector3& scale);
@@ -103,26 +119,42 @@ namespace Spartan
 		//======================================================================================
 
 		void LookAt(const Math::Vector3& v) { m_lookAt = v; }
-		const auto& GetMatrix()         const { return m_matrix; }     
-		const auto& GetLocalMatrix()    const { return m_matrixLocal; }
+		// Always current. World::Tick resolves every transform before anything renders, so while the world ticks these are plain reads,
+		// otherwise (e.g. a model import has the world stopped) whatever was modified since is resolved on demand.
+		const Math::Matrix& GetMatrix()         const { return GetMatrixResolved(); }
+		const Math::Matrix& GetLocalMatrix()    const { GetMatrixResolved(); return m_matrixLocal; }
         const auto& GetWvpLastFrame()   const { return m_wvp_previous; }
         void SetWvpLastFrame(const Math::Matrix& matrix) { m_wvp_previous = matrix;}
 
 	private:
+		friend class World;
+		friend class WorldStreaming;
+
 		Math::Matrix GetParentTransformMatrix() const;
+		void MarkDirty();
+		void Resolve() const;
+		// Resolves on demand, which writes the matrices, so only for the thread that modifies the world
+		const Math::Matrix& GetMatrixResolved() const { if (m_is_dirty) Resolve(); return m_matrix; }
+		void ComputeMatrices() const;
+		void RegisterChild(Transform* child);
+		void UnregisterChild(Transform* child);
+		// For loading, the hierarchy is known to be valid so nothing SetParent() checks or updates is needed
+		void LinkParent(Transform* parent);
 
 		// local
 		Math::Vector3 m_positionLocal;
 		Math::Quaternion m_rotationLocal;
 		Math::Vector3 m_scaleLocal;
 
-		Math::Matrix m_matrix;
-		Math::Matrix m_matrixLocal;
+		mutable Math::Matrix m_matrix;
+		mutable Math::Matrix m_matrixLocal;
+		mutable bool m_is_dirty = true;
 		Math::Vector3 m_lookAt;
 
 		Transform* m_parent; // the parent of this transform
 		std::vector<Transform*> m_children; // the children of this transform
 
 		Math::Matrix m_wvp_previous;
+		World* m_world = nullptr;
 	};
 }
@@ -72,6 +72,54 @@ namespace Spartan
 		m_components.clear();
 	}
 
+	void Entity::SetName(const string& name)
+	{
+		if (m_name == name)
+			return;
+
+		if (m_handle.IsValid())
+		{
+			m_context->GetSubsystem<World>()->EntityIndexName(this, m_name, name);
+		}
+
+		m_name = name;
+	}
+
+	void Entity::SetId(const uint32_t id)
+	{
+		if (m_id == id)
+			return;
+
+		if (m_handle.IsValid())
+		{
+			m_context->GetSubsystem<World>()->EntityIndexId(this, m_id, id);
+		}
+
+		m_id = id;
+	}
+
+	void Entity::SetActive(const bool active)
+	{
+		if (m_is_active == active)
+			return;
+
+		m_is_active = active;
+
+		if (m_handle.IsValid())
+		{
+			m_context->GetSubsystem<World>()->EntityMarkChanged(this);
+		}
+	}
+
+	void Entity::OnComponentsChanged()
+	{
+		// Entities that are not part of the world yet get their storage assigned when they are added
+		if (m_handle.IsValid())
+		{
+			m_context->GetSubsystem<World>()->ArchetypeUpdate(this);
+		}
+	}
+
 	void Entity::Clone()
 	{
 		auto scene = m_context->GetSubsystem<World>();
@@ -159,6 +207,7 @@ namespace Spartan
             stream->Write(m_hierarchy_visibility);
             stream->Write(GetId());
             stream->Write(m_name);
+            stream->Write(m_transform && m_transform->HasParent() ? m_transform->GetParent()->GetEntity()->GetId() : 0);
         }
 
 		// COMPONENTS
@@ -175,44 +224,99 @@ namespace Spartan
                 component->Serialize(stream);
             }
         }
+	}
 
-        // CHILDREN
+    void Entity::DeserializeRecord(FileStream* stream, EntityRecord* record)
+    {
+        // BASIC DATA
         {
-            auto children = GetTransform()->GetChildren();
-
-            // Children count
-            stream->Write(static_cast<uint32_t>(children.size()));
+            stream->Read(&record->is_active);
+            stream->Read(&record->hierarchy_visibility);
+            stream->Read(&record->id);
+            stream->Read(&record->name);
+            stream->Read(&record->parent_id);
+        }
 
-            // Children IDs
-            for (const auto& child : children)
+        // COMPONENTS
+        {
+            record->components.resize(stream->ReadAs<uint32_t>());
+            for (auto& component : record->components)
             {
-                stream->Write(child->GetId());
+                stream->Read(&component.first);     // type
+                stream->Read(&component.second);    // id
             }
+        }
 
-            // Children
-            for (const auto& child : children)
+        // STAGED COMPONENTS
+        {
+            // The component data is written back to back without sizes, so only the leading pure
+            // data components can be read here, the rest is read when the components are created
+            for (const auto& component : record->components)
             {
-                if (child->GetEntity())
+                if (component.first == ComponentType_Transform)
+                {
+                    Transform::DeserializeRecord(stream, &record->transform);
+                }
+                else if (component.first == ComponentType_Renderable)
                 {
-                    child->GetEntity()->Serialize(stream);
+                    Renderable::DeserializeRecord(stream, &record->renderable);
                 }
                 else
                 {
-                    LOG_ERROR("Aborting , child entity is nullptr.");
                     break;
                 }
+
+                record->staged_count++;
             }
         }
-	}
+    }
 
-	void Entity::Deserialize(FileStream* stream, Transform* parent)
+    void Entity::Deserialize(FileStream* stream, const EntityRecord& record)
+    {
+        // BASIC DATA
+        {
+            m_is_active             = record.is_active;
+            m_hierarchy_visibility  = record.hierarchy_visibility;
+            SetId(record.id);
+            SetName(record.name);
+        }
+
+        // COMPONENTS
+        {
+            for (const auto& component : record.components)
+            {
+                AddComponent(static_cast<ComponentType>(component.first), component.second);
+            }
+
+            // Create all the components first, they can depend on each other while deserializing
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_components.size()); i++)
+            {
+                IComponent* component = m_components[i].get();
+
+                if (i >= record.staged_count)
+                {
+                    component->Deserialize(stream);
+                }
+                else if (component->GetType() == ComponentType_Transform)
+                {
+                    static_cast<Transform*>(component)->Deserialize(record.transform);
+                }
+                else if (component->GetType() == ComponentType_Renderable)
+                {
+                    static_cast<Renderable*>(component)->Deserialize(record.renderable);
+                }
+            }
+        }
+    }
+
+	void Entity::DeserializeLegacy(FileStream* stream, Transform* parent)
 	{
         // BASIC DATA
         {
             stream->Read(&m_is_active);
             stream->Read(&m_hierarchy_visibility);
-            stream->Read(&m_id);
-            stream->Read(&m_name);
+            SetId(stream->ReadAs<uint32_t>());
+            SetName(stream->ReadAs<string>());
         }
 
         // COMPONENTS
@@ -259,15 +363,10 @@ namespace Spartan
                 children.emplace_back(child);
             }
 
-            // Children
+            // Children (they attach themselves to this transform)
             for (const auto& child : children)
             {
-                child.lock()->Deserialize(stream, GetTransform());
-            }
-
-            if (m_transform)
-            {
-                m_transform->AcquireChildren();
+                child.lock()->DeserializeLegacy(stream, GetTransform());
             }
         }
 
@@ -334,6 +433,7 @@ namespace Spartan
         {
             m_component_mask &= ~GetComponentMask(component_type);
         }
+        OnComponentsChanged();
 
 		// Make the scene resolve
 		FIRE_EVENT(Event_World_Resolve_Pending);
@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include "../Core/EventSystem.h"
 #include "Components/IComponent.h"
+#include "Components/Transform.h"
+#include "Components/Renderable.h"
 //================================
 
 namespace Spartan
@@ -32,6 +34,33 @@ namespace Spartan
 	class Context;
 	class Transform;
 	class Renderable;
+
+	// A weak reference to an entity, it becomes invalid once the entity is removed from the world
+	struct EntityHandle
+	{
+		uint32_t index		= 0;
+		uint32_t generation	= 0; // 0 is never handed out
+
+		bool IsValid() const { return generation != 0; }
+		bool operator==(const EntityHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+		bool operator!=(const EntityHandle& rhs) const { return !(*this == rhs); }
+	};
+
+	// Everything Entity::Serialize() writes ahead of the component data, plus the data of the leading
+	// pure data components (transform and renderable). Reading it creates nothing, so a world can read
+	// the records of all of its entities in parallel.
+	struct EntityRecord
+	{
+		uint32_t id					= 0;
+		uint32_t parent_id			= 0;
+		bool is_active				= true;
+		bool hierarchy_visibility	= true;
+		std::string name;
+		std::vector<std::pair<uint32_t, uint32_t>> components; // type, id
+		uint32_t staged_count		= 0; // how many of the components were read into the record
+		TransformRecord transform;
+		RenderableRecord renderable;
+	};
 	
 	class SPARTAN_CLASS Entity : public Spartan_Object, public std::enable_shared_from_this<Entity>
 	{
@@ -44,14 +73,22 @@ namespace Spartan
 		void Stop();
 		void Tick(float delta_time);
 		void Serialize(FileStream* stream);
-		void Deserialize(FileStream* stream, Transform* parent);
+		static void DeserializeRecord(FileStream* stream, EntityRecord* record);
+		// Expects the stream right after the record (including the staged components), the parent is linked by the world once every entity exists
+		void Deserialize(FileStream* stream, const EntityRecord& record);
+		// Worlds saved before entities were written as records, every entity was followed by its children
+		void DeserializeLegacy(FileStream* stream, Transform* parent);
 
 		//= PROPERTIES ===================================================================================================
 		const std::string& GetName() const								{ return m_name; }
-		void SetName(const std::string& name)							{ m_name = name; }
+		void SetName(const std::string& name);
+
+		// Overrides Spartan_Object::SetId() so that the world can keep its id index up to date, whichever type it's called through
+		void SetId(uint32_t id) override;
+		const EntityHandle& GetHandle() const							{ return m_handle; }
 
 		bool IsActive() const											{ return m_is_active; }
-		void SetActive(const bool active)								{ m_is_active = active; }
+		void SetActive(bool active);
 
 		bool IsVisibleInHierarchy() const								{ return m_hierarchy_visibility; }
 		void SetHierarchyVisibility(const bool hierarchy_visibility)	{ m_hierarchy_visibility = hierarchy_visibility; }
@@ -81,6 +118,7 @@ namespace Spartan
             // Initialize component
             component->SetType(type);
             component->OnInitialize();
+            OnComponentsChanged();
 
 			// Make the scene resolve
 			FIRE_EVENT(Event_World_Resolve_Pending);
@@ -157,6 +195,7 @@ namespace Spartan
 					++it;
 				}
 			}
+            OnComponentsChanged();
 
 			// Make the scene resolve
 			FIRE_EVENT(Event_World_Resolve_Pending);
@@ -173,8 +212,14 @@ namespace Spartan
 		Renderable* GetRenderable() const	    { return m_renderable; }
 		std::shared_ptr<Entity> GetPtrShared()  { return shared_from_this(); }
 
+		// The leaf of the entity's bounds in the world's scene query, if it has any
+		uint32_t GetSceneQueryProxy() const     { return m_scene_query_proxy; }
+
 	private:
+		friend class World;
+
         constexpr uint32_t GetComponentMask(ComponentType type) { return static_cast<uint32_t>(1) << static_cast<uint32_t>(type); }
+        void OnComponentsChanged();
 
 		std::string m_name			= "Entity";
 		bool m_is_active			= true;
@@ -183,9 +228,20 @@ namespace Spartan
 		Renderable* m_renderable	= nullptr;
         Context* m_context          = nullptr;
         bool m_destruction_pending  = false;
+		EntityHandle m_handle;
 		
         // Components
         std::vector<std::shared_ptr<IComponent>> m_components;
         uint32_t m_component_mask = 0;
+
+        // Location in the world's component storage
+        static constexpr uint32_t archetype_invalid = 0xFFFFFFFF;
+        uint32_t m_archetype        = archetype_invalid;
+        uint32_t m_archetype_row    = 0;
+
+        // Location in the world's scene query
+        static constexpr uint32_t scene_query_proxy_invalid = 0xFFFFFFFF; // Math::BoundingVolumeHierarchy::null_proxy
+        uint32_t m_scene_query_proxy    = scene_query_proxy_invalid;
+        bool m_scene_query_dirty        = false; // queued for a refit
 	};
 }
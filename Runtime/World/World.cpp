@@ -19,23 +19,32 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==========================
+//= INCLUDES ===========================
+#include <limits>
+#include <algorithm>
 #include "World.h"
 #include "Entity.h"
+#include "WorldStreaming.h"
 #include "Components/Transform.h"
+#include "Components/Renderable.h"
 #include "Components/Camera.h"
 #include "Components/Light.h"
 #include "Components/Environment.h"
 #include "Components/AudioListener.h"
 #include "../Core/Engine.h"
 #include "../Core/Stopwatch.h"
+#include "../Core/Timer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ProgressReport.h"
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/ShaderVariation.h"
 #include "../Input/Input.h"
-//=====================================
+#include "../Threading/Threading.h"
+#include "../Math/Ray.h"
+#include "../Math/RayHit.h"
+//======================================
 
 //= NAMESPACES ================
 using namespace std;
@@ -44,6 +53,13 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // Worlds saved before this are a root entity count followed by recursive entities
+        constexpr uint32_t world_magic      = 'S' | ('P' << 8) | ('W' << 16) | ('D' << 24);
+        constexpr uint32_t world_version    = 2;
+    }
+
 	World::World(Context* context) : ISubsystem(context)
 	{
 		// Subscribe to events
@@ -63,6 +79,8 @@ namespace Spartan
 	{
 		m_input		= m_context->GetSubsystem<Input>();
 		m_profiler	= m_context->GetSubsystem<Profiler>();
+		m_threading	= m_context->GetSubsystem<Threading>();
+		m_streaming	= make_unique<WorldStreaming>(this, m_threading);
 
 		CreateCamera();
 		CreateEnvironment();
@@ -82,6 +100,15 @@ namespace Spartan
 		if (m_state != Ticking)
 			return;
 
+        // A save is reading the entities on a worker, the world resumes once it's done. Transforms are still resolved,
+        // the save only reads their local values and everything that renders expects resolved matrices.
+        unique_lock<recursive_mutex> lock(m_mutex, try_to_lock);
+        if (!lock.owns_lock())
+        {
+            TransformsResolve();
+            return;
+        }
+
         SCOPED_TIME_BLOCK(m_profiler);
 
         // Tick entities
@@ -116,24 +143,55 @@ namespace Spartan
             }
 		}
 
+        // Stream cells in and out around the camera, before resolving so that what streamed in is resolved this tick
+        if (const auto& camera = m_context->GetSubsystem<Renderer>()->GetCamera())
+        {
+            const Timer* timer = m_context->GetSubsystem<Timer>();
+            m_streaming->Tick(camera->GetTransform()->GetPosition(), static_cast<float>(timer->GetDeltaTimeMs()), static_cast<float>(timer->GetDeltaTimeSmoothedMs()));
+        }
+
+        // Resolve all the transforms that were modified during the tick
+        TransformsResolve();
+
+        // Refit the bounds of the entities that moved
+        SceneQueryRefit();
+
         if (m_is_dirty)
         {
             // Update dirty entities
             {
-                // Make a copy so we can iterate while removing entities
-                auto entities_copy = m_entities;
-
-                for (const auto& entity : entities_copy)
+                // Gather first, removal swaps entities around
+                vector<shared_ptr<Entity>> entities_pending_destruction;
+                for (const auto& entity : m_entities)
                 {
                     if (entity->IsPendingDestruction())
                     {
-                        _EntityRemove(entity);
+                        entities_pending_destruction.emplace_back(entity);
+                    }
+                }
+
+                for (const auto& entity : entities_pending_destruction)
+                {
+                    _EntityRemove(entity);
+                }
+            }
+
+            // Apply the deltas to the scene query before anyone gets to query it
+            {
+                unordered_set<Entity*> entities_processed;
+                entities_processed.reserve(m_entity_deltas.size());
+                for (const EntityDelta& delta : m_entity_deltas)
+                {
+                    if (entities_processed.insert(delta.entity.get()).second)
+                    {
+                        SceneQueryUpdate(delta.entity.get());
                     }
                 }
             }
 
-            // Notify Renderer
-            FIRE_EVENT_DATA(Event_World_Resolve_Complete, m_entities);
+            // Notify Renderer, it applies the deltas to its render lists
+            FIRE_EVENT(Event_World_Resolve_Complete);
+            m_entity_deltas.clear();
             m_is_dirty = false;
         }
 	}
@@ -143,14 +201,50 @@ namespace Spartan
         // Notify any systems that the entities are about to be cleared
 		FIRE_EVENT(Event_World_Unload);
 
+        // Wait for the cells that are being read
+        if (m_streaming)
+        {
+            m_streaming->Close();
+        }
+
+        // Invalidate all handles, entities which are still referenced elsewhere are no longer part of the world
+        for (const auto& entity : m_entities)
+        {
+            entity->m_handle                = EntityHandle();
+            entity->m_scene_query_proxy     = Entity::scene_query_proxy_invalid;
+            entity->m_scene_query_dirty     = false;
+        }
+        m_entity_slots_free.clear();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_entity_slots.size()); i++)
+        {
+            EntitySlot& slot = m_entity_slots[i];
+            slot.generation = slot.generation == numeric_limits<uint32_t>::max() ? 1 : slot.generation + 1;
+            m_entity_slots_free.emplace_back(i);
+        }
+        m_entity_index_id.clear();
+        m_entity_index_name.clear();
+        m_archetypes.clear();
+        m_archetype_index.clear();
+        m_entity_deltas.clear();
+
         m_entities.clear();
         m_entities.shrink_to_fit();
 
+        m_transforms.clear();
+        m_transforms_depth_offsets.clear();
+        m_transforms_hierarchy_dirty = true;
+
+        m_scene_query.Clear();
+        m_scene_query_dirty.clear();
+
 		m_is_dirty = true;
 	}
 
 	bool World::SaveToFile(const string& filePathIn)
 	{
+        // The entities are read from this thread for the whole save, so they must not change meanwhile
+        lock_guard<recursive_mutex> lock(m_mutex);
+
 		// Start progress report and timer
 		ProgressReport::Get().Reset(g_progress_world);
 		ProgressReport::Get().SetIsLoading(g_progress_world, true);
@@ -168,33 +262,56 @@ namespace Spartan
 		// Notify subsystems that need to save data
 		FIRE_EVENT(Event_World_Save);
 
+		// Streamable entities are saved into cells (which can load some of them), the world file keeps the rest
+		unordered_set<uint32_t> streamed_root_ids;
+		if (!m_streaming->Save(file_path, &streamed_root_ids))
+		{
+			ProgressReport::Get().SetIsLoading(g_progress_world, false);
+			return false;
+		}
+
 		// Create a prefab file
-		auto file = make_unique<FileStream>(file_path, FileStream_Write);
+		auto file = make_unique<FileStream>(file_path, FileStream_Write | (m_save_compressed ? FileStream_Compressed : 0));
 		if (!file->IsOpen())
 		{
 			LOG_ERROR_GENERIC_FAILURE();
 			return false;
 		}
 
-		// Only save root entities as they will also save their descendants
-		auto root_actors = EntityGetRoots();
-		const auto root_entity_count = static_cast<uint32_t>(root_actors.size());
-
-		ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
-
-		// Save root entity count
-		file->Write(root_entity_count);
-
-		// Save root entity IDs
-		for (const auto& root : root_actors)
+		// Parents come before their children, so loading can link every parent in a single pass
+		vector<Entity*> entities;
+		entities.reserve(m_entities.size());
+		for (const auto& root : EntityGetRoots())
+		{
+			if (streamed_root_ids.find(root->GetId()) == streamed_root_ids.end())
+			{
+				entities.emplace_back(root.get());
+			}
+		}
+		for (size_t i = 0; i < entities.size(); i++)
 		{
-			file->Write(root->GetId());
+			for (Transform* child : entities[i]->GetTransform()->GetChildren())
+			{
+				entities.emplace_back(child->GetEntity());
+			}
 		}
+		const auto entity_count = static_cast<uint32_t>(entities.size());
 
-		// Save root entities
-		for (const auto& root : root_actors)
+		ProgressReport::Get().SetJobCount(g_progress_world, entity_count);
+
+		file->Write(world_magic);
+		file->Write(world_version);
+		file->Write(entity_count);
+
+		// Every entity is a self contained block, so loading can read them in parallel
+		vector<std::byte> block;
+		for (Entity* entity : entities)
 		{
-			root->Serialize(file.get());
+			{
+				FileStream stream(&block, FileStream_Write);
+				entity->Serialize(&stream);
+			}
+			file->Write(block);
 			ProgressReport::Get().IncrementJobsDone(g_progress_world);
 		}
 
@@ -217,6 +334,7 @@ namespace Spartan
 		}
 
 		// Thread safety: Wait for scene and the renderer to stop the entities (could do double buffering in the future)
+		// This waits on the main thread's tick, so it has to run on a worker (Threading::AddTaskBackground())
 		while (m_state != Loading || m_context->GetSubsystem<Renderer>()->IsRendering()) { m_state = Request_Loading; this_thread::sleep_for(chrono::milliseconds(16)); }
 
 		// Start progress report and timing
@@ -229,7 +347,7 @@ namespace Spartan
 		Unload();
 
 		// Read all the resource file paths
-		auto file = make_unique<FileStream>(file_path, FileStream_Read);
+		auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Compressed);
 		if (!file->IsOpen())
 			return false;
 
@@ -238,38 +356,131 @@ namespace Spartan
 		// Notify subsystems that need to load data
 		FIRE_EVENT(Event_World_Load);
 
-		// Load root entity count
-        const auto root_entity_count = file->ReadAs<uint32_t>();
+		const auto magic = file->ReadAs<uint32_t>();
+		if (magic == world_magic)
+		{
+			const auto version = file->ReadAs<uint32_t>();
+			if (version != world_version)
+			{
+				LOG_ERROR("Unsupported world version %d", version);
+				ProgressReport::Get().SetIsLoading(g_progress_world, false);
+				m_state = Ticking;
+				return false;
+			}
+
+			LoadEntities(file.get());
+		}
+		else
+		{
+			// Legacy worlds start with their root entity count
+			LoadEntitiesLegacy(file.get(), magic);
+		}
+
+		// Cells stream in as the world ticks
+		m_streaming->Open(file_path);
+
+		// Compile every shader variation the materials need before the world starts ticking, so that nothing pops in
+		ShaderVariation::Precompile(m_context, ShaderVariation::BuildManifest(m_context), g_progress_world);
+
+		m_is_dirty	= true;
+		m_state		= Ticking;
+		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
+		LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
+
+		FIRE_EVENT(Event_World_Loaded);
+		return true;
+	}
+
+	void World::LoadEntities(FileStream* file)
+	{
+		const auto entity_count = file->ReadAs<uint32_t>();
+		ProgressReport::Get().SetJobCount(g_progress_world, entity_count);
+
+		// The file is a single stream, so the blocks are read one after the other
+		vector<vector<std::byte>> blocks(entity_count);
+		for (auto& block : blocks)
+		{
+			file->Read(&block);
+		}
+
+		// Phase 1: Read the records and the transform and renderable data, creating nothing, so every block can be parsed on any thread
+		vector<EntityRecord> records(entity_count);
+		vector<size_t> component_offsets(entity_count);
+		m_threading->ParallelFor([&](const uint32_t start, const uint32_t end)
+		{
+			for (uint32_t i = start; i < end; i++)
+			{
+				FileStream stream(&blocks[i], FileStream_Read);
+				Entity::DeserializeRecord(&stream, &records[i]);
+				component_offsets[i] = stream.GetMemoryPosition();
+			}
+		}, entity_count);
+
+		// Phase 2: Create the entities and their components, components can reach into other subsystems so this is sequential
+		m_entities.reserve(m_entities.size() + entity_count);
+		vector<Entity*> entities(entity_count);
+		for (uint32_t i = 0; i < entity_count; i++)
+		{
+			entities[i] = EntityCreate(records[i].is_active).get();
+
+			FileStream stream(&blocks[i], FileStream_Read);
+			stream.Skip(static_cast<uint32_t>(component_offsets[i]));
+			entities[i]->Deserialize(&stream, records[i]);
+
+			vector<std::byte>().swap(blocks[i]);
+			ProgressReport::Get().IncrementJobsDone(g_progress_world);
+		}
+
+		// Phase 3: Link the hierarchy, parents were saved before their children so the sibling order is kept
+		for (uint32_t i = 0; i < entity_count; i++)
+		{
+			if (records[i].parent_id == 0)
+				continue;
+
+			if (Entity* parent = EntityGetById(records[i].parent_id).get())
+			{
+				entities[i]->GetTransform()->LinkParent(parent->GetTransform());
+			}
+			else
+			{
+				LOG_WARNING("\"%s\" references a missing parent, it will be a root", records[i].name.c_str());
+			}
+		}
+
+		// Phase 4: Compute every world matrix once, top to bottom
+		TransformsMarkHierarchyDirty();
+		TransformsResolve();
+	}
 
+	void World::LoadEntitiesLegacy(FileStream* file, const uint32_t root_entity_count)
+	{
 		ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
 
 		// Load root entity IDs
-		for (uint32_t i = 0; i < root_entity_count; i++)
+        vector<uint32_t> root_ids(root_entity_count);
+        file->Read(root_ids.data(), root_ids.size());
+		for (const uint32_t id : root_ids)
 		{
 			auto& entity = EntityCreate();
-			entity->SetId(file->ReadAs<uint32_t>());
+			entity->SetId(id);
 		}
 
 		// Serialize root entities
 		for (uint32_t i = 0; i < root_entity_count; i++)
 		{
-			m_entities[i]->Deserialize(file.get(), nullptr);
+			m_entities[i]->DeserializeLegacy(file, nullptr);
 			ProgressReport::Get().IncrementJobsDone(g_progress_world);
 		}
-
-		m_is_dirty	= true;
-		m_state		= Ticking;
-		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
-		LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
-
-		FIRE_EVENT(Event_World_Loaded);
-		return true;
 	}
 
     shared_ptr<Entity>& World::EntityCreate(bool is_active /*= true*/)
     {
+        lock_guard<recursive_mutex> lock(m_mutex);
+
         auto& entity = m_entities.emplace_back(make_shared<Entity>(m_context));
         entity->SetActive(is_active);
+        EntityIndexAdd(entity.get());
+        m_transforms_hierarchy_dirty = true;
         return entity;
     }
 
@@ -280,7 +491,16 @@ namespace Spartan
 		if (!entity)
 			return empty;
 
-		return m_entities.emplace_back(entity);
+        lock_guard<recursive_mutex> lock(m_mutex);
+
+        // Already part of the world
+        if (entity->GetHandle().IsValid())
+            return m_entities[m_entity_slots[entity->GetHandle().index].entity_index];
+
+        auto& entity_added = m_entities.emplace_back(entity);
+        EntityIndexAdd(entity_added.get());
+        m_transforms_hierarchy_dirty = true;
+		return entity_added;
 	}
 
 	bool World::EntityExists(const shared_ptr<Entity>& entity)
@@ -318,11 +538,9 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetByName(const string& name)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetName() == name)
-				return entity;
-		}
+        const auto it = m_entity_index_name.find(name);
+        if (it != m_entity_index_name.end() && !it->second.empty())
+            return EntityGetById(it->second.front());
 
         static shared_ptr<Entity> empty;
 		return empty;
@@ -330,46 +548,460 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetById(const uint32_t id)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetId() == id)
-				return entity;
-		}
+        const auto it = m_entity_index_id.find(id);
+        if (it != m_entity_index_id.end())
+            return m_entities[m_entity_slots[it->second].entity_index];
 
         static shared_ptr<Entity> empty;
 		return empty;
 	}
 
+    const shared_ptr<Entity>& World::EntityGetByHandle(const EntityHandle& handle)
+    {
+        if (handle.IsValid() && handle.index < static_cast<uint32_t>(m_entity_slots.size()))
+        {
+            const EntitySlot& slot = m_entity_slots[handle.index];
+            if (slot.generation == handle.generation)
+                return m_entities[slot.entity_index];
+        }
+
+        static shared_ptr<Entity> empty;
+        return empty;
+    }
+
+    void World::EntityIndexAdd(Entity* entity)
+    {
+        // Grab a slot
+        uint32_t slot_index = 0;
+        if (!m_entity_slots_free.empty())
+        {
+            slot_index = m_entity_slots_free.back();
+            m_entity_slots_free.pop_back();
+        }
+        else
+        {
+            slot_index = static_cast<uint32_t>(m_entity_slots.size());
+            m_entity_slots.emplace_back().generation = 1;
+        }
+
+        EntitySlot& slot    = m_entity_slots[slot_index];
+        slot.entity_index   = static_cast<uint32_t>(m_entities.size()) - 1; // entities are always indexed right after being appended
+
+        entity->m_handle.index      = slot_index;
+        entity->m_handle.generation = slot.generation;
+
+        m_entity_index_id[entity->GetId()] = slot_index;
+        m_entity_index_name[entity->GetName()].emplace_back(entity->GetId());
+
+        ArchetypeInsert(entity);
+
+        // The added delta inserts the entity into the scene query, so a stale refit request (from a previous stay in the world) has nothing to add
+        entity->m_scene_query_dirty = false;
+
+        m_entity_deltas.emplace_back(Entity_Delta_Added, entity->GetPtrShared());
+        m_is_dirty = true;
+    }
+
+    void World::EntityIndexId(Entity* entity, const uint32_t id_old, const uint32_t id_new)
+    {
+        const auto it = m_entity_index_id.find(id_old);
+        if (it != m_entity_index_id.end() && it->second == entity->m_handle.index)
+        {
+            m_entity_index_id.erase(it);
+        }
+        m_entity_index_id[id_new] = entity->m_handle.index;
+
+        // Keep the position, the entity still got its name at the same time
+        auto& ids = m_entity_index_name[entity->GetName()];
+        const auto it_name = find(ids.begin(), ids.end(), id_old);
+        if (it_name != ids.end())
+        {
+            *it_name = id_new;
+        }
+        else
+        {
+            ids.emplace_back(id_new);
+        }
+    }
+
+    void World::EntityIndexName(Entity* entity, const string& name_old, const string& name_new)
+    {
+        const auto it = m_entity_index_name.find(name_old);
+        if (it != m_entity_index_name.end())
+        {
+            auto& ids = it->second;
+            ids.erase(remove(ids.begin(), ids.end(), entity->GetId()), ids.end());
+            if (ids.empty())
+            {
+                m_entity_index_name.erase(it);
+            }
+        }
+
+        m_entity_index_name[name_new].emplace_back(entity->GetId());
+    }
+
     // Removes an entity and all of it's children
-    void World::_EntityRemove(const std::shared_ptr<Entity>& entity)
+    void World::_EntityRemove(const std::shared_ptr<Entity>& entity_in)
     {
+        // Keep a reference, the argument might point into m_entities
+        const shared_ptr<Entity> entity = entity_in;
+
+        // Already removed, e.g. as a descendant of an entity that was removed before it
+        if (!entity->GetHandle().IsValid())
+            return;
+
         // Remove any descendants
         auto children = entity->GetTransform()->GetChildren();
         for (const auto& child : children)
         {
-            EntityRemove(child->GetEntity()->GetPtrShared());
+            _EntityRemove(child->GetEntity()->GetPtrShared());
+        }
+
+        // Detach from the parent (in case it has one)
+        entity->GetTransform()->BecomeOrphan();
+
+        // Swap with the last entity and pop
+        EntitySlot& slot            = m_entity_slots[entity->GetHandle().index];
+        const uint32_t index        = slot.entity_index;
+        const uint32_t index_last   = static_cast<uint32_t>(m_entities.size()) - 1;
+        if (index != index_last)
+        {
+            m_entities[index] = move(m_entities[index_last]);
+            m_entity_slots[m_entities[index]->GetHandle().index].entity_index = index;
+        }
+        m_entities.pop_back();
+
+        // Remove from the lookup tables
+        const auto it_id = m_entity_index_id.find(entity->GetId());
+        if (it_id != m_entity_index_id.end() && it_id->second == entity->GetHandle().index)
+        {
+            m_entity_index_id.erase(it_id);
+        }
+        const auto it_name = m_entity_index_name.find(entity->GetName());
+        if (it_name != m_entity_index_name.end())
+        {
+            auto& ids = it_name->second;
+            ids.erase(remove(ids.begin(), ids.end(), entity->GetId()), ids.end());
+            if (ids.empty())
+            {
+                m_entity_index_name.erase(it_name);
+            }
+        }
+
+        ArchetypeRemove(entity.get());
+
+        // Invalidate any outstanding handles and recycle the slot
+        slot.generation = slot.generation == numeric_limits<uint32_t>::max() ? 1 : slot.generation + 1;
+        m_entity_slots_free.emplace_back(entity->GetHandle().index);
+        entity->m_handle = EntityHandle();
+
+        m_entity_deltas.emplace_back(Entity_Delta_Removed, entity);
+        m_transforms_hierarchy_dirty = true;
+    }
+
+    void World::ArchetypeInsert(Entity* entity)
+    {
+        // Find or create the archetype
+        uint32_t archetype_index = 0;
+        const auto it = m_archetype_index.find(entity->m_component_mask);
+        if (it != m_archetype_index.end())
+        {
+            archetype_index = it->second;
+        }
+        else
+        {
+            archetype_index = static_cast<uint32_t>(m_archetypes.size());
+            m_archetypes.emplace_back().mask = entity->m_component_mask;
+            m_archetype_index[entity->m_component_mask] = archetype_index;
         }
 
-        // Keep a reference to it's parent (in case it has one)
-        auto parent = entity->GetTransform()->GetParent();
+        Archetype& archetype    = m_archetypes[archetype_index];
+        entity->m_archetype     = archetype_index;
+        entity->m_archetype_row = static_cast<uint32_t>(archetype.entities.size());
+        archetype.entities.emplace_back(entity);
 
-        // Remove this entity
-        for (auto it = m_entities.begin(); it < m_entities.end();)
+        // Only columns of types in the mask are used, the first component of each type is the one that's stored
+        for (uint32_t type = 0; type < ComponentType_Unknown; type++)
         {
-            const auto temp = *it;
-            if (temp->GetId() == entity->GetId())
+            if (archetype.mask & (1u << type))
             {
-                it = m_entities.erase(it);
-                break;
+                archetype.columns[type].emplace_back(nullptr);
             }
-            ++it;
         }
+        for (const auto& component : entity->GetAllComponents())
+        {
+            auto& column = archetype.columns[component->GetType()];
+            if (!column.back())
+            {
+                column.back() = component.get();
+            }
+        }
+    }
 
-        // If there was a parent, update it
-        if (parent)
+    void World::ArchetypeRemove(Entity* entity)
+    {
+        if (entity->m_archetype == Entity::archetype_invalid)
+            return;
+
+        // Swap with the last row and pop
+        Archetype& archetype    = m_archetypes[entity->m_archetype];
+        const uint32_t row      = entity->m_archetype_row;
+        const uint32_t row_last = static_cast<uint32_t>(archetype.entities.size()) - 1;
+        if (row != row_last)
         {
-            parent->AcquireChildren();
+            archetype.entities[row] = archetype.entities[row_last];
+            archetype.entities[row]->m_archetype_row = row;
+        }
+        archetype.entities.pop_back();
+
+        for (uint32_t type = 0; type < ComponentType_Unknown; type++)
+        {
+            if (archetype.mask & (1u << type))
+            {
+                auto& column    = archetype.columns[type];
+                column[row]     = column[row_last];
+                column.pop_back();
+            }
+        }
+
+        entity->m_archetype     = Entity::archetype_invalid;
+        entity->m_archetype_row = 0;
+    }
+
+    void World::ArchetypeUpdate(Entity* entity)
+    {
+        if (!entity->GetHandle().IsValid())
+            return;
+
+        // Components might have changed even if the mask didn't (e.g. one of multiple scripts), so re-insert
+        ArchetypeRemove(entity);
+        ArchetypeInsert(entity);
+
+        EntityMarkChanged(entity);
+    }
+
+    void World::EntityMarkChanged(Entity* entity)
+    {
+        // Callers can be on a worker, the deltas are only read and cleared while ticking, which holds the lock too
+        lock_guard<recursive_mutex> lock(m_mutex);
+
+        if (!entity || !entity->GetHandle().IsValid())
+            return;
+
+        m_entity_deltas.emplace_back(Entity_Delta_Changed, entity->GetPtrShared());
+        m_is_dirty = true;
+    }
+
+    void World::TransformsSortByDepth()
+    {
+        m_transforms.clear();
+        m_transforms_depth_offsets.clear();
+
+        // Roots
+        for (const auto& entity : m_entities)
+        {
+            Transform* transform = entity->GetTransform();
+            if (transform->IsRoot())
+            {
+                m_transforms.emplace_back(transform);
+            }
+        }
+
+        // Breadth first, so every level only depends on the one before it
+        uint32_t level_start = 0;
+        while (level_start < static_cast<uint32_t>(m_transforms.size()))
+        {
+            const uint32_t level_end = static_cast<uint32_t>(m_transforms.size());
+            m_transforms_depth_offsets.emplace_back(level_start);
+
+            for (uint32_t i = level_start; i < level_end; i++)
+            {
+                for (Transform* child : m_transforms[i]->GetChildren())
+                {
+                    m_transforms.emplace_back(child);
+                }
+            }
+
+            level_start = level_end;
+        }
+        m_transforms_depth_offsets.emplace_back(static_cast<uint32_t>(m_transforms.size()));
+
+        m_transforms_hierarchy_dirty = false;
+    }
+
+    void World::TransformsResolve()
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        if (m_transforms_hierarchy_dirty)
+        {
+            TransformsSortByDepth();
+        }
+
+        // A parent is always resolved in an earlier level than its children, so each level can be done in parallel
+        const auto resolve = [this](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                if (m_transforms[i]->m_is_dirty)
+                {
+                    m_transforms[i]->ComputeMatrices();
+                }
+            }
+        };
+
+        const uint32_t grain_size = 512;
+        for (uint32_t depth = 0; depth + 1 < static_cast<uint32_t>(m_transforms_depth_offsets.size()); depth++)
+        {
+            const uint32_t start    = m_transforms_depth_offsets[depth];
+            const uint32_t end      = m_transforms_depth_offsets[depth + 1];
+            const uint32_t count    = end - start;
+
+            if (count <= grain_size)
+            {
+                resolve(start, end);
+            }
+            else
+            {
+                m_threading->ParallelFor([&resolve, start](const uint32_t i_start, const uint32_t i_end) { resolve(start + i_start, start + i_end); }, count, grain_size);
+            }
+        }
+    }
+
+    void World::SceneQueryRay(const Ray& ray, vector<RayHit>& hits, const bool nearest_only /*= false*/) const
+    {
+        hits.clear();
+
+        // The hierarchy only knows the fattened bounds, so every leaf the ray enters is tested against the renderable's bounds
+        float distance_nearest = numeric_limits<float>::infinity();
+        m_scene_query.QueryRay(ray.GetStart(), ray.GetDirection(), numeric_limits<float>::infinity(), [this, &ray, &hits, &distance_nearest, nearest_only](const uint32_t proxy)
+        {
+            Entity* entity          = static_cast<Entity*>(m_scene_query.GetUserData(proxy));
+            const float distance    = ray.HitDistance(entity->GetRenderable()->GetAabb());
+
+            if (distance != INFINITY && (!nearest_only || distance < distance_nearest))
+            {
+                if (nearest_only)
+                {
+                    hits.clear();
+                    distance_nearest = distance;
+                }
+
+                hits.emplace_back(
+                    entity->GetPtrShared(),                             // Entity
+                    ray.GetStart() + distance * ray.GetDirection(),     // Position
+                    distance,                                           // Distance
+                    distance == 0.0f                                    // Inside
+                );
+            }
+
+            // Once there is a hit, anything behind it can be skipped when only the nearest one is of interest
+            return distance_nearest;
+        });
+
+        // Sort by distance (ascending)
+        sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) { return a.m_distance < b.m_distance; });
+    }
+
+    void World::SceneQueryBox(const BoundingBox& box, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        m_scene_query.QueryBox(box, [this, &box, &entities](const uint32_t proxy)
+        {
+            Entity* entity = static_cast<Entity*>(m_scene_query.GetUserData(proxy));
+            if (box.IsInside(entity->GetRenderable()->GetAabb()) != Outside)
+            {
+                entities.emplace_back(entity);
+            }
+            return true;
+        });
+    }
+
+    void World::SceneQuerySphere(const Vector3& center, const float radius, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        m_scene_query.QuerySphere(center, radius, [this, &center, radius, &entities](const uint32_t proxy)
+        {
+            Entity* entity = static_cast<Entity*>(m_scene_query.GetUserData(proxy));
+            if (entity->GetRenderable()->GetAabb().DistanceSquared(center) <= radius * radius)
+            {
+                entities.emplace_back(entity);
+            }
+            return true;
+        });
+    }
+
+    void World::SceneQueryFrustum(const Frustum& frustum, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        m_scene_query.QueryFrustum(frustum, false, [this, &frustum, &entities](const uint32_t proxy)
+        {
+            Entity* entity = static_cast<Entity*>(m_scene_query.GetUserData(proxy));
+            if (frustum.CheckBox(entity->GetRenderable()->GetAabb()) != Outside)
+            {
+                entities.emplace_back(entity);
+            }
+            return true;
+        });
+    }
+
+    void World::SceneQueryMarkDirty(Entity* entity)
+    {
+        // Entities outside of the world are inserted with up to date bounds once they are added
+        if (entity->m_scene_query_dirty || !entity->GetHandle().IsValid() || !entity->HasComponent<Renderable>())
+            return;
+
+        entity->m_scene_query_dirty = true;
+        m_scene_query_dirty.emplace_back(entity->GetHandle());
+    }
+
+    void World::SceneQueryUpdate(Entity* entity)
+    {
+        Renderable* renderable      = entity->HasComponent<Renderable>() ? entity->GetRenderable() : nullptr;
+        if (renderable && entity->GetHandle().IsValid())
+        {
+            // Every change of the bounds comes through here after the transforms have been resolved, this is where they are cached
+            renderable->UpdateAabb();
+        }
+
+        const bool is_queryable     = entity->GetHandle().IsValid() && entity->IsActive() && renderable && renderable->GetAabb().Defined();
+        uint32_t& proxy             = entity->m_scene_query_proxy;
+
+        if (!is_queryable)
+        {
+            if (proxy != Entity::scene_query_proxy_invalid)
+            {
+                m_scene_query.Remove(proxy);
+                proxy = Entity::scene_query_proxy_invalid;
+            }
+
+            return;
+        }
+
+        if (proxy == Entity::scene_query_proxy_invalid)
+        {
+            proxy = m_scene_query.Insert(renderable->GetAabb(), entity);
+        }
+        else
+        {
+            m_scene_query.Move(proxy, renderable->GetAabb());
+        }
+    }
+
+    void World::SceneQueryRefit()
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        for (const EntityHandle& handle : m_scene_query_dirty)
+        {
+            // Entities that were removed in the meantime leave the hierarchy through their removed delta
+            if (const shared_ptr<Entity>& entity = EntityGetByHandle(handle))
+            {
+                entity->m_scene_query_dirty = false;
+                SceneQueryUpdate(entity.get());
+            }
         }
+        m_scene_query_dirty.clear();
     }
 
 	shared_ptr<Entity>& World::CreateEnvironment()
@@ -25,16 +25,32 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <array>
+#include <utility>
+#include <mutex>
 #include "../Core/EngineDefs.h"
 #include "../Core/ISubsystem.h"
+#include "Components/IComponent.h"
+#include "../Math/BoundingVolumeHierarchy.h"
 //=============================
 
 namespace Spartan
 {
 	class Entity;
+	struct EntityHandle;
 	class Light;
 	class Input;
 	class Profiler;
+	class Threading;
+	class Transform;
+	class WorldStreaming;
+	namespace Math
+	{
+		class Ray;
+		class RayHit;
+	}
 
 	enum Scene_State
 	{
@@ -44,6 +60,25 @@ namespace Spartan
 		Loading
 	};
 
+	enum Entity_Delta_Type
+	{
+		Entity_Delta_Added,
+		Entity_Delta_Removed,
+		Entity_Delta_Changed // components or active state
+	};
+
+	struct EntityDelta
+	{
+		EntityDelta(Entity_Delta_Type type, const std::shared_ptr<Entity>& entity)
+		{
+			this->type		= type;
+			this->entity	= entity;
+		}
+
+		Entity_Delta_Type type;
+		std::shared_ptr<Entity> entity; // keeps removed entities alive until the deltas have been consumed
+	};
+
 	class SPARTAN_CLASS World : public ISubsystem
 	{
 	public:
@@ -60,6 +95,9 @@ namespace Spartan
 		bool LoadFromFile(const std::string& file_path);
 		const auto& GetName() const { return m_name; }
         void MakeDirty() { m_is_dirty = true; }
+        WorldStreaming* GetStreaming() const { return m_streaming.get(); }
+        // Worlds are saved as compressed chunks unless this is turned off, loading reads both
+        void SetSaveCompressed(const bool compressed) { m_save_compressed = compressed; }
 
 		//= Entities ===========================================================================
 		std::shared_ptr<Entity>& EntityCreate(bool is_active = true);
@@ -67,14 +105,78 @@ namespace Spartan
 		bool EntityExists(const std::shared_ptr<Entity>& entity);
 		void EntityRemove(const std::shared_ptr<Entity>& entity);	
 		std::vector<std::shared_ptr<Entity>> EntityGetRoots();
+		// When several entities share the name, it's the one which got it first
 		const std::shared_ptr<Entity>& EntityGetByName(const std::string& name);
 		const std::shared_ptr<Entity>& EntityGetById(uint32_t id);
+		const std::shared_ptr<Entity>& EntityGetByHandle(const EntityHandle& handle);
 		const auto& EntityGetAll() const    { return m_entities; }
 		auto EntityGetCount() const         { return static_cast<uint32_t>(m_entities.size()); }
+
+		// The changes since the previous resolve, in the order they happened. Only valid while Event_World_Resolve_Complete is being handled.
+		const auto& EntityGetDeltas() const { return m_entity_deltas; }
+        // For state outside of the entity's components which decides how it's rendered (e.g. a material's transparency).
+        // Thread safe, entities which are not part of the world are ignored (they are picked up when they are added).
+        void EntityMarkChanged(Entity* entity);
+        // Entities are only added and removed while this is held
+        std::recursive_mutex& GetMutex() { return m_mutex; }
 		//======================================================================================
 
+		//= Components =====================================================================
+		// Invokes function(T*...) for every entity which has all of the given components.
+		// Entities are grouped by component mask (archetype) and each group stores its
+		// components in contiguous columns, so no per entity component search takes place.
+		template <typename... T, typename Function>
+		void Each(Function&& function)
+		{
+			const uint32_t mask = ((1u << static_cast<uint32_t>(IComponent::TypeToEnum<T>())) | ...);
+
+			for (const Archetype& archetype : m_archetypes)
+			{
+				if ((archetype.mask & mask) != mask || archetype.entities.empty())
+					continue;
+
+				EachInArchetype<T...>(archetype, function, std::index_sequence_for<T...>{});
+			}
+		}
+		//==================================================================================
+
+		//= Transforms =====================================================================
+		void TransformsMarkHierarchyDirty() { m_transforms_hierarchy_dirty = true; }
+		//==================================================================================
+
+		//= Scene queries ==================================================================================================
+		// The bounds of every active renderable live in a bounding volume hierarchy which is kept up to date as entities
+		// change and move. The results are exact (tested against each renderable's bounds), hits are sorted by distance.
+		void SceneQueryRay(const Math::Ray& ray, std::vector<Math::RayHit>& hits, bool nearest_only = false) const;
+		void SceneQueryBox(const Math::BoundingBox& box, std::vector<Entity*>& entities) const;
+		void SceneQuerySphere(const Math::Vector3& center, float radius, std::vector<Entity*>& entities) const;
+		void SceneQueryFrustum(const Math::Frustum& frustum, std::vector<Entity*>& entities) const;
+
+		// For systems that walk the hierarchy themselves (e.g. culling), the user data of every leaf is its Entity*
+		const auto& SceneQueryGetHierarchy() const { return m_scene_query; }
+
+		// Queues an entity whose bounds changed, it's refit on the next tick (once the transforms have been resolved)
+		void SceneQueryMarkDirty(Entity* entity);
+		//==================================================================================================================
+
 	private:
+        friend class Entity;
+        friend class WorldStreaming;
+        friend class Benchmark; // times TransformsResolve() on its own
+
         void _EntityRemove(const std::shared_ptr<Entity>& entity);
+        void EntityIndexAdd(Entity* entity);
+        void EntityIndexId(Entity* entity, uint32_t id_old, uint32_t id_new);
+        void EntityIndexName(Entity* entity, const std::string& name_old, const std::string& name_new);
+        void ArchetypeInsert(Entity* entity);
+        void ArchetypeRemove(Entity* entity);
+        void ArchetypeUpdate(Entity* entity);
+        void TransformsSortByDepth();
+        void TransformsResolve();
+		void LoadEntities(FileStream* file);
+		void LoadEntitiesLegacy(FileStream* file, uint32_t root_entity_count);
+        void SceneQueryUpdate(Entity* entity);
+        void SceneQueryRefit();
 
 		//= COMMON ENTITY CREATION ========================
 		std::shared_ptr<Entity>& CreateEnvironment();
@@ -85,10 +187,58 @@ namespace Spartan
         std::string m_name;
         bool m_was_in_editor_mode   = false;
         bool m_is_dirty             = true;
+        bool m_save_compressed      = true;
         Scene_State m_state         = Ticking;	
         Input* m_input              = nullptr;
         Profiler* m_profiler        = nullptr;
+        Threading* m_threading      = nullptr;
+        std::unique_ptr<WorldStreaming> m_streaming;
+        std::recursive_mutex m_mutex; // saving runs on a worker and holds it, ticking and adding entities wait for it
 
         std::vector<std::shared_ptr<Entity>> m_entities;
+        std::vector<EntityDelta> m_entity_deltas;
+
+        // Lookup, an entity's handle slot stores its index in m_entities
+        struct EntitySlot
+        {
+            uint32_t entity_index   = 0;
+            uint32_t generation     = 0;
+        };
+        std::vector<EntitySlot> m_entity_slots;
+        std::vector<uint32_t> m_entity_slots_free;
+        std::unordered_map<uint32_t, uint32_t> m_entity_index_id; // id -> slot
+        std::unordered_map<std::string, std::vector<uint32_t>> m_entity_index_name; // name -> ids, in the order the entities got the name
+
+        // Entities grouped by component mask, row i of every column belongs to entities[i]
+        struct Archetype
+        {
+            uint32_t mask = 0;
+            std::vector<Entity*> entities;
+            std::array<std::vector<IComponent*>, ComponentType_Unknown> columns;
+        };
+
+        template <typename... T, typename Function, size_t... I>
+        static void EachInArchetype(const Archetype& archetype, Function& function, std::index_sequence<I...>)
+        {
+            IComponent* const* columns[] = { archetype.columns[IComponent::TypeToEnum<T>()].data()... };
+            const size_t count = archetype.entities.size();
+
+            for (size_t row = 0; row < count; row++)
+            {
+                function(static_cast<T*>(columns[I][row])...);
+            }
+        }
+
+        std::vector<Archetype> m_archetypes;
+        std::unordered_map<uint32_t, uint32_t> m_archetype_index; // mask -> archetype
+
+        // All the transforms, sorted by hierarchy depth, a level's transforms are [offsets[depth], offsets[depth + 1])
+        std::vector<Transform*> m_transforms;
+        std::vector<uint32_t> m_transforms_depth_offsets;
+        bool m_transforms_hierarchy_dirty = true;
+
+        // Scene queries
+        Math::BoundingVolumeHierarchy m_scene_query;
+        std::vector<EntityHandle> m_scene_query_dirty;
 	};
 }
@@ -0,0 +1,691 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =============================
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include "WorldStreaming.h"
+#include "World.h"
+#include "Components/Transform.h"
+#include "Components/Renderable.h"
+#include "Components/Camera.h"
+#include "Components/Light.h"
+#include "Components/Environment.h"
+#include "Components/AudioListener.h"
+#include "../Core/Stopwatch.h"
+#include "../Core/FileSystem.h"
+#include "../IO/AssetContainer.h"
+#include "../IO/FileStream.h"
+#include "../Logging/Log.h"
+//========================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    namespace
+    {
+        constexpr uint32_t chunk_header = asset_chunk_type('W', 'S', 'H', 'D');
+        constexpr uint32_t chunk_table  = asset_chunk_type('W', 'S', 'T', 'B');
+        constexpr uint32_t chunk_cell   = asset_chunk_type('W', 'S', 'C', 'L'); // one per cell, an entity count followed by the entity blocks
+
+        struct StreamingHeader
+        {
+            float cell_size;
+            uint32_t cell_count;
+        };
+
+        struct CellDesc
+        {
+            int32_t x;
+            int32_t z;
+            Vector3 bounds_min;
+            Vector3 bounds_max;
+        };
+
+        uint64_t cell_key(const int32_t x, const int32_t z)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+        }
+
+        // Parents first, the order entities are saved and linked in
+        void gather_hierarchy(Entity* root, vector<Entity*>& entities)
+        {
+            const size_t start = entities.size();
+            entities.emplace_back(root);
+            for (size_t i = start; i < entities.size(); i++)
+            {
+                for (Transform* child : entities[i]->GetTransform()->GetChildren())
+                {
+                    entities.emplace_back(child->GetEntity());
+                }
+            }
+        }
+
+        // The bounds of the renderables, or the position of the root when there are none
+        BoundingBox hierarchy_bounds(const vector<Entity*>& entities)
+        {
+            const Vector3 position = entities.front()->GetTransform()->GetPosition();
+            BoundingBox bounds(position, position);
+            bool has_renderable = false;
+
+            for (Entity* entity : entities)
+            {
+                if (Renderable* renderable = entity->GetComponent<Renderable>())
+                {
+                    if (has_renderable)
+                    {
+                        bounds.Merge(renderable->GetAabb());
+                    }
+                    else
+                    {
+                        bounds          = renderable->GetAabb();
+                        has_renderable  = true;
+                    }
+                }
+            }
+
+            return bounds;
+        }
+    }
+
+    WorldStreaming::WorldStreaming(World* world, Threading* threading)
+    {
+        m_world     = world;
+        m_threading = threading;
+    }
+
+    WorldStreaming::~WorldStreaming()
+    {
+        Close();
+    }
+
+    bool WorldStreaming::IsStreamable(Entity* root)
+    {
+        vector<Entity*> entities;
+        gather_hierarchy(root, entities);
+
+        for (Entity* entity : entities)
+        {
+            if (entity->HasComponent<Camera>() || entity->HasComponent<Light>() || entity->HasComponent<Environment>() || entity->HasComponent<AudioListener>())
+                return false;
+        }
+
+        return true;
+    }
+
+    bool WorldStreaming::Save(const string& world_file_path, unordered_set<uint32_t>* saved_root_ids)
+    {
+        // Saving happens on a worker, ticking skips streaming until it's done
+        lock_guard<mutex> lock(m_mutex);
+
+        const string file_path = GetCellsFilePath(world_file_path);
+        saved_root_ids->clear();
+
+        // Cells which were read but not added to the world yet are treated as not loaded, a cell which is partly in the
+        // world is completed, so that every cell is either entirely on disk or entirely in the world.
+        for (Cell& cell : m_cells)
+        {
+            if (cell.state == Cell_Reading)
+            {
+                m_threading->Wait(cell.job);
+                cell.state = Cell_Ready;
+            }
+
+            if (cell.state == Cell_Ready)
+            {
+                CellDropData(cell);
+                cell.state          = Cell_Unloaded;
+                m_stats.memory_used -= cell.size;
+            }
+            else if (cell.state == Cell_Integrating)
+            {
+                while (!CellIntegrateEntity(cell)) {}
+                cell.state = Cell_Loaded;
+                CellDropData(cell);
+            }
+        }
+
+        // Entities of cells which are not loaded are not in the world, so they would be lost
+        const bool has_unloaded = any_of(m_cells.begin(), m_cells.end(), [](const Cell& cell) { return cell.state == Cell_Unloaded; });
+        if (m_cell_size <= 0.0f && has_unloaded)
+        {
+            LOG_WARNING("Streaming can only be disabled while every cell is loaded, keeping a cell size of %.2f", m_cell_size_saved);
+            m_cell_size = m_cell_size_saved;
+        }
+
+        if (m_cell_size <= 0.0f)
+        {
+            CloseInternal();
+            if (FileSystem::Exists(file_path))
+            {
+                FileSystem::Delete(file_path);
+            }
+            return true;
+        }
+
+        const auto get_cell = [this](const BoundingBox& bounds, int32_t* x, int32_t* z)
+        {
+            const Vector3 center    = bounds.GetCenter();
+            *x                      = static_cast<int32_t>(floor(center.x / m_cell_size));
+            *z                      = static_cast<int32_t>(floor(center.z / m_cell_size));
+        };
+
+        struct CellBuild
+        {
+            int32_t x               = 0;
+            int32_t z               = 0;
+            BoundingBox bounds;
+            bool has_bounds         = false;
+            bool has_unloaded       = false;
+            vector<vector<std::byte>> blocks;
+            vector<Entity*> roots;
+            vector<std::byte> payload;
+        };
+        unordered_map<uint64_t, CellBuild> builds;
+
+        const auto get_build = [&builds](const int32_t x, const int32_t z, const BoundingBox& bounds) -> CellBuild&
+        {
+            CellBuild& build = builds[cell_key(x, z)];
+            if (build.has_bounds)
+            {
+                build.bounds.Merge(bounds);
+            }
+            else
+            {
+                build.x             = x;
+                build.z             = z;
+                build.bounds        = bounds;
+                build.has_bounds    = true;
+            }
+            return build;
+        };
+
+        // Cells which are not loaded keep what they have on disk. With a different cell size,
+        // a cell moves as a whole into the new cell which its center falls into.
+        const bool regrid = m_cell_size != m_cell_size_saved;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_cells.size()); i++)
+        {
+            const Cell& cell = m_cells[i];
+            if (cell.state != Cell_Unloaded)
+                continue;
+
+            int32_t x = cell.x, z = cell.z;
+            if (regrid)
+            {
+                get_cell(cell.bounds, &x, &z);
+            }
+            CellBuild& build    = get_build(x, z, cell.bounds);
+            build.has_unloaded  = true;
+
+            uint64_t size           = 0;
+            const std::byte* data   = m_container->GetChunk(chunk_cell, i, &size);
+            vector<std::byte> payload(data, data + size);
+            FileStream stream(&payload, FileStream_Read);
+            const auto block_count = stream.ReadAs<uint32_t>();
+            for (uint32_t block = 0; block < block_count; block++)
+            {
+                stream.Read(&build.blocks.emplace_back());
+            }
+        }
+
+        // The rest comes from the world
+        {
+            vector<Entity*> entities;
+            for (const auto& root : m_world->EntityGetRoots())
+            {
+                if (root->IsPendingDestruction() || !IsStreamable(root.get()))
+                    continue;
+
+                entities.clear();
+                gather_hierarchy(root.get(), entities);
+                const BoundingBox bounds = hierarchy_bounds(entities);
+                int32_t x = 0, z = 0;
+                get_cell(bounds, &x, &z);
+
+                // Adding to a cell which isn't loaded would have to take the entity out of the world, so it stays in the world file
+                const auto it = builds.find(cell_key(x, z));
+                if (it != builds.end() && it->second.has_unloaded)
+                    continue;
+
+                CellBuild& build = get_build(x, z, bounds);
+                build.roots.emplace_back(root.get());
+                saved_root_ids->emplace(root->GetId());
+
+                for (Entity* entity : entities)
+                {
+                    FileStream stream(&build.blocks.emplace_back(), FileStream_Write);
+                    entity->Serialize(&stream);
+                }
+            }
+        }
+
+        // Sorted, so that saving the same world twice produces the same file
+        vector<CellBuild*> cells;
+        cells.reserve(builds.size());
+        for (auto& build : builds)
+        {
+            CellBuild& cell = build.second;
+            FileStream stream(&cell.payload, FileStream_Write);
+            stream.Write(static_cast<uint32_t>(cell.blocks.size()));
+            for (const auto& block : cell.blocks)
+            {
+                stream.Write(block);
+            }
+            vector<vector<std::byte>>().swap(cell.blocks);
+
+            cells.emplace_back(&cell);
+        }
+        sort(cells.begin(), cells.end(), [](const CellBuild* a, const CellBuild* b) { return a->x != b->x ? a->x < b->x : a->z < b->z; });
+
+        // The file is about to be replaced, it can't stay mapped
+        CloseInternal();
+
+        if (cells.empty())
+        {
+            if (FileSystem::Exists(file_path))
+            {
+                FileSystem::Delete(file_path);
+            }
+            return true;
+        }
+
+        StreamingHeader header  = {};
+        header.cell_size        = m_cell_size;
+        header.cell_count       = static_cast<uint32_t>(cells.size());
+
+        vector<CellDesc> table(cells.size());
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            table[i].x          = cells[i]->x;
+            table[i].z          = cells[i]->z;
+            table[i].bounds_min = cells[i]->bounds.GetMin();
+            table[i].bounds_max = cells[i]->bounds.GetMax();
+        }
+
+        AssetContainerWriter writer;
+        writer.AddChunk(chunk_header, 0, &header, sizeof(header));
+        writer.AddChunk(chunk_table, 0, table);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(cells.size()); i++)
+        {
+            writer.AddChunk(chunk_cell, i, cells[i]->payload);
+        }
+
+        if (!writer.Save(file_path))
+        {
+            LOG_ERROR("Failed to save \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        // The cells which were saved from the world are loaded
+        if (!OpenInternal(world_file_path))
+            return false;
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(cells.size()); i++)
+        {
+            if (cells[i]->roots.empty())
+                continue;
+
+            Cell& cell = m_cells[i];
+            cell.state = Cell_Loaded;
+            for (Entity* root : cells[i]->roots)
+            {
+                cell.root_ids.emplace_back(root->GetId());
+            }
+            m_stats.memory_used += cell.size;
+        }
+
+        return true;
+    }
+
+    bool WorldStreaming::Open(const string& world_file_path)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return OpenInternal(world_file_path);
+    }
+
+    void WorldStreaming::Close()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        CloseInternal();
+    }
+
+    bool WorldStreaming::OpenInternal(const string& world_file_path)
+    {
+        CloseInternal();
+
+        // A world which was saved without streaming has no cells
+        const string file_path = GetCellsFilePath(world_file_path);
+        if (!FileSystem::Exists(file_path))
+        {
+            m_cell_size = 0.0f;
+            return true;
+        }
+
+        auto container = make_unique<AssetContainer>();
+        if (!container->Open(file_path))
+        {
+            LOG_ERROR("Failed to open \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        const StreamingHeader* header   = container->GetChunk<StreamingHeader>(chunk_header);
+        uint64_t table_count            = 0;
+        const CellDesc* table           = container->GetChunk<CellDesc>(chunk_table, 0, &table_count);
+        if (!header || !table || table_count != header->cell_count || container->GetChunkCount(chunk_cell) != header->cell_count)
+        {
+            LOG_ERROR("\"%s\" is corrupted", file_path.c_str());
+            return false;
+        }
+
+        m_cells.resize(header->cell_count);
+        for (uint32_t i = 0; i < header->cell_count; i++)
+        {
+            Cell& cell  = m_cells[i];
+            cell.x      = table[i].x;
+            cell.z      = table[i].z;
+            cell.bounds = BoundingBox(table[i].bounds_min, table[i].bounds_max);
+            container->GetChunk(chunk_cell, i, &cell.size);
+        }
+
+        m_cell_size             = header->cell_size;
+        m_cell_size_saved       = header->cell_size;
+        m_container             = move(container);
+        m_stats.cells_total     = header->cell_count;
+
+        return true;
+    }
+
+    void WorldStreaming::CloseInternal()
+    {
+        // The workers read into the cells from the mapped file
+        for (Cell& cell : m_cells)
+        {
+            if (cell.state == Cell_Reading)
+            {
+                m_threading->Wait(cell.job);
+            }
+        }
+
+        m_cells.clear();
+        m_container.reset();
+        m_cell_size_saved       = 0.0f;
+        m_stats.cells_total     = 0;
+        m_stats.cells_loaded    = 0;
+        m_stats.cells_in_flight = 0;
+        m_stats.memory_used     = 0;
+    }
+
+    void WorldStreaming::Tick(const Vector3& camera_position, const float frame_ms, const float frame_ms_smoothed)
+    {
+        unique_lock<mutex> lock(m_mutex, try_to_lock);
+        if (!lock.owns_lock() || !IsOpen())
+            return;
+
+        // The frame which just ended ran the previous tick, so a hitch is attributed to streaming if that tick integrated anything.
+        // This is measured against the real frame time, the integration budget only bounds the part streaming knows about.
+        m_stats.hitch_frames += (m_integrated_last_tick && frame_ms > 2.0f * frame_ms_smoothed) ? 1 : 0;
+
+        Stopwatch timer;
+
+        const float unload_radius           = m_load_radius * 1.25f;
+        const float load_radius_squared     = m_load_radius * m_load_radius;
+        const float unload_radius_squared   = unload_radius * unload_radius;
+        const auto cell_count               = static_cast<uint32_t>(m_cells.size());
+
+        vector<float> distances(cell_count);
+        for (uint32_t i = 0; i < cell_count; i++)
+        {
+            distances[i] = m_cells[i].bounds.DistanceSquared(camera_position);
+        }
+
+        // Pick up the reads which finished
+        for (Cell& cell : m_cells)
+        {
+            if (cell.state == Cell_Reading && m_threading->IsDone(cell.job))
+            {
+                cell.state = Cell_Ready;
+            }
+        }
+
+        // Unload what went out of range, a read in progress is picked up once it finishes
+        for (uint32_t i = 0; i < cell_count; i++)
+        {
+            if (m_cells[i].state != Cell_Unloaded && m_cells[i].state != Cell_Reading && distances[i] > unload_radius_squared)
+            {
+                CellUnload(m_cells[i]);
+            }
+        }
+
+        // Unload the furthest cells until the budget is met, e.g. after it was lowered
+        if (m_stats.memory_used > m_memory_budget)
+        {
+            vector<uint32_t> loaded;
+            for (uint32_t i = 0; i < cell_count; i++)
+            {
+                if (m_cells[i].state != Cell_Unloaded && m_cells[i].state != Cell_Reading)
+                {
+                    loaded.emplace_back(i);
+                }
+            }
+            sort(loaded.begin(), loaded.end(), [&distances](const uint32_t a, const uint32_t b) { return distances[a] > distances[b]; });
+
+            for (size_t i = 0; i < loaded.size() && m_stats.memory_used > m_memory_budget; i++)
+            {
+                CellUnload(m_cells[loaded[i]]);
+            }
+        }
+
+        // Request the nearest cells in range, for as long as they fit the budget
+        {
+            vector<uint32_t> candidates;
+            uint32_t reading = 0;
+            for (uint32_t i = 0; i < cell_count; i++)
+            {
+                if (m_cells[i].state == Cell_Unloaded && distances[i] <= load_radius_squared)
+                {
+                    candidates.emplace_back(i);
+                }
+                reading += m_cells[i].state == Cell_Reading ? 1 : 0;
+            }
+            sort(candidates.begin(), candidates.end(), [&distances](const uint32_t a, const uint32_t b) { return distances[a] < distances[b]; });
+
+            for (const uint32_t i : candidates)
+            {
+                if (reading >= m_threading->GetThreadCount() || m_stats.memory_used + m_cells[i].size > m_memory_budget)
+                    break;
+
+                CellRequest(i);
+                reading++;
+            }
+        }
+
+        // Integrate the nearest cells within the budget, at least one entity per tick so that streaming always progresses
+        bool integrated = false;
+        while (!integrated || timer.GetElapsedTimeMs() < m_integration_budget_ms)
+        {
+            Cell* nearest = nullptr;
+            float nearest_distance = numeric_limits<float>::max();
+            for (uint32_t i = 0; i < cell_count; i++)
+            {
+                if ((m_cells[i].state == Cell_Ready || m_cells[i].state == Cell_Integrating) && distances[i] < nearest_distance)
+                {
+                    nearest             = &m_cells[i];
+                    nearest_distance    = distances[i];
+                }
+            }
+
+            if (!nearest)
+                break;
+
+            nearest->state  = Cell_Integrating;
+            bool done       = false;
+            do
+            {
+                done        = CellIntegrateEntity(*nearest);
+                integrated  = true;
+            } while (!done && timer.GetElapsedTimeMs() < m_integration_budget_ms);
+
+            if (done)
+            {
+                nearest->state = Cell_Loaded;
+                CellDropData(*nearest);
+            }
+        }
+
+        // Stats
+        m_stats.cells_loaded    = 0;
+        m_stats.cells_in_flight = 0;
+        for (const Cell& cell : m_cells)
+        {
+            m_stats.cells_loaded    += cell.state == Cell_Loaded ? 1 : 0;
+            m_stats.cells_in_flight += (cell.state == Cell_Reading || cell.state == Cell_Ready || cell.state == Cell_Integrating) ? 1 : 0;
+        }
+        m_stats.frame_ms        = timer.GetElapsedTimeMs();
+        m_stats.frame_ms_max    = Max(m_stats.frame_ms_max, m_stats.frame_ms);
+        m_stats.budget_overruns += m_stats.frame_ms > m_integration_budget_ms ? 1 : 0;
+        m_integrated_last_tick  = integrated;
+    }
+
+    void WorldStreaming::Flush()
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        for (Cell& cell : m_cells)
+        {
+            if (cell.state == Cell_Reading)
+            {
+                m_threading->Wait(cell.job);
+                cell.state = Cell_Ready;
+            }
+
+            if (cell.state == Cell_Ready || cell.state == Cell_Integrating)
+            {
+                cell.state = Cell_Integrating;
+                while (!CellIntegrateEntity(cell)) {}
+                cell.state = Cell_Loaded;
+                CellDropData(cell);
+            }
+        }
+    }
+
+    void WorldStreaming::CellRequest(const uint32_t index)
+    {
+        Cell& cell              = m_cells[index];
+        cell.state              = Cell_Reading;
+        m_stats.memory_used     += cell.size;
+        cell.job                = m_threading->AddTaskBackground([this, index]() { CellRead(index); }); // file reads, so not in a queue that waits help with
+    }
+
+    void WorldStreaming::CellRead(const uint32_t index)
+    {
+        // Runs on a worker, it only touches its own cell and the mapped file, both outlive it
+        Cell& cell              = m_cells[index];
+        uint64_t size           = 0;
+        const std::byte* data   = m_container->GetChunk(chunk_cell, index, &size);
+        vector<std::byte> payload(data, data + size);
+
+        FileStream stream(&payload, FileStream_Read);
+        cell.blocks.resize(stream.ReadAs<uint32_t>());
+        for (auto& block : cell.blocks)
+        {
+            stream.Read(&block);
+        }
+
+        cell.records.resize(cell.blocks.size());
+        cell.component_offsets.resize(cell.blocks.size());
+        for (size_t i = 0; i < cell.blocks.size(); i++)
+        {
+            FileStream block_stream(&cell.blocks[i], FileStream_Read);
+            Entity::DeserializeRecord(&block_stream, &cell.records[i]);
+            cell.component_offsets[i] = block_stream.GetMemoryPosition();
+        }
+    }
+
+    bool WorldStreaming::CellIntegrateEntity(Cell& cell)
+    {
+        if (cell.integrated < cell.records.size())
+        {
+            const uint32_t i            = cell.integrated++;
+            const EntityRecord& record  = cell.records[i];
+            Entity* entity              = m_world->EntityCreate(record.is_active).get();
+
+            FileStream stream(&cell.blocks[i], FileStream_Read);
+            stream.Skip(static_cast<uint32_t>(cell.component_offsets[i]));
+            entity->Deserialize(&stream, record);
+            vector<std::byte>().swap(cell.blocks[i]);
+
+            // Parents are saved before their children, so the parent is already in the world
+            if (Entity* parent = record.parent_id != 0 ? m_world->EntityGetById(record.parent_id).get() : nullptr)
+            {
+                entity->GetTransform()->LinkParent(parent->GetTransform());
+                m_world->TransformsMarkHierarchyDirty();
+            }
+            else
+            {
+                cell.root_ids.emplace_back(record.id);
+            }
+
+            // The world only starts its entities when the game starts
+            if (!m_world->m_was_in_editor_mode)
+            {
+                entity->Start();
+            }
+
+            m_world->MakeDirty();
+        }
+
+        return cell.integrated >= cell.records.size();
+    }
+
+    void WorldStreaming::CellUnload(Cell& cell)
+    {
+        for (const uint32_t id : cell.root_ids)
+        {
+            m_world->EntityRemove(m_world->EntityGetById(id));
+        }
+
+        CellDropData(cell);
+        cell.root_ids.clear();
+        cell.state          = Cell_Unloaded;
+        m_stats.memory_used -= cell.size;
+    }
+
+    void WorldStreaming::CellDropData(Cell& cell)
+    {
+        vector<vector<std::byte>>().swap(cell.blocks);
+        vector<EntityRecord>().swap(cell.records);
+        vector<size_t>().swap(cell.component_offsets);
+        cell.integrated = 0;
+    }
+
+    string WorldStreaming::GetCellsFilePath(const string& world_file_path)
+    {
+        return FileSystem::GetFilePathWithoutExtension(world_file_path) + "_cells.dat";
+    }
+}
@@ -0,0 +1,139 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <unordered_set>
+#include "Entity.h"
+#include "../Math/BoundingBox.h"
+#include "../Threading/Threading.h"
+//================================
+
+namespace Spartan
+{
+    class World;
+    class AssetContainer;
+
+    struct WorldStreamingStats
+    {
+        uint32_t cells_total        = 0;
+        uint32_t cells_loaded       = 0;
+        uint32_t cells_in_flight    = 0;    // being read by a worker or waiting to be integrated
+        uint64_t memory_used        = 0;    // serialized size of the cells which are loaded or in flight
+        float frame_ms              = 0.0f; // main thread time streaming took during the last tick
+        float frame_ms_max          = 0.0f;
+        uint32_t budget_overruns    = 0;    // ticks which went over the integration budget
+        uint32_t hitch_frames       = 0;    // frames which took over twice the smoothed frame time, right after a tick that integrated
+    };
+
+    // Splits the streamable entities of a world into a grid of cells on the XZ plane, which are saved next to
+    // the world file. As the camera approaches a cell, a worker reads and parses it, then the main thread adds
+    // its entities to the world within a time budget, so the world keeps ticking and rendering while it streams.
+    class SPARTAN_CLASS WorldStreaming
+    {
+    public:
+        WorldStreaming(World* world, Threading* threading);
+        ~WorldStreaming();
+
+        // Hierarchies without a camera, light, environment or audio listener stream, everything else is always loaded
+        static bool IsStreamable(Entity* root);
+
+        // Writes the streamable entities into cells and returns the ids of the roots it took, the world file keeps the rest.
+        // Cells which are not loaded keep what they have on disk, entities of the world which moved into one of them stay
+        // in the world file until a save finds that cell loaded. The world must not change while this runs.
+        bool Save(const std::string& world_file_path, std::unordered_set<uint32_t>* saved_root_ids);
+        bool Open(const std::string& world_file_path);
+        void Close();
+        bool IsOpen() const { return m_container != nullptr; }
+
+        // The frame times are the real (previous) frame's, they are only used to count hitches
+        void Tick(const Math::Vector3& camera_position, float frame_ms, float frame_ms_smoothed);
+
+        // Waits for the workers and integrates every cell in flight, ignoring the budget
+        void Flush();
+
+        // Zero disables streaming, it takes effect when the world is saved
+        float GetCellSize() const                   { return m_cell_size; }
+        void SetCellSize(const float size)          { m_cell_size = size; }
+        // Cells unload a quarter further than they load, so that they don't thrash at the edge
+        void SetLoadRadius(const float radius)      { m_load_radius = radius; }
+        void SetIntegrationBudget(const float ms)   { m_integration_budget_ms = ms; }
+        void SetMemoryBudget(const uint64_t bytes)  { m_memory_budget = bytes; }
+        const WorldStreamingStats& GetStats() const { return m_stats; }
+
+    private:
+        enum Cell_State
+        {
+            Cell_Unloaded,
+            Cell_Reading,
+            Cell_Ready,
+            Cell_Integrating,
+            Cell_Loaded
+        };
+
+        struct Cell
+        {
+            int32_t x               = 0;
+            int32_t z               = 0;
+            Math::BoundingBox bounds;
+            uint64_t size           = 0;
+            Cell_State state        = Cell_Unloaded;
+            JobHandle job;
+
+            // Written by the worker, consumed while integrating
+            std::vector<std::vector<std::byte>> blocks;
+            std::vector<EntityRecord> records;
+            std::vector<size_t> component_offsets;
+            uint32_t integrated     = 0;
+
+            // The roots this cell added to the world
+            std::vector<uint32_t> root_ids;
+        };
+
+        bool OpenInternal(const std::string& world_file_path);
+        void CloseInternal();
+        void CellRequest(uint32_t index);
+        void CellRead(uint32_t index);
+        bool CellIntegrateEntity(Cell& cell); // returns true once the cell is fully integrated
+        void CellUnload(Cell& cell);
+        void CellDropData(Cell& cell);
+        static std::string GetCellsFilePath(const std::string& world_file_path);
+
+        World* m_world              = nullptr;
+        Threading* m_threading      = nullptr;
+        std::unique_ptr<AssetContainer> m_container;
+        std::vector<Cell> m_cells;
+        WorldStreamingStats m_stats;
+        bool m_integrated_last_tick = false;
+        std::mutex m_mutex;
+
+        float m_cell_size               = 0.0f;
+        float m_cell_size_saved         = 0.0f; // of the cells on disk
+        float m_load_radius             = 500.0f;
+        float m_integration_budget_ms   = 2.0f;
+        uint64_t m_memory_budget        = 512 * 1024 * 1024;
+    };
+}